@@ -17,20 +17,37 @@
 
 namespace bustub {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     ReplacerType replacer_type)
     : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
   // We allocate a consecutive memory space for the buffer pool.
   pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  if (replacer_type == ReplacerType::CLOCK) {
+    replacer_ = new ClockReplacer(pool_size);
+  } else {
+    replacer_ = new LRUReplacer(pool_size);
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
     free_list_.emplace_back(static_cast<int>(i));
   }
+
+  // twice as many entries as frames, so that few resident pages share an entry
+  size_t num_entries = 1;
+  while (num_entries < 2 * pool_size_) {
+    num_entries <<= 1;
+  }
+  resident_pages_mask_ = num_entries - 1;
+  resident_pages_ = new std::atomic<uint64_t>[num_entries];
+  for (size_t i = 0; i < num_entries; ++i) {
+    resident_pages_[i].store(NO_RESIDENT_PAGE, std::memory_order_relaxed);
+  }
 }
 
 BufferPoolManager::~BufferPoolManager() {
   delete[] pages_;
+  delete[] resident_pages_;
   delete replacer_;
 }
 
@@ -70,6 +87,7 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   }
 
   page = &pages_[frame_id];
+  UnmapFrame(frame_id);
 
   page_table_.erase(page->GetPageId());
   page_table_.emplace(page_id, frame_id);
@@ -83,6 +101,7 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   memset(page->data_, 0, PAGE_SIZE);
   disk_manager_->ReadPage(page_id, page->data_);
   replacer_->Pin(frame_id);
+  MapFrame(page_id, frame_id);
 
   return page;
 }
@@ -142,6 +161,7 @@ Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
   }
 
   page = &pages_[frame_id];
+  UnmapFrame(frame_id);
 
   if (page->IsDirty()) {
     disk_manager_->WritePage(page->GetPageId(), page->GetData());
@@ -156,6 +176,7 @@ Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
   memset(page->data_, 0, PAGE_SIZE);
 
   replacer_->Pin(frame_id);
+  MapFrame(*page_id, frame_id);
   return page;
 }
 
@@ -181,6 +202,7 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
     return false;
   }
 
+  UnmapFrame(pgt_iter->second);
   free_list_.emplace_back(pgt_iter->second);
   replacer_->Pin(pgt_iter->second);
   page_table_.erase(page_id);
@@ -192,6 +214,60 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   return true;
 }
 
+bool BufferPoolManager::IsPageResident(page_id_t page_id) {
+  std::lock_guard<std::mutex> latch(latch_);
+  return page_table_.find(page_id) != page_table_.end();
+}
+
+/*
+ * The entry is read again after the version: if it still maps the page to the
+ * same frame, the frame held the page when the version was read. Otherwise the
+ * frame may have been unmapped in between, and its version may belong to the
+ * next page loaded into it.
+ */
+Page *BufferPoolManager::FindResidentPage(page_id_t page_id, uint64_t *version) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+
+  auto &resident_page = resident_pages_[static_cast<size_t>(page_id) & resident_pages_mask_];
+  auto entry = resident_page.load(std::memory_order_seq_cst);
+  if (entry == NO_RESIDENT_PAGE || static_cast<page_id_t>(entry >> 32) != page_id) {
+    return nullptr;
+  }
+
+  auto page = &pages_[static_cast<frame_id_t>(entry & 0xffffffff)];
+  *version = page->version_.load(std::memory_order_seq_cst);
+  if (resident_page.load(std::memory_order_seq_cst) != entry) {
+    return nullptr;
+  }
+  return page;
+}
+
+void BufferPoolManager::MapFrame(page_id_t page_id, frame_id_t frame_id) {
+  auto entry = (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  resident_pages_[static_cast<size_t>(page_id) & resident_pages_mask_].store(entry, std::memory_order_seq_cst);
+}
+
+/*
+ * The entry is cleared before the version is bumped, so a reader that finds
+ * the entry afterwards misses the page, and one that found it before fails to
+ * validate once the frame is reused. Frames are never freed and page reads
+ * are clamped, so reading a reused frame is harmless. Nothing waits for the
+ * readers.
+ */
+void BufferPoolManager::UnmapFrame(frame_id_t frame_id) {
+  auto page = &pages_[frame_id];
+  if (page->page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+
+  auto entry = (static_cast<uint64_t>(static_cast<uint32_t>(page->page_id_)) << 32) | static_cast<uint32_t>(frame_id);
+  resident_pages_[static_cast<size_t>(page->page_id_) & resident_pages_mask_].compare_exchange_strong(
+      entry, NO_RESIDENT_PAGE, std::memory_order_seq_cst);
+  page->version_.fetch_add(2, std::memory_order_seq_cst);
+}
+
 void BufferPoolManager::FlushAllPagesImpl() {
   // You can do it!
   std::lock_guard<std::mutex> latch(latch_);
@@ -14,16 +14,63 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : in_replacer_(num_pages, false), ref_flags_(num_pages, false) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> latch(latch_);
+  if (size_ == 0) {
+    return false;
+  }
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+  // every frame gets its reference bit cleared at most once, so two sweeps always find a victim
+  while (true) {
+    auto hand = clock_hand_;
+    clock_hand_ = (clock_hand_ + 1) % in_replacer_.size();
+    if (!in_replacer_[hand]) {
+      continue;
+    }
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+    if (ref_flags_[hand]) {
+      ref_flags_[hand] = false;
+      continue;
+    }
 
-size_t ClockReplacer::Size() { return 0; }
+    in_replacer_[hand] = false;
+    --size_;
+    *frame_id = static_cast<frame_id_t>(hand);
+    return true;
+  }
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> latch(latch_);
+  auto ind = static_cast<size_t>(frame_id);
+  if (ind >= in_replacer_.size() || !in_replacer_[ind]) {
+    return;
+  }
+
+  in_replacer_[ind] = false;
+  ref_flags_[ind] = false;
+  --size_;
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> latch(latch_);
+  auto ind = static_cast<size_t>(frame_id);
+  if (ind >= in_replacer_.size() || in_replacer_[ind]) {
+    return;
+  }
+
+  in_replacer_[ind] = true;
+  ref_flags_[ind] = true;
+  ++size_;
+}
+
+size_t ClockReplacer::Size() {
+  std::lock_guard<std::mutex> latch(latch_);
+  return size_;
+}
 
 }  // namespace bustub
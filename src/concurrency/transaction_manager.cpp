@@ -82,18 +82,19 @@ void TransactionManager::Abort(Transaction *txn) {
     // Metadata identifying the table that should be deleted from.
     TableMetadata *table_info = catalog->GetTable(item.table_oid_);
     IndexInfo *index_info = catalog->GetIndex(item.index_oid_);
-    auto new_key = item.tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetKeySchema()),
-                                            index_info->index_->GetKeyAttrs());
+    auto index = index_info->index_.get();
+    auto new_key = item.tuple_.KeyFromTuple(table_info->schema_, *index->GetEntrySchema(), index->GetEntryAttrs());
+    // go through the catalog, which logs the rollback if the index is still being built
     if (item.wtype_ == WType::DELETE) {
-      index_info->index_->InsertEntry(new_key, item.rid_, txn);
+      catalog->InsertIndexEntry(txn, index_info, new_key, item.rid_);
     } else if (item.wtype_ == WType::INSERT) {
-      index_info->index_->DeleteEntry(new_key, item.rid_, txn);
+      catalog->DeleteIndexEntry(txn, index_info, new_key, item.rid_);
     } else if (item.wtype_ == WType::UPDATE) {
       // Delete the new key and insert the old key
-      index_info->index_->DeleteEntry(new_key, item.rid_, txn);
-      auto old_key = item.old_tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetKeySchema()),
-                                                  index_info->index_->GetKeyAttrs());
-      index_info->index_->InsertEntry(old_key, item.rid_, txn);
+      catalog->DeleteIndexEntry(txn, index_info, new_key, item.rid_);
+      auto old_key =
+          item.old_tuple_.KeyFromTuple(table_info->schema_, *index->GetEntrySchema(), index->GetEntryAttrs());
+      catalog->InsertIndexEntry(txn, index_info, old_key, item.rid_);
     }
     index_write_set->pop_back();
   }
@@ -0,0 +1,574 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table.cpp
+//
+// Identification: src/container/hash/extendible_hash_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "container/hash/extendible_hash_table.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+EXTENDIBLE_HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                                uint32_t header_max_depth, uint32_t directory_max_depth)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      directory_max_depth_(directory_max_depth),
+      hash_fn_(std::move(hash_fn)) {
+  auto header_page = buffer_pool_manager_->NewPage(&header_page_id_);
+  if (header_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate a hash table header page");
+  }
+
+  reinterpret_cast<HeaderPage *>(header_page->GetData())->Init(header_page_id_, header_max_depth);
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                          std::vector<ValueType> *result) {
+  auto hash = Hash(key);
+  auto directory_page = FetchDirectoryPage(hash, false);
+  if (directory_page == nullptr) {
+    return false;
+  }
+
+  directory_page->RLatch();
+  auto directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  auto bucket_page_id = directory->GetBucketPageId(directory->HashToBucketIndex(hash));
+  auto bucket_page = FetchPage(bucket_page_id);
+  bucket_page->RLatch();
+  directory_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), false);
+
+  auto found = GetChainValue(reinterpret_cast<BucketPage *>(bucket_page->GetData()), key, result);
+  bucket_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * A bucket only splits or merges while it is write latched, so once the bucket
+ * of the key is latched the directory can be released
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  auto hash = Hash(key);
+  auto directory_page = FetchDirectoryPage(hash, false);
+  if (directory_page != nullptr) {
+    directory_page->RLatch();
+    auto directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+    auto bucket_ind = directory->HashToBucketIndex(hash);
+    auto bucket_page_id = directory->GetBucketPageId(bucket_ind);
+    auto can_grow = directory->GetLocalDepth(bucket_ind) == directory->GetMaxDepth();
+    auto bucket_page = FetchPage(bucket_page_id);
+    bucket_page->WLatch();
+    directory_page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), false);
+
+    auto bucket = reinterpret_cast<BucketPage *>(bucket_page->GetData());
+    auto is_inserted = false;
+    if (InsertIntoChain(bucket, key, value, can_grow, &is_inserted)) {
+      bucket_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(bucket_page_id, is_inserted);
+      return is_inserted;
+    }
+    bucket_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  }
+
+  return InsertPessimistic(key, value, hash);
+}
+
+/*
+ * Insert with the directory write latched, splitting the bucket of the key
+ * until it has room. A bucket whose local depth reached the maximum depth of
+ * the directory cannot split, its pairs share all the hash bits it looks at,
+ * so it grows a chain of overflow pages instead.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::InsertPessimistic(const KeyType &key, const ValueType &value, uint32_t hash) {
+  auto directory_page = FetchDirectoryPage(hash, true);
+  directory_page->WLatch();
+  auto directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  auto is_inserted = false;
+  auto is_dirty = false;
+  while (true) {
+    auto bucket_ind = directory->HashToBucketIndex(hash);
+    auto bucket_page_id = directory->GetBucketPageId(bucket_ind);
+    auto bucket_page = FetchPage(bucket_page_id);
+    bucket_page->WLatch();
+    auto bucket = reinterpret_cast<BucketPage *>(bucket_page->GetData());
+    auto local_depth = directory->GetLocalDepth(bucket_ind);
+    if (InsertIntoChain(bucket, key, value, local_depth == directory->GetMaxDepth(), &is_inserted)) {
+      bucket_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(bucket_page_id, is_inserted);
+      break;
+    }
+
+    if (local_depth == directory->GetGlobalDepth()) {
+      directory->IncrGlobalDepth();
+    }
+    SplitBucket(directory, bucket_ind, bucket);
+    is_dirty = true;
+    bucket_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  }
+
+  directory_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), is_dirty);
+  return is_inserted;
+}
+
+/*
+ * Split a bucket into a new page, the slots and pairs whose next hash bit is
+ * set move to it. Both the directory and the bucket are write latched, the
+ * new page is not reachable before the directory is released. Only buckets at
+ * the maximum depth have overflow pages, so the bucket has none.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::SplitBucket(DirectoryPage *directory, uint32_t bucket_ind, BucketPage *bucket) {
+  auto local_depth = directory->GetLocalDepth(bucket_ind);
+  auto bucket_page_id = directory->GetBucketPageId(bucket_ind);
+  page_id_t image_page_id;
+  auto image = reinterpret_cast<BucketPage *>(NewBucketPage(&image_page_id)->GetData());
+
+  auto split_bit = 1U << local_depth;
+  for (uint32_t i = 0; i < directory->Size(); ++i) {
+    if (directory->GetBucketPageId(i) == bucket_page_id) {
+      directory->SetLocalDepth(i, local_depth + 1);
+      if ((i & split_bit) != 0) {
+        directory->SetBucketPageId(i, image_page_id);
+      }
+    }
+  }
+  // hash the keys as a batch, then move the pairs from the back, so that
+  // RemoveAt fills each hole with a pair that stays
+  auto size = bucket->Size();
+  std::vector<KeyType> keys(size);
+  std::vector<uint64_t> hashes(size);
+  for (uint32_t i = 0; i < size; ++i) {
+    keys[i] = bucket->KeyAt(i);
+  }
+  hash_fn_.GetHashes(keys.data(), size, hashes.data());
+  for (auto i = size; i-- > 0;) {
+    if ((static_cast<uint32_t>(hashes[i]) & split_bit) != 0) {
+      image->Insert(keys[i], bucket->ValueAt(i), comparator_);
+      bucket->RemoveAt(i);
+    }
+  }
+
+  buffer_pool_manager_->UnpinPage(image_page_id, true);
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  auto hash = Hash(key);
+  auto directory_page = FetchDirectoryPage(hash, false);
+  if (directory_page == nullptr) {
+    return false;
+  }
+
+  directory_page->RLatch();
+  auto directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  auto bucket_ind = directory->HashToBucketIndex(hash);
+  auto bucket_page_id = directory->GetBucketPageId(bucket_ind);
+  auto can_merge = directory->GetLocalDepth(bucket_ind) > 0;
+  auto bucket_page = FetchPage(bucket_page_id);
+  bucket_page->WLatch();
+  directory_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), false);
+
+  auto bucket = reinterpret_cast<BucketPage *>(bucket_page->GetData());
+  auto is_removed = RemoveFromChain(bucket, key, value);
+  auto is_empty = bucket->IsEmpty();
+  bucket_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, is_removed);
+
+  if (is_removed && is_empty && can_merge) {
+    Merge(hash);
+  } else if (has_pending_deletes_) {
+    DeletePendingPages();
+  }
+  return is_removed;
+}
+
+/*
+ * Merge the bucket of hash with its split image while one of them is empty,
+ * then shrink the directory as far as the local depths allow. The bucket may
+ * have been refilled or merged by others in the meantime, so everything is
+ * checked again under the directory write latch.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::Merge(uint32_t hash) {
+  auto directory_page = FetchDirectoryPage(hash, false);
+  directory_page->WLatch();
+  auto directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  auto is_dirty = false;
+  while (true) {
+    auto bucket_ind = directory->HashToBucketIndex(hash);
+    auto local_depth = directory->GetLocalDepth(bucket_ind);
+    if (local_depth == 0) {
+      break;
+    }
+    auto image_ind = directory->GetSplitImageIndex(bucket_ind);
+    if (directory->GetLocalDepth(image_ind) != local_depth) {
+      break;
+    }
+
+    // inserts and removes that got past the directory before it was latched may still hold the buckets
+    auto bucket_page_id = directory->GetBucketPageId(bucket_ind);
+    auto image_page_id = directory->GetBucketPageId(image_ind);
+    auto bucket_page = FetchPage(bucket_page_id);
+    auto image_page = FetchPage(image_page_id);
+    bucket_page->WLatch();
+    image_page->WLatch();
+    auto bucket = reinterpret_cast<BucketPage *>(bucket_page->GetData());
+    auto image = reinterpret_cast<BucketPage *>(image_page->GetData());
+    auto is_bucket_empty = bucket->IsEmpty();
+    auto is_image_empty = image->IsEmpty();
+    // overflow pages are only allowed at the maximum depth, so a bucket that has them stays there
+    auto has_overflow = bucket->GetNextPageId() != INVALID_PAGE_ID || image->GetNextPageId() != INVALID_PAGE_ID;
+    image_page->WUnlatch();
+    bucket_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(image_page_id, false);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    if ((!is_bucket_empty && !is_image_empty) || has_overflow) {
+      break;
+    }
+
+    auto merged_page_id = is_bucket_empty ? image_page_id : bucket_page_id;
+    for (uint32_t i = 0; i < directory->Size(); ++i) {
+      auto page_id = directory->GetBucketPageId(i);
+      if (page_id == bucket_page_id || page_id == image_page_id) {
+        directory->SetBucketPageId(i, merged_page_id);
+        directory->SetLocalDepth(i, local_depth - 1);
+      }
+    }
+    DeleteBucketPage(is_bucket_empty ? bucket_page_id : image_page_id);
+    is_dirty = true;
+  }
+
+  while (directory->CanShrink()) {
+    directory->DecrGlobalDepth();
+    is_dirty = true;
+  }
+  directory_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), is_dirty);
+}
+
+/*****************************************************************************
+ * OVERFLOW CHAINS
+ *****************************************************************************/
+/*
+ * Collect the values of key from a latched bucket and its overflow pages
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::GetChainValue(BucketPage *bucket, const KeyType &key, std::vector<ValueType> *result) {
+  auto found = bucket->GetValue(key, comparator_, result);
+  for (auto page_id = bucket->GetNextPageId(); page_id != INVALID_PAGE_ID;) {
+    auto overflow = reinterpret_cast<BucketPage *>(FetchPage(page_id)->GetData());
+    found = overflow->GetValue(key, comparator_, result) || found;
+    auto next_page_id = overflow->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return found;
+}
+
+/*
+ * Insert into a write latched bucket or its overflow pages. Removals keep all
+ * pages but the last one full, so the pair goes to the last page, or to a new
+ * overflow page if can_grow is set.
+ * @return: false if the chain is full and cannot grow, otherwise is_inserted
+ * tells whether the pair was inserted or exists already
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::InsertIntoChain(BucketPage *bucket, const KeyType &key, const ValueType &value,
+                                                 bool can_grow, bool *is_inserted) {
+  *is_inserted = false;
+  if (bucket->Contains(key, value, comparator_)) {
+    return true;
+  }
+
+  auto last = bucket;
+  auto last_page_id = INVALID_PAGE_ID;
+  while (last->GetNextPageId() != INVALID_PAGE_ID) {
+    auto next_page_id = last->GetNextPageId();
+    auto next = reinterpret_cast<BucketPage *>(FetchPage(next_page_id)->GetData());
+    if (last_page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(last_page_id, false);
+    }
+    last = next;
+    last_page_id = next_page_id;
+    if (last->Contains(key, value, comparator_)) {
+      buffer_pool_manager_->UnpinPage(last_page_id, false);
+      return true;
+    }
+  }
+
+  auto is_handled = true;
+  if (!last->IsFull()) {
+    *is_inserted = last->Insert(key, value, comparator_);
+  } else if (can_grow) {
+    page_id_t overflow_page_id;
+    auto overflow = reinterpret_cast<BucketPage *>(NewBucketPage(&overflow_page_id)->GetData());
+    overflow->Insert(key, value, comparator_);
+    buffer_pool_manager_->UnpinPage(overflow_page_id, true);
+    last->SetNextPageId(overflow_page_id);
+    *is_inserted = true;
+  } else {
+    is_handled = false;
+  }
+
+  if (last_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->UnpinPage(last_page_id, *is_inserted);
+  }
+  return is_handled;
+}
+
+/*
+ * Remove a pair from a write latched bucket or its overflow pages. The last
+ * pair of the chain fills the hole, so that only the last page has room and
+ * the bucket is only empty once its overflow pages are gone. An overflow page
+ * that becomes empty is unlinked and deleted.
+ * @return: true if the pair was in the chain
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::RemoveFromChain(BucketPage *bucket, const KeyType &key, const ValueType &value) {
+  auto is_removed = bucket->Remove(key, value, comparator_);
+  // the overflow pages in chain order, the page that held the pair (-1 for the bucket)
+  std::vector<page_id_t> chain;
+  auto holder_ind = is_removed ? -1 : -2;
+  for (auto page_id = bucket->GetNextPageId(); page_id != INVALID_PAGE_ID;) {
+    auto overflow = reinterpret_cast<BucketPage *>(FetchPage(page_id)->GetData());
+    auto is_holder = !is_removed && overflow->Remove(key, value, comparator_);
+    if (is_holder) {
+      is_removed = true;
+      holder_ind = static_cast<int>(chain.size());
+    }
+    chain.push_back(page_id);
+    page_id = overflow->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(chain.back(), is_holder);
+  }
+  if (!is_removed || chain.empty()) {
+    return is_removed;
+  }
+
+  auto last_page_id = chain.back();
+  auto last = reinterpret_cast<BucketPage *>(FetchPage(last_page_id)->GetData());
+  if (holder_ind != static_cast<int>(chain.size()) - 1) {
+    auto holder = bucket;
+    if (holder_ind >= 0) {
+      holder = reinterpret_cast<BucketPage *>(FetchPage(chain[holder_ind])->GetData());
+    }
+    holder->Insert(last->KeyAt(last->Size() - 1), last->ValueAt(last->Size() - 1), comparator_);
+    last->RemoveAt(last->Size() - 1);
+    if (holder_ind >= 0) {
+      buffer_pool_manager_->UnpinPage(chain[holder_ind], true);
+    }
+  }
+
+  auto is_last_empty = last->IsEmpty();
+  buffer_pool_manager_->UnpinPage(last_page_id, true);
+  if (is_last_empty) {
+    if (chain.size() == 1) {
+      bucket->SetNextPageId(INVALID_PAGE_ID);
+    } else {
+      auto prev_page_id = chain[chain.size() - 2];
+      reinterpret_cast<BucketPage *>(FetchPage(prev_page_id)->GetData())->SetNextPageId(INVALID_PAGE_ID);
+      buffer_pool_manager_->UnpinPage(prev_page_id, true);
+    }
+    DeleteBucketPage(last_page_id);
+  }
+  return true;
+}
+
+/*****************************************************************************
+ * UTILITIES
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::GetGlobalDepth(const KeyType &key) {
+  auto directory_page = FetchDirectoryPage(Hash(key), false);
+  if (directory_page == nullptr) {
+    return 0;
+  }
+
+  directory_page->RLatch();
+  auto global_depth = reinterpret_cast<DirectoryPage *>(directory_page->GetData())->GetGlobalDepth();
+  directory_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), false);
+  return global_depth;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::VerifyIntegrity() {
+  auto header_page = FetchPage(header_page_id_);
+  header_page->RLatch();
+  auto header = reinterpret_cast<HeaderPage *>(header_page->GetData());
+  auto is_consistent = true;
+  for (uint32_t directory_ind = 0; directory_ind < header->MaxSize() && is_consistent; ++directory_ind) {
+    auto directory_page_id = header->GetDirectoryPageId(directory_ind);
+    if (directory_page_id == INVALID_PAGE_ID) {
+      continue;
+    }
+
+    auto directory_page = FetchPage(directory_page_id);
+    directory_page->RLatch();
+    auto directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+    // bucket page id -> (local depth, number of slots)
+    std::unordered_map<page_id_t, std::pair<uint32_t, uint32_t>> buckets;
+    for (uint32_t i = 0; i < directory->Size(); ++i) {
+      auto local_depth = directory->GetLocalDepth(i);
+      auto &bucket = buckets.emplace(directory->GetBucketPageId(i), std::make_pair(local_depth, 0)).first->second;
+      ++bucket.second;
+      is_consistent = is_consistent && local_depth <= directory->GetGlobalDepth() && bucket.first == local_depth &&
+                      directory->GetBucketPageId(i & ((1U << local_depth) - 1)) == directory->GetBucketPageId(i);
+    }
+    for (const auto &bucket : buckets) {
+      is_consistent =
+          is_consistent && bucket.second.second == 1U << (directory->GetGlobalDepth() - bucket.second.first);
+    }
+    directory_page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  }
+
+  header_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  return is_consistent;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::Hash(const KeyType &key) {
+  return static_cast<uint32_t>(hash_fn_.GetHash(key));
+}
+
+/*
+ * Delete a bucket page that is no longer reachable. Readers and writers that
+ * got past the directory before it changed may still have it pinned, then the
+ * delete fails and is retried by later removes.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::DeleteBucketPage(page_id_t page_id) {
+  if (!buffer_pool_manager_->DeletePage(page_id)) {
+    std::lock_guard<std::mutex> latch(pending_deletes_latch_);
+    pending_deletes_.push_back(page_id);
+    has_pending_deletes_ = true;
+  }
+  DeletePendingPages();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::DeletePendingPages() {
+  std::unique_lock<std::mutex> latch(pending_deletes_latch_, std::try_to_lock);
+  if (!latch.owns_lock()) {
+    return;
+  }
+
+  auto is_deleted = [this](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); };
+  pending_deletes_.erase(std::remove_if(pending_deletes_.begin(), pending_deletes_.end(), is_deleted),
+                         pending_deletes_.end());
+  has_pending_deletes_ = !pending_deletes_.empty();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *EXTENDIBLE_HASH_TABLE_TYPE::FetchPage(page_id_t page_id) {
+  auto page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  return page;
+}
+
+/*
+ * Allocate an empty bucket page, it is returned pinned
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *EXTENDIBLE_HASH_TABLE_TYPE::NewBucketPage(page_id_t *bucket_page_id) {
+  auto bucket_page = buffer_pool_manager_->NewPage(bucket_page_id);
+  if (bucket_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate a hash table bucket page");
+  }
+
+  reinterpret_cast<BucketPage *>(bucket_page->GetData())->Init();
+  return bucket_page;
+}
+
+/*
+ * Fetch the directory page of hash, creating it with a single empty bucket if
+ * create is set. Directory pages are never deleted, so the header is released
+ * before the directory is latched.
+ * @return: the pinned directory page, nullptr if it does not exist
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *EXTENDIBLE_HASH_TABLE_TYPE::FetchDirectoryPage(uint32_t hash, bool create) {
+  auto header_page = FetchPage(header_page_id_);
+  auto header = reinterpret_cast<HeaderPage *>(header_page->GetData());
+  header_page->RLatch();
+  auto directory_ind = header->HashToDirectoryIndex(hash);
+  auto directory_page_id = header->GetDirectoryPageId(directory_ind);
+  header_page->RUnlatch();
+
+  auto is_dirty = false;
+  if (directory_page_id == INVALID_PAGE_ID && create) {
+    header_page->WLatch();
+    directory_page_id = header->GetDirectoryPageId(directory_ind);
+    if (directory_page_id == INVALID_PAGE_ID) {
+      page_id_t bucket_page_id;
+      NewBucketPage(&bucket_page_id);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      auto directory_page = buffer_pool_manager_->NewPage(&directory_page_id);
+      if (directory_page == nullptr) {
+        header_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(header_page_id_, false);
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate a hash table directory page");
+      }
+
+      reinterpret_cast<DirectoryPage *>(directory_page->GetData())
+          ->Init(directory_page_id, bucket_page_id, directory_max_depth_);
+      buffer_pool_manager_->UnpinPage(directory_page_id, true);
+      header->SetDirectoryPageId(directory_ind, directory_page_id);
+      is_dirty = true;
+    }
+    header_page->WUnlatch();
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, is_dirty);
+
+  return directory_page_id == INVALID_PAGE_ID ? nullptr : FetchPage(directory_page_id);
+}
+
+template class ExtendibleHashTable<int, int, IntComparator>;
+
+template class ExtendibleHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -22,55 +23,603 @@
 
 namespace bustub {
 
-template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
 HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
                                       HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  auto num_blocks = (num_buckets + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  header_page_id_ = CreateTable(std::min(std::max<size_t>(num_blocks, 1), HASH_TABLE_MAX_BLOCKS));
+}
+
+/*
+ * Helper function to switch between stop-the-world resizes (default) and
+ * incremental ones, which split the old layout into the new one a block at a
+ * time
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+void HASH_TABLE_TYPE::SetIncrementalResize(bool incremental_resize) {
+  incremental_resize_ = incremental_resize;
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
-template <typename KeyType, typename ValueType, typename KeyComparator>
+/*
+ * While a resize is split incrementally, the old layout is read before the new
+ * one. A split moves a pair to the new layout before it removes it from the old
+ * one, so the pair is found in at least one of them.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+  auto hash = hash_fn_.GetHash(key);
+  table_latch_.RLock();
+  auto header = FetchHeaderPage(header_page_id_);
+  auto old_header = old_header_page_id_ == INVALID_PAGE_ID ? nullptr : FetchHeaderPage(old_header_page_id_);
+  auto begin = result->size();
+  size_t num_old_values = 0;
+  for (auto layout : {old_header, header}) {
+    if (layout == nullptr) {
+      continue;
+    }
+
+    ProbeKey(layout, hash, false, [&](BlockPage *block, slot_offset_t slot) {
+      if (!block->IsOccupied(slot)) {
+        return false;
+      }
+      if (block->IsReadable(slot) && comparator_(block->KeyAt(slot), key) == 0) {
+        // a pair that was split while it was read is in both layouts
+        auto value = block->ValueAt(slot);
+        auto old_values_end = result->begin() + begin + num_old_values;
+        if (layout == old_header || std::find(result->begin() + begin, old_values_end, value) == old_values_end) {
+          result->push_back(value);
+        }
+      }
+      return true;
+    });
+    num_old_values = result->size() - begin;
+  }
+  if (old_header != nullptr) {
+    buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  table_latch_.RUnlock();
+
+  return result->size() > begin;
 }
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
-template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  auto hash = hash_fn_.GetHash(key);
+  while (true) {
+    table_latch_.RLock();
+    auto header = FetchHeaderPage(header_page_id_);
+    auto size = header->GetSize();
+    auto can_grow = header->NumBlocks() < HASH_TABLE_MAX_BLOCKS;
+    // grow, or rebuild at the same size if tombstones take up much of the table
+    auto is_full = static_cast<double>(num_occupied_.load()) >= MAX_LOAD_FACTOR * static_cast<double>(size);
+    auto is_sparse = 2 * num_pairs_.load() < size;
+    if (is_full && (can_grow || is_sparse)) {
+      buffer_pool_manager_->UnpinPage(header_page_id_, false);
+      table_latch_.RUnlock();
+      Rehash(size, is_sparse ? size : 2 * size);
+      continue;
+    }
+
+    // writers of the key wait for each other on the page of its bucket, in the old layout while it is split
+    auto old_header = old_header_page_id_ == INVALID_PAGE_ID ? nullptr : FetchHeaderPage(old_header_page_id_);
+    auto home_layout = old_header == nullptr ? header : old_header;
+    auto home_page = FetchBlockPage(home_layout, BucketOf(home_layout, hash) / BLOCK_SIZE);
+    home_page->WLatch();
+    // a pair whose block is not split yet is in the old layout
+    auto is_duplicate = old_header != nullptr && FindPair(old_header, key, value, hash, false);
+    auto is_inserted = false;
+    if (!is_duplicate) {
+      ProbeKey(header, hash, true, [&](BlockPage *block, slot_offset_t slot) {
+        if (!block->IsOccupied(slot)) {
+          // the slot ends the probe sequence, unless a writer of another key claims it first
+          is_inserted = InsertAt(block, slot, key, value, hash);
+          return !is_inserted;
+        }
+        is_duplicate = block->IsReadable(slot) && comparator_(block->KeyAt(slot), key) == 0 &&
+                       block->ValueAt(slot) == value;
+        return !is_duplicate;
+      });
+    }
+    if (is_inserted) {
+      num_occupied_++;
+      num_pairs_++;
+    }
+    home_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(home_page->GetPageId(), false);
+    if (old_header != nullptr) {
+      buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+    }
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+    table_latch_.RUnlock();
+
+    // inserts split the old layout bit by bit
+    if (old_header != nullptr) {
+      SplitNextBlock();
+    }
+    if (is_inserted || is_duplicate || !can_grow) {
+      return is_inserted;
+    }
+    // every slot is occupied
+    Rehash(size, 2 * size);
+  }
 }
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
-template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  auto hash = hash_fn_.GetHash(key);
+  table_latch_.RLock();
+  auto header = FetchHeaderPage(header_page_id_);
+  auto old_header = old_header_page_id_ == INVALID_PAGE_ID ? nullptr : FetchHeaderPage(old_header_page_id_);
+  auto home_layout = old_header == nullptr ? header : old_header;
+  auto home_page = FetchBlockPage(home_layout, BucketOf(home_layout, hash) / BLOCK_SIZE);
+  home_page->WLatch();
+  auto is_removed = (old_header != nullptr && FindPair(old_header, key, value, hash, true)) ||
+                    FindPair(header, key, value, hash, true);
+  if (is_removed) {
+    num_pairs_--;
+  }
+  home_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(home_page->GetPageId(), false);
+  if (old_header != nullptr) {
+    buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  table_latch_.RUnlock();
+
+  return is_removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
-template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+/*
+ * Nothing happens if the table has grown to that size already, e.g. because a
+ * concurrent insert resized it first
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+void HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  auto size = GetSize();
+  if (size < 2 * initial_size) {
+    Rehash(size, 2 * initial_size);
+  }
+}
+
+/*
+ * Move the pairs of a table of size buckets into a new one of num_buckets
+ * buckets, which leaves the tombstones behind. Nothing happens if a concurrent
+ * rehash got to the table first: it is of another size by now, or it is no
+ * longer full if it is rebuilt at its size.
+ *
+ * With incremental resizes, the new layout starts out empty and the current
+ * one becomes the old layout, which inserts split into the new one (see
+ * SplitNextBlock). A split that is still running is finished first.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+void HASH_TABLE_TYPE::Rehash(size_t size, size_t num_buckets) {
+  table_latch_.WLock();
+  FinishSplits();
+  auto header = FetchHeaderPage(header_page_id_);
+  auto num_blocks = std::min((num_buckets + BLOCK_SIZE - 1) / BLOCK_SIZE, HASH_TABLE_MAX_BLOCKS);
+  auto is_full = static_cast<double>(num_occupied_.load()) >= MAX_LOAD_FACTOR * static_cast<double>(size);
+  if (header->GetSize() != size || (header->NumBlocks() >= num_blocks && !is_full)) {
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+    table_latch_.WUnlock();
+    return;
+  }
+
+  auto old_header_page_id = header_page_id_;
+  header_page_id_ = CreateTable(num_blocks);
+  if (incremental_resize_ && old_header_page_id_ == INVALID_PAGE_ID) {
+    buffer_pool_manager_->UnpinPage(old_header_page_id, false);
+    old_header_page_id_ = old_header_page_id;
+    split_block_ = 0;
+    num_split_blocks_ = 0;
+    is_split_failed_ = false;
+    num_occupied_ = 0;
+    table_latch_.WUnlock();
+    return;
+  }
+
+  auto new_header = FetchHeaderPage(header_page_id_);
+  size_t num_occupied = 0;
+  // the keys of a block are hashed as a batch before its pairs are moved
+  std::vector<KeyType> keys(BLOCK_SIZE);
+  std::vector<ValueType> values(BLOCK_SIZE);
+  std::vector<uint64_t> hashes(BLOCK_SIZE);
+  for (size_t block_ind = 0; block_ind < header->NumBlocks(); ++block_ind) {
+    auto page = FetchBlockPage(header, block_ind);
+    auto block = reinterpret_cast<BlockPage *>(page->GetData());
+    size_t num_pairs = 0;
+    for (slot_offset_t slot = 0; slot < BLOCK_SIZE; ++slot) {
+      if (block->IsReadable(slot)) {
+        keys[num_pairs] = block->KeyAt(slot);
+        values[num_pairs++] = block->ValueAt(slot);
+      }
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+
+    hash_fn_.GetHashes(keys.data(), num_pairs, hashes.data());
+    for (size_t i = 0; i < num_pairs; ++i) {
+      InsertPair(new_header, keys[i], values[i], hashes[i]);
+    }
+    num_occupied += num_pairs;
+  }
+
+  DeleteTable(header);
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  num_occupied_ = num_occupied;
+  table_latch_.WUnlock();
+}
+
+/*
+ * Split the block of the old layout at the split pointer. The split that
+ * finishes the old layout drops it. A block whose pairs do not fit into the
+ * new layout is not counted, and once the split pointer is past the end, the
+ * next round splits the old layout from the start again.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+void HASH_TABLE_TYPE::SplitNextBlock() {
+  table_latch_.RLock();
+  if (old_header_page_id_ == INVALID_PAGE_ID) {
+    table_latch_.RUnlock();
+    return;
+  }
+
+  auto old_header = FetchHeaderPage(old_header_page_id_);
+  auto num_blocks = old_header->NumBlocks();
+  auto block_ind = split_block_++;
+  auto is_done = false;
+  auto is_restart = false;
+  if (block_ind < num_blocks) {
+    auto header = FetchHeaderPage(header_page_id_);
+    if (SplitBlock(old_header, header, block_ind)) {
+      is_done = ++num_split_blocks_ == num_blocks;
+    } else {
+      is_split_failed_ = true;
+    }
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  } else {
+    is_restart = is_split_failed_;
+  }
+  buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+  table_latch_.RUnlock();
+
+  if (is_done) {
+    table_latch_.WLock();
+    FinishSplits();
+    table_latch_.WUnlock();
+  } else if (is_restart) {
+    table_latch_.WLock();
+    // another split may have started the next round already
+    if (old_header_page_id_ != INVALID_PAGE_ID && split_block_ >= num_blocks && is_split_failed_) {
+      split_block_ = 0;
+      num_split_blocks_ = 0;
+      is_split_failed_ = false;
+    }
+    table_latch_.WUnlock();
+  }
+}
+
+/*
+ * Move the pairs whose bucket is in a block of the old layout to the new one.
+ * They are found from the start of the block on until the first free slot past
+ * its end. The block's page is write latched, so writers of their keys wait.
+ * @return: false if the new layout ran out of slots, which leaves the rest of
+ * the pairs behind
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+bool HASH_TABLE_TYPE::SplitBlock(HashTableHeaderPage *old_header, HashTableHeaderPage *header, size_t block_ind) {
+  auto home_page = FetchBlockPage(old_header, block_ind);
+  home_page->WLatch();
+  size_t num_visited = 0;
+  auto is_moved = true;
+  Probe(old_header, block_ind * BLOCK_SIZE, true, [&](BlockPage *block, slot_offset_t slot) {
+    auto is_in_block = num_visited++ < BLOCK_SIZE;
+    if (!block->IsOccupied(slot)) {
+      return is_in_block;
+    }
+    if (!block->IsReadable(slot)) {
+      return true;
+    }
+    auto key = block->KeyAt(slot);
+    auto hash = hash_fn_.GetHash(key);
+    if (BucketOf(old_header, hash) / BLOCK_SIZE == block_ind) {
+      // the new layout gets the pair before readers miss it in the old one
+      if (!InsertPair(header, key, block->ValueAt(slot), hash)) {
+        is_moved = false;
+        return false;
+      }
+      num_occupied_++;
+      block->Remove(slot);
+    }
+    return true;
+  });
+  home_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(home_page->GetPageId(), false);
+
+  return is_moved;
+}
+
+/*
+ * Split the blocks of the old layout that are left and drop it. Blocks behind
+ * the split pointer are split again if one of them failed. If the new layout
+ * runs out of slots, the old layout keeps the rest of its pairs and is split
+ * from the start again later, after the new layout is resized. table_latch_
+ * has to be held exclusively.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+void HASH_TABLE_TYPE::FinishSplits() {
+  if (old_header_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+
+  auto old_header = FetchHeaderPage(old_header_page_id_);
+  auto header = FetchHeaderPage(header_page_id_);
+  auto is_moved = true;
+  auto begin = is_split_failed_ ? 0 : split_block_.load();
+  for (auto block_ind = begin; block_ind < old_header->NumBlocks() && is_moved; ++block_ind) {
+    is_moved = SplitBlock(old_header, header, block_ind);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+
+  if (!is_moved) {
+    buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+    split_block_ = 0;
+    num_split_blocks_ = 0;
+    is_split_failed_ = false;
+    return;
+  }
+
+  DeleteTable(old_header);
+  old_header_page_id_ = INVALID_PAGE_ID;
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
-template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
 size_t HASH_TABLE_TYPE::GetSize() {
-  return 0;
+  table_latch_.RLock();
+  auto size = FetchHeaderPage(header_page_id_)->GetSize();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  table_latch_.RUnlock();
+
+  return size;
+}
+
+/*****************************************************************************
+ * UTILITIES
+ *****************************************************************************/
+/*
+ * Allocate the header page and num_blocks empty block pages of a table
+ * @return: the page id of the header page
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+page_id_t HASH_TABLE_TYPE::CreateTable(size_t num_blocks) {
+  page_id_t header_page_id;
+  auto header_page = buffer_pool_manager_->NewPage(&header_page_id);
+  if (header_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate a hash table header page");
+  }
+
+  auto header = reinterpret_cast<HashTableHeaderPage *>(header_page->GetData());
+  header->SetPageId(header_page_id);
+  header->SetSize(num_blocks * BLOCK_SIZE);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    page_id_t block_page_id;
+    if (buffer_pool_manager_->NewPage(&block_page_id) == nullptr) {
+      buffer_pool_manager_->UnpinPage(header_page_id, true);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate a hash table block page");
+    }
+
+    header->AddBlockPageId(block_page_id);
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+  }
+
+  buffer_pool_manager_->UnpinPage(header_page_id, true);
+  return header_page_id;
+}
+
+/*
+ * Delete the block pages and the pinned header page of a table that is no
+ * longer reachable
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+void HASH_TABLE_TYPE::DeleteTable(HashTableHeaderPage *header) {
+  for (size_t block_ind = 0; block_ind < header->NumBlocks(); ++block_ind) {
+    buffer_pool_manager_->DeletePage(header->GetBlockPageId(block_ind));
+  }
+  auto header_page_id = header->GetPageId();
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  buffer_pool_manager_->DeletePage(header_page_id);
+}
+
+/*
+ * The header pages only change while table_latch_ is held exclusively, so they
+ * are read without a latch
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+HashTableHeaderPage *HASH_TABLE_TYPE::FetchHeaderPage(page_id_t header_page_id) {
+  auto page = buffer_pool_manager_->FetchPage(header_page_id);
+  if (page == nullptr) {
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  return reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+Page *HASH_TABLE_TYPE::FetchBlockPage(HashTableHeaderPage *header, size_t block_ind) {
+  auto page = buffer_pool_manager_->FetchPage(header->GetBlockPageId(block_ind));
+  if (page == nullptr) {
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  return page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+size_t HASH_TABLE_TYPE::BucketOf(HashTableHeaderPage *header, uint64_t hash) {
+  return hash % header->GetSize();
+}
+
+/*
+ * Find a pair in a layout and remove it if is_remove
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+bool HASH_TABLE_TYPE::FindPair(HashTableHeaderPage *header, const KeyType &key, const ValueType &value,
+                               uint64_t hash, bool is_remove) {
+  auto is_found = false;
+  ProbeKey(header, hash, is_remove, [&](BlockPage *block, slot_offset_t slot) {
+    if (!block->IsOccupied(slot)) {
+      return false;
+    }
+    is_found = block->IsReadable(slot) && comparator_(block->KeyAt(slot), key) == 0 && block->ValueAt(slot) == value;
+    if (is_found && is_remove) {
+      block->Remove(slot);
+    }
+    return !is_found;
+  });
+
+  return is_found;
+}
+
+/*
+ * Put a pair into the first free slot of its probe sequence in a layout,
+ * without looking for a duplicate
+ * @return: false if every slot is occupied
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+bool HASH_TABLE_TYPE::InsertPair(HashTableHeaderPage *header, const KeyType &key, const ValueType &value,
+                                 uint64_t hash) {
+  auto is_inserted = false;
+  ProbeKey(header, hash, true, [&](BlockPage *block, slot_offset_t slot) {
+    is_inserted = InsertAt(block, slot, key, value, hash);
+    return !is_inserted;
+  });
+
+  return is_inserted;
+}
+
+/*
+ * Claim a slot for a pair, tagged blocks store the tag of its hash as well
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+bool HASH_TABLE_TYPE::InsertAt(BlockPage *block, slot_offset_t slot, const KeyType &key, const ValueType &value,
+                               uint64_t hash) {
+  if constexpr (IS_TAGGED) {
+    return block->Insert(slot, key, value, BlockPage::TagOf(hash));
+  } else {
+    return block->Insert(slot, key, value);
+  }
+}
+
+/*
+ * Walk the slots from a bucket on, wrapping around at the end of the table,
+ * and call visit(block, slot) on each until it returns false. The block pages
+ * are pinned but not latched.
+ * @return: false if visit went through every slot of the table
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+template <typename Visitor>
+bool HASH_TABLE_TYPE::Probe(HashTableHeaderPage *header, size_t bucket, bool is_write, Visitor visit) {
+  auto size = header->GetSize();
+  Page *page = nullptr;
+  for (size_t i = 0; i < size; ++i) {
+    auto ind = (bucket + i) % size;
+    auto slot = static_cast<slot_offset_t>(ind % BLOCK_SIZE);
+    if (page == nullptr || slot == 0) {
+      if (page != nullptr) {
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), is_write);
+      }
+      page = FetchBlockPage(header, ind / BLOCK_SIZE);
+    }
+
+    if (!visit(reinterpret_cast<BlockPage *>(page->GetData()), slot)) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), is_write);
+      return true;
+    }
+  }
+
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), is_write);
+  return false;
+}
+
+/*
+ * Probe the slots of a key from its bucket on like Probe, which visits only the
+ * ones that may hold the key or end its probe sequence. In tagged blocks those
+ * are the slots that hold the tag of the key or are free, and they are found a
+ * group at a time. The slots a group loads past the end of the block or of the
+ * probe sequence are masked off.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, typename BlockPage>
+template <typename Visitor>
+bool HASH_TABLE_TYPE::ProbeKey(HashTableHeaderPage *header, uint64_t hash, bool is_write, Visitor visit) {
+  if constexpr (!IS_TAGGED) {
+    return Probe(header, BucketOf(header, hash), is_write, visit);
+  } else {
+    auto bucket = BucketOf(header, hash);
+    auto tag = BlockPage::TagOf(hash);
+    auto size = header->GetSize();
+    Page *page = nullptr;
+    for (size_t i = 0; i < size;) {
+      auto ind = (bucket + i) % size;
+      auto slot = static_cast<slot_offset_t>(ind % BLOCK_SIZE);
+      if (page == nullptr || slot == 0) {
+        if (page != nullptr) {
+          buffer_pool_manager_->UnpinPage(page->GetPageId(), is_write);
+        }
+        page = FetchBlockPage(header, ind / BLOCK_SIZE);
+      }
+
+      auto block = reinterpret_cast<BlockPage *>(page->GetData());
+      auto num_slots = std::min<size_t>({BlockPage::GROUP_SIZE, BLOCK_SIZE - slot, size - i});
+      auto matches = block->MatchTagOrEmpty(slot, tag);
+      if (num_slots < 32) {
+        matches &= (1U << num_slots) - 1;
+      }
+      for (; matches != 0; matches &= matches - 1) {
+        if (!visit(block, slot + __builtin_ctz(matches))) {
+          buffer_pool_manager_->UnpinPage(page->GetPageId(), is_write);
+          return true;
+        }
+      }
+      i += num_slots;
+    }
+
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_write);
+    return false;
+  }
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
+template class LinearProbeHashTable<int, int, IntComparator, HashTableTaggedBlockPage<int, int, IntComparator>>;
 
 template class LinearProbeHashTable<GenericKey<4>, RID, GenericComparator<4>>;
 template class LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>>;
 template class LinearProbeHashTable<GenericKey<16>, RID, GenericComparator<16>>;
 template class LinearProbeHashTable<GenericKey<32>, RID, GenericComparator<32>>;
 template class LinearProbeHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+template class LinearProbeHashTable<GenericKey<4>, RID, GenericComparator<4>,
+                                    HashTableTaggedBlockPage<GenericKey<4>, RID, GenericComparator<4>>>;
+template class LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>,
+                                    HashTableTaggedBlockPage<GenericKey<8>, RID, GenericComparator<8>>>;
+template class LinearProbeHashTable<GenericKey<16>, RID, GenericComparator<16>,
+                                    HashTableTaggedBlockPage<GenericKey<16>, RID, GenericComparator<16>>>;
+template class LinearProbeHashTable<GenericKey<32>, RID, GenericComparator<32>,
+                                    HashTableTaggedBlockPage<GenericKey<32>, RID, GenericComparator<32>>>;
+template class LinearProbeHashTable<GenericKey<64>, RID, GenericComparator<64>,
+                                    HashTableTaggedBlockPage<GenericKey<64>, RID, GenericComparator<64>>>;
 
 }  // namespace bustub
@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
 
+#include "buffer/clock_replacer.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
@@ -30,14 +32,18 @@ class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Replacement policies the buffer pool can be configured with. */
+  enum class ReplacerType { LRU, CLOCK };
 
   /**
    * Creates a new BufferPoolManager.
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
    */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                    ReplacerType replacer_type = ReplacerType::LRU);
 
   /**
    * Destroys an existing BufferPoolManager.
@@ -97,6 +103,24 @@ class BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() { return pool_size_; }
 
+  /**
+   * Check whether a page is in the buffer pool, i.e. could be fetched without reading it from disk.
+   * The page may be evicted right after, so the answer is only a hint.
+   * @param page_id id of the page to look for
+   * @return true if the page is in the page table
+   */
+  bool IsPageResident(page_id_t page_id);
+
+  /**
+   * Looks up a page without pinning it or taking the buffer pool latch, for optimistic readers. The frame may be reused
+   * for another page at any time, and writers may still modify the page, so anything read from it has to be validated
+   * against the returned version. The version is read while the frame held the page, and reusing the frame bumps it.
+   * @param page_id id of the page to look for
+   * @param[out] version the version of the frame while it held the page
+   * @return the frame of the page, or nullptr if it is not resident (or was not found, which is rare)
+   */
+  Page *FindResidentPage(page_id_t page_id, uint64_t *version);
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -152,6 +176,14 @@ class BufferPoolManager {
    */
   void FlushAllPagesImpl();
 
+  /** Makes a frame findable by FindResidentPage(). */
+  void MapFrame(page_id_t page_id, frame_id_t frame_id);
+
+  /** Hides a frame from FindResidentPage() and bumps its version, so that readers that found it fail to validate. */
+  void UnmapFrame(frame_id_t frame_id);
+
+  static constexpr uint64_t NO_RESIDENT_PAGE = ~0ULL;
+
   /** Number of pages in the buffer pool. */
   size_t pool_size_;
   /** Array of buffer pool pages. */
@@ -168,5 +200,11 @@ class BufferPoolManager {
   std::list<frame_id_t> free_list_;
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
+  /**
+   * Direct-mapped copy of the page table for FindResidentPage(), indexed by the low bits of the page id. An entry
+   * holds the page id in its upper and the frame id in its lower half. Only written under latch_.
+   */
+  std::atomic<uint64_t> *resident_pages_;
+  size_t resident_pages_mask_;
 };
 }  // namespace bustub
@@ -46,7 +46,15 @@ class ClockReplacer : public Replacer {
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  /** in_replacer_[i] is true iff frame i is unpinned and can be victimized. */
+  std::vector<bool> in_replacer_;
+  /** Reference bit of every frame, set on unpin and cleared as the clock hand sweeps past. */
+  std::vector<bool> ref_flags_;
+  /** Position of the clock hand. */
+  size_t clock_hand_{0};
+  /** Number of frames that are currently in the replacer. */
+  size_t size_{0};
+  std::mutex latch_;
 };
 
 }  // namespace bustub
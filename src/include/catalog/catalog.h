@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -33,6 +36,20 @@ struct TableMetadata {
   table_oid_t oid_;
 };
 
+/**
+ * Side log of an index that is being built, see Catalog::CreateIndex. Until the index is published, writers of the
+ * table append their changes to the index here instead.
+ */
+struct IndexBuildLog {
+  struct Record {
+    WType wtype_;
+    Tuple key_;
+    RID rid_;
+  };
+  std::mutex latch_;
+  std::vector<Record> records_;
+};
+
 /**
  * Metadata about a index
  */
@@ -51,6 +68,10 @@ struct IndexInfo {
   index_oid_t index_oid_;
   std::string table_name_;
   const size_t key_size_;
+  /** The statistics of the last Catalog::AnalyzeIndex, empty before */
+  IndexStats stats_;
+  /** The side log while the index is being built, nullptr once it is published */
+  std::unique_ptr<IndexBuildLog> build_log_;
 };
 
 /**
@@ -77,17 +98,28 @@ class Catalog {
    */
   TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
     BUSTUB_ASSERT(names_.count(table_name) == 0, "Table names should be unique!");
-    return nullptr;
+    auto table_oid = next_table_oid_++;
+    auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn);
+    auto &table_metadata = tables_[table_oid];
+    table_metadata = std::make_unique<TableMetadata>(schema, table_name, std::move(table), table_oid);
+    names_[table_name] = table_oid;
+    return table_metadata.get();
   }
 
-  /** @return table metadata by name */
-  TableMetadata *GetTable(const std::string &table_name) { return nullptr; }
+  /** @return table metadata by name, throws std::out_of_range if there is no such table */
+  TableMetadata *GetTable(const std::string &table_name) { return tables_.at(names_.at(table_name)).get(); }
 
-  /** @return table metadata by oid */
-  TableMetadata *GetTable(table_oid_t table_oid) { return nullptr; }
+  /** @return table metadata by oid, throws std::out_of_range if there is no such table */
+  TableMetadata *GetTable(table_oid_t table_oid) { return tables_.at(table_oid).get(); }
 
   /**
    * Create a new index, populate existing data of the table and return its metadata.
+   *
+   * The index is built online: writers of the table go on, but log their changes to the index in a side log (see
+   * InsertIndexEntries) from the start of the build. A scan of the table is sorted externally, so the table does not
+   * have to fit in memory, and bulk loaded into the index. Then the side log is applied, which fixes up the tuples the
+   * scan saw before or after they changed. Only its last records are applied while writers wait, right before the
+   * index is published to GetTableIndexes.
    * @param txn the transaction in which the table is being created
    * @param index_name the name of the new index
    * @param table_name the name of the table
@@ -95,25 +127,200 @@ class Catalog {
    * @param key_schema the schema of the key
    * @param key_attrs key attributes
    * @param keysize size of the key
+   * @param include_attrs columns stored in the index next to the key (INCLUDE columns), which lets the index answer
+   * queries on them without fetching the tuples. Key and included columns have to fit into keysize together.
+   * @param is_unique whether the index keeps a single tuple per key, otherwise it keeps every tuple of a key
    * @return a pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
-                         size_t keysize) {
-    return nullptr;
+                         size_t keysize, const std::vector<uint32_t> &include_attrs = {}, bool is_unique = false) {
+    auto table_metadata = GetTable(table_name);
+    auto index_oid = next_index_oid_++;
+    auto index_metadata = new IndexMetadata(index_name, table_name, &schema, key_attrs, is_unique, include_attrs);
+    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(index_metadata, bpm_);
+    auto tree_index = index.get();
+
+    // from here on the writers of the table log their changes to the index
+    IndexInfo *index_info;
+    {
+      std::unique_lock<std::shared_mutex> latch(index_latch_);
+      auto &info = indexes_[index_oid];
+      info = std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+      info->build_log_ = std::make_unique<IndexBuildLog>();
+      index_builds_[table_name][index_name] = index_oid;
+      index_info = info.get();
+    }
+
+    // bulk load the tuples the scan sees, the index sorts them externally
+    auto &table = table_metadata->table_;
+    auto itr = table->Begin(txn);
+    tree_index->BulkLoad(
+        [&](Tuple *entry, RID *rid) {
+          if (itr == table->End()) {
+            return false;
+          }
+          *entry = itr->KeyFromTuple(schema, *tree_index->GetEntrySchema(), tree_index->GetEntryAttrs());
+          *rid = itr->GetRid();
+          ++itr;
+          return true;
+        },
+        txn);
+
+    // catch up with the side log while writers go on, then apply the rest and publish the index
+    while (ApplyBuildLog(index_info, txn) > BUILD_LOG_TAIL_SIZE) {
+    }
+    std::unique_lock<std::shared_mutex> latch(index_latch_);
+    ApplyBuildLog(index_info, txn);
+    index_info->build_log_.reset();
+    index_builds_[table_name].erase(index_name);
+    index_names_[table_name][index_name] = index_oid;
+    return index_info;
   }
 
-  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) { return nullptr; }
+  /** @return index metadata by name, throws std::out_of_range if there is no such index */
+  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) {
+    std::shared_lock<std::shared_mutex> latch(index_latch_);
+    return indexes_.at(index_names_.at(table_name).at(index_name)).get();
+  }
 
-  IndexInfo *GetIndex(index_oid_t index_oid) { return nullptr; }
+  /** @return index metadata by oid, throws std::out_of_range if there is no such index */
+  IndexInfo *GetIndex(index_oid_t index_oid) {
+    std::shared_lock<std::shared_mutex> latch(index_latch_);
+    return indexes_.at(index_oid).get();
+  }
 
-  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) { return std::vector<IndexInfo *>(); }
+  /**
+   * Collect the statistics of an index and keep them in its metadata.
+   * @param txn the transaction in which the index is analyzed
+   * @param index_oid the identifier of the index
+   * @param sample_rate fraction of the index entries to read, all of them by default
+   * @param num_buckets maximum number of buckets of the key histogram
+   * @return the new statistics of the index
+   */
+  const IndexStats &AnalyzeIndex(Transaction *txn, index_oid_t index_oid, double sample_rate = 1.0,
+                                 int num_buckets = 32) {
+    auto index_info = GetIndex(index_oid);
+    index_info->index_->CollectStats(&index_info->stats_, sample_rate, num_buckets, txn);
+    return index_info->stats_;
+  }
+
+  /**
+   * @return the published indexes of a table. Writers should go through InsertIndexEntries and DeleteIndexEntries
+   * instead, which reach indexes that are still being built as well.
+   */
+  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) {
+    std::shared_lock<std::shared_mutex> latch(index_latch_);
+    std::vector<IndexInfo *> index_infos;
+    auto itr = index_names_.find(table_name);
+    if (itr == index_names_.end()) {
+      return index_infos;
+    }
+    for (const auto &index_name : itr->second) {
+      index_infos.push_back(indexes_.at(index_name.second).get());
+    }
+    return index_infos;
+  }
+
+  /**
+   * Add the entries of a newly inserted tuple to the indexes of its table, including the ones being built.
+   * @param txn the transaction that inserted the tuple, the index writes go to its index write set unless nullptr
+   * @param table_name the name of the table
+   * @param tuple the tuple, of the table schema
+   * @param rid the rid of the tuple
+   */
+  void InsertIndexEntries(Transaction *txn, const std::string &table_name, const Tuple &tuple, RID rid) {
+    WriteIndexEntries(txn, table_name, tuple, rid, WType::INSERT);
+  }
+
+  /**
+   * Remove the entries of a deleted tuple from the indexes of its table, including the ones being built.
+   * @param txn the transaction that deleted the tuple, the index writes go to its index write set unless nullptr
+   * @param table_name the name of the table
+   * @param tuple the tuple, of the table schema
+   * @param rid the rid of the tuple
+   */
+  void DeleteIndexEntries(Transaction *txn, const std::string &table_name, const Tuple &tuple, RID rid) {
+    WriteIndexEntries(txn, table_name, tuple, rid, WType::DELETE);
+  }
+
+  /** Insert an entry into a single index, or into its side log while it is being built */
+  void InsertIndexEntry(Transaction *txn, IndexInfo *index_info, const Tuple &key, RID rid) {
+    std::shared_lock<std::shared_mutex> latch(index_latch_);
+    WriteIndexEntry(txn, index_info, key, rid, WType::INSERT);
+  }
+
+  /** Delete an entry from a single index, or log the deletion while it is being built */
+  void DeleteIndexEntry(Transaction *txn, IndexInfo *index_info, const Tuple &key, RID rid) {
+    std::shared_lock<std::shared_mutex> latch(index_latch_);
+    WriteIndexEntry(txn, index_info, key, rid, WType::DELETE);
+  }
 
  private:
-  [[maybe_unused]] BufferPoolManager *bpm_;
-  [[maybe_unused]] LockManager *lock_manager_;
-  [[maybe_unused]] LogManager *log_manager_;
+  void WriteIndexEntries(Transaction *txn, const std::string &table_name, Tuple tuple, RID rid, WType wtype) {
+    auto table_metadata = GetTable(table_name);
+    std::shared_lock<std::shared_mutex> latch(index_latch_);
+    for (auto names : {&index_names_, &index_builds_}) {
+      auto itr = names->find(table_name);
+      if (itr == names->end()) {
+        continue;
+      }
+      for (const auto &index_name : itr->second) {
+        auto index_info = indexes_.at(index_name.second).get();
+        auto index = index_info->index_.get();
+        WriteIndexEntry(txn, index_info, tuple.KeyFromTuple(table_metadata->schema_, *index->GetEntrySchema(),
+                                                            index->GetEntryAttrs()),
+                        rid, wtype);
+        if (txn != nullptr) {
+          txn->GetIndexWriteSet()->emplace_back(rid, table_metadata->oid_, wtype, tuple, index_info->index_oid_, this);
+        }
+      }
+    }
+  }
+
+  /** index_latch_ has to be held */
+  void WriteIndexEntry(Transaction *txn, IndexInfo *index_info, const Tuple &key, RID rid, WType wtype) {
+    if (index_info->build_log_ != nullptr) {
+      std::lock_guard<std::mutex> guard(index_info->build_log_->latch_);
+      index_info->build_log_->records_.push_back({wtype, key, rid});
+      return;
+    }
+
+    if (wtype == WType::INSERT) {
+      index_info->index_->InsertEntry(key, rid, txn);
+    } else {
+      index_info->index_->DeleteEntry(key, rid, txn);
+    }
+  }
+
+  /**
+   * Apply the records logged for an index being built so far.
+   * @return the number of records applied
+   */
+  size_t ApplyBuildLog(IndexInfo *index_info, Transaction *txn) {
+    std::vector<IndexBuildLog::Record> records;
+    {
+      std::lock_guard<std::mutex> guard(index_info->build_log_->latch_);
+      records.swap(index_info->build_log_->records_);
+    }
+
+    for (const auto &record : records) {
+      if (record.wtype_ == WType::INSERT) {
+        index_info->index_->InsertEntry(record.key_, record.rid_, txn);
+      } else {
+        index_info->index_->DeleteEntry(record.key_, record.rid_, txn);
+      }
+    }
+    return records.size();
+  }
+
+  /** Side logs shorter than this are applied while writers wait */
+  static constexpr size_t BUILD_LOG_TAIL_SIZE = 64;
+
+  BufferPoolManager *bpm_;
+  LockManager *lock_manager_;
+  LogManager *log_manager_;
 
   /** tables_ : table identifiers -> table metadata. Note that tables_ owns all table metadata. */
   std::unordered_map<table_oid_t, std::unique_ptr<TableMetadata>> tables_;
@@ -125,6 +332,10 @@ class Catalog {
   std::unordered_map<index_oid_t, std::unique_ptr<IndexInfo>> indexes_;
   /** index_names_: table name -> index names -> index identifiers */
   std::unordered_map<std::string, std::unordered_map<std::string, index_oid_t>> index_names_;
+  /** index_builds_: table name -> names of the indexes being built -> index identifiers */
+  std::unordered_map<std::string, std::unordered_map<std::string, index_oid_t>> index_builds_;
+  /** Protects the index maps and the side logs of IndexInfo, held exclusively to register and publish an index */
+  std::shared_mutex index_latch_;
   /** The next index identifier to be used */
   std::atomic<index_oid_t> next_index_oid_{0};
 };
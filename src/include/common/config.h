@@ -21,6 +21,15 @@ namespace bustub {
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
 extern std::chrono::milliseconds cycle_detection_interval;
 
+/** Underfull B+ tree pages left behind by relaxed deletes are merged every BACKGROUND_MERGE_INTERVAL milliseconds. */
+extern std::chrono::milliseconds background_merge_interval;
+
+/**
+ * True if B+ tree indexes with duplicate keys buffer changes to leaves that are not in the buffer pool, false (default)
+ * otherwise.
+ */
+extern std::atomic<bool> enable_change_buffering;
+
 /** True if logging should be enabled, false otherwise. */
 extern std::atomic<bool> enable_logging;
 
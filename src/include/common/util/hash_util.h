@@ -13,10 +13,16 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
 #include "common/macros.h"
 #include "type/value.h"
 
@@ -28,21 +34,86 @@ class HashUtil {
  private:
   static const hash_t prime_factor = 10000019;
 
+  // multipliers of wyhash
+  static constexpr uint64_t WY_P0 = 0xa0761d6478bd642fULL;
+  static constexpr uint64_t WY_P1 = 0xe7037ed1a0b428dbULL;
+  static constexpr uint64_t WY_P2 = 0x8ebc6af09c88c6e3ULL;
+
+  /** @return the xor of the halves of the 128-bit product of a and b */
+  static inline uint64_t Mum(uint64_t a, uint64_t b) {
+    auto product = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+  }
+
+  static inline uint64_t Read8(const char *bytes) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
+  static inline uint64_t Read4(const char *bytes) {
+    uint32_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
  public:
+  /**
+   * Hashes a fixed-width integer. With SSE4.2 each half of the hash is one
+   * CRC32C instruction, the upper half over the key with its halves swapped,
+   * so that both the low bits (bucket) and the high bits (tags) of the hash
+   * depend on the whole key.
+   * @return the hash of the integer
+   */
+  static inline hash_t HashInt(uint64_t key) {
+#ifdef __SSE4_2__
+    uint64_t lower = _mm_crc32_u64(static_cast<uint32_t>(WY_P0), key);
+    uint64_t upper = _mm_crc32_u64(static_cast<uint32_t>(WY_P1), (key << 32) | (key >> 32));
+    return static_cast<hash_t>((upper << 32) | lower);
+#else
+    // finalizer of MurmurHash3_x64_128
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return static_cast<hash_t>(key);
+#endif
+  }
+
+  /**
+   * Hashes a byte string a word at a time in the style of wyhash: every 16
+   * bytes are folded into the state with one 64x64->128 bit multiplication,
+   * and the last 1 to 16 bytes are read with (possibly overlapping) loads.
+   * @return the hash of the bytes
+   */
   static inline hash_t HashBytes(const char *bytes, size_t length) {
-    // https://github.com/greenplum-db/gpos/blob/b53c1acd6285de94044ff91fbee91589543feba1/libgpos/src/utils.cpp#L126
-    hash_t hash = length;
-    for (size_t i = 0; i < length; ++i) {
-      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+    uint64_t seed = WY_P0 ^ length;
+    size_t i = 0;
+    for (; i + 16 < length; i += 16) {
+      seed = Mum(Read8(bytes + i) ^ WY_P1, Read8(bytes + i + 8) ^ seed);
+    }
+
+    auto rest = length - i;
+    auto tail = bytes + i;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (rest > 8) {
+      a = Read8(tail);
+      b = Read8(tail + rest - 8);
+    } else if (rest >= 4) {
+      a = Read4(tail);
+      b = Read4(tail + rest - 4);
+    } else if (rest > 0) {
+      a = (static_cast<uint64_t>(static_cast<uint8_t>(tail[0])) << 16) |
+          (static_cast<uint64_t>(static_cast<uint8_t>(tail[rest >> 1])) << 8) |
+          static_cast<uint64_t>(static_cast<uint8_t>(tail[rest - 1]));
     }
-    return hash;
+    return static_cast<hash_t>(Mum(WY_P2 ^ length, Mum(a ^ WY_P1, b ^ seed)));
   }
 
   static inline hash_t CombineHashes(hash_t l, hash_t r) {
-    hash_t both[2];
-    both[0] = l;
-    both[1] = r;
-    return HashBytes(reinterpret_cast<char *>(both), sizeof(hash_t) * 2);
+    return static_cast<hash_t>(Mum(static_cast<uint64_t>(l) ^ WY_P0, static_cast<uint64_t>(r) ^ WY_P1));
   }
 
   static inline hash_t SumHashes(hash_t l, hash_t r) { return (l % prime_factor + r % prime_factor) % prime_factor; }
@@ -61,24 +132,19 @@ class HashUtil {
   static inline hash_t HashValue(const Value *val) {
     switch (val->GetTypeId()) {
       case TypeId::TINYINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int8_t>());
-        return Hash<int64_t>(&raw);
+        return HashInt(static_cast<uint64_t>(val->GetAs<int8_t>()));
       }
       case TypeId::SMALLINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int16_t>());
-        return Hash<int64_t>(&raw);
+        return HashInt(static_cast<uint64_t>(val->GetAs<int16_t>()));
       }
       case TypeId::INTEGER: {
-        auto raw = static_cast<int64_t>(val->GetAs<int32_t>());
-        return Hash<int64_t>(&raw);
+        return HashInt(static_cast<uint64_t>(val->GetAs<int32_t>()));
       }
       case TypeId::BIGINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int64_t>());
-        return Hash<int64_t>(&raw);
+        return HashInt(static_cast<uint64_t>(val->GetAs<int64_t>()));
       }
       case TypeId::BOOLEAN: {
-        auto raw = val->GetAs<bool>();
-        return Hash<bool>(&raw);
+        return HashInt(static_cast<uint64_t>(val->GetAs<bool>()));
       }
       case TypeId::DECIMAL: {
         auto raw = val->GetAs<double>();
@@ -90,8 +156,7 @@ class HashUtil {
         return HashBytes(raw, len);
       }
       case TypeId::TIMESTAMP: {
-        auto raw = val->GetAs<uint64_t>();
-        return Hash<uint64_t>(&raw);
+        return HashInt(val->GetAs<uint64_t>());
       }
       default: {
         BUSTUB_ASSERT(false, "Unsupported type.");
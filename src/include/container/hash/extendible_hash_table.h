@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table.h
+//
+// Identification: src/include/container/hash/extendible_hash_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "container/hash/hash_function.h"
+#include "container/hash/hash_table.h"
+#include "storage/page/extendible_hash_table_bucket_page.h"
+#include "storage/page/extendible_hash_table_directory_page.h"
+#include "storage/page/extendible_hash_table_header_page.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+#define EXTENDIBLE_HASH_TABLE_TYPE ExtendibleHashTable<KeyType, ValueType, KeyComparator>
+
+/**
+ * Implementation of extendible hashing that is backed by a buffer pool
+ * manager. Non-unique keys are supported. Supports insert and delete.
+ *
+ * The header page picks a directory page by the high bits of the hash of a
+ * key, and the directory picks a bucket page by the low bits. A full bucket
+ * splits on its own and only doubles its directory when it is pointed to by a
+ * single slot, so the table grows a bucket at a time instead of rehashing
+ * everything like LinearProbeHashTable. A bucket that becomes empty merges
+ * with its split image, and directories shrink again. A full bucket that
+ * cannot split any further, because its pairs share all the hash bits the
+ * directory may look at, chains overflow pages instead, so that many values
+ * of one key still fit.
+ *
+ * Pages are latched top down and the latch of the parent is released once the
+ * child is latched. Inserts and removes first write latch only the bucket and
+ * retry with the directory write latched when they have to split or merge.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class ExtendibleHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
+ public:
+  /**
+   * Creates a new ExtendibleHashTable
+   *
+   * @param buffer_pool_manager buffer pool manager to be used
+   * @param comparator comparator for keys
+   * @param hash_fn the hash function
+   * @param header_max_depth the number of hash bits that pick a directory
+   * @param directory_max_depth the maximum global depth of a directory
+   */
+  explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                               uint32_t header_max_depth = EXTENDIBLE_HEADER_MAX_DEPTH,
+                               uint32_t directory_max_depth = EXTENDIBLE_DIRECTORY_MAX_DEPTH);
+
+  /**
+   * Inserts a key-value pair into the hash table.
+   * @param transaction the current transaction
+   * @param key the key to create
+   * @param value the value to be associated with the key
+   * @return true if insert succeeded, false if the pair exists
+   */
+  bool Insert(Transaction *transaction, const KeyType &key, const ValueType &value) override;
+
+  /**
+   * Deletes the associated value for the given key.
+   * @param transaction the current transaction
+   * @param key the key to delete
+   * @param value the value to delete
+   * @return true if remove succeeded, false otherwise
+   */
+  bool Remove(Transaction *transaction, const KeyType &key, const ValueType &value) override;
+
+  /**
+   * Performs a point query on the hash table.
+   * @param transaction the current transaction
+   * @param key the key to look up
+   * @param[out] result the value(s) associated with a given key
+   * @return the value(s) associated with the given key
+   */
+  bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
+
+  /**
+   * @param key a key
+   * @return the global depth of the directory of the key, 0 if the directory
+   * is not created yet
+   */
+  uint32_t GetGlobalDepth(const KeyType &key);
+
+  /**
+   * Checks the invariants of every directory: local depths do not exceed the
+   * global depth, and a bucket of local depth d is pointed to by exactly
+   * 2^(global_depth - d) slots, which all agree on d.
+   * @return true if all directories are consistent
+   */
+  bool VerifyIntegrity();
+
+ private:
+  using HeaderPage = ExtendibleHashTableHeaderPage;
+  using DirectoryPage = ExtendibleHashTableDirectoryPage;
+  using BucketPage = ExtendibleHashTableBucketPage<KeyType, ValueType, KeyComparator>;
+
+  uint32_t Hash(const KeyType &key);
+  Page *FetchPage(page_id_t page_id);
+  Page *NewBucketPage(page_id_t *bucket_page_id);
+  void DeleteBucketPage(page_id_t page_id);
+  void DeletePendingPages();
+  Page *FetchDirectoryPage(uint32_t hash, bool create);
+  bool InsertPessimistic(const KeyType &key, const ValueType &value, uint32_t hash);
+  void SplitBucket(DirectoryPage *directory, uint32_t bucket_ind, BucketPage *bucket);
+  void Merge(uint32_t hash);
+  bool GetChainValue(BucketPage *bucket, const KeyType &key, std::vector<ValueType> *result);
+  bool InsertIntoChain(BucketPage *bucket, const KeyType &key, const ValueType &value, bool can_grow,
+                       bool *is_inserted);
+  bool RemoveFromChain(BucketPage *bucket, const KeyType &key, const ValueType &value);
+
+  // member variable
+  page_id_t header_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  uint32_t directory_max_depth_;
+  // unreachable bucket pages that were still pinned when they were deleted
+  std::mutex pending_deletes_latch_;
+  std::vector<page_id_t> pending_deletes_;
+  std::atomic<bool> has_pending_deletes_{false};
+
+  // Hash function
+  HashFunction<KeyType> hash_fn_;
+};
+
+}  // namespace bustub
@@ -12,24 +12,51 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
-#include "murmur3/MurmurHash3.h"
+#include "common/util/hash_util.h"
 
 namespace bustub {
 
+/**
+ * Hash function of the keys of the hash tables. The hash is picked at compile
+ * time from the key type: keys of up to eight bytes (int, GenericKey<4> and
+ * GenericKey<8>) are hashed as an integer with HashUtil::HashInt, wider keys
+ * as a byte string with HashUtil::HashBytes.
+ */
 template <typename KeyType>
 class HashFunction {
+  static_assert(std::is_trivially_copyable_v<KeyType>, "keys are hashed by their bytes");
+
  public:
   /**
    * @param key the key to be hashed
    * @return the hashed value
    */
-  virtual uint64_t GetHash(KeyType key) {
-    uint64_t hash[2];
-    murmur3::MurmurHash3_x64_128(reinterpret_cast<const void *>(&key), static_cast<int>(sizeof(KeyType)), 0,
-                                 reinterpret_cast<void *>(&hash));
-    return hash[0];
+  uint64_t GetHash(const KeyType &key) const {
+    if constexpr (sizeof(KeyType) <= sizeof(uint64_t)) {
+      uint64_t raw = 0;
+      std::memcpy(&raw, &key, sizeof(KeyType));
+      return HashUtil::HashInt(raw);
+    } else {
+      return HashUtil::HashBytes(reinterpret_cast<const char *>(&key), sizeof(KeyType));
+    }
+  }
+
+  /**
+   * Hashes an array of keys. The hashes do not depend on each other, so the
+   * CPU overlaps the latencies of their instructions.
+   * @param keys the keys to be hashed
+   * @param num_keys the number of keys
+   * @param[out] hashes the hash of keys[i] is written to hashes[i]
+   */
+  void GetHashes(const KeyType *keys, size_t num_keys, uint64_t *hashes) const {
+    for (size_t i = 0; i < num_keys; ++i) {
+      hashes[i] = GetHash(keys[i]);
+    }
   }
 };
 
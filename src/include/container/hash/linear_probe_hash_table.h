@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
@@ -23,17 +25,35 @@
 #include "storage/page/hash_table_block_page.h"
 #include "storage/page/hash_table_header_page.h"
 #include "storage/page/hash_table_page_defs.h"
+#include "storage/page/hash_table_tagged_block_page.h"
 
 namespace bustub {
 
-#define HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
+#define HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator, BlockPage>
 
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * Lookups do not latch pages, they rely on the atomic flags of the block
+ * pages (see HashTableBlockPage). Writers of a key write latch the block page
+ * of its bucket, which serializes the writers of a key without blocking the
+ * writers of keys that probe the same slots. Removed pairs leave tombstones
+ * that only Resize clears, which takes table_latch_ exclusively.
+ *
+ * An incremental resize (see SetIncrementalResize) only takes table_latch_
+ * exclusively to switch to the new layout. Like in linear hashing, the blocks
+ * of the old layout are then split into the new one in order, a block per
+ * insert, and the split pointer tells which block is next. Both layouts are
+ * read until the last block is split.
+ *
+ * BlockPage is the layout of the blocks, HashTableBlockPage or its tagged
+ * variant HashTableTaggedBlockPage. With tags, the probes for a key skip the
+ * slots whose tag differs a group at a time.
  */
-template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename BlockPage = HashTableBlockPage<KeyType, ValueType, KeyComparator>>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
  public:
   /**
@@ -47,6 +67,13 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   explicit LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                 const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn);
 
+  /**
+   * Switches between stop-the-world and incremental resizes, which are split
+   * over the following inserts.
+   * @param incremental_resize whether resizes are incremental
+   */
+  void SetIncrementalResize(bool incremental_resize);
+
   /**
    * Inserts a key-value pair into the hash table.
    * @param transaction the current transaction
@@ -87,10 +114,49 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   size_t GetSize();
 
  private:
+  static constexpr bool IS_TAGGED =
+      std::is_same<BlockPage, HashTableTaggedBlockPage<KeyType, ValueType, KeyComparator>>::value;
+  // number of slots of a block
+  static constexpr size_t BLOCK_SIZE = IS_TAGGED ? TAGGED_BLOCK_ARRAY_SIZE : BLOCK_ARRAY_SIZE;
+
+  void Rehash(size_t size, size_t num_buckets);
+  void SplitNextBlock();
+  bool SplitBlock(HashTableHeaderPage *old_header, HashTableHeaderPage *header, size_t block_ind);
+  void FinishSplits();
+  page_id_t CreateTable(size_t num_blocks);
+  void DeleteTable(HashTableHeaderPage *header);
+  HashTableHeaderPage *FetchHeaderPage(page_id_t header_page_id);
+  Page *FetchBlockPage(HashTableHeaderPage *header, size_t block_ind);
+  size_t BucketOf(HashTableHeaderPage *header, uint64_t hash);
+  bool FindPair(HashTableHeaderPage *header, const KeyType &key, const ValueType &value, uint64_t hash,
+                bool is_remove);
+  bool InsertPair(HashTableHeaderPage *header, const KeyType &key, const ValueType &value, uint64_t hash);
+  bool InsertAt(BlockPage *block, slot_offset_t slot, const KeyType &key, const ValueType &value, uint64_t hash);
+  template <typename Visitor>
+  bool Probe(HashTableHeaderPage *header, size_t bucket, bool is_write, Visitor visit);
+  template <typename Visitor>
+  bool ProbeKey(HashTableHeaderPage *header, uint64_t hash, bool is_write, Visitor visit);
+
+  // tombstones count as well, they keep probe sequences going
+  static constexpr double MAX_LOAD_FACTOR = 0.75;
+
   // member variable
   page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  // number of occupied slots of the current layout, i.e. pairs and tombstones
+  std::atomic<size_t> num_occupied_{0};
+  // number of pairs, in both layouts
+  std::atomic<size_t> num_pairs_{0};
+
+  bool incremental_resize_{false};
+  // header page of the layout an incremental resize splits, INVALID_PAGE_ID if there is none
+  page_id_t old_header_page_id_{INVALID_PAGE_ID};
+  // split pointer: the next block of the old layout to split
+  std::atomic<size_t> split_block_{0};
+  // number of blocks split in this round, and whether one of them did not fit into the new layout
+  std::atomic<size_t> num_split_blocks_{0};
+  std::atomic<bool> is_split_failed_{false};
 
   // Readers includes inserts and removes, writer is only resize
   ReaderWriterLatch table_latch_;
@@ -15,9 +15,11 @@
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
+#include <memory>
 #include <string>
 
 #include "common/config.h"
+#include "storage/disk/disk_trace.h"
 
 namespace bustub {
 
@@ -33,7 +35,7 @@ class DiskManager {
    */
   explicit DiskManager(const std::string &db_file);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -91,6 +93,19 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of disk reads */
+  int GetNumReads() const;
+
+  /**
+   * Start recording every page and log I/O into a binary trace, see storage/disk/disk_trace.h.
+   * Replaces the trace that is currently being recorded, if any. Must not race with in-flight I/O.
+   * @param trace_file the file name of the trace to write to
+   */
+  void EnableTrace(const std::string &trace_file);
+
+  /** Stop recording and flush the trace file. */
+  void DisableTrace();
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -111,8 +126,11 @@ class DiskManager {
   std::atomic<page_id_t> next_page_id_;
   int num_flushes_;
   int num_writes_;
+  int num_reads_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  // optional I/O trace recorder, nullptr when tracing is off
+  std::unique_ptr<DiskTraceWriter> trace_writer_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_trace.h
+//
+// Identification: src/include/storage/disk/disk_trace.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** The kinds of disk operations that end up in an I/O trace. */
+enum class DiskTraceOp : uint8_t { READ_PAGE = 0, WRITE_PAGE, READ_LOG, WRITE_LOG, ALLOCATE_PAGE, DEALLOCATE_PAGE };
+
+/**
+ * One entry of an I/O trace. Records are written to the trace file verbatim.
+ *
+ * Record format (size in byte, 24 bytes in total):
+ * -----------------------------------------------------------------------------
+ * | Timestamp (8) | Latency (4) | PageId (4) | Size (4) | Op (1) | Padding (3) |
+ * -----------------------------------------------------------------------------
+ * The timestamp is in microseconds since tracing started, the latency in nanoseconds.
+ * Log operations carry INVALID_PAGE_ID.
+ */
+struct DiskTraceRecord {
+  uint64_t timestamp_us_;
+  uint32_t latency_ns_;
+  page_id_t page_id_;
+  uint32_t size_;
+  DiskTraceOp op_;
+  uint8_t padding_[3];
+};
+
+static_assert(sizeof(DiskTraceRecord) == 24, "trace records must stay compact");
+
+/**
+ * DiskTraceWriter appends trace records to a binary trace file. The file starts with an 8 byte header
+ * (magic number + format version) followed by DiskTraceRecords. Records are buffered in memory and written
+ * out in batches so that tracing does not add a write per traced operation.
+ */
+class DiskTraceWriter {
+ public:
+  using clock_t = std::chrono::steady_clock;
+
+  /**
+   * Creates a trace writer that truncates and writes to the given file.
+   * @param trace_file the file name of the trace
+   */
+  explicit DiskTraceWriter(const std::string &trace_file);
+
+  ~DiskTraceWriter();
+
+  /**
+   * Appends a record for an operation that started at start and finished just now.
+   * @param op the traced operation
+   * @param page_id the page the operation touched, INVALID_PAGE_ID for log operations
+   * @param size the number of bytes transferred
+   * @param start the time point at which the operation started
+   */
+  void Record(DiskTraceOp op, page_id_t page_id, uint32_t size, clock_t::time_point start);
+
+  /** Writes buffered records to the trace file. */
+  void Flush();
+
+  /** @return the number of records written so far */
+  uint64_t GetNumRecords();
+
+ private:
+  void FlushLocked();
+
+  static constexpr size_t BUFFER_RECORDS = 1024;
+
+  std::ofstream trace_io_;
+  clock_t::time_point trace_start_;
+  std::vector<DiskTraceRecord> buffer_;
+  uint64_t num_records_{0};
+  std::mutex latch_;
+};
+
+/**
+ * DiskTraceReader reads back the records of a trace file produced by DiskTraceWriter.
+ */
+class DiskTraceReader {
+ public:
+  /**
+   * Opens a trace file, throws if the file is missing or is not a trace.
+   * @param trace_file the file name of the trace
+   */
+  explicit DiskTraceReader(const std::string &trace_file);
+
+  /**
+   * Reads the next record of the trace.
+   * @param[out] record the record that was read
+   * @return false when the end of the trace was reached
+   */
+  bool Next(DiskTraceRecord *record);
+
+ private:
+  std::ifstream trace_io_;
+};
+
+/**
+ * RAII helper that times one disk operation and records it when it goes out of scope.
+ * Does nothing (and does not read the clock) when tracing is disabled.
+ */
+class DiskTraceScope {
+ public:
+  DiskTraceScope(DiskTraceWriter *writer, DiskTraceOp op, page_id_t page_id, uint32_t size)
+      : writer_(writer), op_(op), page_id_(page_id), size_(size) {
+    if (writer_ != nullptr) {
+      start_ = DiskTraceWriter::clock_t::now();
+    }
+  }
+
+  ~DiskTraceScope() {
+    if (writer_ != nullptr) {
+      writer_->Record(op_, page_id_, size_, start_);
+    }
+  }
+
+ private:
+  DiskTraceWriter *writer_;
+  DiskTraceOp op_;
+  page_id_t page_id_;
+  uint32_t size_;
+  DiskTraceWriter::clock_t::time_point start_;
+};
+
+}  // namespace bustub
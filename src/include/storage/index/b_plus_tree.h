@@ -10,15 +10,25 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <random>
 #include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
+#include "storage/index/index_stats.h"
+#include "storage/index/reverse_index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
@@ -29,7 +39,8 @@ namespace bustub {
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique by default, otherwise a key keeps all its values in a
+ * sorted posting list (see BPlusTreePostingPage)
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
@@ -41,27 +52,114 @@ class BPlusTree {
 
   enum class Operation { READ, INSERT, DELETE };
 
+  // the range an insert checks for entries, see InsertIfAbsent()
+  struct InsertRange {
+    const KeyType *low_key_;
+    const KeyType *high_key_;
+    // set when the range does not lie within a single leaf, nothing is inserted then
+    bool is_spanning_{false};
+  };
+
  public:
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     bool unique_keys = true);
+
+  ~BPlusTree();
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty();
 
-  // Insert a key-value pair into this B+ tree.
+  // Insert/Remove descend with read latches and only write latch the leaf, restarting pessimistically when the
+  // leaf would split or merge. Turn off to always write latch from the root down.
+  void SetOptimisticLatching(bool optimistic_latching);
+
+  // GetValue descends without latching, validating page versions instead, and falls back to latch crabbing
+  // after repeated conflicts with writers.
+  void SetOptimisticReads(bool optimistic_reads);
+
+  // Remove only deletes from the leaf, which may stay underfull, and leaves merging and redistributing to
+  // MergeUnderflowPages(). Underfull leaves slow down scans until they are merged.
+  void SetRelaxedDeletes(bool relaxed_deletes);
+
+  // Merge or redistribute the leaves left underfull by relaxed deletes, one at a time. Returns the number of
+  // leaves that were merged or redistributed.
+  size_t MergeUnderflowPages();
+
+  // Changes to a key whose leaf is not in the buffer pool go to a change buffer instead of fetching the leaf, and are
+  // merged into the leaves by MergeChangeBuffer(), by range scans over them and opportunistically by lookups. Only
+  // works with duplicate keys, as a buffered insert cannot check the leaf for the key. Turning it off merges every
+  // pending change.
+  void SetChangeBuffering(bool change_buffering);
+
+  // Merge every buffered change into the leaves, in batches. Returns the number of changes merged.
+  size_t MergeChangeBuffer();
+
+  // Returns true if buffered changes wait to be merged.
+  bool HasPendingChanges();
+
+  // Run MergeUnderflowPages() and MergeChangeBuffer() in a background thread every background_merge_interval, until
+  // stopped or destroyed.
+  void StartBackgroundMerge();
+
+  void StopBackgroundMerge();
+
+  // Start the background merge thread once a change is buffered instead of calling StartBackgroundMerge() up front,
+  // so that trees whose leaves stay in the buffer pool run no thread.
+  void SetBackgroundMergeOnDemand(bool background_merge_on_demand);
+
+  // Insert a key-value pair into this B+ tree. With duplicate keys only an existing key-value pair is rejected, a
+  // buffered insert only if it is buffered already: with change buffering on, true means maybe inserted.
   bool Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
-  // Remove a key and its value from this B+ tree.
+  // Insert a key-value pair unless an entry within [low_key, high_key] exists, e.g. one that shares a prefix with key,
+  // which has to lie in the range. The check and the insertion happen under the write latch of the leaf, so two such
+  // inserts into the same range never both succeed. Bypasses the change buffer.
+  bool InsertIfAbsent(const KeyType &key, const ValueType &value, const KeyType &low_key, const KeyType &high_key,
+                      Transaction *transaction = nullptr);
+
+  // Remove a key and all its values from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove a single key-value pair from this B+ tree.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // Build the tree bottom-up from key-value pairs returned in ascending key order by next, which returns false at
+  // the end of the stream. Leaves are packed to fill_factor of their capacity and pages are allocated in order.
+  // Repeated keys are skipped with unique keys and collected into posting lists otherwise.
+  // Only works on an empty tree, returns false otherwise.
+  bool BulkLoad(const std::function<bool(KeyType *, ValueType *)> &next, double fill_factor = 1.0,
+                Transaction *transaction = nullptr);
+
+  // return the values associated with a given key
   bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
 
+  // return the values associated with each of a batch of keys, (*results)[i] holds the values of keys[i]
+  void MultiGet(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                Transaction *transaction = nullptr);
+
+  // Collect structural statistics and an equi-depth histogram of at most num_buckets buckets into stats, the upper
+  // bounds of the buckets go to histogram_bounds. Internal levels are read in full, leaves only at sample_rate.
+  void CollectStats(IndexStats *stats, std::vector<KeyType> *histogram_bounds, double sample_rate = 1.0,
+                    int num_buckets = 32);
+
   // index iterator
   INDEXITERATOR_TYPE begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
+  // iterator over [key, stop_key), or [key, stop_key] if is_stop_inclusive
+  INDEXITERATOR_TYPE Begin(const KeyType &key, const KeyType &stop_key, bool is_stop_inclusive);
   INDEXITERATOR_TYPE end();
 
+  // Split [low_key, high_key] into at most num_partitions sub-ranges at separator keys of the levels near the root
+  // and return an iterator per sub-range, in key order. The iterators end with their sub-range and can be consumed
+  // concurrently.
+  std::vector<INDEXITERATOR_TYPE> PartitionRange(const KeyType &low_key, const KeyType &high_key, int num_partitions);
+
+  // reverse index iterator, RBegin starts at the greatest key <= key
+  REVERSE_INDEXITERATOR_TYPE rbegin();
+  REVERSE_INDEXITERATOR_TYPE RBegin(const KeyType &key);
+  REVERSE_INDEXITERATOR_TYPE rend();
+
   void Print(BufferPoolManager *bpm) {
     ToString(reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(root_page_id_)->GetData()), bpm);
   }
@@ -79,13 +177,77 @@ class BPlusTree {
 
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
+
+  // read unsorted data from file, sort it externally and bulk load it
+  bool BulkLoadFromFile(const std::string &file_name, double fill_factor = 1.0, Transaction *transaction = nullptr,
+                        size_t sort_threads = 4);
+
   // expose for test purpose
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
  private:
   void StartNewTree(const KeyType &key, const ValueType &value);
 
-  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr,
+                      InsertRange *range = nullptr);
+
+  bool InsertEntry(const KeyType &key, const ValueType &value, Transaction *transaction,
+                   InsertRange *range = nullptr, bool *is_resident = nullptr);
+
+  bool OptimisticInsert(const KeyType &key, const ValueType &value, bool *is_inserted, InsertRange *range = nullptr,
+                        bool *is_resident = nullptr);
+
+  bool IsRangeEmpty(LeafPage *leaf, InsertRange *range) const;
+
+  void RemoveEntry(const KeyType &key, const ValueType *value, Transaction *transaction,
+                   bool *is_resident = nullptr);
+
+  bool OptimisticRemove(const KeyType &key, const ValueType *value, bool *is_resident = nullptr);
+
+  void RelaxedRemove(const KeyType &key, const ValueType *value, bool *is_resident = nullptr);
+
+  bool ShouldMerge(LeafPage *leaf) const;
+
+  bool MergeUnderflowPage(const KeyType &key, Transaction *transaction);
+
+  void RunBackgroundMerge();
+
+  void OnChangeBuffered();
+
+  void DeletePages(Transaction *transaction);
+
+  bool LookupValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction);
+
+  void LookupValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results);
+
+  bool IsLeafResident(const KeyType &key);
+
+  bool CancelChange(BPlusTree *buffer, const KeyType &key, const ValueType &value, Transaction *transaction);
+
+  bool ApplyChanges(const KeyType &key, std::vector<ValueType> *values);
+
+  void MergeChanges(const KeyType *low_key, const KeyType *high_key);
+
+  size_t MergeChangeBatch(const KeyType *low_key, const KeyType *high_key, size_t limit);
+
+  void CollectChanges(BPlusTree *buffer, const KeyType *low_key, const KeyType *high_key, size_t limit,
+                      std::vector<MappingType> *changes);
+
+  bool RemoveFromLeaf(LeafPage *leaf, const KeyType &key, const ValueType *value, bool can_remove_entry,
+                      bool *is_dirty);
+
+  bool InsertIntoPostingList(LeafPage *leaf, int index, const ValueType &value, bool can_overflow,
+                             std::vector<page_id_t> *created = nullptr);
+
+  bool RemoveFromPostingList(LeafPage *leaf, int index, const ValueType &reference, const ValueType &value);
+
+  void CollectValues(const LeafPage *leaf, int index, std::vector<ValueType> *result);
+
+  void DeletePostingList(const ValueType &reference);
+
+  Page *FetchPostingPage(page_id_t page_id);
+
+  Page *NewPostingPage(page_id_t *page_id, std::vector<page_id_t> *created);
 
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
                         Transaction *transaction = nullptr);
@@ -93,6 +255,14 @@ class BPlusTree {
   template <typename N>
   N *Split(N *node);
 
+  void BulkLoadPushNode(std::vector<Page *> *levels, std::vector<Page *> *prev_levels, size_t level, Page *page,
+                        const KeyType &low_key, int internal_fill, std::vector<page_id_t> *created);
+
+  Page *BulkLoadNewPage(std::vector<page_id_t> *created);
+
+  void BulkLoadAbort(std::vector<Page *> *levels, std::vector<Page *> *prev_levels,
+                     const std::vector<page_id_t> &created);
+
   template <typename N>
   bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
 
@@ -101,37 +271,101 @@ class BPlusTree {
                 int index, Transaction *transaction = nullptr);
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, bool from_left, int node_ind, InternalPage *parent);
+  bool Redistribute(N *neighbor_node, N *node, bool from_left, int node_ind, InternalPage *parent);
 
   bool AdjustRoot(BPlusTreePage *node);
 
   void UpdateRootPageId(int insert_record = 0);
 
+  INDEXITERATOR_TYPE BeginRange(const KeyType &key, const KeyType *stop_key, bool is_stop_inclusive);
+
+  std::function<Page *(const KeyType &)> LeafFinder();
+
+  bool CollectSeparators(Page *page, int depth, const KeyType &low_key, const KeyType &high_key,
+                         std::vector<KeyType> *separators);
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
 
   void ToString(BPlusTreePage *page, BufferPoolManager *bpm) const;
 
-  Page *FindLeafPage(const KeyType &key, Operation op, Transaction *transaction = nullptr, bool left_most = false);
+  Page *FindLeafPage(const KeyType &key, Operation op, Transaction *transaction = nullptr, bool left_most = false,
+                     bool right_most = false);
+
+  Page *FindLeafPageOptimistic(const KeyType &key, bool *is_resident = nullptr);
+
+  Page *LatchRootPage(bool is_leaf_exclusive);
+
+  bool OptimisticGetValue(const KeyType &key, std::vector<ValueType> *result, bool *is_existing, bool *is_resident);
+
+  bool IsKeyInPage(BPlusTreePage *node, const KeyType &key) const;
+
+  Page *MoveRightOnLevel(Page *page, page_id_t next_page_id, Page *pinned_page);
+
+  Page *FindRandomLeafPage(std::mt19937 *generator);
+
+  void CollectLeafStats(LeafPage *leaf, std::vector<std::pair<KeyType, uint64_t>> *key_counts,
+                        uint64_t *num_posting_pages);
+
+  void ReleasePath(std::vector<Page *> *path);
+
+  void ReleaseLeafWLatch(Page *page, bool isDirty);
+
+  bool IsSafe(BPlusTreePage *node, Operation op) const;
+
+  void ReleaseSplitPage(Page *page, Transaction *transaction);
+
+  uint32_t GetLowKeyVersion(BPlusTreePage *node) const;
+
+  void UpdatePrevPageId(page_id_t page_id, page_id_t old_prev_page_id, page_id_t prev_page_id);
 
   void ReleaseAllWLatches(Transaction *transaction, bool isDirty);
 
   void ReleasePrevRLatch(Page *prevPage);
 
-  bool ShouldRedistribute(BPlusTreePage *node, BPlusTreePage *neighbor_node) const;
+  bool ShouldRedistribute(BPlusTreePage *node, BPlusTreePage *neighbor_node, bool from_left, int node_ind,
+                          InternalPage *parent) const;
 
-  void AcquireRootPageIdLatch(bool is_exclusive);
+  void AcquireRootPageIdLatch();
 
-  void ReleaseRootPageIdLatch(bool is_exclusive);
+  void ReleaseRootPageIdLatch();
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // readers latch the root without root_page_id_latch_, see LatchRootPage()
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
-  std::shared_mutex root_page_id_latch_;
+  bool unique_keys_;
+  // held by writers that may split or collapse the root
+  std::mutex root_page_id_latch_;
+  // held shared by InsertIfAbsent() within a single leaf, exclusively when its range spans several leaves
+  std::shared_mutex insert_range_latch_;
+  bool optimistic_latching_{true};
+  bool optimistic_reads_{true};
+  static constexpr int OPTIMISTIC_READ_RETRIES = 8;
+  // keys a batched lookup looks up before it releases its latched path
+  static constexpr size_t MULTI_GET_LATCH_BATCH = 64;
+  bool relaxed_deletes_{false};
+  // keys whose leaves relaxed deletes left underfull
+  std::mutex underflow_keys_latch_;
+  std::vector<KeyType> underflow_keys_;
+  std::atomic<bool> enable_background_merge_{false};
+  std::thread *background_merge_thread_{nullptr};
+  // serializes starting and stopping the background merge thread
+  std::mutex background_merge_latch_;
+  std::atomic<bool> background_merge_on_demand_{false};
+  std::atomic<bool> change_buffering_{false};
+  // buffered inserts and deletes, a key-value pair is pending in at most one of them. Writers and readers hold
+  // change_buffer_latch_ shared, merges exclusively. Readers skip it while nothing is pending.
+  std::unique_ptr<BPlusTree> insert_buffer_;
+  std::unique_ptr<BPlusTree> delete_buffer_;
+  // set once both buffers exist, they are kept until the tree is destroyed
+  std::atomic<bool> has_change_buffer_{false};
+  std::shared_mutex change_buffer_latch_;
+  static constexpr size_t CHANGE_BUFFER_MERGE_BATCH = 256;
 };
 
 }  // namespace bustub
@@ -11,8 +11,10 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/index/b_plus_tree.h"
@@ -22,6 +24,12 @@ namespace bustub {
 
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
+/**
+ * A covering index (see IndexMetadata::IsCovering) stores its included columns
+ * in the leaf entries, encoded after the key columns of each key. Entries of a
+ * key then share the encoding of the key as a prefix, so a lookup scans that
+ * prefix and reads the included columns from the leaves alone.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
@@ -33,6 +41,26 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  void ScanEntries(const Tuple &key, std::vector<Tuple> *entries, std::vector<RID> *result,
+                   Transaction *transaction) override;
+
+  void CollectStats(IndexStats *stats, double sample_rate, int num_buckets, Transaction *transaction) override;
+
+  /**
+   * Build the index bottom-up from the entries of a table, keys made with the entry schema, returned in any order by
+   * next, which returns false at the end of the stream. The entries are sorted externally, so they do not have to fit
+   * in memory. A unique index keeps the first entry of a key. Only works on an empty index.
+   * @param run_size the number of entries each sort thread keeps in memory, see ExternalSort
+   * @return false if the index was not empty
+   */
+  bool BulkLoad(const std::function<bool(Tuple *, RID *)> &next, Transaction *transaction, size_t run_size = 1 << 16);
+
+  // decode the entry columns from a key of the tree, e.g. one returned by an iterator
+  Tuple EntryToTuple(const KeyType &key) const;
+
   INDEXITERATOR_TYPE GetBeginIterator();
 
   INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key);
@@ -40,6 +68,13 @@ class BPlusTreeIndex : public Index {
   INDEXITERATOR_TYPE GetEndIterator();
 
  protected:
+  /**
+   * Append the RIDs (and entries, unless nullptr) of every key whose encoding
+   * starts with the first prefix_size bytes of prefix, i.e. whose key columns
+   * equal those of prefix.
+   */
+  void ScanPrefix(const KeyType &prefix, size_t prefix_size, std::vector<RID> *result, std::vector<Tuple> *entries);
+
   // comparator for key
   KeyComparator comparator_;
   // container
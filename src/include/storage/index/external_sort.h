@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.h
+//
+// Identification: src/include/storage/index/external_sort.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+/**
+ * ExternalSort sorts (key, value) pairs that may not fit in memory, it is the front end of BPlusTree::BulkLoad for
+ * unsorted input.
+ *
+ * Pairs are buffered until the buffer holds run_size pairs per thread. The buffer is then cut into one chunk per
+ * thread, the chunks are sorted in parallel and every chunk is written to its own run file. Finish() sorts what is
+ * left, after which Next() returns the pairs in key order by merging the runs. The sort is stable, pairs with equal
+ * keys come out in the order they were added.
+ * If no run was spilled the pairs are merged in memory and no file is written.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class ExternalSort {
+ public:
+  /**
+   * @param comparator the key comparator
+   * @param run_file_prefix run files are named run_file_prefix + run number and removed by the destructor
+   * @param run_size the number of pairs each thread sorts in memory
+   * @param num_threads the number of threads that sort runs
+   */
+  ExternalSort(const KeyComparator &comparator, std::string run_file_prefix, size_t run_size = 1 << 20,
+               size_t num_threads = 4);
+
+  ~ExternalSort();
+
+  /** Adds a pair, may sort and spill a batch of runs. Must not be called after Finish(). */
+  void Add(const KeyType &key, const ValueType &value);
+
+  /** Sorts the remaining pairs and prepares the merge. */
+  void Finish();
+
+  /**
+   * Returns the next pair in key order, only valid after Finish().
+   * @return false when all pairs were returned
+   */
+  bool Next(KeyType *key, ValueType *value);
+
+  /** @return the number of run files spilled to disk */
+  size_t GetNumRuns() const { return run_files_.size(); }
+
+ private:
+  /** Cuts the buffer into one chunk per thread and sorts the chunks in parallel, returns the chunk boundaries */
+  std::vector<size_t> SortChunks();
+  void SpillRuns();
+  bool ReadRun(size_t run, MappingType *item);
+  void PushHeap(MappingType item, size_t run);
+  bool HeapGreater(const std::pair<MappingType, size_t> &a, const std::pair<MappingType, size_t> &b) const;
+
+  KeyComparator comparator_;
+  std::string run_file_prefix_;
+  size_t run_size_;
+  size_t num_threads_;
+  bool is_finished_{false};
+
+  std::vector<MappingType> buffer_;
+  std::vector<std::string> run_files_;
+
+  // merge state, runs are either files or chunks of the in memory buffer
+  std::vector<std::unique_ptr<std::ifstream>> run_streams_;
+  std::vector<std::pair<size_t, size_t>> run_ranges_;
+  std::vector<std::pair<MappingType, size_t>> heap_;
+};
+
+}  // namespace bustub
@@ -12,9 +12,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
+#include <string>
 
 #include "storage/table/tuple.h"
+#include "type/limits.h"
 #include "type/value.h"
 
 namespace bustub {
@@ -25,39 +28,79 @@ namespace bustub {
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * Key columns are stored in a normalized, order preserving encoding, so that
+ * keys compare with a plain byte-wise comparison:
+ * - integers and booleans are stored big-endian with the sign bit flipped.
+ *   NULL is the minimum value of these types and therefore sorts first without
+ *   an extra byte.
+ * - timestamps are stored big-endian as value + 1, NULL as 0.
+ * - decimals flip the sign bit of positive values and all bits of negative
+ *   values, then are stored big-endian.
+ * - varchars start with a null byte (0 for NULL, 1 otherwise), escape 0x00 as
+ *   0x00 0xFF and are terminated by 0x00 0x00.
+ * Unused trailing bytes are zero, keys longer than KeySize are truncated.
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
+  /**
+   * Encode the first column_count columns of key_schema (all of them by
+   * default).
+   * @return the size of the encoding, which exceeds KeySize if it got truncated
+   */
+  inline size_t SetFromKey(const Tuple &tuple, const Schema *key_schema, uint32_t column_count = UINT32_MAX) {
     // intialize to 0
     memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    size_t pos = 0;
+    column_count = std::min(column_count, key_schema->GetColumnCount());
+    for (uint32_t i = 0; i < column_count; i++) {
+      const auto &col = key_schema->GetColumn(i);
+      const char *data_ptr = tuple.GetData() + col.GetOffset();
+      if (col.IsInlined()) {
+        PutFixed(col.GetType(), data_ptr, &pos);
+        continue;
+      }
+
+      data_ptr = tuple.GetData() + *reinterpret_cast<const uint32_t *>(data_ptr);
+      PutVarchar(data_ptr, &pos);
+    }
+    return pos;
   }
 
   // NOTE: for test purpose only
+  // a single BIGINT column
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    size_t pos = 0;
+    PutFixed(TypeId::BIGINT, reinterpret_cast<const char *>(&key), &pos);
   }
 
   inline Value ToValue(Schema *schema, uint32_t column_idx) const {
-    const char *data_ptr;
+    size_t pos = 0;
+    for (uint32_t i = 0; i < column_idx; i++) {
+      const auto &col = schema->GetColumn(i);
+      if (col.IsInlined()) {
+        pos += Type::GetTypeSize(col.GetType());
+      } else {
+        GetVarchar(&pos, nullptr);
+      }
+    }
+
     const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
+    if (col.IsInlined()) {
+      return GetFixed(col.GetType(), pos);
+    }
+    std::string str;
+    if (!GetVarchar(&pos, &str)) {
+      return Value(TypeId::VARCHAR, nullptr, BUSTUB_VALUE_NULL, false);
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return Value(TypeId::VARCHAR, str);
   }
 
   // NOTE: for test purpose only
   // interpret the first 8 bytes as int64_t from data vector
-  inline int64_t ToString() const { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  inline int64_t ToString() const { return GetFixed(TypeId::BIGINT, 0).template GetAs<int64_t>(); }
 
   // NOTE: for test purpose only
   // interpret the first 8 bytes as int64_t from data vector
@@ -68,28 +111,150 @@ class GenericKey {
 
   // actual location of data, extends past the end.
   char data_[KeySize];
+
+ private:
+  // bytes past the end are only counted
+  inline void PutByte(uint8_t byte, size_t *pos) {
+    if (*pos < KeySize) {
+      data_[*pos] = static_cast<char>(byte);
+    }
+    ++*pos;
+  }
+
+  inline void PutFixed(TypeId type, const char *data_ptr, size_t *pos) {
+    auto width = Type::GetTypeSize(type);
+    uint64_t bits = 0;
+    switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        bits = static_cast<uint8_t>(*reinterpret_cast<const int8_t *>(data_ptr)) ^ 0x80U;
+        break;
+      case TypeId::SMALLINT:
+        bits = static_cast<uint16_t>(*reinterpret_cast<const int16_t *>(data_ptr)) ^ 0x8000U;
+        break;
+      case TypeId::INTEGER:
+        bits = static_cast<uint32_t>(*reinterpret_cast<const int32_t *>(data_ptr)) ^ 0x80000000U;
+        break;
+      case TypeId::BIGINT:
+        memcpy(&bits, data_ptr, sizeof(bits));
+        bits ^= 1ULL << 63;
+        break;
+      case TypeId::TIMESTAMP:
+        memcpy(&bits, data_ptr, sizeof(bits));
+        bits = bits == BUSTUB_TIMESTAMP_NULL ? 0 : bits + 1;
+        break;
+      case TypeId::DECIMAL:
+        memcpy(&bits, data_ptr, sizeof(bits));
+        bits = (bits >> 63) != 0 ? ~bits : bits ^ (1ULL << 63);
+        break;
+      default:
+        return;
+    }
+    for (auto shift = static_cast<int>(width * 8) - 8; shift >= 0; shift -= 8) {
+      PutByte(static_cast<uint8_t>(bits >> shift), pos);
+    }
+  }
+
+  inline void PutVarchar(const char *data_ptr, size_t *pos) {
+    auto len = *reinterpret_cast<const uint32_t *>(data_ptr);
+    if (len == BUSTUB_VALUE_NULL) {
+      PutByte(0, pos);
+      return;
+    }
+    PutByte(1, pos);
+    // the serialized length counts the terminating '\0', which does not take part in comparisons
+    for (uint32_t i = 0; i + 1 < len; i++) {
+      auto byte = static_cast<uint8_t>(data_ptr[sizeof(uint32_t) + i]);
+      PutByte(byte, pos);
+      if (byte == 0) {
+        PutByte(0xFF, pos);
+      }
+    }
+    PutByte(0, pos);
+    PutByte(0, pos);
+  }
+
+  inline Value GetFixed(TypeId type, size_t pos) const {
+    auto width = Type::GetTypeSize(type);
+    uint64_t bits = 0;
+    for (size_t i = 0; i < width; i++) {
+      bits = (bits << 8) | (pos + i < KeySize ? static_cast<uint8_t>(data_[pos + i]) : 0);
+    }
+    switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        return Value(type, static_cast<int8_t>(bits ^ 0x80U));
+      case TypeId::SMALLINT:
+        return Value(type, static_cast<int16_t>(bits ^ 0x8000U));
+      case TypeId::INTEGER:
+        return Value(type, static_cast<int32_t>(bits ^ 0x80000000U));
+      case TypeId::BIGINT:
+        return Value(type, static_cast<int64_t>(bits ^ (1ULL << 63)));
+      case TypeId::TIMESTAMP:
+        return Value(type, static_cast<uint64_t>(bits == 0 ? BUSTUB_TIMESTAMP_NULL : bits - 1));
+      case TypeId::DECIMAL: {
+        bits = (bits >> 63) != 0 ? bits ^ (1ULL << 63) : ~bits;
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        return Value(type, d);
+      }
+      default:
+        return Value(type);
+    }
+  }
+
+  // @return false if the varchar is NULL
+  inline bool GetVarchar(size_t *pos, std::string *str) const {
+    if (*pos >= KeySize || data_[(*pos)++] == 0) {
+      return false;
+    }
+    while (*pos < KeySize) {
+      auto byte = data_[(*pos)++];
+      if (byte != 0) {
+        if (str != nullptr) {
+          str->push_back(byte);
+        }
+        continue;
+      }
+      if (*pos >= KeySize || static_cast<uint8_t>(data_[(*pos)++]) != 0xFF) {
+        break;
+      }
+      if (str != nullptr) {
+        str->push_back(0);
+      }
+    }
+    return true;
+  }
 };
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * Keys are normalized, so they are compared word by word as big-endian
+ * integers, which is the same order as memcmp.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline int operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
-    uint32_t column_count = key_schema_->GetColumnCount();
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
-      }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= KeySize; i += sizeof(uint64_t)) {
+      uint64_t lhs_word;
+      uint64_t rhs_word;
+      memcpy(&lhs_word, lhs.data_ + i, sizeof(uint64_t));
+      memcpy(&rhs_word, rhs.data_ + i, sizeof(uint64_t));
+      if (lhs_word != rhs_word) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        lhs_word = __builtin_bswap64(lhs_word);
+        rhs_word = __builtin_bswap64(rhs_word);
+#endif
+        return lhs_word < rhs_word ? -1 : 1;
       }
     }
+    if (i < KeySize) {
+      auto result = memcmp(lhs.data_ + i, rhs.data_ + i, KeySize - i);
+      return (result > 0) - (result < 0);
+    }
     // equals
     return 0;
   }
@@ -99,6 +264,9 @@ class GenericComparator {
   // constructor
   explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
 
+  // the schema to decode keys with GenericKey::ToValue
+  inline Schema *GetKeySchema() const { return key_schema_; }
+
  private:
   Schema *key_schema_;
 };
@@ -18,6 +18,8 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/exception.h"
+#include "storage/index/index_stats.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -37,12 +39,24 @@ class IndexMetadata {
   IndexMetadata() = delete;
 
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                std::vector<uint32_t> key_attrs, bool is_unique = true, std::vector<uint32_t> include_attrs = {})
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(std::move(key_attrs)),
+        include_attrs_(std::move(include_attrs)),
+        is_unique_(is_unique) {
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
+    entry_attrs_ = key_attrs_;
+    entry_attrs_.insert(entry_attrs_.end(), include_attrs_.begin(), include_attrs_.end());
+    entry_schema_ = include_attrs_.empty() ? key_schema_ : Schema::CopySchema(tuple_schema, entry_attrs_);
   }
 
-  ~IndexMetadata() { delete key_schema_; }
+  ~IndexMetadata() {
+    if (entry_schema_ != key_schema_) {
+      delete entry_schema_;
+    }
+    delete key_schema_;
+  }
 
   inline const std::string &GetName() const { return name_; }
 
@@ -60,6 +74,21 @@ class IndexMetadata {
   //  columns
   inline const std::vector<uint32_t> &GetKeyAttrs() const { return key_attrs_; }
 
+  // Returns false if several tuples may share a key, which the index then maps to all of their RIDs
+  inline bool IsUnique() const { return is_unique_; }
+
+  // Returns the columns stored in the index next to the key without being part of it (INCLUDE columns)
+  inline const std::vector<uint32_t> &GetIncludeAttrs() const { return include_attrs_; }
+
+  // Returns true if the index stores included columns and can answer queries on them without the table
+  inline bool IsCovering() const { return !include_attrs_.empty(); }
+
+  // Returns the columns of an index entry, the key attributes followed by the included ones
+  inline const std::vector<uint32_t> &GetEntryAttrs() const { return entry_attrs_; }
+
+  // Returns the schema of an index entry, the key schema unless there are included columns
+  inline Schema *GetEntrySchema() const { return entry_schema_; }
+
   // Get a string representation for debugging
   std::string ToString() const {
     std::stringstream os;
@@ -67,8 +96,9 @@ class IndexMetadata {
     os << "IndexMetadata["
        << "Name = " << name_ << ", "
        << "Type = B+Tree, "
-       << "Table name = " << table_name_ << "] :: ";
-    os << key_schema_->ToString();
+       << "Table name = " << table_name_ << ", "
+       << "Unique = " << is_unique_ << "] :: ";
+    os << entry_schema_->ToString();
 
     return os.str();
   }
@@ -78,8 +108,16 @@ class IndexMetadata {
   std::string table_name_;
   // The mapping relation between key schema and tuple schema
   const std::vector<uint32_t> key_attrs_;
+  // The included columns of the tuple schema
+  const std::vector<uint32_t> include_attrs_;
+  // key_attrs_ followed by include_attrs_
+  std::vector<uint32_t> entry_attrs_;
+  // whether index keys are unique
+  bool is_unique_;
   // schema of the indexed key
   Schema *key_schema_;
+  // schema of the key and the included columns, same as key_schema_ without included columns
+  Schema *entry_schema_;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -117,6 +155,12 @@ class Index {
 
   const std::vector<uint32_t> &GetKeyAttrs() const { return metadata_->GetKeyAttrs(); }
 
+  Schema *GetEntrySchema() const { return metadata_->GetEntrySchema(); }
+
+  // Entries are inserted and deleted as tuples of these columns, which are the key attributes unless the index is
+  // covering. Lookups only take the key.
+  const std::vector<uint32_t> &GetEntryAttrs() const { return metadata_->GetEntryAttrs(); }
+
   // Get a string representation for debugging
   std::string ToString() const {
     std::stringstream os;
@@ -129,7 +173,7 @@ class Index {
   ///////////////////////////////////////////////////////////////////
   // Point Modification
   ///////////////////////////////////////////////////////////////////
-  // designed for secondary indexes.
+  // designed for secondary indexes. key holds the entry columns, see GetEntryAttrs
   virtual void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
   // delete the index entry linked to given tuple
@@ -137,6 +181,31 @@ class Index {
 
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  // batched ScanKey, (*results)[i] holds the RIDs of keys[i]. Indexes that can share work between the keys of a
+  // batch override this, the default scans the keys one by one.
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->assign(keys.size(), std::vector<RID>());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+  }
+
+  // index-only ScanKey: entries[i] holds the entry columns (see GetEntrySchema) of (*result)[i], read from the
+  // index itself. Only covering indexes store more than the key.
+  virtual void ScanEntries(const Tuple &key, std::vector<Tuple> *entries, std::vector<RID> *result,
+                           Transaction *transaction) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "index-only scans are not supported by " + GetName());
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Statistics
+  ///////////////////////////////////////////////////////////////////
+  // collect the statistics of the index, reading only a sample of its entries if sample_rate < 1
+  virtual void CollectStats(IndexStats *stats, double sample_rate, int num_buckets, Transaction *transaction) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "statistics are not supported by " + GetName());
+  }
+
  private:
   //===--------------------------------------------------------------------===//
   //  Data members
@@ -13,20 +13,40 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <functional>
+#include <vector>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * Walks the leaf level from left to right along the right links.
+ *
+ * Only one page is latched at a time, so pages change between steps. The
+ * iterator keeps the current pair and the frame and version of its leaf: an
+ * unchanged leaf is stepped through by position. Otherwise the leaf may have
+ * split or even been merged away and freed, so the iterator looks the current
+ * key up from the root again and goes to the smallest key above. Keys that
+ * stay in the tree throughout the scan are neither lost nor repeated.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
-  // you may define your own constructor based on your member variables
-  IndexIterator(page_id_t page_id, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                int start_ind = 0);
+  /**
+   * Start at index start_ind of the read latched leaf page, which the iterator
+   * releases, or at the end if page is nullptr. find_leaf descends from the
+   * root to the read latched leaf of a key. The iterator ends before stop_key,
+   * or after it if is_stop_inclusive, and runs to the last key if it is nullptr.
+   */
+  IndexIterator(Page *page, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                std::function<Page *(const KeyType &)> find_leaf = nullptr, int start_ind = 0,
+                bool unique_keys = true, const KeyType *stop_key = nullptr, bool is_stop_inclusive = false);
   ~IndexIterator();
 
   bool isEnd() const;
@@ -39,14 +59,50 @@ class IndexIterator {
 
   bool operator!=(const IndexIterator &itr) const;
 
+  /**
+   * Batch scan, a leaf at a time: decode the entries of the current leaf from the current position on into batch,
+   * then move on to the next leaf, so the leaf is pinned and latched once for all of its entries. The scan ends after
+   * end_key (inclusive, no bound if nullptr). Entries whose key fails the predicate are skipped within the leaf.
+   * @return false if the scan is over, batch is not empty otherwise
+   */
+  bool NextBatch(std::vector<MappingType> *batch, const KeyType *end_key = nullptr,
+                 const std::function<bool(const KeyType &)> &predicate = nullptr);
+
  private:
   void ReleasePage(Page *page) const;
 
+  bool IsLeafChanged(Page *page) const;
+
+  void MoveTo(Page *page, int index);
+
+  void LoadItem(Page *page, int index);
+
+  Page *FetchPostingPage(Page *leaf_page, const ValueType &reference) const;
+
+  void AppendPostingList(Page *leaf_page, const MappingType &item, std::vector<MappingType> *batch);
+
+  bool IsPastStop(const KeyType &key) const;
+
   // add your own private member variables here
   BufferPoolManager *buffer_pool_manager_ = nullptr;
   KeyComparator comparator_;
+  std::function<Page *(const KeyType &)> find_leaf_;
   page_id_t cur_page_id_ = INVALID_PAGE_ID;
   int cur_ind_ = 0;
+  // the frame and version of the current leaf when the current pair was loaded, see Page::GetVersion()
+  Page *cur_page_ = nullptr;
+  uint64_t cur_version_ = 0;
+  // keys with duplicates yield every value of their posting list, which is inline or on posting pages.
+  // INVALID_PAGE_ID stands for the head page
+  bool unique_keys_ = true;
+  page_id_t posting_page_id_ = INVALID_PAGE_ID;
+  int posting_ind_ = 0;
+  // end of the range of a partitioned scan
+  bool has_stop_key_ = false;
+  bool is_stop_inclusive_ = false;
+  KeyType stop_key_;
+  // keys are rebuilt from their compressed entries, so the current pair is copied out
+  MappingType item_;
 };
 
 }  // namespace bustub
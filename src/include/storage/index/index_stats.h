@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_stats.h
+//
+// Identification: src/include/storage/index/index_stats.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * Statistics of an index, collected by Index::CollectStats and kept in the
+ * catalog (see Catalog::AnalyzeIndex).
+ *
+ * The structural part describes the pages of the index, to spot indexes that
+ * need to be rebuilt. The equi-depth histogram describes the key distribution,
+ * to estimate how many entries a lookup or range scan returns: bucket i holds
+ * the keys within (histogram_bounds_[i - 1], histogram_bounds_[i]], the first
+ * bucket every key up to its bound. Buckets hold about the same number of
+ * values, except that a key never spans two buckets.
+ *
+ * If only a sample of the leaves was read, every count is scaled up to the
+ * whole index.
+ */
+struct IndexStats {
+  /**
+   * Estimate the fraction of the values of the index whose key is within
+   * [low_key, high_key]. nullptr stands for an open end.
+   * @param key_schema the schema of the keys and the bounds
+   */
+  double EstimateSelectivity(const Tuple *low_key, const Tuple *high_key, const Schema *key_schema) const;
+
+  // Get a string representation for debugging
+  std::string ToString() const;
+
+  // number of levels, 0 for an empty index
+  uint32_t height_{0};
+  // number of pages of each level, root first
+  std::vector<uint64_t> num_pages_;
+  // average fraction of the page space in use on each level, root first
+  std::vector<double> fill_factors_;
+  // pages that keep the values of duplicate keys, see BPlusTreePostingPage
+  uint64_t num_posting_pages_{0};
+  // number of distinct keys
+  uint64_t num_keys_{0};
+  // number of values, i.e. RIDs
+  uint64_t num_values_{0};
+  // fraction of the leaves that were read
+  double sample_rate_{1.0};
+
+  // upper bound of each bucket, a tuple of the key schema
+  std::vector<Tuple> histogram_bounds_;
+  // number of values of each bucket
+  std::vector<uint64_t> histogram_counts_;
+  // number of distinct keys of each bucket
+  std::vector<uint64_t> histogram_num_keys_;
+};
+
+}  // namespace bustub
@@ -41,8 +41,9 @@ class LinearProbeHashTableIndex : public Index {
  protected:
   // comparator for key
   KeyComparator comparator_;
-  // container
-  LinearProbeHashTable<KeyType, ValueType, KeyComparator> container_;
+  // container, the tags of its blocks keep long probe sequences cheap
+  LinearProbeHashTable<KeyType, ValueType, KeyComparator, HashTableTaggedBlockPage<KeyType, ValueType, KeyComparator>>
+      container_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// reverse_index_iterator.h
+//
+// Identification: src/include/storage/index/reverse_index_iterator.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+/**
+ * reverse_index_iterator.h
+ * For descending range scan of b+ tree
+ */
+#pragma once
+#include <functional>
+
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
+
+namespace bustub {
+
+#define REVERSE_INDEXITERATOR_TYPE ReverseIndexIterator<KeyType, ValueType, KeyComparator>
+
+/**
+ * Walks the leaf level from right to left along the left links, yielding keys
+ * in descending order. The values of a key with duplicates still come in
+ * ascending order, posting lists are only linked forward.
+ *
+ * Only one page is latched at a time, so pages change between steps. The
+ * iterator keeps the current pair and steps by key: it finds the current key
+ * again and goes to the greatest key below. If its leaf changed since the pair
+ * was loaded, the leaf may have split or even been merged away and freed, so
+ * the key is looked up from the root again.
+ * Left links are hints as well (see BPlusTreeSlottedPage): the left sibling
+ * may have split or merged by the time it is latched, so the iterator moves
+ * right from the linked page if that page split in the meantime.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class ReverseIndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
+ public:
+  /**
+   * Start at index start_ind of the read latched leaf page, which the iterator
+   * releases, or at the end if page is nullptr. A negative start_ind starts at
+   * the greatest key below bound (every key if nullptr) left of the leaf.
+   * find_leaf descends from the root to the read latched leaf of a key.
+   */
+  ReverseIndexIterator(Page *page, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                       std::function<Page *(const KeyType &)> find_leaf = nullptr, int start_ind = 0,
+                       bool unique_keys = true, const KeyType *bound = nullptr);
+  ~ReverseIndexIterator();
+
+  bool isEnd() const;
+
+  const MappingType &operator*() const;
+
+  ReverseIndexIterator &operator++();
+
+  bool operator==(const ReverseIndexIterator &itr) const;
+
+  bool operator!=(const ReverseIndexIterator &itr) const;
+
+ private:
+  void ReleasePage(Page *page) const;
+
+  void MoveToPrevPage(Page *page, const KeyType *bound);
+
+  Page *LatchLeaf(Page *page) const;
+
+  void LoadItem(Page *page, int index);
+
+  Page *FetchPostingPage(Page *leaf_page, const ValueType &reference) const;
+
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  KeyComparator comparator_;
+  std::function<Page *(const KeyType &)> find_leaf_;
+  page_id_t cur_page_id_ = INVALID_PAGE_ID;
+  // the frame and version of the current leaf when the current pair was loaded, see Page::GetVersion()
+  Page *cur_page_ = nullptr;
+  uint64_t cur_version_ = 0;
+  // keys with duplicates yield every value of their posting list, which is inline or on posting pages.
+  // INVALID_PAGE_ID stands for the head page
+  bool unique_keys_ = true;
+  page_id_t posting_page_id_ = INVALID_PAGE_ID;
+  int posting_ind_ = 0;
+  // the current pair, its key is looked up again on every step
+  MappingType item_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_fixed_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_fixed_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "storage/page/b_plus_tree_key_search.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_PLUS_TREE_FIXED_PAGE_TYPE BPlusTreeFixedPage<KeyType, ValueType, KeyComparator>
+#define FIXED_PAGE_ENTRY_SIZE (sizeof(KeyType) + sizeof(ValueType))
+// the list bitmap takes one bit per slot there would be without it
+#define FIXED_PAGE_LIST_WORDS (((PAGE_SIZE - 48 - 2 * sizeof(KeyType)) / FIXED_PAGE_ENTRY_SIZE + 63) / 64)
+#define FIXED_PAGE_HEADER_SIZE (48 + 8 * FIXED_PAGE_LIST_WORDS + 2 * sizeof(KeyType))
+#define FIXED_PAGE_SLOTS ((PAGE_SIZE - FIXED_PAGE_HEADER_SIZE) / FIXED_PAGE_ENTRY_SIZE)
+
+/**
+ * The counterpart of BPlusTreeSlottedPage for keys of one machine word, e.g.
+ * integer keys. Such keys gain nothing from head compression, so every entry
+ * takes the same space and keys and values live in separate arrays: a search
+ * only touches the keys and uses the SIMD search of KeySearch. The interface
+ * is the one of BPlusTreeSlottedPage, with space counted in whole entries.
+ *
+ * Page format (keys are stored in order):
+ *  ------------------------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) | ... | KEY(n) | free keys | VALUE(1) | ... | VALUE(n) | free values | value lists |
+ *  ------------------------------------------------------------------------------------------------------
+ *
+ * An entry with several values (see BPlusTreeLeafPage) is marked in the list
+ * bitmap, its value is a handle, Offset (2) | Count (2), to the run of values
+ * at VALUE(Offset) in the value lists. The lists are allocated from the end of
+ * the page, every value of a list takes the space of a whole entry. Removed
+ * lists stay behind as garbage until the page runs out of contiguous space
+ * and is compacted.
+ *
+ * Header format (size in byte, 48 bytes + 8 * ListWords + 2 * sizeof(KeyType) in total):
+ *  ------------------------------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) | PageId (4) |
+ *  ------------------------------------------------------------------------------------------
+ *  -------------------------------------------------------------------------------------------------
+ * | NextPageId (4) | LowKeyVersion (4) | PrevPageId (4) | HasLowKey (2) | NumLists (2) | HeapOffset (2) |
+ *  -------------------------------------------------------------------------------------------------
+ *  -----------------------------------------------------------------------------------------------------------
+ * | GarbageSize (2) | Reserved (4) | ListBitmap (8 * ListWords) | LowKey (KeyType) | HighKey (KeyType) |
+ *  -----------------------------------------------------------------------------------------------------------
+ *
+ * The B-link fields mean the same as in BPlusTreeSlottedPage. HeapOffset and
+ * GarbageSize count values.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeFixedPage : public BPlusTreePage {
+ public:
+  static constexpr int SLOTS = FIXED_PAGE_SLOTS;
+  // most values a single entry holds
+  static constexpr int MAX_ENTRY_VALUES = 256;
+
+  KeyType KeyAt(int index) const;
+  // the first value of the entry at index
+  ValueType ValueAt(int index) const;
+  ValueType ValueAt(int index, int value_index) const;
+  // number of values of the entry at index, at least 1
+  int ValueCountAt(int index) const;
+
+  page_id_t GetNextPageId() const;
+  page_id_t GetPrevPageId() const;
+  void SetPrevPageId(page_id_t prev_page_id);
+  KeyType GetHighKey() const;
+  bool HasLowKey() const;
+  KeyType GetLowKey() const;
+  bool ShouldMoveRight(const KeyType &key, const KeyComparator &comparator) const;
+  uint32_t GetLowKeyVersion() const;
+  void IncreaseLowKeyVersion();
+
+  // keys are not compressed, there is no prefix
+  int GetPrefixSize() const;
+  // bytes taken by the entries
+  int GetUsedSpace() const;
+  // bytes still available for new entries
+  int GetFreeSpace() const;
+  // bytes the entry of key would take, the same for every key
+  int EntrySize(const KeyType &key) const;
+  // bytes a single insertion takes at most: a second value turns the entry into a list of two
+  int MaxEntrySize() const;
+
+  // fixed-width keys are not truncated, right is the separator
+  static KeyType ShortestSeparator(const KeyType &left, const KeyType &right);
+
+ protected:
+  static constexpr int ENTRY_SIZE = FIXED_PAGE_ENTRY_SIZE;
+  static constexpr int CAPACITY = SLOTS * ENTRY_SIZE;
+
+  void InitSlots();
+  // first index i >= begin so that KeyAt(i) >= key
+  int LowerBound(const KeyType &key, int begin, bool *is_equal = nullptr) const;
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  void RemoveAt(int index);
+  void SetKeyAt(int index, const KeyType &key);
+  // the entry at index must hold a single value
+  void SetValueAt(int index, const ValueType &value);
+  bool CanSetValuesAt(int index, int count, int reserve_space) const;
+  void SetValuesAt(int index, const ValueType *values, int count);
+
+  std::vector<ItemType> GetItems() const;
+  void Assign(const ItemType *items, int size);
+  void SetFences(const KeyType *low_key, page_id_t next_page_id, const KeyType *high_key);
+  const KeyType *LowFence() const;
+  const KeyType *HighFence() const;
+  int HalfSpaceIndex() const;
+  bool Fits(const ItemType *items, int size, const KeyType *low_key, const KeyType *high_key,
+            int reserve_entries) const;
+
+ private:
+  static constexpr int LIST_WORDS = FIXED_PAGE_LIST_WORDS;
+
+  int ClampedSize() const;
+  const ValueType *Values() const;
+  ValueType *Values();
+  bool IsList(int index) const;
+  void GetList(int index, int *offset, int *count) const;
+  void SetList(int index, int offset, int count);
+  void FreeList(int index);
+  void InsertListBit(int index);
+  void RemoveListBit(int index);
+  void Compact();
+  // entries of space an entry with count values takes
+  static int EntryUnits(int count);
+
+  page_id_t next_page_id_;
+  uint32_t low_key_version_;
+  page_id_t prev_page_id_;
+  uint16_t has_low_key_;
+  uint16_t num_lists_;
+  uint16_t heap_offset_;
+  uint16_t garbage_size_;
+  uint32_t reserved_ __attribute__((__unused__));
+  uint64_t lists_[LIST_WORDS];
+  KeyType low_key_;
+  KeyType high_key_;
+  KeyType keys_[0];
+};
+
+}  // namespace bustub
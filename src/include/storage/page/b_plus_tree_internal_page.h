@@ -12,13 +12,13 @@
 
 #include <queue>
 
-#include "storage/page/b_plus_tree_page.h"
+#include "storage/page/b_plus_tree_node_layout.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+// one slot more than the max size, an overflowing page holds max size + 1 children until it is split
+#define INTERNAL_PAGE_SIZE (BPlusTreeNodeLayout<KeyType, page_id_t, KeyComparator>::SLOTS - 1)
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -27,43 +27,54 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Internal pages use the layout picked from the key type by
+ * BPlusTreeNodeLayout, in the slotted layout the entry of the first key
+ * stores no key at all. LowKey and HighKey are the separators of the page in
+ * its parent, every key of the page lies within them. Keys pushed up by a
+ * split or moved through the parent keep their bytes, only leaf splits pick
+ * shorter separators.
+ *
+ * Slotted separators differ in size, so replacing one may need more space. Insertions
+ * split a page before the new entry would not fit, and a key is only replaced
+ * if there is room for it (see CanSetKeyAt).
  */
 INDEX_TEMPLATE_ARGUMENTS
-class BPlusTreeInternalPage : public BPlusTreePage {
+class BPlusTreeInternalPage : public BPlusTreeNodeLayout<KeyType, ValueType, KeyComparator> {
  public:
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
 
-  KeyType KeyAt(int index) const;
-  void SetKeyAt(int index, const KeyType &key);
+  using BPlusTreeNodeLayout<KeyType, ValueType, KeyComparator>::SetKeyAt;
+  bool CanSetKeyAt(int index, const KeyType &key) const;
   int ValueIndex(const ValueType &value) const;
-  ValueType ValueAt(int index) const;
+
+  // size checks, the safe ones hold if the next insertion / deletion cannot split / underflow the page
+  bool IsOverflow() const;
+  bool IsUnderflow() const;
+  bool IsInsertSafe() const;
+  bool IsDeleteSafe() const;
+  // @return true if there is room to insert key without splitting first
+  bool HasRoomFor(const KeyType &key) const;
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+  int Append(const KeyType &new_key, const ValueType &new_value);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
-  // Split and Merge utility methods
+  // Split and Merge utility methods, the ones returning bool do nothing if the result does not fit
+  bool CanMoveAllTo(const BPlusTreeInternalPage *recipient, const KeyType &middle_key) const;
   void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key, BufferPoolManager *buffer_pool_manager);
   void MoveHalfTo(BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager);
-  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+  bool MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                         BufferPoolManager *buffer_pool_manager);
-  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+  bool MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                          BufferPoolManager *buffer_pool_manager);
+  // link the empty page built after this one by bulk loading
+  void LinkRightSibling(BPlusTreeInternalPage *sibling, const KeyType &separator);
 
  private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  MappingType array[0];
-
-  int keyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  void updateParentPageId(const MappingType &pair, BufferPoolManager *buffer_pool_manager) const;
+  void updateParentPageId(const ValueType &child, BufferPoolManager *buffer_pool_manager) const;
 };
 }  // namespace bustub
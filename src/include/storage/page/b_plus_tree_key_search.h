@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_search.h
+//
+// Identification: src/include/storage/page/b_plus_tree_key_search.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+/**
+ * Binary search over a contiguous key array.
+ * @return the first index i in [l, r) with keys[i] >= key, or r
+ */
+template <typename KeyType, typename KeyComparator>
+inline int BinaryLowerBound(const KeyType *keys, int l, int r, const KeyType &key, const KeyComparator &comparator) {
+  while (l < r) {
+    int mid = l + (r - l) / 2;
+    if (comparator(keys[mid], key) == -1) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+  return l;
+}
+
+/**
+ * Searches normalized keys of one machine word (see GenericKey), which compare as big-endian unsigned integers, in
+ * the key array of a fixed-width B+ tree page (see BPlusTreeFixedPage).
+ * A branchy binary search narrows the range down to a few cache lines, then the keys below the search key are
+ * counted with AVX2, which avoids the mispredicted branches of the last binary search steps.
+ */
+template <typename Word>
+class NormalizedKeySearch {
+ public:
+  // keys scanned linearly, four cache lines
+  static constexpr int LINEAR_WINDOW = 256 / sizeof(Word);
+
+  template <typename KeyType>
+  static int LowerBound(const KeyType *keys, int size, const KeyType &key) {
+    static_assert(sizeof(KeyType) == sizeof(Word), "key must be one word");
+    auto target = Load(&key);
+    int l = 0;
+    int r = size;
+    while (r - l > LINEAR_WINDOW) {
+      int mid = l + (r - l) / 2;
+      if (Load(&keys[mid]) < target) {
+        l = mid + 1;
+      } else {
+        r = mid;
+      }
+    }
+    return l + CountLess(reinterpret_cast<const char *>(keys + l), r - l, target);
+  }
+
+ private:
+  static Word Load(const void *key) {
+    Word word;
+    memcpy(&word, key, sizeof(Word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (sizeof(Word) == sizeof(uint64_t)) {
+      word = __builtin_bswap64(word);
+    } else {
+      word = __builtin_bswap32(word);
+    }
+#endif
+    return word;
+  }
+
+  // number of keys below target among n sorted keys
+  static int CountLess(const char *keys, int n, Word target);
+};
+
+template <>
+inline int NormalizedKeySearch<uint64_t>::CountLess(const char *keys, int n, uint64_t target) {
+  int i = 0;
+#ifdef __AVX2__
+  // byte swap every 64-bit lane and flip the sign bit, so that a signed compare orders like memcmp
+  const __m256i bswap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                         15, 14, 13, 12, 11, 10, 9, 8);
+  const __m256i flip = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i needle = _mm256_set1_epi64x(static_cast<int64_t>(target ^ (1ULL << 63)));
+  for (; i + 4 <= n; i += 4) {
+    auto lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i * sizeof(uint64_t)));
+    lanes = _mm256_xor_si256(_mm256_shuffle_epi8(lanes, bswap), flip);
+    auto mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(needle, lanes)));
+    if (mask != 0xF) {
+      return i + __builtin_popcount(mask);
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (Load(keys + i * sizeof(uint64_t)) >= target) {
+      break;
+    }
+  }
+  return i;
+}
+
+template <>
+inline int NormalizedKeySearch<uint32_t>::CountLess(const char *keys, int n, uint32_t target) {
+  int i = 0;
+#ifdef __AVX2__
+  const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4,
+                                         11, 10, 9, 8, 15, 14, 13, 12);
+  const __m256i flip = _mm256_set1_epi32(INT32_MIN);
+  const __m256i needle = _mm256_set1_epi32(static_cast<int32_t>(target ^ (1U << 31)));
+  for (; i + 8 <= n; i += 8) {
+    auto lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i * sizeof(uint32_t)));
+    lanes = _mm256_xor_si256(_mm256_shuffle_epi8(lanes, bswap), flip);
+    auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(needle, lanes)));
+    if (mask != 0xFF) {
+      return i + __builtin_popcount(mask);
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (Load(keys + i * sizeof(uint32_t)) >= target) {
+      break;
+    }
+  }
+  return i;
+}
+
+/**
+ * Searches the slot array of a slotted B+ tree page (see BPlusTreeSlottedPage). Every slot keeps the head of its key
+ * in the upper 32 bits, so slots order like their heads when compared as unsigned integers. A branchy binary search
+ * narrows the range down to a few cache lines, then the slots below the search head are counted with AVX2, which
+ * avoids the mispredicted branches of the last binary search steps.
+ * @return the first index i in [0, size) whose head is >= head, or size
+ */
+inline int SlotHeadLowerBound(const uint64_t *slots, int size, uint32_t head) {
+  // slots scanned linearly, four cache lines
+  constexpr int linear_window = 32;
+  auto target = static_cast<uint64_t>(head) << 32;
+  int l = 0;
+  int r = size;
+  while (r - l > linear_window) {
+    int mid = l + (r - l) / 2;
+    if (slots[mid] < target) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+
+  int i = l;
+#ifdef __AVX2__
+  // flip the sign bit of every 64-bit lane, so that a signed compare orders like an unsigned one
+  const __m256i flip = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i needle = _mm256_set1_epi64x(static_cast<int64_t>(target ^ (1ULL << 63)));
+  for (; i + 4 <= r; i += 4) {
+    auto lanes = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(slots + i)), flip);
+    auto mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(needle, lanes)));
+    if (mask != 0xF) {
+      return i + __builtin_popcount(mask);
+    }
+  }
+#endif
+  for (; i < r; ++i) {
+    if (slots[i] >= target) {
+      break;
+    }
+  }
+  return i;
+}
+
+}  // namespace bustub
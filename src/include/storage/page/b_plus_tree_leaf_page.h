@@ -13,63 +13,70 @@
 #include <utility>
 #include <vector>
 
-#include "storage/page/b_plus_tree_page.h"
+#include "storage/page/b_plus_tree_node_layout.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_SIZE (BPlusTreeNodeLayout<KeyType, ValueType, KeyComparator>::SLOTS)
+// longest posting list kept inline in a leaf entry
+#define LEAF_PAGE_MAX_INLINE_VALUES 32
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
+ * page. Keys are unique within the page, a tree with duplicate keys keeps the
+ * RIDs of a key inline in its entry, in RID order, as long as there are at
+ * most LEAF_PAGE_MAX_INLINE_VALUES of them. Longer lists are spilled to
+ * posting pages and the entry holds a reference to them instead (see
+ * BPlusTreePostingPage).
  *
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
- *
- *  Header format (size in byte, 28 bytes in total):
- *  ---------------------------------------------------------------------
- * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
- *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ * Leaf pages use the layout picked from the key type by BPlusTreeNodeLayout,
+ * which also holds the B-link fields. A page is full once it holds max size
+ * entries or has no room for another entry of the largest size, whichever
+ * comes first, and it only underflows if it is below both min size and half
+ * of its space. The separator of a split is the shortest key between both
+ * halves (suffix truncation for slotted pages), it becomes HighKey of the
+ * left and LowKey of the right page. Leaves are doubly linked, PrevPageId
+ * leads to the left sibling.
  */
 INDEX_TEMPLATE_ARGUMENTS
-class BPlusTreeLeafPage : public BPlusTreePage {
+class BPlusTreeLeafPage : public BPlusTreeNodeLayout<KeyType, ValueType, KeyComparator> {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
   // helper methods
-  page_id_t GetNextPageId() const;
-  void SetNextPageId(page_id_t next_page_id);
-  KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  // index of key, or -1 if it does not exist
+  int LookupIndex(const KeyType &key, const KeyComparator &comparator) const;
+  MappingType GetItem(int index) const;
+  void GetValues(int index, std::vector<ValueType> *values) const;
+
+  // size checks, the safe ones hold if the next insertion / deletion cannot split / underflow the page
+  bool IsOverflow() const;
+  bool IsUnderflow() const;
+  bool IsInsertSafe() const;
+  bool IsDeleteSafe() const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
   bool Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const;
+  bool Update(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
+  bool SetValues(int index, const std::vector<ValueType> &values, bool can_overflow);
+  bool HasRoomForValue(int index) const;
   int RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator);
 
-  // Split and Merge utility methods
+  // Split and Merge utility methods, the ones returning bool do nothing if the result does not fit
   void MoveHalfTo(BPlusTreeLeafPage *recipient);
+  bool CanMoveAllTo(const BPlusTreeLeafPage *recipient) const;
   void MoveAllTo(BPlusTreeLeafPage *recipient);
-  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
-  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
+  bool MoveFirstToEndOf(BPlusTreeLeafPage *recipient, const KeyType &separator);
+  bool MoveLastToFrontOf(BPlusTreeLeafPage *recipient, const KeyType &separator);
+  // link the empty page built after this one by bulk loading
+  void LinkRightSibling(BPlusTreeLeafPage *sibling, const KeyType &separator);
 
  private:
-  void CopyNFrom(MappingType *items, int size);
-  void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item);
-  page_id_t next_page_id_;
-  MappingType array[0];
-
   int keyIndex(const KeyType &key, const KeyComparator &comparator) const;
 };
 }  // namespace bustub
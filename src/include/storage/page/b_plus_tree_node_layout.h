@@ -0,0 +1,34 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_node_layout.h
+//
+// Identification: src/include/storage/page/b_plus_tree_node_layout.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "storage/page/b_plus_tree_fixed_page.h"
+#include "storage/page/b_plus_tree_slotted_page.h"
+
+namespace bustub {
+
+/**
+ * The layout of the entries of leaf and internal pages, picked at compile
+ * time from the key type. Keys of up to one machine word, e.g. integer keys,
+ * use the fixed-width layout with its SIMD key search (BPlusTreeFixedPage).
+ * Wider keys, e.g. string keys, use the slotted layout with head compression
+ * and suffix truncation (BPlusTreeSlottedPage).
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+using BPlusTreeNodeLayout =
+    std::conditional_t<sizeof(KeyType) <= sizeof(uint64_t), BPlusTreeFixedPage<KeyType, ValueType, KeyComparator>,
+                       BPlusTreeSlottedPage<KeyType, ValueType, KeyComparator>>;
+
+}  // namespace bustub
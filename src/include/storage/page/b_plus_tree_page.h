@@ -14,6 +14,7 @@
 #include <climits>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "storage/index/generic_key.h"
@@ -21,9 +22,25 @@
 namespace bustub {
 
 #define MappingType std::pair<KeyType, ValueType>
+#define ItemType BPlusTreeItem<KeyType, ValueType>
 
 #define INDEX_TEMPLATE_ARGUMENTS template <typename KeyType, typename ValueType, typename KeyComparator>
 
+/**
+ * An entry taken out of a leaf or internal page, e.g. while entries are
+ * redistributed between pages. Leaf entries of a tree with duplicate keys may
+ * hold an inline list of values (see BPlusTreeLeafPage), the values after the
+ * first one are kept in more_values.
+ */
+template <typename KeyType, typename ValueType>
+struct BPlusTreeItem {
+  BPlusTreeItem(const KeyType &key, const ValueType &value) : first(key), second(value) {}
+
+  KeyType first;
+  ValueType second;
+  std::vector<ValueType> more_values;
+};
+
 // define page type enum
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
@@ -44,6 +61,7 @@ class BPlusTreePage {
  public:
   bool IsLeafPage() const;
   bool IsRootPage() const;
+  bool IsInvalidPage() const;
   void SetPageType(IndexPageType page_type);
 
   int GetSize() const;
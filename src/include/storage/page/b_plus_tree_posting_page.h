@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_posting_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <limits>
+
+#include "common/config.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+#define POSTING_PAGE_HEADER_SIZE 16
+#define POSTING_PAGE_SIZE ((PAGE_SIZE - POSTING_PAGE_HEADER_SIZE) / sizeof(RID))
+
+/**
+ * Posting list of a B+ tree that allows duplicate keys. A key with a few
+ * RIDs keeps them inline in its leaf entry (see BPlusTreeLeafPage). Once
+ * they outgrow the entry, the leaf entry is replaced by a reference (see
+ * MakeReference) to a chain of posting pages holding all RIDs of the key in
+ * ascending order, every page covering a range of RIDs above the ones of its
+ * predecessor.
+ *
+ * Posting pages are owned by the leaf entry and are only accessed while
+ * holding the latch of the leaf page that contains the entry, so they are
+ * never latched themselves.
+ *
+ * Posting page format (RIDs are stored in order):
+ *  ----------------------------------------------
+ * | HEADER | RID(1) | RID(2) | ... | RID(n) |
+ *  ----------------------------------------------
+ *
+ *  Header format (size in byte, 16 bytes in total):
+ *  -----------------------------------------------------------
+ * | LSN (4) | CurrentSize (4) | NextPageId (4) | Reserved (4) |
+ *  -----------------------------------------------------------
+ */
+class BPlusTreePostingPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  BPlusTreePostingPage() = delete;
+
+  // After creating a new posting page from buffer pool, must call initialize method to set default values
+  void Init(page_id_t next_page_id = INVALID_PAGE_ID);
+
+  int GetSize() const { return size_; }
+  page_id_t GetNextPageId() const { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+  bool IsFull() const { return size_ == static_cast<int>(POSTING_PAGE_SIZE); }
+  const RID &ValueAt(int index) const { return values_[index]; }
+
+  // @return true if value is greater than every RID of this page
+  bool IsAfter(const RID &value) const;
+  bool Contains(const RID &value) const;
+
+  // insert and delete methods, both return false if nothing changed
+  bool Insert(const RID &value);
+  bool Remove(const RID &value);
+
+  // Split and Merge utility methods
+  void MoveHalfTo(BPlusTreePostingPage *recipient);
+  void MoveAllTo(BPlusTreePostingPage *recipient);
+
+  /**
+   * Leaf entries store either a RID or a reference to the head posting page
+   * of their key. References use a slot number no table page can have.
+   */
+  static RID MakeReference(page_id_t page_id) { return RID(page_id, REFERENCE_SLOT_NUM); }
+  static bool IsReference(const RID &value) { return value.GetSlotNum() == REFERENCE_SLOT_NUM; }
+
+ private:
+  static constexpr uint32_t REFERENCE_SLOT_NUM = std::numeric_limits<uint32_t>::max();
+
+  int ValueIndex(const RID &value) const;
+
+  lsn_t lsn_ __attribute__((__unused__));
+  int size_;
+  page_id_t next_page_id_;
+  int reserved_ __attribute__((__unused__));
+  RID values_[0];
+};
+
+}  // namespace bustub
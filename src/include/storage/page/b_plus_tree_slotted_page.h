@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_slotted_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_slotted_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "storage/page/b_plus_tree_key_search.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_PLUS_TREE_SLOTTED_PAGE_TYPE BPlusTreeSlottedPage<KeyType, ValueType, KeyComparator>
+#define SLOTTED_PAGE_HEADER_SIZE (48 + 2 * sizeof(KeyType))
+// number of entries that fit when no key needs heap space
+#define SLOTTED_PAGE_SLOTS ((PAGE_SIZE - SLOTTED_PAGE_HEADER_SIZE) / (sizeof(uint64_t) + sizeof(ValueType)))
+
+/**
+ * The part leaf and internal pages share for keys wider than a machine word
+ * (see BPlusTreeNodeLayout): the B-link fields and the slotted layout of the
+ * entries, which stores keys with variable length.
+ *
+ * Keys are normalized (see GenericKey), they order like their bytes and their
+ * trailing zero bytes carry no information. Every key of a page lies within
+ * the fences of the page, LowKey <= key < HighKey, so all keys share the
+ * common prefix of both fences (head compression). The prefix is stored once,
+ * as the start of LowKey, and every entry only keeps the rest of its key
+ * without the trailing zero bytes. The first four bytes of that suffix are
+ * the head of the key, which lives in the slot, so a search rarely touches
+ * the entries themselves.
+ *
+ * Page format (slots are stored in key order):
+ *  ---------------------------------------------------------------------------
+ * | HEADER | SLOT(1) | ... | SLOT(n) | free space | ENTRY(x) | ... | ENTRY(y) |
+ *  ---------------------------------------------------------------------------
+ *
+ * Slot format (64 bits): Head (32) | Offset (16) | MoreValues (8) | Size (8)
+ * Entry format: Value | ... | Value | key suffix without its head (Size - 4 bytes, if any)
+ *
+ * An entry holds MoreValues + 1 values. Leaf pages keep the short posting
+ * lists of duplicate keys inline this way, see BPlusTreeLeafPage.
+ *
+ * Entries are allocated from the end of the page. Removed entries stay behind
+ * as garbage until the page runs out of contiguous space and is compacted.
+ *
+ * Header format (size in byte, 48 bytes + 2 * sizeof(KeyType) in total):
+ *  ------------------------------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) | PageId (4) |
+ *  ------------------------------------------------------------------------------------------
+ *  -------------------------------------------------------------------------------------
+ * | NextPageId (4) | LowKeyVersion (4) | HeapOffset (2) | GarbageSize (2) | Prefix (2) |
+ *  -------------------------------------------------------------------------------------
+ *  -----------------------------------------------------------------------------------------
+ * | HasLowKey (2) | PrevPageId (4) | Reserved (4) | LowKey (KeyType) | HighKey (KeyType) |
+ *  -----------------------------------------------------------------------------------------
+ *
+ * B-link: NextPageId doubles as the right link. Every key of the page is below
+ * HighKey, which is only meaningful when there is a right sibling. Readers that
+ * reach the page without holding its parent move right while key >= HighKey.
+ * LowKeyVersion is bumped whenever entries leave towards the left sibling
+ * (merge or redistribution), which such readers cannot recover from. LowKey is
+ * the separator of the page in its parent, the leftmost page of a level has
+ * none.
+ *
+ * PrevPageId is the left link of the leaf level, for descending scans. Unlike
+ * the right link it is only a hint for readers: a page may split or merge
+ * between reading the link and latching its target, so scans locate their
+ * position by key once they get there. Internal pages do not keep it.
+ *
+ * Pages are read without latches by optimistic readers, so every read of the
+ * slots stays within the page no matter what it finds there.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeSlottedPage : public BPlusTreePage {
+ public:
+  static constexpr int SLOTS = SLOTTED_PAGE_SLOTS;
+  // most values a single entry holds
+  static constexpr int MAX_ENTRY_VALUES = 256;
+
+  KeyType KeyAt(int index) const;
+  // the first value of the entry at index
+  ValueType ValueAt(int index) const;
+  ValueType ValueAt(int index, int value_index) const;
+  // number of values of the entry at index, at least 1
+  int ValueCountAt(int index) const;
+
+  page_id_t GetNextPageId() const;
+  page_id_t GetPrevPageId() const;
+  void SetPrevPageId(page_id_t prev_page_id);
+  KeyType GetHighKey() const;
+  bool HasLowKey() const;
+  KeyType GetLowKey() const;
+  bool ShouldMoveRight(const KeyType &key, const KeyComparator &comparator) const;
+  uint32_t GetLowKeyVersion() const;
+  void IncreaseLowKeyVersion();
+
+  // size of the key prefix shared by every entry
+  int GetPrefixSize() const;
+  // bytes taken by the slots and the live entries
+  int GetUsedSpace() const;
+  // bytes still available for new entries, including garbage
+  int GetFreeSpace() const;
+  // bytes the entry of key would take, including its slot
+  int EntrySize(const KeyType &key) const;
+  // bytes the largest possible entry would take
+  int MaxEntrySize() const;
+
+  /**
+   * Suffix truncation: the shortest key k with left < k <= right, i.e. the
+   * bytes of right up to the first one that differs from left.
+   */
+  static KeyType ShortestSeparator(const KeyType &left, const KeyType &right);
+
+ protected:
+  static constexpr int CAPACITY = PAGE_SIZE - SLOTTED_PAGE_HEADER_SIZE;
+
+  void InitSlots();
+  // first index i >= begin so that KeyAt(i) >= key
+  int LowerBound(const KeyType &key, int begin, bool *is_equal = nullptr) const;
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  void RemoveAt(int index);
+  void SetKeyAt(int index, const KeyType &key);
+  void SetValueAt(int index, const ValueType &value);
+  bool CanSetValuesAt(int index, int count, int reserve_space) const;
+  void SetValuesAt(int index, const ValueType *values, int count);
+
+  // decode all entries, e.g. before they are redistributed between pages
+  std::vector<ItemType> GetItems() const;
+  // rewrite the page with the given entries, under its current fences, the entries have to fit
+  void Assign(const ItemType *items, int size);
+  // fences are changed before the entries are assigned again, nullptr stands for no fence
+  void SetFences(const KeyType *low_key, page_id_t next_page_id, const KeyType *high_key);
+  const KeyType *LowFence() const;
+  const KeyType *HighFence() const;
+  // index to split the page at by space
+  int HalfSpaceIndex() const;
+  /**
+   * @return true if the entries fit into a page with the given fences, leaving
+   * room for reserve_entries more entries of the largest size
+   */
+  bool Fits(const ItemType *items, int size, const KeyType *low_key, const KeyType *high_key,
+            int reserve_entries) const;
+
+ private:
+  bool IsKeyless(int index) const;
+  const char *Data() const;
+  char *Data();
+  int SlotsEnd() const;
+  int ClampedSize() const;
+  const char *EntryAt(uint64_t slot) const;
+  const char *SuffixAt(uint64_t slot) const;
+  int CompareAt(uint64_t slot, uint32_t head, const char *suffix, int size) const;
+  void Compact(int skip_index);
+  void WriteEntry(int index, const KeyType &key, const ValueType &value, const ValueType *more_values, int num_more);
+  static int PrefixSize(const KeyType *low_key, const KeyType *high_key);
+  static int SuffixOf(const KeyType &key, int prefix_size, const char **suffix);
+  static int EntryHeapSize(int suffix_size, int num_values);
+  static int MaxEntrySize(int prefix_size);
+
+  page_id_t next_page_id_;
+  uint32_t low_key_version_;
+  uint16_t heap_offset_;
+  uint16_t garbage_size_;
+  uint16_t prefix_size_;
+  uint16_t has_low_key_;
+  page_id_t prev_page_id_;
+  uint32_t reserved_ __attribute__((__unused__));
+  KeyType low_key_;
+  KeyType high_key_;
+  uint64_t slots_[0];
+};
+
+}  // namespace bustub
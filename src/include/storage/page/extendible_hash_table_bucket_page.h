@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_bucket_page.h
+//
+// Identification: src/include/storage/page/extendible_hash_table_bucket_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/index/int_comparator.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+/**
+ * Bucket page of an extendible hash table. Supports non-unique keys, but not
+ * duplicate (key, value) pairs. The pairs are packed at the front of the
+ * array in no particular order, a removal moves the last pair into the hole.
+ * Callers latch the page, the bucket is not thread safe by itself.
+ *
+ * A full bucket that cannot split any further links to overflow pages of the
+ * same format through NextPageId. The whole chain is protected by the latch
+ * of its first page.
+ *
+ * Bucket page format:
+ *  ----------------------------------------------------------------------------------
+ * | Size (4) | NextPageId (4) | KEY(1) + VALUE(1) | KEY(2) + VALUE(2) | ... | KEY(n) + VALUE(n)
+ *  ----------------------------------------------------------------------------------
+ *
+ *  Here '+' means concatenation.
+ *
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class ExtendibleHashTableBucketPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  ExtendibleHashTableBucketPage() = delete;
+
+  /**
+   * Initializes a new, empty bucket page
+   */
+  void Init();
+
+  /**
+   * Collects the values of a key.
+   *
+   * @param key the key to look up
+   * @param comparator comparator for keys
+   * @param[out] result the values of the key are appended to it
+   * @return true if the key has any value
+   */
+  bool GetValue(const KeyType &key, KeyComparator comparator, std::vector<ValueType> *result) const;
+
+  /**
+   * Inserts a key and value, unless the pair is in the bucket already or the
+   * bucket is full.
+   *
+   * @param key key to insert
+   * @param value value to insert
+   * @param comparator comparator for keys
+   * @return true if the pair is inserted
+   */
+  bool Insert(const KeyType &key, const ValueType &value, KeyComparator comparator);
+
+  /**
+   * Removes a key and value.
+   *
+   * @param key key to remove
+   * @param value value to remove
+   * @param comparator comparator for keys
+   * @return true if the pair was in the bucket
+   */
+  bool Remove(const KeyType &key, const ValueType &value, KeyComparator comparator);
+
+  /**
+   * @param key key to look for
+   * @param value value to look for
+   * @param comparator comparator for keys
+   * @return whether the pair is in the bucket
+   */
+  bool Contains(const KeyType &key, const ValueType &value, KeyComparator comparator) const;
+
+  /**
+   * Removes the pair at an index, the last pair takes its place.
+   *
+   * @param bucket_ind the index of the pair
+   */
+  void RemoveAt(uint32_t bucket_ind);
+
+  /**
+   * Gets the key at an index in the bucket.
+   *
+   * @param bucket_ind the index in the bucket to get the key at
+   * @return key at index bucket_ind of the bucket
+   */
+  KeyType KeyAt(uint32_t bucket_ind) const;
+
+  /**
+   * Gets the value at an index in the bucket.
+   *
+   * @param bucket_ind the index in the bucket to get the value at
+   * @return value at index bucket_ind of the bucket
+   */
+  ValueType ValueAt(uint32_t bucket_ind) const;
+
+  /**
+   * @return the number of pairs in the bucket
+   */
+  uint32_t Size() const;
+
+  /**
+   * @return whether the bucket has no room for another pair
+   */
+  bool IsFull() const;
+
+  /**
+   * @return whether the bucket has no pair
+   */
+  bool IsEmpty() const;
+
+  /**
+   * @return the next overflow page of the chain, INVALID_PAGE_ID at its end
+   */
+  page_id_t GetNextPageId() const;
+
+  /**
+   * @param next_page_id the next overflow page of the chain
+   */
+  void SetNextPageId(page_id_t next_page_id);
+
+ private:
+  uint32_t size_;
+  page_id_t next_page_id_;
+  MappingType array_[0];
+};
+
+}  // namespace bustub
@@ -0,0 +1,151 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_directory_page.h
+//
+// Identification: src/include/storage/page/extendible_hash_table_directory_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** Maximum global depth of a directory page */
+static constexpr uint32_t EXTENDIBLE_DIRECTORY_MAX_DEPTH = 9;
+static constexpr uint32_t EXTENDIBLE_DIRECTORY_ARRAY_SIZE = 1 << EXTENDIBLE_DIRECTORY_MAX_DEPTH;
+
+/**
+ * Directory page of an extendible hash table. The least significant
+ * global_depth bits of the hash of a key index its slot, and the slot points
+ * to the bucket page of the key. A bucket with local depth d is pointed to by
+ * the 2^(global_depth - d) slots that share its d low bits.
+ *
+ * Directory format (size in byte):
+ * ------------------------------------------------------------------------------
+ * | LSN (4) | PageId (4) | MaxDepth (4) | GlobalDepth (4) | LocalDepths (512) |
+ * ------------------------------------------------------------------------------
+ * | BucketPageIds (2048) |
+ * ------------------------
+ */
+class ExtendibleHashTableDirectoryPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  ExtendibleHashTableDirectoryPage() = delete;
+
+  /**
+   * Initializes a new directory page with global depth 0, its only slot
+   * points to bucket_page_id
+   *
+   * @param page_id the page id of this page
+   * @param bucket_page_id the page id of the first bucket
+   * @param max_depth the maximum global depth of the directory
+   */
+  void Init(page_id_t page_id, page_id_t bucket_page_id, uint32_t max_depth = EXTENDIBLE_DIRECTORY_MAX_DEPTH);
+
+  /**
+   * @return the page ID of this page
+   */
+  page_id_t GetPageId() const;
+
+  /**
+   * @return the lsn of this page
+   */
+  lsn_t GetLSN() const;
+
+  /**
+   * Sets the LSN of this page
+   *
+   * @param lsn the log sequence number for the lsn field to be set to
+   */
+  void SetLSN(lsn_t lsn);
+
+  /**
+   * @param hash the hash of a key
+   * @return the slot of the key
+   */
+  uint32_t HashToBucketIndex(uint32_t hash) const;
+
+  /**
+   * @param bucket_ind a slot of the directory
+   * @return the page id of the bucket the slot points to
+   */
+  page_id_t GetBucketPageId(uint32_t bucket_ind) const;
+
+  /**
+   * Points a slot to a bucket
+   *
+   * @param bucket_ind the slot
+   * @param bucket_page_id the page id of the bucket
+   */
+  void SetBucketPageId(uint32_t bucket_ind, page_id_t bucket_page_id);
+
+  /**
+   * @param bucket_ind a slot of the directory
+   * @return the slot its bucket was split from, or would be merged with
+   */
+  uint32_t GetSplitImageIndex(uint32_t bucket_ind) const;
+
+  /**
+   * @return the number of hash bits that index the directory
+   */
+  uint32_t GetGlobalDepth() const;
+
+  /**
+   * @return the maximum global depth of the directory
+   */
+  uint32_t GetMaxDepth() const;
+
+  /**
+   * Doubles the directory, the new upper half points to the same buckets as
+   * the lower half
+   */
+  void IncrGlobalDepth();
+
+  /**
+   * Halves the directory
+   */
+  void DecrGlobalDepth();
+
+  /**
+   * @return whether no bucket needs the full global depth, so the directory
+   * can be halved
+   */
+  bool CanShrink() const;
+
+  /**
+   * @return the number of slots of the directory
+   */
+  uint32_t Size() const;
+
+  /**
+   * @param bucket_ind a slot of the directory
+   * @return the local depth of the bucket the slot points to
+   */
+  uint32_t GetLocalDepth(uint32_t bucket_ind) const;
+
+  /**
+   * Sets the local depth of a slot
+   *
+   * @param bucket_ind the slot
+   * @param local_depth the local depth of its bucket
+   */
+  void SetLocalDepth(uint32_t bucket_ind, uint32_t local_depth);
+
+ private:
+  lsn_t lsn_;
+  page_id_t page_id_;
+  uint32_t max_depth_;
+  uint32_t global_depth_;
+  uint8_t local_depths_[EXTENDIBLE_DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[EXTENDIBLE_DIRECTORY_ARRAY_SIZE];
+};
+
+}  // namespace bustub
@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_header_page.h
+//
+// Identification: src/include/storage/page/extendible_hash_table_header_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** Depth of a header page, i.e. the number of hash bits that pick a directory */
+static constexpr uint32_t EXTENDIBLE_HEADER_MAX_DEPTH = 9;
+static constexpr uint32_t EXTENDIBLE_HEADER_ARRAY_SIZE = 1 << EXTENDIBLE_HEADER_MAX_DEPTH;
+
+/**
+ * Header page of an extendible hash table. It spreads the keys over up to
+ * 2^max_depth directory pages by the most significant bits of their hash, so
+ * the size of the table is not capped by what a single directory page holds.
+ * Directory pages are created on the first insert into their range.
+ *
+ * Header format (size in byte):
+ * --------------------------------------------------------------------------
+ * | LSN (4) | PageId (4) | MaxDepth (4) | DirectoryPageIds (4 * 2^MaxDepth)
+ * --------------------------------------------------------------------------
+ */
+class ExtendibleHashTableHeaderPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  ExtendibleHashTableHeaderPage() = delete;
+
+  /**
+   * Initializes a new header page, without any directory page
+   *
+   * @param page_id the page id of this page
+   * @param max_depth the number of hash bits that pick a directory
+   */
+  void Init(page_id_t page_id, uint32_t max_depth = EXTENDIBLE_HEADER_MAX_DEPTH);
+
+  /**
+   * @return the page ID of this page
+   */
+  page_id_t GetPageId() const;
+
+  /**
+   * @return the lsn of this page
+   */
+  lsn_t GetLSN() const;
+
+  /**
+   * Sets the LSN of this page
+   *
+   * @param lsn the log sequence number for the lsn field to be set to
+   */
+  void SetLSN(lsn_t lsn);
+
+  /**
+   * @param hash the hash of a key
+   * @return the index of the directory the key belongs to
+   */
+  uint32_t HashToDirectoryIndex(uint32_t hash) const;
+
+  /**
+   * @param directory_ind the index of a directory
+   * @return its page id, INVALID_PAGE_ID if it is not created yet
+   */
+  page_id_t GetDirectoryPageId(uint32_t directory_ind) const;
+
+  /**
+   * Sets the page id of a directory
+   *
+   * @param directory_ind the index of the directory
+   * @param directory_page_id the page id of the directory
+   */
+  void SetDirectoryPageId(uint32_t directory_ind, page_id_t directory_page_id);
+
+  /**
+   * @return the number of directories the header page indexes
+   */
+  uint32_t MaxSize() const;
+
+ private:
+  lsn_t lsn_;
+  page_id_t page_id_;
+  uint32_t max_depth_;
+  page_id_t directory_page_ids_[EXTENDIBLE_HEADER_ARRAY_SIZE];
+};
+
+}  // namespace bustub
@@ -22,3 +22,21 @@
 #define BLOCK_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
 
 #define HASH_TABLE_BLOCK_TYPE HashTableBlockPage<KeyType, ValueType, KeyComparator>
+
+/** BUCKET_ARRAY_SIZE is the number of (key, value) pairs that fit in an extendible hash table bucket page, after the
+ * count of its pairs and the id of its next overflow page. The pairs are kept packed at the front of the array, so no
+ * flags are needed. */
+#define BUCKET_ARRAY_SIZE ((PAGE_SIZE - sizeof(uint32_t) - sizeof(page_id_t)) / sizeof(MappingType))
+
+#define HASH_TABLE_BUCKET_TYPE ExtendibleHashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+/** Tagged block pages load their control bytes a probe group at a time, which reads up to this many bytes past the
+ * control byte of the last slot */
+#define TAGGED_BLOCK_GROUP_PADDING 32
+
+/** TAGGED_BLOCK_ARRAY_SIZE is the number of (key, value) pairs of a tagged block page. Each pair has a control byte
+ * besides, and the control array is padded by a probe group and rounded up to 8 bytes so that the pairs stay
+ * aligned. */
+#define TAGGED_BLOCK_ARRAY_SIZE ((PAGE_SIZE - TAGGED_BLOCK_GROUP_PADDING - 8) / (sizeof(MappingType) + 1))
+
+#define HASH_TABLE_TAGGED_BLOCK_TYPE HashTableTaggedBlockPage<KeyType, ValueType, KeyComparator>
@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_tagged_block_page.h
+//
+// Identification: src/include/storage/page/hash_table_tagged_block_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+#include "common/config.h"
+#include "storage/index/int_comparator.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+/**
+ * Variant of HashTableBlockPage that keeps a control byte per slot instead of
+ * the occupied and readable bits. The control byte of a readable slot holds a
+ * 7-bit tag of the hash of its key, so a probe compares the tags of a whole
+ * group of slots with one SIMD instruction and only compares the keys of the
+ * slots whose tag matches.
+ *
+ * Tagged block page format:
+ *  ------------------------------------------------------------------------
+ * | CTRL(1) | ... | CTRL(n) | Padding | KEY(1) + VALUE(1) | ... | KEY(n) + VALUE(n)
+ *  ------------------------------------------------------------------------
+ *
+ *  Here '+' means concatenation. A control byte is EMPTY (0), DELETED,
+ *  CLAIMED while an insert writes the pair, or the tag with the high bit set.
+ *
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class HashTableTaggedBlockPage {
+ public:
+#ifdef __AVX2__
+  static constexpr slot_offset_t GROUP_SIZE = 32;
+#else
+  static constexpr slot_offset_t GROUP_SIZE = 16;
+#endif
+  static_assert(GROUP_SIZE <= TAGGED_BLOCK_GROUP_PADDING, "a probe group reads past the control array");
+
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableTaggedBlockPage() = delete;
+
+  /**
+   * @param hash the hash of a key
+   * @return the control byte of a readable slot that holds the key
+   */
+  static uint8_t TagOf(uint64_t hash) { return static_cast<uint8_t>(0x80 | (hash >> 57)); }
+
+  /**
+   * Gets the key at an index in the block.
+   *
+   * @param bucket_ind the index in the block to get the key at
+   * @return key at index bucket_ind of the block
+   */
+  KeyType KeyAt(slot_offset_t bucket_ind) const;
+
+  /**
+   * Gets the value at an index in the block.
+   *
+   * @param bucket_ind the index in the block to get the value at
+   * @return value at index bucket_ind of the block
+   */
+  ValueType ValueAt(slot_offset_t bucket_ind) const;
+
+  /**
+   * Attempts to insert a key and value into an index in the block. Like
+   * HashTableBlockPage::Insert it is thread safe: it claims the index with a
+   * compare and swap, writes the pair and then publishes the tag.
+   *
+   * @param bucket_ind index to write the key and value to
+   * @param key key to insert
+   * @param value value to insert
+   * @param tag the tag of the key (see TagOf)
+   * @return false if the index is occupied before the pair can be inserted
+   */
+  bool Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value, uint8_t tag);
+
+  /**
+   * Removes a key and value at index, it leaves a tombstone.
+   *
+   * @param bucket_ind ind to remove the value
+   */
+  void Remove(slot_offset_t bucket_ind);
+
+  /**
+   * Returns whether or not an index is occupied (key/value pair or tombstone)
+   *
+   * @param bucket_ind index to look at
+   * @return true if the index is occupied, false otherwise
+   */
+  bool IsOccupied(slot_offset_t bucket_ind) const;
+
+  /**
+   * Returns whether or not an index is readable (valid key/value pair)
+   *
+   * @param bucket_ind index to look at
+   * @return true if the index is readable, false otherwise
+   */
+  bool IsReadable(slot_offset_t bucket_ind) const;
+
+  /**
+   * Compares the control bytes of the group of GROUP_SIZE slots that starts at
+   * an index at once. The group may reach past the last slot of the block,
+   * the bits of those slots are meaningless.
+   *
+   * @param bucket_ind the first index of the group
+   * @param tag the tag to look for
+   * @return a mask with bit i set if slot bucket_ind + i holds tag or is free
+   */
+  uint32_t MatchTagOrEmpty(slot_offset_t bucket_ind, uint8_t tag) const;
+
+ private:
+  static constexpr uint8_t EMPTY = 0x00;
+  static constexpr uint8_t DELETED = 0x01;
+  static constexpr uint8_t CLAIMED = 0x02;
+
+  std::atomic<uint8_t> ctrl_[(TAGGED_BLOCK_ARRAY_SIZE + TAGGED_BLOCK_GROUP_PADDING + 7) / 8 * 8];
+  MappingType array_[0];
+};
+
+}  // namespace bustub
@@ -30,7 +30,13 @@ static char *buffer_used;
  * @input db_file: database file name
  */
 DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+    : file_name_(db_file),
+      next_page_id_(0),
+      num_flushes_(0),
+      num_writes_(0),
+      num_reads_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -68,6 +74,8 @@ DiskManager::DiskManager(const std::string &db_file)
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() = default;
+
 /**
  * Close all file streams
  */
@@ -80,6 +88,7 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  DiskTraceScope trace(trace_writer_.get(), DiskTraceOp::WRITE_PAGE, page_id, PAGE_SIZE);
   size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
   // set write cursor to offset
   num_writes_ += 1;
@@ -98,7 +107,9 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  DiskTraceScope trace(trace_writer_.get(), DiskTraceOp::READ_PAGE, page_id, PAGE_SIZE);
   int offset = page_id * PAGE_SIZE;
+  num_reads_ += 1;
   // check if read beyond file length
   if (offset > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error reading past end of file");
@@ -136,6 +147,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   flush_log_ = true;
+  DiskTraceScope trace(trace_writer_.get(), DiskTraceOp::WRITE_LOG, INVALID_PAGE_ID, static_cast<uint32_t>(size));
 
   if (flush_log_f_ != nullptr) {
     // used for checking non-blocking flushing
@@ -167,6 +179,7 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
+  DiskTraceScope trace(trace_writer_.get(), DiskTraceOp::READ_LOG, INVALID_PAGE_ID, static_cast<uint32_t>(size));
   log_io_.seekp(offset);
   log_io_.read(log_data, size);
 
@@ -188,14 +201,20 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
  * Allocate new page (operations like create index/table)
  * For now just keep an increasing counter
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() {
+  auto page_id = next_page_id_++;
+  DiskTraceScope trace(trace_writer_.get(), DiskTraceOp::ALLOCATE_PAGE, page_id, 0);
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
  * Need bitmap in header page for tracking pages
  * This does not actually need to do anything for now.
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  DiskTraceScope trace(trace_writer_.get(), DiskTraceOp::DEALLOCATE_PAGE, page_id, 0);
+}
 
 /**
  * Returns number of flushes made so far
@@ -207,6 +226,23 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 int DiskManager::GetNumWrites() const { return num_writes_; }
 
+/**
+ * Returns number of Reads made so far
+ */
+int DiskManager::GetNumReads() const { return num_reads_; }
+
+/**
+ * Start tracing into a new trace file
+ */
+void DiskManager::EnableTrace(const std::string &trace_file) {
+  trace_writer_ = std::make_unique<DiskTraceWriter>(trace_file);
+}
+
+/**
+ * Stop tracing, the trace writer flushes the remaining records on destruction
+ */
+void DiskManager::DisableTrace() { trace_writer_.reset(); }
+
 /**
  * Returns true if the log is currently being flushed
  */
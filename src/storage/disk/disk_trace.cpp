@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_trace.cpp
+//
+// Identification: src/storage/disk/disk_trace.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_trace.h"
+
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+static constexpr uint32_t TRACE_MAGIC = 0x42545452;  // "RTTB"
+static constexpr uint32_t TRACE_VERSION = 1;
+
+DiskTraceWriter::DiskTraceWriter(const std::string &trace_file) : trace_start_(clock_t::now()) {
+  trace_io_.open(trace_file, std::ios::binary | std::ios::trunc | std::ios::out);
+  if (!trace_io_.is_open()) {
+    throw Exception("can't open trace file");
+  }
+  trace_io_.write(reinterpret_cast<const char *>(&TRACE_MAGIC), sizeof(TRACE_MAGIC));
+  trace_io_.write(reinterpret_cast<const char *>(&TRACE_VERSION), sizeof(TRACE_VERSION));
+  buffer_.reserve(BUFFER_RECORDS);
+}
+
+DiskTraceWriter::~DiskTraceWriter() {
+  Flush();
+  trace_io_.close();
+}
+
+void DiskTraceWriter::Record(DiskTraceOp op, page_id_t page_id, uint32_t size, clock_t::time_point start) {
+  auto now = clock_t::now();
+  DiskTraceRecord record{};
+  record.timestamp_us_ =
+      static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(start - trace_start_).count());
+  record.latency_ns_ = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count());
+  record.page_id_ = page_id;
+  record.size_ = size;
+  record.op_ = op;
+
+  std::lock_guard<std::mutex> guard(latch_);
+  buffer_.push_back(record);
+  ++num_records_;
+  if (buffer_.size() >= BUFFER_RECORDS) {
+    FlushLocked();
+  }
+}
+
+void DiskTraceWriter::Flush() {
+  std::lock_guard<std::mutex> guard(latch_);
+  FlushLocked();
+}
+
+uint64_t DiskTraceWriter::GetNumRecords() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return num_records_;
+}
+
+void DiskTraceWriter::FlushLocked() {
+  if (buffer_.empty()) {
+    return;
+  }
+  trace_io_.write(reinterpret_cast<const char *>(buffer_.data()),
+                  static_cast<std::streamsize>(buffer_.size() * sizeof(DiskTraceRecord)));
+  if (trace_io_.bad()) {
+    LOG_DEBUG("I/O error while writing trace");
+  }
+  trace_io_.flush();
+  buffer_.clear();
+}
+
+DiskTraceReader::DiskTraceReader(const std::string &trace_file) {
+  trace_io_.open(trace_file, std::ios::binary | std::ios::in);
+  if (!trace_io_.is_open()) {
+    throw Exception("can't open trace file");
+  }
+
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  trace_io_.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  trace_io_.read(reinterpret_cast<char *>(&version), sizeof(version));
+  if (!trace_io_ || magic != TRACE_MAGIC || version != TRACE_VERSION) {
+    throw Exception("not a disk trace file");
+  }
+}
+
+bool DiskTraceReader::Next(DiskTraceRecord *record) {
+  trace_io_.read(reinterpret_cast<char *>(record), sizeof(DiskTraceRecord));
+  return trace_io_.gcount() == static_cast<std::streamsize>(sizeof(DiskTraceRecord));
+}
+
+}  // namespace bustub
@@ -9,62 +9,417 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
 #include <vector>
 
 #include "common/exception.h"
 #include "common/rid.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/external_sort.h"
 #include "storage/page/header_page.h"
 
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, bool unique_keys)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(internal_max_size),
+      unique_keys_(unique_keys) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() { this->StopBackgroundMerge(); }
+
+/*
+ * Helper function to switch between optimistic latch crabbing (default) and
+ * the pessimistic protocol that write latches every node from the root down
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetOptimisticLatching(bool optimistic_latching) { optimistic_latching_ = optimistic_latching; }
+
+/*
+ * Helper function to switch between optimistic lock coupling for point
+ * queries (default) and read latch crabbing
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetOptimisticReads(bool optimistic_reads) { optimistic_reads_ = optimistic_reads; }
+
+/*
+ * Helper function to switch between relaxed deletes, which leave underfull
+ * leaves to MergeUnderflowPages(), and deletes that merge or redistribute
+ * right away (default)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetRelaxedDeletes(bool relaxed_deletes) { relaxed_deletes_ = relaxed_deletes; }
+
+/*
+ * Helper function to switch change buffering on or off (default). The insert
+ * and delete buffers are trees with duplicate keys of their own, created on
+ * first use, so they live in the buffer pool and on disk like the tree and
+ * keep their root ids in the header page. They are created under
+ * change_buffer_latch_ and published through has_change_buffer_ for the
+ * readers that skip the latch.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetChangeBuffering(bool change_buffering) {
+  if (change_buffering && this->unique_keys_) {
+    throw Exception(ExceptionType::INVALID, "change buffering needs duplicate keys");
+  }
+
+  if (change_buffering) {
+    std::unique_lock<std::shared_mutex> latch(change_buffer_latch_);
+    if (!has_change_buffer_) {
+      insert_buffer_ = std::make_unique<BPlusTree>(index_name_ + "_ibuf", buffer_pool_manager_, comparator_,
+                                                   leaf_max_size_, internal_max_size_, false);
+      delete_buffer_ = std::make_unique<BPlusTree>(index_name_ + "_dbuf", buffer_pool_manager_, comparator_,
+                                                   leaf_max_size_, internal_max_size_, false);
+      has_change_buffer_ = true;
+    }
+    change_buffering_ = true;
+    return;
+  }
+
+  this->MergeChangeBuffer();
+  // writers check the flag again under the latch, so nothing is buffered once it is off
+  std::unique_lock<std::shared_mutex> latch(change_buffer_latch_);
+  while (this->MergeChangeBatch(nullptr, nullptr, CHANGE_BUFFER_MERGE_BATCH) > 0) {
+  }
+  change_buffering_ = false;
+}
 
 /*
- * Helper function to decide whether current b+tree is empty
+ * Helper function to decide whether current b+tree is empty, buffered inserts
+ * count as keys
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::IsEmpty() {
-  std::shared_lock<std::shared_mutex> latch(root_page_id_latch_);
-  return root_page_id_ == INVALID_PAGE_ID;
+  return root_page_id_ == INVALID_PAGE_ID && (!has_change_buffer_ || insert_buffer_->IsEmpty());
 }
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 /*
- * Return the only value that associated with input key
+ * Return the values associated with input key, all of them are read in the
+ * same traversal. Buffered changes of the key are applied to the values read
+ * from the leaf and then merged into it, unless a merge is running already.
  * This method is used for point query
  * @return : true means key exists
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  this->AcquireRootPageIdLatch(false);
-  if (root_page_id_ == INVALID_PAGE_ID) {
-    this->ReleaseRootPageIdLatch(false);
-    return false;
+  // changes buffered from here on are concurrent with the lookup
+  if (!this->change_buffering_ || !this->HasPendingChanges()) {
+    return this->LookupValue(key, result, transaction);
+  }
+
+  std::vector<ValueType> values;
+  auto hasChanges = false;
+  {
+    std::shared_lock<std::shared_mutex> latch(change_buffer_latch_);
+    this->LookupValue(key, &values, transaction);
+    hasChanges = this->ApplyChanges(key, &values);
+  }
+  result->insert(result->end(), values.begin(), values.end());
+
+  // the leaf was just read, so merging its changes now is cheap
+  if (hasChanges) {
+    std::unique_lock<std::shared_mutex> latch(change_buffer_latch_, std::try_to_lock);
+    if (latch.owns_lock()) {
+      this->MergeChangeBatch(&key, &key, CHANGE_BUFFER_MERGE_BATCH);
+    }
+  }
+
+  return !values.empty();
+}
+
+/*
+ * Read the values of key from its leaf, leaving the change buffer aside
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::LookupValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
+  if (this->optimistic_reads_) {
+    for (int i = 0; i < OPTIMISTIC_READ_RETRIES; ++i) {
+      auto isExisting = false;
+      auto isResident = true;
+      if (this->OptimisticGetValue(key, result, &isExisting, &isResident)) {
+        return isExisting;
+      }
+      // the lookup reads from disk anyway, so latch crabbing costs little next to that
+      if (!isResident) {
+        break;
+      }
+    }
   }
 
   auto page = this->FindLeafPage(key, Operation::READ, transaction);
-  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
-  ValueType v;
+  if (page == nullptr) {
+    return false;
+  }
 
-  auto isExisting = leaf->Lookup(key, &v, this->comparator_);
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  auto ind = leaf->LookupIndex(key, this->comparator_);
+  auto isExisting = ind >= 0;
   if (isExisting) {
-    result->emplace_back(v);
+    this->CollectValues(leaf, ind, result);
   }
 
   this->ReleasePrevRLatch(page);
   return isExisting;
 }
 
+/*
+ * Look up a batch of keys, applying the buffered changes of each key like
+ * GetValue() does
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MultiGet(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                              Transaction *transaction) {
+  if (!this->change_buffering_ || !this->HasPendingChanges()) {
+    this->LookupValues(keys, results);
+    return;
+  }
+
+  std::shared_lock<std::shared_mutex> latch(change_buffer_latch_);
+  this->LookupValues(keys, results);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    this->ApplyChanges(keys[i], &(*results)[i]);
+  }
+}
+
+/*
+ * Look up a batch of keys in sorted order with a cursor: the read latched path
+ * from the root to the current leaf is kept between keys. For the next key the
+ * cursor only climbs up to the deepest page on the path whose fences hold the
+ * key and descends from there, so keys in the same leaf or subtree skip most of
+ * the descent. Pages are latched top-down like in FindLeafPage(). Every
+ * MULTI_GET_LATCH_BATCH keys the path is released and the cursor starts over
+ * at the root, so a large batch keeps writers out of its pages only for a
+ * short while.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::LookupValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results) {
+  results->assign(keys.size(), std::vector<ValueType>());
+  std::vector<size_t> order(keys.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+            [this, &keys](size_t a, size_t b) { return this->comparator_(keys[a], keys[b]) == -1; });
+
+  if (keys.empty()) {
+    return;
+  }
+
+  auto page = this->LatchRootPage(false);
+  if (page == nullptr) {
+    return;
+  }
+
+  std::vector<Page *> path{page};
+  for (size_t i = 0; i < order.size(); ++i) {
+    auto ind = order[i];
+    const auto &key = keys[ind];
+    if (i > 0 && i % MULTI_GET_LATCH_BATCH == 0) {
+      this->ReleasePath(&path);
+      page = this->LatchRootPage(false);
+      if (page == nullptr) {
+        return;
+      }
+      path.push_back(page);
+    }
+
+    // the root holds every key
+    while (path.size() > 1 &&
+           !this->IsKeyInPage(reinterpret_cast<BPlusTreePage *>(path.back()->GetData()), key)) {
+      this->ReleasePrevRLatch(path.back());
+      path.pop_back();
+    }
+
+    auto treePage = reinterpret_cast<BPlusTreePage *>(path.back()->GetData());
+    while (!treePage->IsLeafPage()) {
+      auto childPage = buffer_pool_manager_->FetchPage(
+          reinterpret_cast<InternalPage *>(treePage)->Lookup(key, this->comparator_));
+      if (childPage == nullptr) {
+        this->ReleasePath(&path);
+        throw ExceptionType::OUT_OF_MEMORY;
+      }
+
+      childPage->RLatch();
+      path.push_back(childPage);
+      treePage = reinterpret_cast<BPlusTreePage *>(childPage->GetData());
+    }
+
+    auto leaf = reinterpret_cast<LeafPage *>(treePage);
+    auto keyInd = leaf->LookupIndex(key, this->comparator_);
+    if (keyInd >= 0) {
+      this->CollectValues(leaf, keyInd, &(*results)[ind]);
+    }
+  }
+
+  this->ReleasePath(&path);
+}
+
+/*
+ * @return : true if key lies within the fences of the page, LowKey <= key < HighKey
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsKeyInPage(BPlusTreePage *node, const KeyType &key) const {
+  if (node->IsLeafPage()) {
+    auto leaf = reinterpret_cast<LeafPage *>(node);
+    return (!leaf->HasLowKey() || this->comparator_(key, leaf->GetLowKey()) != -1) &&
+           !leaf->ShouldMoveRight(key, this->comparator_);
+  }
+
+  auto internal = reinterpret_cast<InternalPage *>(node);
+  return (!internal->HasLowKey() || this->comparator_(key, internal->GetLowKey()) != -1) &&
+         !internal->ShouldMoveRight(key, this->comparator_);
+}
+
+/*
+ * Release a read latched path of pages from the bottom up
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleasePath(std::vector<Page *> *path) {
+  while (!path->empty()) {
+    this->ReleasePrevRLatch(path->back());
+    path->pop_back();
+  }
+}
+
+/*
+ * Optimistic lock coupling: descend without latching or pinning any page. The
+ * frames are found with BufferPoolManager::FindResidentPage(), so the descent
+ * writes no shared memory. The version of each page is recorded when its frame
+ * is found and validated after reading it, and the page pointing to the next
+ * one is validated again once the next page is found.
+ * Splits of the next page that happen afterwards are handled by moving right
+ * (B-link), merges and redistributions to the left are caught by the low key
+ * version. The root page id is read again once the root version is recorded,
+ * a root that was replaced in between makes the lookup restart.
+ * @return : false means a writer interfered and the lookup has to restart, or
+ * that a page is not resident (is_resident is cleared then)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticGetValue(const KeyType &key, std::vector<ValueType> *result, bool *is_existing,
+                                        bool *is_resident) {
+  page_id_t pageId = root_page_id_;
+  if (pageId == INVALID_PAGE_ID) {
+    *is_existing = false;
+    return true;
+  }
+
+  uint64_t version = 0;
+  auto page = buffer_pool_manager_->FindResidentPage(pageId, &version);
+  if (page == nullptr) {
+    *is_resident = false;
+    return false;
+  }
+
+  // odd versions belong to pages that are being modified right now
+  if ((version & 1) != 0 || root_page_id_ != pageId) {
+    return false;
+  }
+
+  auto expectedLowKeyVersion = this->GetLowKeyVersion(reinterpret_cast<BPlusTreePage *>(page->GetData()));
+  while (true) {
+    auto treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    auto lowKeyVersion = this->GetLowKeyVersion(treePage);
+    auto isLeaf = treePage->IsLeafPage();
+    auto isMoveRight = false;
+    auto isExisting = false;
+    auto keyInd = -1;
+    ValueType v;
+    // inline posting lists are copied out before the page is validated
+    std::vector<ValueType> values;
+    page_id_t nextPageId = INVALID_PAGE_ID;
+    if (isLeaf) {
+      auto leaf = reinterpret_cast<LeafPage *>(treePage);
+      isMoveRight = leaf->ShouldMoveRight(key, this->comparator_);
+      if (isMoveRight) {
+        nextPageId = leaf->GetNextPageId();
+      } else {
+        keyInd = leaf->LookupIndex(key, this->comparator_);
+        isExisting = keyInd >= 0;
+        if (isExisting) {
+          v = leaf->ValueAt(keyInd);
+        }
+        if (isExisting && !this->unique_keys_ && !BPlusTreePostingPage::IsReference(v)) {
+          leaf->GetValues(keyInd, &values);
+        }
+      }
+    } else {
+      auto internal = reinterpret_cast<InternalPage *>(treePage);
+      isMoveRight = internal->ShouldMoveRight(key, this->comparator_);
+      nextPageId = isMoveRight ? internal->GetNextPageId() : internal->Lookup(key, this->comparator_);
+    }
+
+    // entries that left for the left sibling are out of reach, and the next page id may be garbage if the page changed
+    if (lowKeyVersion != expectedLowKeyVersion || !page->ValidateVersion(version)) {
+      return false;
+    }
+
+    if (isLeaf && !isMoveRight) {
+      if (isExisting && !this->unique_keys_ && BPlusTreePostingPage::IsReference(v)) {
+        // posting pages are only stable under the leaf latch, which needs the leaf pinned. The leaf must still be in
+        // the same frame and unchanged once the latch is taken.
+        auto leafPage = buffer_pool_manager_->FetchPage(pageId);
+        if (leafPage == nullptr) {
+          throw ExceptionType::OUT_OF_MEMORY;
+        }
+
+        leafPage->RLatch();
+        auto isValid = leafPage == page && leafPage->ValidateVersion(version);
+        if (isValid) {
+          this->CollectValues(reinterpret_cast<LeafPage *>(leafPage->GetData()), keyInd, result);
+        }
+        leafPage->RUnlatch();
+        buffer_pool_manager_->UnpinPage(pageId, false);
+        if (!isValid) {
+          return false;
+        }
+      } else if (!values.empty()) {
+        result->insert(result->end(), values.begin(), values.end());
+      } else if (isExisting) {
+        result->emplace_back(v);
+      }
+
+      *is_existing = isExisting;
+      return true;
+    }
+
+    uint64_t nextVersion = 0;
+    auto nextPage = buffer_pool_manager_->FindResidentPage(nextPageId, &nextVersion);
+    if (nextPage == nullptr) {
+      *is_resident = false;
+      return false;
+    }
+
+    // the next page cannot be merged away or lose entries to the left without changing this page, once the
+    // validation succeeds the low key version is the one the next page had when its id was read. If the frame was
+    // reused in the meantime, the next version fails to validate.
+    auto nextLowKeyVersion = this->GetLowKeyVersion(reinterpret_cast<BPlusTreePage *>(nextPage->GetData()));
+    auto isValid = page->ValidateVersion(version);
+    version = nextVersion;
+    if (!isValid || (version & 1) != 0) {
+      return false;
+    }
+
+    page = nextPage;
+    pageId = nextPageId;
+    expectedLowKeyVersion = nextLowKeyVersion;
+  }
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -72,22 +427,165 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: with unique keys, if user try to insert duplicate keys return
+ * false. Otherwise the value is added to the posting list of the key, false
+ * means the key & value pair already exists. A pair that goes to the change
+ * buffer is only checked against the buffer, so true means it was maybe
+ * inserted: it may exist in the leaf, and the merge then drops it.
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  this->AcquireRootPageIdLatch(true);
+  if (!this->change_buffering_) {
+    return this->InsertEntry(key, value, transaction);
+  }
+
+  std::shared_lock<std::shared_mutex> latch(change_buffer_latch_);
+  if (!this->change_buffering_) {
+    return this->InsertEntry(key, value, transaction);
+  }
+
+  auto isResident = true;
+  auto isInserted = this->InsertEntry(key, value, transaction, nullptr, &isResident);
+  if (!isResident) {
+    // the leaf is not read, so the pair may exist already and is merged into it later, true only means maybe inserted
+    this->CancelChange(delete_buffer_.get(), key, value, transaction);
+    auto isBuffered = insert_buffer_->Insert(key, value, transaction);
+    latch.unlock();
+    this->OnChangeBuffered();
+    return isBuffered;
+  }
+
+  // a pending delete hid the pair so far
+  return this->CancelChange(delete_buffer_.get(), key, value, transaction) || isInserted;
+}
+
+/*
+ * Insert unless the range holds an entry. The leaf of key usually holds the
+ * whole range, then it is checked and the pair inserted under the write latch
+ * of the leaf. Inserts of the same range find the same leaf, or one that
+ * already holds the entry of the other insert after a split. A range that
+ * spans several leaves is scanned instead, while no other InsertIfAbsent()
+ * runs.
+ * @return: false if an entry within the range exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertIfAbsent(const KeyType &key, const ValueType &value, const KeyType &low_key,
+                                    const KeyType &high_key, Transaction *transaction) {
+  InsertRange range{&low_key, &high_key};
+  {
+    std::shared_lock<std::shared_mutex> latch(insert_range_latch_);
+    auto isInserted = this->InsertEntry(key, value, transaction, &range);
+    if (!range.is_spanning_) {
+      return isInserted;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> latch(insert_range_latch_);
+  if (!this->BeginRange(low_key, &high_key, true).isEnd()) {
+    return false;
+  }
+  return this->InsertEntry(key, value, transaction);
+}
+
+/*
+ * Insert into the tree itself, leaving the change buffer aside. With a range
+ * nothing is inserted if the range holds an entry, see InsertIfAbsent(). With
+ * is_resident nothing is inserted either if the leaf of key is not in the
+ * buffer pool, which the descent finds out on the way.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertEntry(const KeyType &key, const ValueType &value, Transaction *transaction,
+                                 InsertRange *range, bool *is_resident) {
+  if (is_resident != nullptr && !this->optimistic_latching_) {
+    *is_resident = this->IsLeafResident(key);
+    if (!*is_resident) {
+      return false;
+    }
+  }
+
+  auto isInserted = false;
+  if (this->optimistic_latching_ && this->OptimisticInsert(key, value, &isInserted, range, is_resident)) {
+    return isInserted;
+  }
+  if (is_resident != nullptr && !*is_resident) {
+    return false;
+  }
+
+  this->AcquireRootPageIdLatch();
   // LOG_DEBUG("Try Insert %ld", key.ToString());
   if (root_page_id_ == INVALID_PAGE_ID) {
     this->StartNewTree(key, value);
-    this->ReleaseRootPageIdLatch(true);
+    this->ReleaseRootPageIdLatch();
+
+    return true;
+  }
+
+  return this->InsertIntoLeaf(key, value, transaction, range);
+}
+
+/*
+ * @return: true if the write latched leaf holds the whole range but no entry
+ * within it. Sets is_spanning_ of the range if the leaf holds only a part.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsRangeEmpty(LeafPage *leaf, InsertRange *range) const {
+  if (!this->IsKeyInPage(leaf, *range->low_key_) || !this->IsKeyInPage(leaf, *range->high_key_)) {
+    range->is_spanning_ = true;
+    return false;
+  }
+
+  auto ind = leaf->KeyIndex(*range->low_key_, this->comparator_);
+  return ind == leaf->GetSize() || this->comparator_(leaf->KeyAt(ind), *range->high_key_) == 1;
+}
+
+/*
+ * Optimistic latch crabbing for insertion: descend with read latches and write
+ * latch only the leaf. Works when the leaf can take the entry without a split.
+ * @return: false means the leaf is unsafe (or the tree is empty, or with
+ * is_resident the leaf is not in the buffer pool) and nothing happened, the
+ * caller has to restart pessimistically
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticInsert(const KeyType &key, const ValueType &value, bool *is_inserted,
+                                      InsertRange *range, bool *is_resident) {
+  auto page = this->FindLeafPageOptimistic(key, is_resident);
+  if (page == nullptr) {
+    return false;
+  }
+
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  if (range != nullptr && !this->IsRangeEmpty(leaf, range)) {
+    this->ReleaseLeafWLatch(page, false);
+    *is_inserted = false;
+    return true;
+  }
+
+  auto ind = leaf->LookupIndex(key, this->comparator_);
+  if (ind >= 0) {
+    // posting pages grow without changing the leaf, inline posting lists need the room of an insertion
+    if (!this->unique_keys_ && !BPlusTreePostingPage::IsReference(leaf->ValueAt(ind)) &&
+        !this->IsSafe(leaf, Operation::INSERT)) {
+      this->ReleaseLeafWLatch(page, false);
+      return false;
+    }
 
+    auto isInserted = !this->unique_keys_ && this->InsertIntoPostingList(leaf, ind, value, false);
+    this->ReleaseLeafWLatch(page, isInserted);
+    *is_inserted = isInserted;
     return true;
   }
 
-  return this->InsertIntoLeaf(key, value, transaction);
+  if (!this->IsSafe(leaf, Operation::INSERT)) {
+    this->ReleaseLeafWLatch(page, false);
+    return false;
+  }
+
+  leaf->Insert(key, value, this->comparator_);
+  this->ReleaseLeafWLatch(page, true);
+  *is_inserted = true;
+  return true;
 }
+
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -119,48 +617,73 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
- * immdiately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * immdiately (or add the value to the posting list of the key), otherwise
+ * insert entry. Remember to deal with split if necessary.
+ * @return: false if the key (or, with duplicate keys, the key & value pair)
+ * already exists, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
+bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction,
+                                    InsertRange *range) {
   // LOG_DEBUG("try find leaf for insertion");
   auto page = this->FindLeafPage(key, Operation::INSERT, transaction);
   // LOG_DEBUG("find leaf for insertion: %d, pin count: %d", page->GetPageId(), page->GetPinCount());
 
   auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
-  auto sz = leaf->GetSize();
-  auto isDuplicated = false;
+  auto isInserted = true;
 
   // LOG_DEBUG("try insert into %d", leaf->GetPageId());
-  if (sz == leaf->Insert(key, value, this->comparator_)) {
-    // duplicated key
-    isDuplicated = true;
+  auto ind = leaf->LookupIndex(key, this->comparator_);
+  if (range != nullptr && !this->IsRangeEmpty(leaf, range)) {
+    isInserted = false;
+  } else if (ind >= 0) {
+    // duplicated key, a growing inline posting list may overflow the leaf like a new entry
+    isInserted = !this->unique_keys_ && this->InsertIntoPostingList(leaf, ind, value, true);
+  } else {
+    leaf->Insert(key, value, this->comparator_);
   }
 
   auto isSplit = false;
-  if (leaf->GetSize() == leaf->GetMaxSize()) {
+  auto isReleased = false;
+  auto nextPageId = INVALID_PAGE_ID;
+  auto newPageId = INVALID_PAGE_ID;
+  if (leaf->IsOverflow()) {
     // split
     isSplit = true;
     auto newLeaf = this->Split<LeafPage>(leaf);
+    nextPageId = newLeaf->GetNextPageId();
+    newPageId = newLeaf->GetPageId();
+
+    // the new leaf is reachable through the right link, so readers can use both leaves while the parent, which stays
+    // write latched, is updated. A root has to be replaced by the new root first.
+    if (!leaf->IsRootPage()) {
+      page->WUnlatch();
+      isReleased = true;
+    }
 
-    this->InsertIntoParent(leaf, newLeaf->KeyAt(0), newLeaf, transaction);
+    this->InsertIntoParent(leaf, newLeaf->GetLowKey(), newLeaf, transaction);
     this->buffer_pool_manager_->UnpinPage(newLeaf->GetPageId(), true);
   }
 
   this->ReleaseAllWLatches(transaction, isSplit);
 
-  if (leaf->IsRootPage()) {
-    this->ReleaseRootPageIdLatch(true);
-    // LOG_DEBUG("Unlatch root page id: %d", leaf->GetPageId());
+  if (!isReleased) {
+    if (leaf->IsRootPage()) {
+      this->ReleaseRootPageIdLatch();
+      // LOG_DEBUG("Unlatch root page id: %d", leaf->GetPageId());
+    }
+
+    page->WUnlatch();
   }
 
   // LOG_DEBUG("%d pin count: %d", page->GetPageId(), page->GetPinCount());
-  page->WUnlatch();
-  this->buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  auto pageId = page->GetPageId();
+  this->buffer_pool_manager_->UnpinPage(pageId, true);
+
+  // the left link of the old right neighbour is a hint, it is only updated once no latch is held
+  this->UpdatePrevPageId(nextPageId, pageId, newPageId);
 
-  return !isDuplicated;
+  return isInserted;
 }
 
 /*
@@ -182,17 +705,14 @@ N *BPLUSTREE_TYPE::Split(N *node) {
 
   auto treePage = reinterpret_cast<N *>(page->GetData());
   treePage->Init(pageId, node->GetParentPageId(), node->GetMaxSize());
+  // the pages link themselves, the low key of the new page is the separator to move up into the parent
   if (node->IsLeafPage()) {
-    auto leaf = reinterpret_cast<LeafPage *>(node);
     auto newLeaf = reinterpret_cast<LeafPage *>(treePage);
-    leaf->MoveHalfTo(newLeaf);
+    reinterpret_cast<LeafPage *>(node)->MoveHalfTo(newLeaf);
     // LOG_DEBUG("split leaf: %d -> %d", node->GetPageId(), treePage->GetPageId());
-
-    newLeaf->SetNextPageId(leaf->GetNextPageId());
-    leaf->SetNextPageId(newLeaf->GetPageId());
   } else {
-    auto internal = reinterpret_cast<InternalPage *>(node);
-    internal->MoveHalfTo(reinterpret_cast<InternalPage *>(treePage), this->buffer_pool_manager_);
+    reinterpret_cast<InternalPage *>(node)->MoveHalfTo(reinterpret_cast<InternalPage *>(treePage),
+                                                       this->buffer_pool_manager_);
     // LOG_DEBUG("split internal: %d -> %d", node->GetPageId(), treePage->GetPageId());
   }
 
@@ -228,16 +748,17 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
     parentInternalPage->Init(parentPageId, INVALID_PAGE_ID, this->internal_max_size_);
     parentInternalPage->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
 
-    root_page_id_ = parentPageId;
-    UpdateRootPageId(0);
-
     old_node->SetParentPageId(parentPageId);
     new_node->SetParentPageId(parentPageId);
 
+    // publish the new root once it is complete, readers latch it without the root page id latch
+    root_page_id_ = parentPageId;
+    UpdateRootPageId(0);
+
     buffer_pool_manager_->UnpinPage(parentPage->GetPageId(), true);
 
     // LOG_DEBUG("Unlatch root page id: %d", parentPageId);
-    this->ReleaseRootPageIdLatch(true);
+    this->ReleaseRootPageIdLatch();
     return;
   }
 
@@ -249,17 +770,31 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
   }
 
   parentInternalPage = reinterpret_cast<InternalPage *>(parentPage->GetData());
-  parentInternalPage->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  InternalPage *newInternal = nullptr;
+  if (!parentInternalPage->HasRoomFor(key)) {
+    // separators differ in size, a parent that is short of space is split before the insertion
+    newInternal = this->Split<InternalPage>(parentInternalPage);
+  }
 
-  buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
+  auto target = newInternal != nullptr && newInternal->ValueIndex(old_node->GetPageId()) != -1 ? newInternal
+                                                                                               : parentInternalPage;
+  target->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  new_node->SetParentPageId(target->GetPageId());
   // LOG_DEBUG("finish insert into parent: %d", parentPageId);
 
-  if (parentInternalPage->GetSize() == parentInternalPage->GetMaxSize() + 1) {
+  if (newInternal == nullptr && parentInternalPage->IsOverflow()) {
     // split internal
     // LOG_DEBUG("try split internal: %d", parentPageId);
-    auto newInternal = this->Split<InternalPage>(parentInternalPage);
-    auto middleKey = newInternal->KeyAt(0);
-    newInternal->SetKeyAt(0, KeyType());
+    newInternal = this->Split<InternalPage>(parentInternalPage);
+  }
+
+  if (newInternal != nullptr) {
+    auto middleKey = newInternal->GetLowKey();
+    // same as for leaves, release the split page before its parent is updated
+    if (!parentInternalPage->IsRootPage()) {
+      this->ReleaseSplitPage(parentPage, transaction);
+    }
+
     this->InsertIntoParent(parentInternalPage, middleKey, newInternal, transaction);
     this->buffer_pool_manager_->UnpinPage(newInternal->GetPageId(), true);
   }
@@ -268,63 +803,797 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
   this->buffer_pool_manager_->UnpinPage(parentPageId, true);
 }
 
-/*****************************************************************************
- * REMOVE
- *****************************************************************************/
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Build the tree bottom-up from a stream of key & value pairs in ascending key
+ * order. Every level keeps its rightmost node pinned, entries are appended to
+ * the rightmost leaf and whenever a node reaches its fill a new right sibling
+ * is started and hung into the level above, so pages are written once and in
+ * allocation order. The last node of a level may end up underfull, it is
+ * topped up from its left sibling at the end.
+ * Equal keys in the stream are skipped with unique keys, otherwise their
+ * values are collected into the posting list of the key.
+ * @return: false if the tree is not empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::function<bool(KeyType *, ValueType *)> &next, double fill_factor,
+                              Transaction *transaction) {
+  this->AcquireRootPageIdLatch();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    this->ReleaseRootPageIdLatch();
+    return false;
+  }
+
+  // fills are clamped so that a full left sibling can always top up the last node of its level
+  auto leafNeed = std::max(leaf_max_size_ / 2 + leaf_max_size_ % 2 - 1, 1);
+  auto internalNeed = std::max(internal_max_size_ / 2 + internal_max_size_ % 2, 2);
+  auto leafFill = std::clamp(static_cast<int>(fill_factor * (leaf_max_size_ - 1)), 2 * leafNeed - 1,
+                             std::max(leaf_max_size_ - 1, 1));
+  auto internalFill = std::clamp(static_cast<int>(fill_factor * internal_max_size_),
+                                 std::min(2 * internalNeed - 1, internal_max_size_), internal_max_size_);
+  // with variable sized keys a leaf may run out of space before it reaches its fill
+  auto spaceFill = std::clamp(fill_factor, 0.5, 1.0);
+  auto isLeafFilled = [&](LeafPage *leaf) {
+    auto used = leaf->GetUsedSpace();
+    return leaf->GetSize() == leafFill || !leaf->IsInsertSafe() ||
+           used >= spaceFill * (used + leaf->GetFreeSpace());
+  };
+
+  std::vector<Page *> levels;
+  std::vector<Page *> prevLevels;
+  std::vector<page_id_t> created;
+  // the buffer pool may run out of frames and next may throw, neither may leave the root latch held
+  try {
+    KeyType key;
+    ValueType value;
+    LeafPage *leaf = nullptr;
+    auto startLeaf = [&](const KeyType &firstKey, const ValueType &firstValue) {
+      auto page = this->BulkLoadNewPage(&created);
+      auto newLeaf = reinterpret_cast<LeafPage *>(page->GetData());
+      newLeaf->Init(page->GetPageId(), INVALID_PAGE_ID, leaf_max_size_);
+      newLeaf->Insert(firstKey, firstValue, this->comparator_);
+      auto lowKey =
+          leaf == nullptr ? firstKey : LeafPage::ShortestSeparator(leaf->KeyAt(leaf->GetSize() - 1), firstKey);
+      this->BulkLoadPushNode(&levels, &prevLevels, 0, page, lowKey, internalFill, &created);
+      leaf = newLeaf;
+    };
+    while (next(&key, &value)) {
+      if (leaf != nullptr && leaf->GetSize() > 0) {
+        auto last = leaf->GetSize() - 1;
+        auto cmp = this->comparator_(key, leaf->KeyAt(last));
+        if (cmp == 0) {
+          if (this->unique_keys_) {
+            continue;
+          }
+
+          // an inline posting list that outgrows the room of a full leaf takes its key along to the next leaf
+          if (last > 0 && !BPlusTreePostingPage::IsReference(leaf->ValueAt(last)) &&
+              leaf->ValueCountAt(last) < LEAF_PAGE_MAX_INLINE_VALUES && !leaf->HasRoomForValue(last)) {
+            std::vector<ValueType> values;
+            leaf->GetValues(last, &values);
+            leaf->RemoveAndDeleteRecord(key, this->comparator_);
+            startLeaf(key, values[0]);
+            leaf->SetValues(0, values, false);
+            last = 0;
+          }
+          this->InsertIntoPostingList(leaf, last, value, false, &created);
+          continue;
+        }
+        if (cmp < 0) {
+          throw Exception(ExceptionType::INVALID, "bulk load input is not sorted");
+        }
+      }
+
+      if (leaf == nullptr || isLeafFilled(leaf)) {
+        startLeaf(key, value);
+        continue;
+      }
+
+      leaf->Insert(key, value, this->comparator_);
+    }
+
+    if (levels.empty()) {
+      this->ReleaseRootPageIdLatch();
+      return true;
+    }
+
+    // top up the last node of every level from its left sibling, going down so that both share a parent
+    for (auto level = static_cast<int>(levels.size()) - 2; level >= 0; --level) {
+      auto parent = reinterpret_cast<InternalPage *>(levels[level + 1]->GetData());
+      auto node = reinterpret_cast<BPlusTreePage *>(levels[level]->GetData());
+      auto neighbor = reinterpret_cast<BPlusTreePage *>(prevLevels[level]->GetData());
+      if (node->IsLeafPage()) {
+        auto leafNode = reinterpret_cast<LeafPage *>(node);
+        while (leafNode->IsUnderflow() && this->Redistribute<LeafPage>(reinterpret_cast<LeafPage *>(neighbor),
+                                                                       leafNode, true, parent->GetSize() - 1, parent)) {
+        }
+      } else {
+        auto internalNode = reinterpret_cast<InternalPage *>(node);
+        while (internalNode->IsUnderflow() &&
+               this->Redistribute<InternalPage>(reinterpret_cast<InternalPage *>(neighbor), internalNode, true,
+                                                parent->GetSize() - 1, parent)) {
+        }
+      }
+    }
+  } catch (...) {
+    this->BulkLoadAbort(&levels, &prevLevels, created);
+    this->ReleaseRootPageIdLatch();
+    throw;
+  }
+
+  root_page_id_ = levels.back()->GetPageId();
+  UpdateRootPageId(1);
+
+  for (size_t level = 0; level < levels.size(); ++level) {
+    if (prevLevels[level] != nullptr) {
+      buffer_pool_manager_->UnpinPage(prevLevels[level]->GetPageId(), true);
+    }
+    buffer_pool_manager_->UnpinPage(levels[level]->GetPageId(), true);
+  }
+
+  this->ReleaseRootPageIdLatch();
+  return true;
+}
+
+/*
+ * Make the newly created page the rightmost node of its level. The previous
+ * rightmost node gets linked to it and the page is appended to the rightmost
+ * node of the level above, which is started (or becomes a new root) when it
+ * is full.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadPushNode(std::vector<Page *> *levels, std::vector<Page *> *prev_levels, size_t level,
+                                      Page *page, const KeyType &low_key, int internal_fill,
+                                      std::vector<page_id_t> *created) {
+  if (level == levels->size()) {
+    levels->push_back(page);
+    prev_levels->push_back(nullptr);
+    return;
+  }
+
+  auto oldPage = (*levels)[level];
+  auto oldNode = reinterpret_cast<BPlusTreePage *>(oldPage->GetData());
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (oldNode->IsLeafPage()) {
+    reinterpret_cast<LeafPage *>(oldNode)->LinkRightSibling(reinterpret_cast<LeafPage *>(node), low_key);
+  } else {
+    reinterpret_cast<InternalPage *>(oldNode)->LinkRightSibling(reinterpret_cast<InternalPage *>(node), low_key);
+  }
+
+  if ((*prev_levels)[level] != nullptr) {
+    buffer_pool_manager_->UnpinPage((*prev_levels)[level]->GetPageId(), true);
+  }
+  (*prev_levels)[level] = oldPage;
+  (*levels)[level] = page;
+
+  if (level + 1 == levels->size()) {
+    // the old node was the root so far
+    auto rootPage = this->BulkLoadNewPage(created);
+    auto root = reinterpret_cast<InternalPage *>(rootPage->GetData());
+    root->Init(rootPage->GetPageId(), INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(oldPage->GetPageId(), low_key, page->GetPageId());
+    oldNode->SetParentPageId(rootPage->GetPageId());
+    node->SetParentPageId(rootPage->GetPageId());
+    levels->push_back(rootPage);
+    prev_levels->push_back(nullptr);
+    return;
+  }
+
+  auto parentPage = (*levels)[level + 1];
+  auto parent = reinterpret_cast<InternalPage *>(parentPage->GetData());
+  if (parent->GetSize() < internal_fill && parent->IsInsertSafe()) {
+    parent->Append(low_key, page->GetPageId());
+    node->SetParentPageId(parentPage->GetPageId());
+    return;
+  }
+
+  auto newParentPage = this->BulkLoadNewPage(created);
+  auto newParent = reinterpret_cast<InternalPage *>(newParentPage->GetData());
+  newParent->Init(newParentPage->GetPageId(), INVALID_PAGE_ID, internal_max_size_);
+  newParent->Append(KeyType(), page->GetPageId());
+  node->SetParentPageId(newParentPage->GetPageId());
+  this->BulkLoadPushNode(levels, prev_levels, level + 1, newParentPage, low_key, internal_fill, created);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::BulkLoadNewPage(std::vector<page_id_t> *created) {
+  page_id_t pageId = INVALID_PAGE_ID;
+  auto *page = buffer_pool_manager_->NewPage(&pageId);
+  if (page == nullptr) {
+    // LOG_DEBUG("OOM");
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  created->push_back(pageId);
+  return page;
+}
+
+/*
+ * Unpin and delete every page created by an unfinished bulk load. No other
+ * thread can reach them, so every pin left on them is the bulk load's own.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadAbort(std::vector<Page *> *levels, std::vector<Page *> *prev_levels,
+                                   const std::vector<page_id_t> &created) {
+  for (size_t level = 0; level < levels->size(); ++level) {
+    if ((*prev_levels)[level] != nullptr) {
+      buffer_pool_manager_->UnpinPage((*prev_levels)[level]->GetPageId(), false);
+    }
+    buffer_pool_manager_->UnpinPage((*levels)[level]->GetPageId(), false);
+  }
+  levels->clear();
+  prev_levels->clear();
+
+  // a page that was just created may still be pinned without being on a level yet
+  for (auto pageId : created) {
+    while (!buffer_pool_manager_->DeletePage(pageId) && buffer_pool_manager_->UnpinPage(pageId, false)) {
+    }
+  }
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Delete key & value pair associated with input key
+ * If current tree is empty, return immdiately.
+ * If not, User needs to first find the right leaf page as deletion target, then
+ * delete entry from leaf page. Remember to deal with redistribute or merge if
+ * necessary.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  if (!this->change_buffering_) {
+    this->RemoveEntry(key, nullptr, transaction);
+    return;
+  }
+
+  // the values of the key are unknown without the leaf, so it is never buffered, and its pending changes go away
+  std::shared_lock<std::shared_mutex> latch(change_buffer_latch_);
+  this->RemoveEntry(key, nullptr, transaction);
+  insert_buffer_->Remove(key, transaction);
+  delete_buffer_->Remove(key, transaction);
+}
+
+/*
+ * Delete a single key & value pair. The leaf entry is deleted once the key
+ * has no values left.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  if (!this->change_buffering_) {
+    this->RemoveEntry(key, &value, transaction);
+    return;
+  }
+
+  std::shared_lock<std::shared_mutex> latch(change_buffer_latch_);
+  if (!this->change_buffering_) {
+    this->RemoveEntry(key, &value, transaction);
+    return;
+  }
+
+  auto isResident = true;
+  this->RemoveEntry(key, &value, transaction, &isResident);
+  if (!isResident) {
+    // a buffered insert of the pair may have found it in the leaf already, so it is hidden either way
+    this->CancelChange(insert_buffer_.get(), key, value, transaction);
+    delete_buffer_->Insert(key, value, transaction);
+    latch.unlock();
+    this->OnChangeBuffered();
+    return;
+  }
+
+  this->CancelChange(insert_buffer_.get(), key, value, transaction);
+}
+
+/*
+ * Delete key with all its values (value == nullptr) or only the given key &
+ * value pair
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveEntry(const KeyType &key, const ValueType *value, Transaction *transaction,
+                                 bool *is_resident) {
+  if (this->relaxed_deletes_) {
+    this->RelaxedRemove(key, value, is_resident);
+    return;
+  }
+
+  if (is_resident != nullptr && !this->optimistic_latching_) {
+    *is_resident = this->IsLeafResident(key);
+    if (!*is_resident) {
+      return;
+    }
+  }
+
+  if (this->optimistic_latching_ && this->OptimisticRemove(key, value, is_resident)) {
+    return;
+  }
+
+  this->AcquireRootPageIdLatch();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    this->ReleaseRootPageIdLatch();
+    return;
+  }
+
+  auto page = this->FindLeafPage(key, Operation::DELETE, transaction);
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+
+  // LOG_DEBUG("try delete %ld in %d", key.ToString(), leaf->GetPageId());
+
+  auto isDirty = false;
+  this->RemoveFromLeaf(leaf, key, value, true, &isDirty);
+
+  auto isCoalescedOrRedistributed = false;
+  if (leaf->IsUnderflow()) {
+    isCoalescedOrRedistributed = true;
+    this->CoalesceOrRedistribute<LeafPage>(leaf, transaction);
+  }
+
+  this->ReleaseAllWLatches(transaction, isCoalescedOrRedistributed);
+
+  if (leaf->IsRootPage()) {
+    // LOG_DEBUG("Unlatch root page id: %d", leaf->GetPageId());
+    this->ReleaseRootPageIdLatch();
+  }
+
+  // LOG_DEBUG("%d pin count: %d", page->GetPageId(), page->GetPinCount());
+  // LOG_DEBUG("Finish delete %ld in %d", key.ToString(), leaf->GetPageId());
+  page->WUnlatch();
+  this->buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+
+  this->DeletePages(transaction);
+}
+
+/*
+ * Free the pages emptied by merges, once the operation released its latches.
+ * The buffer pool deallocates them on disk, frames still pinned by readers are
+ * evicted like any other page later. Iterators may still reach a merged leaf
+ * through a left link or their position, so it is written out as an invalid
+ * page that links to the leaf its entries moved to, and its right neighbour
+ * is pointed past it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePages(Transaction *transaction) {
+  for (const auto &deletedPageId : *transaction->GetDeletedPageSet()) {
+    auto page = this->buffer_pool_manager_->FetchPage(deletedPageId);
+    if (page == nullptr) {
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    page->RLatch();
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    auto isMergedLeaf = leaf->IsInvalidPage();
+    auto nextPageId = isMergedLeaf ? leaf->GetNextPageId() : INVALID_PAGE_ID;
+    auto prevPageId = isMergedLeaf ? leaf->GetPrevPageId() : INVALID_PAGE_ID;
+    page->RUnlatch();
+    this->buffer_pool_manager_->UnpinPage(deletedPageId, false);
+
+    if (isMergedLeaf) {
+      this->UpdatePrevPageId(nextPageId, deletedPageId, prevPageId);
+      this->buffer_pool_manager_->FlushPage(deletedPageId);
+    }
+    this->buffer_pool_manager_->DeletePage(deletedPageId);
+    // LOG_DEBUG("DELETE %d", deletedPageId);
+    /* if (!) {
+      // LOG_INFO("Failed to delete page: %d", deletedPageId);
+      throw Exception(ExceptionType::INVALID, "Failed to delete page");
+    } */
+  }
+
+  transaction->GetDeletedPageSet()->clear();
+}
+
+/*
+ * Optimistic latch crabbing for deletion, see OptimisticInsert(). Works when
+ * the leaf stays at least half full after the deletion.
+ * @return: false means the caller has to restart pessimistically
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticRemove(const KeyType &key, const ValueType *value, bool *is_resident) {
+  auto page = this->FindLeafPageOptimistic(key, is_resident);
+  if (page == nullptr) {
+    return true;
+  }
+
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  auto isDirty = false;
+  if (!this->RemoveFromLeaf(leaf, key, value, this->IsSafe(leaf, Operation::DELETE), &isDirty)) {
+    this->ReleaseLeafWLatch(page, false);
+    return false;
+  }
+
+  this->ReleaseLeafWLatch(page, isDirty);
+  return true;
+}
+
+/*
+ * Relaxed deletion: descend like OptimisticRemove() but always delete from the
+ * leaf, which may fall below its minimum size (or, as the root, become empty).
+ * The key then leads MergeUnderflowPages() back to the leaf later.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RelaxedRemove(const KeyType &key, const ValueType *value, bool *is_resident) {
+  auto page = this->FindLeafPageOptimistic(key, is_resident);
+  if (page == nullptr) {
+    return;
+  }
+
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  auto isDirty = false;
+  this->RemoveFromLeaf(leaf, key, value, true, &isDirty);
+  auto isUnderflow = isDirty && this->ShouldMerge(leaf);
+  this->ReleaseLeafWLatch(page, isDirty);
+
+  if (isUnderflow) {
+    std::lock_guard<std::mutex> latch(underflow_keys_latch_);
+    underflow_keys_.push_back(key);
+  }
+}
+
+/*
+ * @return : true if the leaf is underfull, the root only once it is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::ShouldMerge(LeafPage *leaf) const {
+  return leaf->IsRootPage() ? leaf->GetSize() == 0 : leaf->IsUnderflow();
+}
+
+/*
+ * Fix the leaves left underfull by relaxed deletes, in key order. Every leaf
+ * is found again by a pessimistic descent of its own, so latches are only held
+ * for a single merge or redistribution (and the merges it cascades into), and
+ * leaves that were refilled or fixed in the meantime are skipped.
+ * @return : the number of leaves that were merged or redistributed
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::MergeUnderflowPages() {
+  std::vector<KeyType> keys;
+  {
+    std::lock_guard<std::mutex> latch(underflow_keys_latch_);
+    keys.swap(underflow_keys_);
+  }
+  std::sort(keys.begin(), keys.end(),
+            [this](const KeyType &a, const KeyType &b) { return this->comparator_(a, b) == -1; });
+
+  Transaction transaction(INVALID_TXN_ID);
+  size_t numMerged = 0;
+  for (const auto &key : keys) {
+    if (this->MergeUnderflowPage(key, &transaction)) {
+      ++numMerged;
+    }
+  }
+
+  return numMerged;
+}
+
+/*
+ * Merge or redistribute the leaf of key if it is still underfull, with the
+ * same latching as a pessimistic Remove()
+ * @return : true if the leaf was merged or redistributed
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::MergeUnderflowPage(const KeyType &key, Transaction *transaction) {
+  this->AcquireRootPageIdLatch();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    this->ReleaseRootPageIdLatch();
+    return false;
+  }
+
+  auto page = this->FindLeafPage(key, Operation::DELETE, transaction);
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  auto isMerged = this->ShouldMerge(leaf);
+  if (isMerged) {
+    this->CoalesceOrRedistribute<LeafPage>(leaf, transaction);
+  }
+
+  this->ReleaseAllWLatches(transaction, isMerged);
+  if (leaf->IsRootPage()) {
+    this->ReleaseRootPageIdLatch();
+  }
+
+  page->WUnlatch();
+  this->buffer_pool_manager_->UnpinPage(page->GetPageId(), isMerged);
+
+  this->DeletePages(transaction);
+  return isMerged;
+}
+
+/*
+ * Start a thread that runs MergeUnderflowPages() every
+ * background_merge_interval, nothing happens if one is running already
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartBackgroundMerge() {
+  std::lock_guard<std::mutex> latch(background_merge_latch_);
+  if (background_merge_thread_ != nullptr) {
+    return;
+  }
+
+  enable_background_merge_ = true;
+  background_merge_thread_ = new std::thread(&BPlusTree::RunBackgroundMerge, this);
+}
+
+/*
+ * Stop the background merge thread after its current round, the leaves
+ * it has not fixed yet stay pending
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StopBackgroundMerge() {
+  std::lock_guard<std::mutex> latch(background_merge_latch_);
+  if (background_merge_thread_ == nullptr) {
+    return;
+  }
+
+  enable_background_merge_ = false;
+  background_merge_thread_->join();
+  delete background_merge_thread_;
+  background_merge_thread_ = nullptr;
+}
+
+/*
+ * Helper function to start the background merge thread with the first
+ * buffered change instead of right away (off by default)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetBackgroundMergeOnDemand(bool background_merge_on_demand) {
+  background_merge_on_demand_ = background_merge_on_demand;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RunBackgroundMerge() {
+  while (enable_background_merge_) {
+    std::this_thread::sleep_for(background_merge_interval);
+    this->MergeUnderflowPages();
+    this->MergeChangeBuffer();
+  }
+}
+
+/*****************************************************************************
+ * CHANGE BUFFER
+ *****************************************************************************/
+/*
+ * Descend with read latch crabbing like FindLeafPage(), but only as long as
+ * the pages on the way are in the buffer pool. Concurrent splits may lead the
+ * descent to a neighbor of the leaf, which does not matter for a hint.
+ * @return : true if every page from the root to the leaf of key is in the
+ * buffer pool, or the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsLeafResident(const KeyType &key) {
+  auto page = this->LatchRootPage(false);
+  if (page == nullptr) {
+    return true;
+  }
+
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto childPageId = reinterpret_cast<InternalPage *>(node)->Lookup(key, this->comparator_);
+    if (!this->buffer_pool_manager_->IsPageResident(childPageId)) {
+      this->ReleasePrevRLatch(page);
+      return false;
+    }
+
+    auto childPage = this->buffer_pool_manager_->FetchPage(childPageId);
+    if (childPage == nullptr) {
+      this->ReleasePrevRLatch(page);
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    childPage->RLatch();
+    this->ReleasePrevRLatch(page);
+    page = childPage;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+
+  this->ReleasePrevRLatch(page);
+  return true;
+}
+
+/*
+ * Drop a pending change of a key & value pair from one of the buffers
+ * @return : true if the pair was pending there
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::CancelChange(BPlusTree *buffer, const KeyType &key, const ValueType &value,
+                                  Transaction *transaction) {
+  if (buffer->IsEmpty()) {
+    return false;
+  }
+
+  std::vector<ValueType> values;
+  buffer->GetValue(key, &values);
+  if (std::find(values.begin(), values.end(), value) == values.end()) {
+    return false;
+  }
+
+  buffer->Remove(key, value, transaction);
+  return true;
+}
+
+/*
+ * Apply the pending changes of key to the values read from its leaf: buffered
+ * deletes hide values, buffered inserts add them unless they are there already
+ * @return : true if the key has pending changes
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::ApplyChanges(const KeyType &key, std::vector<ValueType> *values) {
+  if (!this->HasPendingChanges()) {
+    return false;
+  }
+
+  std::vector<ValueType> deleted;
+  delete_buffer_->GetValue(key, &deleted);
+  for (const auto &value : deleted) {
+    values->erase(std::remove(values->begin(), values->end(), value), values->end());
+  }
+
+  std::vector<ValueType> inserted;
+  insert_buffer_->GetValue(key, &inserted);
+  for (const auto &value : inserted) {
+    if (std::find(values->begin(), values->end(), value) == values->end()) {
+      values->push_back(value);
+    }
+  }
+
+  return !deleted.empty() || !inserted.empty();
+}
+
+/*
+ * Start the background merge thread on demand, the flag is only set while
+ * the thread runs, so this is a single load once it does. Called without
+ * change_buffer_latch_, since stopping the thread waits for a merge that
+ * takes it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::OnChangeBuffered() {
+  if (this->background_merge_on_demand_ && !this->enable_background_merge_) {
+    this->StartBackgroundMerge();
+  }
+}
+
+/*
+ * Only reads the root page ids of the buffers, cheap enough for every lookup
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::HasPendingChanges() {
+  return has_change_buffer_ && (!insert_buffer_->IsEmpty() || !delete_buffer_->IsEmpty());
+}
+
+/*
+ * Merge the buffered changes batch by batch, every batch holds
+ * change_buffer_latch_ exclusively so writers and readers get in between
+ * @return : the number of changes merged
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::MergeChangeBuffer() {
+  size_t numMerged = 0;
+  while (this->HasPendingChanges()) {
+    std::unique_lock<std::shared_mutex> latch(change_buffer_latch_);
+    auto batchSize = this->MergeChangeBatch(nullptr, nullptr, CHANGE_BUFFER_MERGE_BATCH);
+    numMerged += batchSize;
+    // changes buffered meanwhile are left to the next round
+    if (batchSize < CHANGE_BUFFER_MERGE_BATCH) {
+      break;
+    }
+  }
+
+  return numMerged;
+}
+
+/*
+ * Merge the buffered changes within [low_key, high_key] before a scan reads
+ * the leaves of the range, nullptr stands for an open end
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MergeChanges(const KeyType *low_key, const KeyType *high_key) {
+  while (this->HasPendingChanges()) {
+    std::unique_lock<std::shared_mutex> latch(change_buffer_latch_);
+    if (this->MergeChangeBatch(low_key, high_key, CHANGE_BUFFER_MERGE_BATCH) < CHANGE_BUFFER_MERGE_BATCH) {
+      break;
+    }
+  }
+}
+
+/*
+ * Apply at most limit buffered inserts and as many buffered deletes within
+ * [low_key, high_key] to the leaves and drop them from the buffers. The
+ * buffers hold a pair in at most one of them, so the order does not matter.
+ * change_buffer_latch_ must be held exclusively.
+ * @return : the number of changes merged
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::MergeChangeBatch(const KeyType *low_key, const KeyType *high_key, size_t limit) {
+  if (!this->HasPendingChanges()) {
+    return 0;
+  }
+
+  std::vector<MappingType> inserts;
+  std::vector<MappingType> deletes;
+  this->CollectChanges(insert_buffer_.get(), low_key, high_key, limit, &inserts);
+  this->CollectChanges(delete_buffer_.get(), low_key, high_key, limit, &deletes);
+
+  Transaction transaction(INVALID_TXN_ID);
+  for (const auto &[key, value] : inserts) {
+    this->InsertEntry(key, value, &transaction);
+    insert_buffer_->Remove(key, value, &transaction);
+  }
+  for (const auto &[key, value] : deletes) {
+    this->RemoveEntry(key, &value, &transaction);
+    delete_buffer_->Remove(key, value, &transaction);
+  }
+
+  return inserts.size() + deletes.size();
+}
+
+/*
+ * Collect at most limit pairs within [low_key, high_key] of a buffer, in key
+ * order
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CollectChanges(BPlusTree *buffer, const KeyType *low_key, const KeyType *high_key, size_t limit,
+                                    std::vector<MappingType> *changes) {
+  auto iterator = low_key == nullptr ? buffer->begin() : buffer->Begin(*low_key);
+  for (; !iterator.isEnd() && changes->size() < limit; ++iterator) {
+    if (high_key != nullptr && this->comparator_((*iterator).first, *high_key) == 1) {
+      break;
+    }
+    changes->push_back(*iterator);
+  }
+}
+
 /*
- * Delete key & value pair associated with input key
- * If current tree is empty, return immdiately.
- * If not, User needs to first find the right leaf page as deletion target, then
- * delete entry from leaf page. Remember to deal with redistribute or merge if
- * necessary.
+ * Delete key with all its values (value == nullptr) or a single key & value
+ * pair from a write latched leaf. Dropping a value from a posting list keeps
+ * the leaf entry, the entry itself is only deleted if can_remove_entry is set.
+ * @return: false means the leaf entry has to be deleted but can_remove_entry
+ * is not set, nothing happened
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-  this->AcquireRootPageIdLatch(true);
-  if (root_page_id_ == INVALID_PAGE_ID) {
-    this->ReleaseRootPageIdLatch(true);
-    return;
+bool BPLUSTREE_TYPE::RemoveFromLeaf(LeafPage *leaf, const KeyType &key, const ValueType *value,
+                                    bool can_remove_entry, bool *is_dirty) {
+  *is_dirty = false;
+  auto ind = leaf->LookupIndex(key, this->comparator_);
+  if (ind < 0) {
+    return true;
   }
 
-  auto page = this->FindLeafPage(key, Operation::DELETE, transaction);
-  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
-
-  // LOG_DEBUG("try delete %ld in %d", key.ToString(), leaf->GetPageId());
-
-  ValueType v;
-  auto isExisted = leaf->Lookup(key, &v, this->comparator_);
-  if (isExisted) {
-    leaf->RemoveAndDeleteRecord(key, this->comparator_);
+  auto v = leaf->ValueAt(ind);
+  auto isPostingList = !this->unique_keys_ && BPlusTreePostingPage::IsReference(v);
+  if (value != nullptr && isPostingList) {
+    *is_dirty = this->RemoveFromPostingList(leaf, ind, v, *value);
+    return true;
   }
 
-  auto isCoalescedOrRedistributed = false;
-  if (leaf->GetSize() < leaf->GetMinSize()) {
-    isCoalescedOrRedistributed = true;
-    this->CoalesceOrRedistribute<LeafPage>(leaf, transaction);
+  if (value != nullptr && leaf->ValueCountAt(ind) > 1) {
+    // an inline posting list shrinks by a value, which never takes more than an entry of space
+    std::vector<ValueType> values;
+    leaf->GetValues(ind, &values);
+    auto it = std::find(values.begin(), values.end(), *value);
+    if (it != values.end()) {
+      values.erase(it);
+      leaf->SetValues(ind, values, true);
+      *is_dirty = true;
+    }
+    return true;
   }
 
-  this->ReleaseAllWLatches(transaction, isCoalescedOrRedistributed);
-
-  if (leaf->IsRootPage()) {
-    // LOG_DEBUG("Unlatch root page id: %d", leaf->GetPageId());
-    this->ReleaseRootPageIdLatch(true);
+  if (value != nullptr && !(v == *value)) {
+    return true;
   }
 
-  // LOG_DEBUG("%d pin count: %d", page->GetPageId(), page->GetPinCount());
-  // LOG_DEBUG("Finish delete %ld in %d", key.ToString(), leaf->GetPageId());
-  page->WUnlatch();
-  this->buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  if (!can_remove_entry) {
+    return false;
+  }
 
-  for (const auto &deletedPageId : *transaction->GetDeletedPageSet()) {
-    this->buffer_pool_manager_->DeletePage(deletedPageId);
-    // LOG_DEBUG("DELETE %d", deletedPageId);
-    /* if (!) {
-      // LOG_INFO("Failed to delete page: %d", deletedPageId);
-      throw Exception(ExceptionType::INVALID, "Failed to delete page");
-    } */
+  if (isPostingList) {
+    this->DeletePostingList(v);
   }
 
-  transaction->GetDeletedPageSet()->clear();
+  leaf->RemoveAndDeleteRecord(key, this->comparator_);
+  *is_dirty = true;
+  return true;
 }
 
 /*
@@ -375,7 +1644,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
     siblingPage->WLatch();
 
     siblingTreePage = reinterpret_cast<N *>(siblingPage->GetData());
-    shouldRedistribute = this->ShouldRedistribute(node, siblingTreePage);
+    shouldRedistribute = this->ShouldRedistribute(node, siblingTreePage, false, nodeInd, parentInternalPage);
 
   } else if (nodeInd == parentInternalPage->GetSize() - 1) {
     siblingPage = this->buffer_pool_manager_->FetchPage(parentInternalPage->ValueAt(nodeInd - 1));
@@ -387,7 +1656,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
     siblingPage->WLatch();
 
     siblingTreePage = reinterpret_cast<N *>(siblingPage->GetData());
-    shouldRedistribute = this->ShouldRedistribute(node, siblingTreePage);
+    shouldRedistribute = this->ShouldRedistribute(node, siblingTreePage, true, nodeInd, parentInternalPage);
     fromLeft = true;
 
   } else {
@@ -410,7 +1679,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
     auto leftSiblingTreePage = reinterpret_cast<N *>(leftSiblingPage->GetData());
     auto rightSiblingTreePage = reinterpret_cast<N *>(rightSiblingPage->GetData());
 
-    if (this->ShouldRedistribute(node, rightSiblingTreePage)) {
+    if (this->ShouldRedistribute(node, rightSiblingTreePage, false, nodeInd, parentInternalPage)) {
       shouldRedistribute = true;
       siblingPage = rightSiblingPage;
       siblingTreePage = rightSiblingTreePage;
@@ -419,7 +1688,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
       leftSiblingPage->WUnlatch();
       this->buffer_pool_manager_->UnpinPage(leftSiblingPage->GetPageId(), false);
 
-    } else if (this->ShouldRedistribute(node, leftSiblingTreePage)) {
+    } else if (this->ShouldRedistribute(node, leftSiblingTreePage, true, nodeInd, parentInternalPage)) {
       shouldRedistribute = true;
       fromLeft = true;
       siblingPage = leftSiblingPage;
@@ -440,7 +1709,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
   }
 
   if (shouldRedistribute) {
-    // redistribute
+    // redistribute, the node stays underfull if no entry can be moved
     this->Redistribute<N>(siblingTreePage, node, fromLeft, nodeInd, parentInternalPage);
   } else {
     // coalesce
@@ -459,7 +1728,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
   // LOG_DEBUG("%d pin count: %d", parentPageId, parentPage->GetPinCount());
   // LOG_DEBUG("%d pin count: %d", siblingPage->GetPageId(), siblingPage->GetPinCount());
   if (siblingTreePage->IsRootPage()) {
-    this->ReleaseRootPageIdLatch(true);
+    this->ReleaseRootPageIdLatch();
   }
 
   siblingPage->WUnlatch();
@@ -495,12 +1764,16 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
     auto leafSib = reinterpret_cast<LeafPage *>(*neighbor_node);
 
     leaf->MoveAllTo(leafSib);
-    leafSib->SetNextPageId(leaf->GetNextPageId());
+    leaf->IncreaseLowKeyVersion();
+    // the merged leaf stays behind as an invalid page linking to the leaf its entries moved to, see DeletePages()
+    leaf->SetPageType(IndexPageType::INVALID_INDEX_PAGE);
+    leaf->SetPrevPageId(leafSib->GetPageId());
   } else {
     auto internal = reinterpret_cast<InternalPage *>(*node);
     auto internalSib = reinterpret_cast<InternalPage *>(*neighbor_node);
 
     internal->MoveAllTo(internalSib, (*parent)->KeyAt(index), this->buffer_pool_manager_);
+    internal->IncreaseLowKeyVersion();
   }
 
   (*parent)->Remove(index);
@@ -508,7 +1781,7 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
   transaction->AddIntoDeletedPageSet((*node)->GetPageId());
   // LOG_DEBUG("Add %d into deleted page set", (*node)->GetPageId());
   // LOG_DEBUG("Finish coalesce %d", (*node)->GetPageId());
-  if ((*parent)->GetSize() - 1 < (*parent)->GetMinSize()) {
+  if ((*parent)->IsUnderflow()) {
     return this->CoalesceOrRedistribute<InternalPage>(*parent, transaction);
   }
 
@@ -519,44 +1792,69 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  * Redistribute key & value pairs from one page to its sibling page. If index ==
  * 0, move sibling page's first key & value pair into end of input "node",
  * otherwise move sibling page's last key & value pair into head of input
- * "node".
+ * "node". The separator in the parent changes, leaves pick the shortest one
+ * between both pages.
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @return  false means nothing was moved, the neighbor cannot spare an entry
+ * or there is no room for it or for the new separator
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, bool from_left, int node_ind, InternalPage *parent) {
+bool BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, bool from_left, int node_ind, InternalPage *parent) {
   // LOG_DEBUG("Try Redistribute %d", node->GetPageId());
+  auto sz = neighbor_node->GetSize();
+  auto keyInd = from_left ? node_ind : node_ind + 1;
   if (node->IsLeafPage()) {
     auto neighborLeaf = reinterpret_cast<LeafPage *>(neighbor_node);
     auto leaf = reinterpret_cast<LeafPage *>(node);
+    if (sz < 2) {
+      return false;
+    }
+
+    auto newKey = from_left ? LeafPage::ShortestSeparator(neighborLeaf->KeyAt(sz - 2), neighborLeaf->KeyAt(sz - 1))
+                            : LeafPage::ShortestSeparator(neighborLeaf->KeyAt(0), neighborLeaf->KeyAt(1));
+    if (!parent->CanSetKeyAt(keyInd, newKey)) {
+      return false;
+    }
 
     if (from_left) {
-      neighborLeaf->MoveLastToFrontOf(leaf);
-      parent->SetKeyAt(node_ind, node->KeyAt(0));
-      return;
+      if (!neighborLeaf->MoveLastToFrontOf(leaf, newKey)) {
+        return false;
+      }
+    } else {
+      if (!neighborLeaf->MoveFirstToEndOf(leaf, newKey)) {
+        return false;
+      }
+      neighborLeaf->IncreaseLowKeyVersion();
     }
 
-    neighborLeaf->MoveFirstToEndOf(leaf);
-    parent->SetKeyAt(node_ind + 1, neighbor_node->KeyAt(0));
-    return;
+    parent->SetKeyAt(keyInd, newKey);
+    return true;
   }
 
   auto neighborInternal = reinterpret_cast<InternalPage *>(neighbor_node);
   auto internal = reinterpret_cast<InternalPage *>(node);
+  auto newKey = neighborInternal->KeyAt(from_left ? sz - 1 : 1);
+  if (sz < 3 || !parent->CanSetKeyAt(keyInd, newKey)) {
+    return false;
+  }
 
   if (from_left) {
-    auto newKey = neighborInternal->KeyAt(neighborInternal->GetSize() - 1);
-    neighborInternal->MoveLastToFrontOf(internal, parent->KeyAt(node_ind), this->buffer_pool_manager_);
-    parent->SetKeyAt(node_ind, newKey);
-    return;
+    if (!neighborInternal->MoveLastToFrontOf(internal, parent->KeyAt(keyInd), this->buffer_pool_manager_)) {
+      return false;
+    }
+  } else {
+    if (!neighborInternal->MoveFirstToEndOf(internal, parent->KeyAt(keyInd), this->buffer_pool_manager_)) {
+      return false;
+    }
+    neighborInternal->IncreaseLowKeyVersion();
   }
 
-  auto newKey = neighborInternal->KeyAt(1);
-  neighborInternal->MoveFirstToEndOf(internal, parent->KeyAt(node_ind + 1), this->buffer_pool_manager_);
-  parent->SetKeyAt(node_ind + 1, newKey);
+  parent->SetKeyAt(keyInd, newKey);
   // LOG_DEBUG("Finish Redistribute %d", node->GetPageId());
+  return true;
 }
 /*
  * Update root page if necessary
@@ -580,102 +1878,707 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
 
       // set to self to avoid unlatch root_page_id_
       old_root_node->SetParentPageId(pageId);
+      // optimistic readers that reached the old root before it was unlinked restart
+      reinterpret_cast<LeafPage *>(old_root_node)->IncreaseLowKeyVersion();
+
+      this->ReleaseRootPageIdLatch();
+      // LOG_DEBUG("Old Root Page Id: %d, New Root Page Id: %d", pageId, INVALID_PAGE_ID);
+
+      return true;
+    }
+
+    return false;
+  }
+
+  if (old_root_node->GetSize() == 1) {
+    auto internalPage = reinterpret_cast<InternalPage *>(old_root_node);
+    auto newRootPageId = internalPage->RemoveAndReturnOnlyChild();
+
+    auto newRootPage = this->buffer_pool_manager_->FetchPage(newRootPageId);
+    if (newRootPage == nullptr) {
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    auto leafPage = reinterpret_cast<LeafPage *>(newRootPage->GetData());
+    this->root_page_id_ = leafPage->GetPageId();
+    this->UpdateRootPageId(0);
+    // LOG_DEBUG("Old Root Page Id: %d, New Root Page Id: %d", pageId, root_page_id_);
+
+    leafPage->SetParentPageId(INVALID_PAGE_ID);
+
+    // set to self to avoid unlatch root_page_id_
+    old_root_node->SetParentPageId(pageId);
+    internalPage->IncreaseLowKeyVersion();
+
+    // LOG_DEBUG("%d pin count: %d", newRootPageId, newRootPage->GetPinCount());
+    this->buffer_pool_manager_->UnpinPage(newRootPageId, true);
+
+    return true;
+  }
+
+  return false;
+}
+
+/*****************************************************************************
+ * POSTING LIST
+ *****************************************************************************/
+/*
+ * Add value to the values of the key at index of a write latched leaf. Short
+ * posting lists stay inline in the leaf entry, in RID order. A list that
+ * outgrows LEAF_PAGE_MAX_INLINE_VALUES, or the room of the leaf, is spilled
+ * to a new posting page, which the leaf entry then refers to. Full posting
+ * pages are split, so a spilled list no longer changes the leaf entry.
+ * @param   can_overflow   the caller splits the leaf if it overflows
+ * @param   created        collects newly allocated pages if not nullptr
+ * @return: false if the key & value pair already exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertIntoPostingList(LeafPage *leaf, int index, const ValueType &value, bool can_overflow,
+                                           std::vector<page_id_t> *created) {
+  auto reference = leaf->ValueAt(index);
+  if (!BPlusTreePostingPage::IsReference(reference)) {
+    std::vector<ValueType> values;
+    leaf->GetValues(index, &values);
+    auto it = std::lower_bound(values.begin(), values.end(), value,
+                               [](const ValueType &a, const ValueType &b) { return a.Get() < b.Get(); });
+    if (it != values.end() && *it == value) {
+      return false;
+    }
+
+    values.insert(it, value);
+    if (leaf->SetValues(index, values, can_overflow)) {
+      return true;
+    }
+
+    page_id_t headPageId = INVALID_PAGE_ID;
+    auto headPage = this->NewPostingPage(&headPageId, created);
+    auto head = reinterpret_cast<BPlusTreePostingPage *>(headPage->GetData());
+    head->Init();
+    for (const auto &v : values) {
+      head->Insert(v);
+    }
+    leaf->SetValues(index, {BPlusTreePostingPage::MakeReference(headPageId)}, true);
+    this->buffer_pool_manager_->UnpinPage(headPageId, true);
+    return true;
+  }
+
+  // the first page whose RIDs reach up to value, or the last one
+  auto page = this->FetchPostingPage(reference.GetPageId());
+  auto posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  while (posting->GetNextPageId() != INVALID_PAGE_ID && posting->IsAfter(value)) {
+    auto nextPage = this->FetchPostingPage(posting->GetNextPageId());
+    this->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = nextPage;
+    posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  }
+
+  if (!posting->IsFull()) {
+    auto isInserted = posting->Insert(value);
+    this->buffer_pool_manager_->UnpinPage(page->GetPageId(), isInserted);
+    return isInserted;
+  }
+
+  if (posting->Contains(value)) {
+    this->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return false;
+  }
+
+  // split
+  page_id_t newPageId = INVALID_PAGE_ID;
+  auto newPage = this->NewPostingPage(&newPageId, created);
+  auto newPosting = reinterpret_cast<BPlusTreePostingPage *>(newPage->GetData());
+  newPosting->Init(posting->GetNextPageId());
+  posting->MoveHalfTo(newPosting);
+  posting->SetNextPageId(newPageId);
+  if (posting->IsAfter(value)) {
+    newPosting->Insert(value);
+  } else {
+    posting->Insert(value);
+  }
+
+  this->buffer_pool_manager_->UnpinPage(newPageId, true);
+  this->buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  return true;
+}
+
+/*
+ * Remove value from the posting list of the key at index in a write latched
+ * leaf. Pages never stay empty and a page is merged with its successor when
+ * both fit in half a page. A list that shrinks to half of
+ * LEAF_PAGE_MAX_INLINE_VALUES moves back inline if the leaf has room for it.
+ * @param   reference      current value of the key in the leaf
+ * @return: false if value is not in the posting list
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::RemoveFromPostingList(LeafPage *leaf, int index, const ValueType &reference,
+                                           const ValueType &value) {
+  Page *prevPage = nullptr;
+  auto page = this->FetchPostingPage(reference.GetPageId());
+  auto posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  while (posting->GetNextPageId() != INVALID_PAGE_ID && posting->IsAfter(value)) {
+    auto nextPage = this->FetchPostingPage(posting->GetNextPageId());
+    if (prevPage != nullptr) {
+      this->buffer_pool_manager_->UnpinPage(prevPage->GetPageId(), false);
+    }
+    prevPage = page;
+    page = nextPage;
+    posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  }
+
+  if (!posting->Remove(value)) {
+    if (prevPage != nullptr) {
+      this->buffer_pool_manager_->UnpinPage(prevPage->GetPageId(), false);
+    }
+    this->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return false;
+  }
+
+  std::vector<page_id_t> deletedPageIds;
+  if (posting->GetSize() == 0 && prevPage != nullptr) {
+    // unlink the empty page, the head page has to stay since the leaf refers to it
+    reinterpret_cast<BPlusTreePostingPage *>(prevPage->GetData())->SetNextPageId(posting->GetNextPageId());
+    deletedPageIds.push_back(page->GetPageId());
+    this->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = prevPage;
+    posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+    prevPage = nullptr;
+  } else if (posting->GetNextPageId() != INVALID_PAGE_ID) {
+    auto nextPage = this->FetchPostingPage(posting->GetNextPageId());
+    auto nextPosting = reinterpret_cast<BPlusTreePostingPage *>(nextPage->GetData());
+    auto isMerged = posting->GetSize() == 0 ||
+                    posting->GetSize() + nextPosting->GetSize() <= static_cast<int>(POSTING_PAGE_SIZE / 2);
+    if (isMerged) {
+      nextPosting->MoveAllTo(posting);
+      posting->SetNextPageId(nextPosting->GetNextPageId());
+      deletedPageIds.push_back(nextPage->GetPageId());
+    }
+    this->buffer_pool_manager_->UnpinPage(nextPage->GetPageId(), false);
+  }
+
+  if (page->GetPageId() == reference.GetPageId() && posting->GetSize() <= LEAF_PAGE_MAX_INLINE_VALUES / 2 &&
+      posting->GetNextPageId() == INVALID_PAGE_ID) {
+    std::vector<ValueType> values;
+    for (int i = 0; i < posting->GetSize(); ++i) {
+      values.emplace_back(posting->ValueAt(i));
+    }
+    if (leaf->SetValues(index, values, false)) {
+      deletedPageIds.push_back(page->GetPageId());
+    }
+  }
+
+  if (prevPage != nullptr) {
+    this->buffer_pool_manager_->UnpinPage(prevPage->GetPageId(), true);
+  }
+  this->buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+
+  // posting pages are only pinned under the leaf latch, so nobody else can hold them
+  for (auto pageId : deletedPageIds) {
+    this->buffer_pool_manager_->DeletePage(pageId);
+  }
+  return true;
+}
+
+/*
+ * Append the values of the leaf entry at index to result, following its
+ * posting list if it is not inline. The leaf has to be latched.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CollectValues(const LeafPage *leaf, int index, std::vector<ValueType> *result) {
+  auto value = leaf->ValueAt(index);
+  if (this->unique_keys_ || !BPlusTreePostingPage::IsReference(value)) {
+    leaf->GetValues(index, result);
+    return;
+  }
+
+  auto pageId = value.GetPageId();
+  while (pageId != INVALID_PAGE_ID) {
+    auto page = this->FetchPostingPage(pageId);
+    auto posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+    for (int i = 0; i < posting->GetSize(); ++i) {
+      result->emplace_back(posting->ValueAt(i));
+    }
+    pageId = posting->GetNextPageId();
+    this->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+}
+
+/*
+ * Delete every page of the posting list a leaf entry refers to
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePostingList(const ValueType &reference) {
+  auto pageId = reference.GetPageId();
+  while (pageId != INVALID_PAGE_ID) {
+    auto page = this->FetchPostingPage(pageId);
+    auto nextPageId = reinterpret_cast<BPlusTreePostingPage *>(page->GetData())->GetNextPageId();
+    this->buffer_pool_manager_->UnpinPage(pageId, false);
+    this->buffer_pool_manager_->DeletePage(pageId);
+    pageId = nextPageId;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchPostingPage(page_id_t page_id) {
+  auto page = this->buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::NewPostingPage(page_id_t *page_id, std::vector<page_id_t> *created) {
+  auto page = this->buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr) {
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  if (created != nullptr) {
+    created->push_back(*page_id);
+  }
+  return page;
+}
+
+/*****************************************************************************
+ * INDEX ITERATOR
+ *****************************************************************************/
+/*
+ * Input parameter is void, find the leaftmost leaf page first, then construct
+ * index iterator. Iterators only read the leaves, so the starters merge the
+ * buffered changes of their range first.
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
+  this->MergeChanges(nullptr, nullptr);
+  auto page = this->FindLeafPage(KeyType(), Operation::READ, nullptr, true);
+
+  return INDEXITERATOR_TYPE(page, this->buffer_pool_manager_, this->comparator_, this->LeafFinder(), 0,
+                            this->unique_keys_);
+}
+
+/*
+ * Input parameter is low key, find the leaf page that contains the input key
+ * first, then construct index iterator
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+  this->MergeChanges(&key, nullptr);
+  return this->BeginRange(key, nullptr, false);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key, const KeyType &stop_key, bool is_stop_inclusive) {
+  this->MergeChanges(&key, &stop_key);
+  return this->BeginRange(key, &stop_key, is_stop_inclusive);
+}
+
+/*
+ * Same as Begin(key), the iterator ends before stop_key (after it if
+ * is_stop_inclusive) or at the last key if stop_key is nullptr
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::BeginRange(const KeyType &key, const KeyType *stop_key, bool is_stop_inclusive) {
+  auto page = this->FindLeafPage(key, Operation::READ);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE(nullptr, this->buffer_pool_manager_, this->comparator_);
+  }
+
+  auto ind = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(key, this->comparator_);
+  return INDEXITERATOR_TYPE(page, this->buffer_pool_manager_, this->comparator_, this->LeafFinder(), ind,
+                            this->unique_keys_, stop_key, is_stop_inclusive);
+}
+
+/*
+ * Partitioned range scan: descend level by level, with read latch crabbing
+ * like FindLeafPage(), until the pages of a level within the range have at
+ * least num_partitions - 1 separators in the range, or the next level is the
+ * leaf level. Evenly spaced separators of that level split the range, every
+ * sub-range starts at its separator and ends before the next one. Separators
+ * are only hints, concurrent writers can change the tree before or while the
+ * iterators run: the iterators step by key (see IndexIterator), so keys that
+ * stay in the tree are neither lost nor repeated.
+ * @return : at most num_partitions iterators, in key order
+ */
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<INDEXITERATOR_TYPE> BPLUSTREE_TYPE::PartitionRange(const KeyType &low_key, const KeyType &high_key,
+                                                               int num_partitions) {
+  std::vector<INDEXITERATOR_TYPE> iterators;
+  if (this->comparator_(low_key, high_key) == 1) {
+    return iterators;
+  }
+  this->MergeChanges(&low_key, &high_key);
+
+  std::vector<KeyType> separators;
+  auto page = this->LatchRootPage(false);
+  if (page == nullptr) {
+    return iterators;
+  }
+
+  if (!reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage()) {
+    std::vector<KeyType> levelSeparators;
+    for (int depth = 0; static_cast<int>(separators.size()) + 1 < num_partitions; ++depth) {
+      levelSeparators.clear();
+      if (!this->CollectSeparators(page, depth, low_key, high_key, &levelSeparators)) {
+        break;
+      }
+      separators.swap(levelSeparators);
+    }
+  }
+  this->ReleasePrevRLatch(page);
+
+  // pick evenly spaced ones among the sub-ranges of the separators
+  int numSeparators = separators.size();
+  int numSplits = std::min(numSeparators, std::max(num_partitions, 1) - 1);
+  const KeyType *startKey = &low_key;
+  for (int i = 1; i <= numSplits; ++i) {
+    const auto &separator = separators[static_cast<int64_t>(i) * (numSeparators + 1) / (numSplits + 1) - 1];
+    iterators.push_back(this->BeginRange(*startKey, &separator, false));
+    startKey = &separator;
+  }
+  iterators.push_back(this->BeginRange(*startKey, &high_key, true));
+
+  return iterators;
+}
+
+/*
+ * Collect the separators within (low_key, high_key] of the internal pages
+ * depth levels below the read latched internal page, in key order. Children
+ * are latched before the latch of their parent is released.
+ * @return : false if the pages that deep are leaves
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::CollectSeparators(Page *page, int depth, const KeyType &low_key, const KeyType &high_key,
+                                       std::vector<KeyType> *separators) {
+  auto internal = reinterpret_cast<InternalPage *>(page->GetData());
+  auto sz = internal->GetSize();
+  for (int i = 0; i < sz; ++i) {
+    // child i covers [KeyAt(i), KeyAt(i + 1)), the first one has no lower bound
+    if (i > 0 && this->comparator_(internal->KeyAt(i), high_key) == 1) {
+      break;
+    }
+    if (i + 1 < sz && this->comparator_(internal->KeyAt(i + 1), low_key) != 1) {
+      continue;
+    }
+
+    if (depth == 0) {
+      if (i > 0 && this->comparator_(internal->KeyAt(i), low_key) == 1) {
+        separators->push_back(internal->KeyAt(i));
+      }
+      continue;
+    }
+
+    auto childPage = buffer_pool_manager_->FetchPage(internal->ValueAt(i));
+    if (childPage == nullptr) {
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    auto isLeaf = reinterpret_cast<BPlusTreePage *>(childPage->GetData())->IsLeafPage();
+    auto isCollected = false;
+    if (!isLeaf) {
+      childPage->RLatch();
+      isCollected = this->CollectSeparators(childPage, depth - 1, low_key, high_key, separators);
+      childPage->RUnlatch();
+    }
+    buffer_pool_manager_->UnpinPage(childPage->GetPageId(), false);
+    if (!isCollected) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Walk every internal level from left to right along the right links, pinning
+ * the leftmost page of the level below on the way. The lowest internal level
+ * tells the number of leaves, which are then either read in full along their
+ * right links or sampled by descents to random children. Only one page is
+ * latched at a time, so concurrent changes make the statistics approximate.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CollectStats(IndexStats *stats, std::vector<KeyType> *histogram_bounds, double sample_rate,
+                                  int num_buckets) {
+  *stats = IndexStats();
+  histogram_bounds->clear();
+
+  auto page = this->LatchRootPage(false);
+  if (page == nullptr) {
+    return;
+  }
 
-      this->ReleaseRootPageIdLatch(true);
-      // LOG_DEBUG("Old Root Page Id: %d, New Root Page Id: %d", pageId, INVALID_PAGE_ID);
+  uint64_t numLeaves = 1;
+  while (!reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage()) {
+    Page *childPage = nullptr;
+    uint64_t numPages = 0;
+    uint64_t numChildren = 0;
+    double fill = 0;
+    while (page != nullptr) {
+      auto internal = reinterpret_cast<InternalPage *>(page->GetData());
+      if (childPage == nullptr) {
+        childPage = buffer_pool_manager_->FetchPage(internal->ValueAt(0));
+        if (childPage == nullptr) {
+          page->RUnlatch();
+          buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+          throw ExceptionType::OUT_OF_MEMORY;
+        }
+      }
 
-      return true;
+      ++numPages;
+      numChildren += internal->GetSize();
+      fill += static_cast<double>(internal->GetUsedSpace()) / (internal->GetUsedSpace() + internal->GetFreeSpace());
+      page = this->MoveRightOnLevel(page, internal->GetNextPageId(), childPage);
     }
 
-    return false;
+    stats->num_pages_.push_back(numPages);
+    stats->fill_factors_.push_back(fill / numPages);
+    numLeaves = numChildren;
+    page = childPage;
+    page->RLatch();
   }
 
-  if (old_root_node->GetSize() == 1) {
-    auto internalPage = reinterpret_cast<InternalPage *>(old_root_node);
-    auto newRootPageId = internalPage->RemoveAndReturnOnlyChild();
+  std::vector<std::pair<KeyType, uint64_t>> keyCounts;
+  uint64_t numPostingPages = 0;
+  uint64_t numRead = 0;
+  double fill = 0;
+  if (sample_rate >= 1 || numLeaves <= 1) {
+    while (page != nullptr) {
+      auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+      this->CollectLeafStats(leaf, &keyCounts, &numPostingPages);
+      ++numRead;
+      fill += static_cast<double>(leaf->GetUsedSpace()) / (leaf->GetUsedSpace() + leaf->GetFreeSpace());
+      page = this->MoveRightOnLevel(page, leaf->GetNextPageId(), nullptr);
+    }
+    numLeaves = numRead;
+  } else {
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+
+    // descents may end up in the same leaf, give up after a few repeats
+    auto numSamples = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(sample_rate * numLeaves)), 1);
+    std::mt19937 generator(std::random_device{}());
+    std::unordered_set<page_id_t> sampled;
+    for (uint64_t attempt = 0; sampled.size() < numSamples && attempt < 4 * numSamples; ++attempt) {
+      page = this->FindRandomLeafPage(&generator);
+      if (page == nullptr) {
+        break;
+      }
 
-    auto newRootPage = this->buffer_pool_manager_->FetchPage(newRootPageId);
-    if (newRootPage == nullptr) {
-      throw ExceptionType::OUT_OF_MEMORY;
+      auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+      if (sampled.insert(page->GetPageId()).second) {
+        this->CollectLeafStats(leaf, &keyCounts, &numPostingPages);
+        ++numRead;
+        fill += static_cast<double>(leaf->GetUsedSpace()) / (leaf->GetUsedSpace() + leaf->GetFreeSpace());
+      }
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
     }
 
-    auto leafPage = reinterpret_cast<LeafPage *>(newRootPage->GetData());
-    this->root_page_id_ = leafPage->GetPageId();
-    this->UpdateRootPageId(0);
-    // LOG_DEBUG("Old Root Page Id: %d, New Root Page Id: %d", pageId, root_page_id_);
+    std::sort(keyCounts.begin(), keyCounts.end(), [this](const auto &lhs, const auto &rhs) {
+      return this->comparator_(lhs.first, rhs.first) == -1;
+    });
+  }
 
-    leafPage->SetParentPageId(INVALID_PAGE_ID);
+  if (numRead == 0) {
+    return;
+  }
 
-    // set to self to avoid unlatch root_page_id_
-    old_root_node->SetParentPageId(pageId);
+  // counts of the leaves read stand for all leaves
+  auto scale = static_cast<double>(numLeaves) / numRead;
+  auto scaled = [scale](uint64_t count) { return static_cast<uint64_t>(std::llround(count * scale)); };
+  stats->height_ = stats->num_pages_.size() + 1;
+  stats->num_pages_.push_back(numLeaves);
+  stats->fill_factors_.push_back(fill / numRead);
+  stats->sample_rate_ = static_cast<double>(numRead) / numLeaves;
+  stats->num_posting_pages_ = scaled(numPostingPages);
+  stats->num_keys_ = scaled(keyCounts.size());
+
+  uint64_t total = 0;
+  for (const auto &keyCount : keyCounts) {
+    total += keyCount.second;
+  }
+  stats->num_values_ = scaled(total);
+
+  // a bucket ends with the key that brings the values seen so far to its share of the total
+  uint64_t seen = 0;
+  uint64_t bucketValues = 0;
+  uint64_t bucketKeys = 0;
+  for (size_t i = 0; i < keyCounts.size(); ++i) {
+    seen += keyCounts[i].second;
+    bucketValues += keyCounts[i].second;
+    ++bucketKeys;
+    if (i + 1 < keyCounts.size() && seen * num_buckets < (histogram_bounds->size() + 1) * total) {
+      continue;
+    }
 
-    // LOG_DEBUG("%d pin count: %d", newRootPageId, newRootPage->GetPinCount());
-    this->buffer_pool_manager_->UnpinPage(newRootPageId, true);
+    histogram_bounds->push_back(keyCounts[i].first);
+    stats->histogram_counts_.push_back(scaled(bucketValues));
+    stats->histogram_num_keys_.push_back(scaled(bucketKeys));
+    bucketValues = 0;
+    bucketKeys = 0;
+  }
+}
 
-    return true;
+/*
+ * Move from the read latched page to its right sibling on the same level. The
+ * sibling is pinned before the page is released and latched after, so it can
+ * neither be deleted in between nor deadlock with a writer. pinned_page, if
+ * any, is unpinned when that fails.
+ * @return : the read latched right sibling, nullptr at the end of the level
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::MoveRightOnLevel(Page *page, page_id_t next_page_id, Page *pinned_page) {
+  Page *nextPage = nullptr;
+  if (next_page_id != INVALID_PAGE_ID) {
+    nextPage = buffer_pool_manager_->FetchPage(next_page_id);
   }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
 
-  return false;
+  if (next_page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  if (nextPage == nullptr) {
+    if (pinned_page != nullptr) {
+      buffer_pool_manager_->UnpinPage(pinned_page->GetPageId(), false);
+    }
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  nextPage->RLatch();
+  return nextPage;
 }
 
-/*****************************************************************************
- * INDEX ITERATOR
- *****************************************************************************/
 /*
- * Input parameter is void, find the leaftmost leaf page first, then construct
- * index iterator
- * @return : index iterator
+ * Descend to a child chosen uniformly at random on every level, latching
+ * top-down like FindLeafPage()
+ * @return : the read latched leaf, nullptr if the tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
-  this->AcquireRootPageIdLatch(false);
-  if (root_page_id_ == INVALID_PAGE_ID) {
-    this->ReleaseRootPageIdLatch(false);
-    return INDEXITERATOR_TYPE(INVALID_PAGE_ID, this->buffer_pool_manager_, this->comparator_);
+Page *BPLUSTREE_TYPE::FindRandomLeafPage(std::mt19937 *generator) {
+  auto page = this->LatchRootPage(false);
+  if (page == nullptr) {
+    return nullptr;
   }
 
-  auto page = this->FindLeafPage(KeyType(), Operation::READ, nullptr, true);
-  auto pageId = page->GetPageId();
-  this->ReleasePrevRLatch(page);
+  auto treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!treePage->IsLeafPage()) {
+    auto internal = reinterpret_cast<InternalPage *>(treePage);
+    std::uniform_int_distribution<int> distribution(0, internal->GetSize() - 1);
+    auto childPage = buffer_pool_manager_->FetchPage(internal->ValueAt(distribution(*generator)));
+    if (childPage != nullptr) {
+      childPage->RLatch();
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (childPage == nullptr) {
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    page = childPage;
+    treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
 
-  return INDEXITERATOR_TYPE(pageId, this->buffer_pool_manager_, this->comparator_);
+  return page;
 }
 
 /*
- * Input parameter is low key, find the leaf page that contains the input key
- * first, then construct index iterator
+ * Append every key of the read latched leaf with its number of values, which
+ * are counted along the posting lists that are not inline
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CollectLeafStats(LeafPage *leaf, std::vector<std::pair<KeyType, uint64_t>> *key_counts,
+                                      uint64_t *num_posting_pages) {
+  for (int i = 0; i < leaf->GetSize(); ++i) {
+    auto value = leaf->ValueAt(i);
+    uint64_t count = leaf->ValueCountAt(i);
+    if (!this->unique_keys_ && BPlusTreePostingPage::IsReference(value)) {
+      count = 0;
+      auto pageId = value.GetPageId();
+      while (pageId != INVALID_PAGE_ID) {
+        auto page = this->FetchPostingPage(pageId);
+        auto posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+        count += posting->GetSize();
+        ++*num_posting_pages;
+        pageId = posting->GetNextPageId();
+        this->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      }
+    }
+    key_counts->emplace_back(leaf->KeyAt(i), count);
+  }
+}
+
+/*
+ * Input parameter is void, construct an index iterator representing the end
+ * of the key/value pair in the leaf node
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  this->AcquireRootPageIdLatch(false);
-  if (root_page_id_ == INVALID_PAGE_ID) {
-    this->ReleaseRootPageIdLatch(false);
-    return INDEXITERATOR_TYPE(INVALID_PAGE_ID, this->buffer_pool_manager_, this->comparator_);
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
+  return INDEXITERATOR_TYPE(nullptr, this->buffer_pool_manager_, this->comparator_);
+}
+
+/*
+ * Input parameter is void, find the rightmost leaf page first, then construct
+ * reverse index iterator
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+REVERSE_INDEXITERATOR_TYPE BPLUSTREE_TYPE::rbegin() {
+  this->MergeChanges(nullptr, nullptr);
+  auto page = this->FindLeafPage(KeyType(), Operation::READ, nullptr, false, true);
+  if (page == nullptr) {
+    return REVERSE_INDEXITERATOR_TYPE(nullptr, this->buffer_pool_manager_, this->comparator_);
   }
+  // an empty rightmost leaf makes the iterator start on its left
+  auto ind = reinterpret_cast<LeafPage *>(page->GetData())->GetSize() - 1;
 
-  auto page = this->FindLeafPage(key, Operation::READ);
-  auto pageId = page->GetPageId();
+  return REVERSE_INDEXITERATOR_TYPE(page, this->buffer_pool_manager_, this->comparator_, this->LeafFinder(), ind,
+                                    this->unique_keys_);
+}
 
+/*
+ * Input parameter is high key, find the leaf page that contains the input key
+ * first, then construct reverse index iterator at the greatest key <= key
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+REVERSE_INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin(const KeyType &key) {
+  this->MergeChanges(nullptr, &key);
+  auto page = this->FindLeafPage(key, Operation::READ);
+  if (page == nullptr) {
+    return REVERSE_INDEXITERATOR_TYPE(nullptr, this->buffer_pool_manager_, this->comparator_);
+  }
   auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
   auto ind = leaf->KeyIndex(key, this->comparator_);
-  this->ReleasePrevRLatch(page);
-
-  if (ind < 0) {
-    pageId = INVALID_PAGE_ID;
+  if (ind == leaf->GetSize() || this->comparator_(leaf->KeyAt(ind), key) != 0) {
+    // no key is equal, the one before is below key, or if there is none the iterator starts on the left
+    --ind;
   }
 
-  return INDEXITERATOR_TYPE(pageId, this->buffer_pool_manager_, this->comparator_, ind);
+  return REVERSE_INDEXITERATOR_TYPE(page, this->buffer_pool_manager_, this->comparator_, this->LeafFinder(), ind,
+                                    this->unique_keys_, &key);
 }
 
 /*
- * Input parameter is void, construct an index iterator representing the end
- * of the key/value pair in the leaf node
- * @return : index iterator
+ * Input parameter is void, construct a reverse index iterator representing the
+ * end of the key/value pairs in descending order
+ * @return : reverse index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
-  return INDEXITERATOR_TYPE(INVALID_PAGE_ID, this->buffer_pool_manager_, this->comparator_);
+REVERSE_INDEXITERATOR_TYPE BPLUSTREE_TYPE::rend() {
+  return REVERSE_INDEXITERATOR_TYPE(nullptr, this->buffer_pool_manager_, this->comparator_);
+}
+
+/*
+ * @return : a descent from the root to the read latched leaf of a key, for
+ * iterators whose leaf changed between two steps
+ */
+INDEX_TEMPLATE_ARGUMENTS
+std::function<Page *(const KeyType &)> BPLUSTREE_TYPE::LeafFinder() {
+  return [this](const KeyType &key) { return this->FindLeafPage(key, Operation::READ); };
 }
 
 /*****************************************************************************
@@ -689,13 +2592,11 @@ INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
   // throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
 
-  this->AcquireRootPageIdLatch(false);
-  if (root_page_id_ == INVALID_PAGE_ID) {
-    this->ReleaseRootPageIdLatch(false);
+  auto page = this->FindLeafPage(key, Operation::READ, nullptr, leftMost);
+  if (page == nullptr) {
     return nullptr;
   }
 
-  auto page = this->FindLeafPage(key, Operation::READ, nullptr, leftMost);
   this->ReleasePrevRLatch(page);
 
   return page;
@@ -755,6 +2656,29 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name, Transaction *t
   }
 }
 
+/*
+ * This method is used for test only
+ * Read unsorted data from file, sort it with the external sort and bulk load
+ * the sorted stream
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoadFromFile(const std::string &file_name, double fill_factor, Transaction *transaction,
+                                      size_t sort_threads) {
+  int64_t key;
+  std::ifstream input(file_name);
+  ExternalSort<KeyType, ValueType, KeyComparator> sorter(this->comparator_, file_name + ".run", 1 << 16, sort_threads);
+  while (input >> key) {
+    KeyType index_key;
+    index_key.SetFromInteger(key);
+    RID rid(key);
+    sorter.Add(index_key, rid);
+  }
+  sorter.Finish();
+
+  return BulkLoad([&sorter](KeyType *index_key, ValueType *value) { return sorter.Next(index_key, value); },
+                  fill_factor, transaction);
+}
+
 /**
  * This method is used for debug only, You don't  need to modify
  * @tparam KeyType
@@ -858,7 +2782,7 @@ void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const
   if (page->IsLeafPage()) {
     LeafPage *leaf = reinterpret_cast<LeafPage *>(page);
     std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
-              << " next: " << leaf->GetNextPageId() << std::endl;
+              << " prev: " << leaf->GetPrevPageId() << " next: " << leaf->GetNextPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
       std::cout << leaf->KeyAt(i) << ",";
     }
@@ -880,36 +2804,37 @@ void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, Operation op, Transaction *transaction, bool left_most) {
-  auto page = buffer_pool_manager_->FetchPage(root_page_id_);
-  // LOG_DEBUG("root page id: %d", root_page_id_);
-
-  if (page == nullptr) {
-    this->ReleaseRootPageIdLatch(op != Operation::READ);
-    throw ExceptionType::OUT_OF_MEMORY;
+Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, Operation op, Transaction *transaction, bool left_most,
+                                   bool right_most) {
+  Page *page = nullptr;
+  if (op == Operation::READ) {
+    page = this->LatchRootPage(false);
+    if (page == nullptr) {
+      return nullptr;
+    }
+  } else {
+    // writers hold the root page id latch, the root cannot change under them
+    page = buffer_pool_manager_->FetchPage(root_page_id_);
+    // LOG_DEBUG("root page id: %d", root_page_id_);
+    if (page == nullptr) {
+      this->ReleaseRootPageIdLatch();
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+    page->WLatch();
   }
 
   decltype(page) prevPage = nullptr;
 
   while (true) {
-    if (op == Operation::READ) {
-      page->RLatch();
-    } else {
-      page->WLatch();
-    }
 
     // LOG_DEBUG("Latch page id: %d", page->GetPageId());
     auto treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
-    auto sz = treePage->GetSize();
 
     if (treePage->IsLeafPage()) {
       if (op == Operation::READ) {
         this->ReleasePrevRLatch(prevPage);
-      } else {
-        auto isSafe = op == Operation::INSERT ? sz + 1 < treePage->GetMaxSize() : sz - 1 >= treePage->GetMinSize();
-        if (isSafe) {
-          this->ReleaseAllWLatches(transaction, false);
-        }
+      } else if (this->IsSafe(treePage, op)) {
+        this->ReleaseAllWLatches(transaction, false);
       }
 
       return page;
@@ -921,23 +2846,22 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, Operation op, Transaction
 
       prevPage = page;
     } else {
-      auto isSafe =
-          op == Operation::INSERT ? sz + 1 < internal->GetMaxSize() + 1 : sz - 1 >= internal->GetMinSize() + 1;
-
-      if (isSafe) {
+      if (this->IsSafe(treePage, op)) {
         this->ReleaseAllWLatches(transaction, false);
       }
 
       transaction->AddIntoPageSet(page);
     }
 
-    auto pageId = left_most ? internal->ValueAt(0) : internal->Lookup(key, this->comparator_);
+    auto pageId = left_most    ? internal->ValueAt(0)
+                  : right_most ? internal->ValueAt(internal->GetSize() - 1)
+                               : internal->Lookup(key, this->comparator_);
     // LOG_DEBUG("Fetch page id: %d", pageId);
     auto childPage = buffer_pool_manager_->FetchPage(pageId);
     page = childPage;
 
     if (page == nullptr) {
-      this->ReleaseRootPageIdLatch(op != Operation::READ);
+      // the root page id latch of a writer goes with the root page in the page set
       if (op == Operation::READ) {
         this->ReleasePrevRLatch(prevPage);
       } else {
@@ -947,14 +2871,191 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, Operation op, Transaction
       // LOG_DEBUG("OOM for %d", pageId);
       throw ExceptionType::OUT_OF_MEMORY;
     }
+
+    if (op == Operation::READ) {
+      page->RLatch();
+    } else {
+      page->WLatch();
+    }
+  }
+}
+
+/*
+ * Descend with read latch crabbing and write latch only the leaf page.
+ * While the parent is read latched no writer can split or merge the child, so
+ * switching to a write latch at the leaf is safe. A root leaf is write latched
+ * right away, see LatchRootPage(). With is_resident the descent stops at the
+ * first page that is not in the buffer pool instead of reading it, see
+ * IsLeafResident().
+ * @return : the write latched leaf, nullptr if the tree is empty or the
+ * descent stopped
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, bool *is_resident) {
+  auto page = this->LatchRootPage(true);
+  if (page == nullptr) {
+    return nullptr;
+  }
+
+  while (true) {
+    auto treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (treePage->IsLeafPage()) {
+      return page;
+    }
+
+    auto childPageId = reinterpret_cast<InternalPage *>(treePage)->Lookup(key, this->comparator_);
+    if (is_resident != nullptr && !buffer_pool_manager_->IsPageResident(childPageId)) {
+      this->ReleasePrevRLatch(page);
+      *is_resident = false;
+      return nullptr;
+    }
+
+    auto childPage = buffer_pool_manager_->FetchPage(childPageId);
+    if (childPage == nullptr) {
+      this->ReleasePrevRLatch(page);
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    // the page type never changes once a page is linked into the tree
+    if (reinterpret_cast<BPlusTreePage *>(childPage->GetData())->IsLeafPage()) {
+      childPage->WLatch();
+    } else {
+      childPage->RLatch();
+    }
+    this->ReleasePrevRLatch(page);
+    page = childPage;
+  }
+}
+
+/*
+ * Latch the root page without taking the root page id latch: read the root
+ * page id, latch that page and check that it is still the root, otherwise try
+ * again. A page only stops being the root while a writer holds it write
+ * latched (root split or collapse, see InsertIntoParent() and AdjustRoot()),
+ * so the latched root stays the root until it is released.
+ * @param is_leaf_exclusive write latch the root if it is a leaf, read latch otherwise
+ * @return : the latched root page, nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::LatchRootPage(bool is_leaf_exclusive) {
+  while (true) {
+    page_id_t rootPageId = root_page_id_;
+    if (rootPageId == INVALID_PAGE_ID) {
+      return nullptr;
+    }
+
+    auto page = buffer_pool_manager_->FetchPage(rootPageId);
+    if (page == nullptr) {
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    auto isWLatched = is_leaf_exclusive && reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage();
+    if (isWLatched) {
+      page->WLatch();
+    } else {
+      page->RLatch();
+    }
+
+    auto treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (treePage->IsRootPage() && root_page_id_ == rootPageId &&
+        (!is_leaf_exclusive || treePage->IsLeafPage() == isWLatched)) {
+      return page;
+    }
+
+    if (isWLatched) {
+      page->WUnlatch();
+    } else {
+      page->RUnlatch();
+    }
+    buffer_pool_manager_->UnpinPage(rootPageId, false);
+  }
+}
+
+/*
+ * Release a leaf returned by FindLeafPageOptimistic()
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseLeafWLatch(Page *page, bool isDirty) {
+  page->WUnlatch();
+  this->buffer_pool_manager_->UnpinPage(page->GetPageId(), isDirty);
+}
+
+/*
+ * A node is safe when the operation cannot make it split (insert) or
+ * coalesce/redistribute (delete), so latches above it can be released
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, Operation op) const {
+  if (node->IsLeafPage()) {
+    auto leaf = reinterpret_cast<LeafPage *>(node);
+    return op == Operation::INSERT ? leaf->IsInsertSafe() : leaf->IsDeleteSafe();
+  }
+
+  auto internal = reinterpret_cast<InternalPage *>(node);
+  return op == Operation::INSERT ? internal->IsInsertSafe() : internal->IsDeleteSafe();
+}
+
+/*
+ * Release the write latch of a split internal page before its parent gets
+ * updated. The page is the deepest one in the page set, the pin taken by
+ * InsertIntoParent() is kept until the parent is done.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseSplitPage(Page *page, Transaction *transaction) {
+  auto pageSet = transaction->GetPageSet();
+  if (pageSet->empty() || pageSet->back() != page) {
+    return;
+  }
+
+  pageSet->pop_back();
+  page->WUnlatch();
+  this->buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+}
+
+/*
+ * Point the left link of a leaf from old_prev_page_id at prev_page_id after
+ * its left sibling split or merged. Left links are hints, so the caller holds
+ * no latch: the leaf may have been merged away or relinked in between, it is
+ * left alone then.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::UpdatePrevPageId(page_id_t page_id, page_id_t old_prev_page_id, page_id_t prev_page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+
+  auto page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  page->WLatch();
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  auto isUpdated = leaf->IsLeafPage() && leaf->GetPrevPageId() == old_prev_page_id;
+  if (isUpdated) {
+    leaf->SetPrevPageId(prev_page_id);
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, isUpdated);
+}
+
+/*
+ * @return : the low key version of a leaf or internal page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t BPLUSTREE_TYPE::GetLowKeyVersion(BPlusTreePage *node) const {
+  if (node->IsLeafPage()) {
+    return reinterpret_cast<LeafPage *>(node)->GetLowKeyVersion();
   }
+
+  return reinterpret_cast<InternalPage *>(node)->GetLowKeyVersion();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::ReleaseAllWLatches(Transaction *transaction, bool isDirty) {
   for (const auto &prevPage : *transaction->GetPageSet()) {
     if (reinterpret_cast<BPlusTreePage *>(prevPage->GetData())->IsRootPage()) {
-      this->ReleaseRootPageIdLatch(true);
+      this->ReleaseRootPageIdLatch();
       // LOG_DEBUG("Unlatch root page id: %d", prevPage->GetPageId());
     }
 
@@ -973,40 +3074,32 @@ void BPLUSTREE_TYPE::ReleasePrevRLatch(Page *prevPage) {
     return;
   }
 
-  if (reinterpret_cast<BPlusTreePage *>(prevPage->GetData())->IsRootPage()) {
-    this->ReleaseRootPageIdLatch(false);
-  }
-
   // LOG_DEBUG("%d pin count: %d", prevPage->GetPageId(), prevPage->GetPinCount());
   prevPage->RUnlatch();
   this->buffer_pool_manager_->UnpinPage(prevPage->GetPageId(), false);
 }
 
+/*
+ * Redistribute unless both pages fit into the left one, by count and by space
+ */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::ShouldRedistribute(BPlusTreePage *node, BPlusTreePage *neighbor_node) const {
-  return ((node->IsLeafPage() && node->GetSize() + neighbor_node->GetSize() >= node->GetMaxSize()) ||
-          (!node->IsLeafPage() && node->GetSize() + neighbor_node->GetSize() - 1 >= node->GetMaxSize()));
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::AcquireRootPageIdLatch(bool is_exclusive) {
-  if (is_exclusive) {
-    root_page_id_latch_.lock();
-    return;
+bool BPLUSTREE_TYPE::ShouldRedistribute(BPlusTreePage *node, BPlusTreePage *neighbor_node, bool from_left,
+                                        int node_ind, InternalPage *parent) const {
+  auto left = from_left ? neighbor_node : node;
+  auto right = from_left ? node : neighbor_node;
+  if (node->IsLeafPage()) {
+    return !reinterpret_cast<LeafPage *>(right)->CanMoveAllTo(reinterpret_cast<LeafPage *>(left));
   }
 
-  root_page_id_latch_.lock_shared();
+  return !reinterpret_cast<InternalPage *>(right)->CanMoveAllTo(reinterpret_cast<InternalPage *>(left),
+                                                                parent->KeyAt(from_left ? node_ind : node_ind + 1));
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::ReleaseRootPageIdLatch(bool is_exclusive) {
-  if (is_exclusive) {
-    root_page_id_latch_.unlock();
-    return;
-  }
+void BPLUSTREE_TYPE::AcquireRootPageIdLatch() { root_page_id_latch_.lock(); }
 
-  root_page_id_latch_.unlock_shared();
-}
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseRootPageIdLatch() { root_page_id_latch_.unlock(); }
 
 template class BPlusTree<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
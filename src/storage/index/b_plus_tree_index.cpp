@@ -11,6 +11,12 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "storage/index/external_sort.h"
+
 namespace bustub {
 /*
  * Constructor
@@ -18,15 +24,41 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager)
     : Index(metadata),
-      comparator_(metadata->GetKeySchema()),
-      container_(metadata->GetName(), buffer_pool_manager, comparator_) {}
+      comparator_(metadata->GetEntrySchema()),
+      container_(metadata->GetName(), buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE,
+                 metadata->IsUnique()) {
+  // a unique index has to read the leaf anyway to reject duplicates
+  if (enable_change_buffering && !metadata->IsUnique()) {
+    container_.SetChangeBuffering(true);
+    container_.SetBackgroundMergeOnDemand(true);
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  auto size = index_key.SetFromKey(key, GetEntrySchema());
+
+  if (GetMetadata()->IsCovering()) {
+    // truncated included columns could not be read back
+    if (size > sizeof(KeyType)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "index entry exceeds the key size of " + GetName());
+    }
+
+    // the tree only tells entries apart, which include more than the key: entries with the key columns of this one
+    // lie within [prefix, prefix followed by 0xFF bytes]
+    if (GetMetadata()->IsUnique()) {
+      KeyType prefix;
+      auto prefix_size = std::min(prefix.SetFromKey(key, GetEntrySchema(), GetIndexColumnCount()), sizeof(KeyType));
+      KeyType stop_key = prefix;
+      memset(stop_key.data_ + prefix_size, 0xFF, sizeof(KeyType) - prefix_size);
+      container_.InsertIfAbsent(index_key, rid, prefix, stop_key, transaction);
+      return;
+    }
+  }
 
+  // with change buffering the result only means maybe inserted, and an existing pair is not an error here anyway
   container_.Insert(index_key, rid, transaction);
 }
 
@@ -34,20 +66,148 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetEntrySchema());
 
-  container_.Remove(index_key, transaction);
+  container_.Remove(index_key, rid, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  auto size = index_key.SetFromKey(key, GetKeySchema());
+
+  // the key is only a prefix of the entries of a covering index
+  if (GetMetadata()->IsCovering()) {
+    ScanPrefix(index_key, size, result, nullptr);
+    return;
+  }
 
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                    Transaction *transaction) {
+  if (GetMetadata()->IsCovering()) {
+    Index::ScanKeys(keys, results, transaction);
+    return;
+  }
+
+  // construct scan index keys
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    index_keys[i].SetFromKey(keys[i], GetKeySchema());
+  }
+
+  container_.MultiGet(index_keys, results, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanEntries(const Tuple &key, std::vector<Tuple> *entries, std::vector<RID> *result,
+                                       Transaction *transaction) {
+  // construct scan index key
+  KeyType index_key;
+  auto size = index_key.SetFromKey(key, GetKeySchema());
+
+  ScanPrefix(index_key, size, result, entries);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::CollectStats(IndexStats *stats, double sample_rate, int num_buckets,
+                                        Transaction *transaction) {
+  std::vector<KeyType> bounds;
+  container_.CollectStats(stats, &bounds, sample_rate, num_buckets);
+
+  // the bounds only keep the key columns, which come first in the entries of a covering index
+  auto entry_schema = GetEntrySchema();
+  stats->histogram_bounds_.reserve(bounds.size());
+  for (const auto &bound : bounds) {
+    std::vector<Value> values;
+    values.reserve(GetIndexColumnCount());
+    for (int i = 0; i < GetIndexColumnCount(); ++i) {
+      values.push_back(bound.ToValue(entry_schema, i));
+    }
+    stats->histogram_bounds_.emplace_back(values, GetKeySchema());
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::BulkLoad(const std::function<bool(Tuple *, RID *)> &next, Transaction *transaction,
+                                    size_t run_size) {
+  auto isCovering = GetMetadata()->IsCovering();
+  ExternalSort<KeyType, RID, KeyComparator> sorter(comparator_,
+                                                   GetMetadata()->GetTableName() + "_" + GetName() + ".run", run_size);
+  Tuple entry;
+  RID rid;
+  while (next(&entry, &rid)) {
+    KeyType key;
+    auto size = key.SetFromKey(entry, GetEntrySchema());
+    if (isCovering && size > sizeof(KeyType)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "index entry exceeds the key size of " + GetName());
+    }
+    sorter.Add(key, rid);
+  }
+  sorter.Finish();
+
+  // the tree only skips repeated entries, but the entries of a repeated key sort next to each other
+  auto isUniqueCovering = isCovering && GetMetadata()->IsUnique();
+  KeyType prevPrefix;
+  size_t prevPrefixSize = 0;
+  auto hasPrev = false;
+  auto nextKey = [&](KeyType *key, RID *value) {
+    while (sorter.Next(key, value)) {
+      if (!isUniqueCovering) {
+        return true;
+      }
+
+      // size of the encoding of the key columns, which a covering index keeps unique
+      KeyType prefix;
+      auto prefixSize =
+          std::min(prefix.SetFromKey(EntryToTuple(*key), GetEntrySchema(), GetIndexColumnCount()), sizeof(KeyType));
+      if (hasPrev && prefixSize == prevPrefixSize && memcmp(prefix.data_, prevPrefix.data_, prefixSize) == 0) {
+        continue;
+      }
+      prevPrefix = prefix;
+      prevPrefixSize = prefixSize;
+      hasPrev = true;
+      return true;
+    }
+    return false;
+  };
+
+  return container_.BulkLoad(nextKey, 1.0, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Tuple BPLUSTREE_INDEX_TYPE::EntryToTuple(const KeyType &key) const {
+  auto schema = GetEntrySchema();
+  std::vector<Value> values;
+  values.reserve(schema->GetColumnCount());
+  for (uint32_t i = 0; i < schema->GetColumnCount(); ++i) {
+    values.push_back(key.ToValue(schema, i));
+  }
+
+  return Tuple(values, schema);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanPrefix(const KeyType &prefix, size_t prefix_size, std::vector<RID> *result,
+                                      std::vector<Tuple> *entries) {
+  // keys starting with the prefix lie within [prefix, prefix followed by 0xFF bytes]
+  prefix_size = std::min(prefix_size, sizeof(KeyType));
+  KeyType stop_key = prefix;
+  memset(stop_key.data_ + prefix_size, 0xFF, sizeof(KeyType) - prefix_size);
+
+  for (auto itr = container_.Begin(prefix, stop_key, true); !itr.isEnd(); ++itr) {
+    const auto &item = *itr;
+    result->push_back(item.second);
+    if (entries != nullptr) {
+      entries->push_back(EntryToTuple(item.first));
+    }
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator() { return container_.begin(); }
 
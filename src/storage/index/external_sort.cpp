@@ -0,0 +1,178 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.cpp
+//
+// Identification: src/storage/index/external_sort.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/external_sort.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>  // NOLINT
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+ExternalSort<KeyType, ValueType, KeyComparator>::ExternalSort(const KeyComparator &comparator,
+                                                              std::string run_file_prefix, size_t run_size,
+                                                              size_t num_threads)
+    : comparator_(comparator),
+      run_file_prefix_(std::move(run_file_prefix)),
+      run_size_(std::max<size_t>(run_size, 1)),
+      num_threads_(std::max<size_t>(num_threads, 1)) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+ExternalSort<KeyType, ValueType, KeyComparator>::~ExternalSort() {
+  run_streams_.clear();
+  for (const auto &run_file : run_files_) {
+    remove(run_file.c_str());
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ExternalSort<KeyType, ValueType, KeyComparator>::Add(const KeyType &key, const ValueType &value) {
+  buffer_.emplace_back(key, value);
+  if (buffer_.size() >= run_size_ * num_threads_) {
+    SpillRuns();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ExternalSort<KeyType, ValueType, KeyComparator>::Finish() {
+  if (is_finished_) {
+    return;
+  }
+  is_finished_ = true;
+
+  if (!run_files_.empty()) {
+    SpillRuns();
+    for (size_t run = 0; run < run_files_.size(); ++run) {
+      run_streams_.emplace_back(std::make_unique<std::ifstream>(run_files_[run], std::ios::binary | std::ios::in));
+      MappingType item;
+      if (ReadRun(run, &item)) {
+        PushHeap(item, run);
+      }
+    }
+    return;
+  }
+
+  // everything fits in memory, merge the sorted chunks of the buffer directly
+  auto bounds = SortChunks();
+  for (size_t run = 0; run + 1 < bounds.size(); ++run) {
+    run_ranges_.emplace_back(bounds[run], bounds[run + 1]);
+    MappingType item;
+    if (ReadRun(run, &item)) {
+      PushHeap(item, run);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool ExternalSort<KeyType, ValueType, KeyComparator>::Next(KeyType *key, ValueType *value) {
+  if (heap_.empty()) {
+    return false;
+  }
+
+  std::pop_heap(heap_.begin(), heap_.end(), [this](const auto &a, const auto &b) { return HeapGreater(a, b); });
+  auto [item, run] = heap_.back();
+  heap_.pop_back();
+  *key = item.first;
+  *value = item.second;
+
+  MappingType next;
+  if (ReadRun(run, &next)) {
+    PushHeap(next, run);
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<size_t> ExternalSort<KeyType, ValueType, KeyComparator>::SortChunks() {
+  auto less = [this](const MappingType &a, const MappingType &b) { return comparator_(a.first, b.first) == -1; };
+  auto chunk_size = (buffer_.size() + num_threads_ - 1) / num_threads_;
+  std::vector<size_t> bounds;
+  for (size_t start = 0; start < buffer_.size(); start += chunk_size) {
+    bounds.push_back(start);
+  }
+  bounds.push_back(buffer_.size());
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+    threads.emplace_back([this, &less, &bounds, i] {
+      std::stable_sort(buffer_.begin() + bounds[i], buffer_.begin() + bounds[i + 1], less);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return bounds;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ExternalSort<KeyType, ValueType, KeyComparator>::SpillRuns() {
+  auto bounds = SortChunks();
+  for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+    auto run_file = run_file_prefix_ + std::to_string(run_files_.size());
+    std::ofstream run_io(run_file, std::ios::binary | std::ios::trunc | std::ios::out);
+    if (!run_io.is_open()) {
+      throw Exception("can't open run file");
+    }
+    run_io.write(reinterpret_cast<const char *>(&buffer_[bounds[i]]),
+                 static_cast<std::streamsize>((bounds[i + 1] - bounds[i]) * sizeof(MappingType)));
+    if (run_io.bad()) {
+      throw Exception("I/O error while writing run file");
+    }
+    run_files_.push_back(run_file);
+  }
+  buffer_.clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool ExternalSort<KeyType, ValueType, KeyComparator>::ReadRun(size_t run, MappingType *item) {
+  if (!run_streams_.empty()) {
+    auto &run_io = *run_streams_[run];
+    run_io.read(reinterpret_cast<char *>(item), sizeof(MappingType));
+    return run_io.gcount() == static_cast<std::streamsize>(sizeof(MappingType));
+  }
+
+  auto &[begin, end] = run_ranges_[run];
+  if (begin == end) {
+    return false;
+  }
+  *item = buffer_[begin++];
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ExternalSort<KeyType, ValueType, KeyComparator>::PushHeap(MappingType item, size_t run) {
+  heap_.emplace_back(item, run);
+  std::push_heap(heap_.begin(), heap_.end(), [this](const auto &a, const auto &b) { return HeapGreater(a, b); });
+}
+
+/*
+ * Orders the heap by key and equal keys by run, runs hold consecutive pairs in the order they were added
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool ExternalSort<KeyType, ValueType, KeyComparator>::HeapGreater(const std::pair<MappingType, size_t> &a,
+                                                                  const std::pair<MappingType, size_t> &b) const {
+  auto cmp = comparator_(a.first.first, b.first.first);
+  return cmp == 1 || (cmp == 0 && a.second > b.second);
+}
+
+template class ExternalSort<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExternalSort<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExternalSort<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExternalSort<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExternalSort<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -2,6 +2,7 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
 #include "storage/index/index_iterator.h"
 
@@ -12,9 +13,22 @@ namespace bustub {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(page_id_t page_id, BufferPoolManager *buffer_pool_manager,
-                                  const KeyComparator &comparator, int start_ind)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), cur_page_id_(page_id), cur_ind_(start_ind) {}
+INDEXITERATOR_TYPE::IndexIterator(Page *page, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                                  std::function<Page *(const KeyType &)> find_leaf, int start_ind, bool unique_keys,
+                                  const KeyType *stop_key, bool is_stop_inclusive)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      find_leaf_(std::move(find_leaf)),
+      unique_keys_(unique_keys),
+      has_stop_key_(stop_key != nullptr),
+      is_stop_inclusive_(is_stop_inclusive) {
+  if (has_stop_key_) {
+    stop_key_ = *stop_key;
+  }
+  if (page != nullptr) {
+    this->MoveTo(page, start_ind);
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;
@@ -28,18 +42,7 @@ const MappingType &INDEXITERATOR_TYPE::operator*() const {
     throw Exception(ExceptionType::OUT_OF_RANGE, "Index Reach End");
   }
 
-  auto page = this->buffer_pool_manager_->FetchPage(this->cur_page_id_);
-  if (page == nullptr) {
-    throw ExceptionType::OUT_OF_MEMORY;
-  }
-
-  page->RLatch();
-  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
-
-  auto &item = leaf->GetItem(cur_ind_);
-
-  this->ReleasePage(page);
-  return item;
+  return item_;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -54,19 +57,55 @@ INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
   }
 
   page->RLatch();
-  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  if (this->IsLeafChanged(page)) {
+    // the rest of a posting list is skipped then, its positions may have shifted
+    this->ReleasePage(page);
+    page = this->find_leaf_(item_.first);
+    if (page == nullptr) {
+      cur_page_id_ = INVALID_PAGE_ID;
+      return *this;
+    }
+
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    auto ind = leaf->KeyIndex(item_.first, this->comparator_);
+    if (ind < leaf->GetSize() && this->comparator_(leaf->KeyAt(ind), item_.first) == 0) {
+      ++ind;
+    }
+    this->MoveTo(page, ind);
+    return *this;
+  }
 
-  if (cur_ind_ + 1 < leaf->GetSize()) {
-    ++cur_ind_;
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  auto value = leaf->ValueAt(cur_ind_);
+  if (!unique_keys_ && BPlusTreePostingPage::IsReference(value)) {
+    auto postingPage = this->FetchPostingPage(page, value);
+    auto posting = reinterpret_cast<BPlusTreePostingPage *>(postingPage->GetData());
+    auto nextPageId = posting->GetNextPageId();
+    auto isNext = posting_ind_ + 1 < posting->GetSize();
+    if (isNext) {
+      item_.second = posting->ValueAt(++posting_ind_);
+    }
+    this->buffer_pool_manager_->UnpinPage(postingPage->GetPageId(), false);
 
+    if (!isNext && nextPageId != INVALID_PAGE_ID) {
+      posting_page_id_ = nextPageId;
+      posting_ind_ = 0;
+      postingPage = this->FetchPostingPage(page, value);
+      item_.second = reinterpret_cast<BPlusTreePostingPage *>(postingPage->GetData())->ValueAt(0);
+      this->buffer_pool_manager_->UnpinPage(postingPage->GetPageId(), false);
+    }
+    if (isNext || nextPageId != INVALID_PAGE_ID) {
+      this->ReleasePage(page);
+      return *this;
+    }
+  } else if (!unique_keys_ && posting_ind_ + 1 < leaf->ValueCountAt(cur_ind_)) {
+    // the next value of an inline posting list
+    item_.second = leaf->ValueAt(cur_ind_, ++posting_ind_);
     this->ReleasePage(page);
     return *this;
   }
 
-  cur_ind_ = 0;
-  cur_page_id_ = leaf->GetNextPageId();
-  this->ReleasePage(page);
-
+  this->MoveTo(page, cur_ind_ + 1);
   return *this;
 }
 
@@ -80,23 +119,85 @@ bool INDEXITERATOR_TYPE::operator==(const IndexIterator &itr) const {
     return false;
   }
 
-  auto page = this->buffer_pool_manager_->FetchPage(this->cur_page_id_);
-  if (page == nullptr) {
-    throw ExceptionType::OUT_OF_MEMORY;
-  }
-
-  page->RLatch();
-  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
-  auto isEqual = this->comparator_(leaf->KeyAt(cur_ind_), (*itr).first) == 0;
-
-  this->ReleasePage(page);
-
-  return isEqual;
+  return this->comparator_(item_.first, itr.item_.first) == 0;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::operator!=(const IndexIterator &itr) const { return !(*this == itr); }
 
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::NextBatch(std::vector<MappingType> *batch, const KeyType *end_key,
+                                   const std::function<bool(const KeyType &)> &predicate) {
+  batch->clear();
+  while (batch->empty() && !isEnd()) {
+    auto page = this->buffer_pool_manager_->FetchPage(this->cur_page_id_);
+    if (page == nullptr) {
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    page->RLatch();
+    auto ind = cur_ind_;
+    if (this->IsLeafChanged(page)) {
+      // see operator++(), the batch starts at the current key
+      this->ReleasePage(page);
+      page = this->find_leaf_(item_.first);
+      if (page == nullptr) {
+        cur_page_id_ = INVALID_PAGE_ID;
+        break;
+      }
+
+      ind = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(item_.first, this->comparator_);
+      posting_page_id_ = INVALID_PAGE_ID;
+      posting_ind_ = 0;
+    }
+
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    auto sz = leaf->GetSize();
+    // every key of the leaf is below its high key, so the end keys only need checking on the last leaf
+    auto isLastLeaf = end_key != nullptr && (leaf->GetNextPageId() == INVALID_PAGE_ID ||
+                                             this->comparator_(leaf->GetHighKey(), *end_key) == 1);
+    auto isStopLeaf = has_stop_key_ && (leaf->GetNextPageId() == INVALID_PAGE_ID ||
+                                        this->comparator_(leaf->GetHighKey(), stop_key_) != -1);
+    auto isDone = false;
+    for (; ind < sz; ++ind) {
+      auto item = leaf->GetItem(ind);
+      if ((isLastLeaf && this->comparator_(item.first, *end_key) == 1) ||
+          (isStopLeaf && this->IsPastStop(item.first))) {
+        isDone = true;
+        break;
+      }
+      if (predicate && !predicate(item.first)) {
+        posting_page_id_ = INVALID_PAGE_ID;
+        posting_ind_ = 0;
+        continue;
+      }
+
+      if (!unique_keys_ && BPlusTreePostingPage::IsReference(item.second)) {
+        this->AppendPostingList(page, item, batch);
+        continue;
+      }
+      if (!unique_keys_) {
+        auto count = leaf->ValueCountAt(ind);
+        for (; posting_ind_ < count; ++posting_ind_) {
+          batch->emplace_back(item.first, leaf->ValueAt(ind, posting_ind_));
+        }
+        posting_ind_ = 0;
+        continue;
+      }
+      batch->push_back(item);
+    }
+
+    if (isDone) {
+      this->ReleasePage(page);
+      cur_page_id_ = INVALID_PAGE_ID;
+    } else {
+      this->MoveTo(page, sz);
+    }
+  }
+
+  return !batch->empty();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void INDEXITERATOR_TYPE::ReleasePage(Page *page) const {
   auto page_id = page->GetPageId();
@@ -104,6 +205,141 @@ void INDEXITERATOR_TYPE::ReleasePage(Page *page) const {
   this->buffer_pool_manager_->UnpinPage(page_id, false);
 }
 
+/*
+ * @return true if the read latched page is not the current leaf as it was
+ * when the current pair was loaded. Frames are reused and versions only grow,
+ * so an unchanged frame and version mean that no writer touched the leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::IsLeafChanged(Page *page) const {
+  return page != cur_page_ || page->GetVersion() != cur_version_;
+}
+
+/*
+ * Make the pair at index of the read latched leaf the current one, or the
+ * first one right of it if index is past the end of the leaf, and release the
+ * leaf. Leaves may stay empty when their entries do not fit into a sibling.
+ * The iteration ends once it reaches the stop key.
+ * Merges latch the left sibling last, so a leaf is only kept pinned while the
+ * next one is latched. If it changed in between, entries of the next leaf may
+ * have moved into it or the next leaf may be gone: the scan goes on from the
+ * high key, looked up from the root again.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::MoveTo(Page *page, int index) {
+  while (true) {
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    if (index < leaf->GetSize()) {
+      if (this->IsPastStop(leaf->KeyAt(index))) {
+        cur_page_id_ = INVALID_PAGE_ID;
+      } else {
+        this->LoadItem(page, index);
+      }
+      this->ReleasePage(page);
+      return;
+    }
+
+    auto nextPageId = leaf->GetNextPageId();
+    if (nextPageId == INVALID_PAGE_ID) {
+      cur_page_id_ = INVALID_PAGE_ID;
+      this->ReleasePage(page);
+      return;
+    }
+
+    auto highKey = leaf->GetHighKey();
+    auto version = page->GetVersion();
+    page->RUnlatch();
+    auto nextPage = this->buffer_pool_manager_->FetchPage(nextPageId);
+    if (nextPage == nullptr) {
+      this->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    nextPage->RLatch();
+    auto isChanged = page->GetVersion() != version;
+    this->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (!isChanged) {
+      page = nextPage;
+      index = 0;
+      continue;
+    }
+
+    this->ReleasePage(nextPage);
+    page = this->find_leaf_(highKey);
+    if (page == nullptr) {
+      cur_page_id_ = INVALID_PAGE_ID;
+      return;
+    }
+    index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(highKey, this->comparator_);
+  }
+}
+
+/*
+ * Make the pair at index of the read latched leaf the current one, starting
+ * at the head of its posting list if it has one
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::LoadItem(Page *page, int index) {
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  cur_page_id_ = page->GetPageId();
+  cur_ind_ = index;
+  cur_page_ = page;
+  cur_version_ = page->GetVersion();
+  item_ = leaf->GetItem(index);
+  posting_page_id_ = INVALID_PAGE_ID;
+  posting_ind_ = 0;
+  if (!unique_keys_ && BPlusTreePostingPage::IsReference(item_.second)) {
+    auto postingPage = this->FetchPostingPage(page, item_.second);
+    item_.second = reinterpret_cast<BPlusTreePostingPage *>(postingPage->GetData())->ValueAt(0);
+    this->buffer_pool_manager_->UnpinPage(postingPage->GetPageId(), false);
+  } else if (!unique_keys_) {
+    item_.second = leaf->ValueAt(index, 0);
+  }
+}
+
+/*
+ * Fetch the current page of the posting list a leaf entry refers to, the
+ * read latched leaf is released if that fails
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *INDEXITERATOR_TYPE::FetchPostingPage(Page *leaf_page, const ValueType &reference) const {
+  auto pageId = posting_page_id_ == INVALID_PAGE_ID ? reference.GetPageId() : posting_page_id_;
+  auto page = this->buffer_pool_manager_->FetchPage(pageId);
+  if (page == nullptr) {
+    this->ReleasePage(leaf_page);
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  return page;
+}
+
+/*
+ * Append every value of the posting list of item, from the current position in
+ * the list on, with the leaf read latched
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::AppendPostingList(Page *leaf_page, const MappingType &item,
+                                           std::vector<MappingType> *batch) {
+  do {
+    auto postingPage = this->FetchPostingPage(leaf_page, item.second);
+    auto posting = reinterpret_cast<BPlusTreePostingPage *>(postingPage->GetData());
+    for (; posting_ind_ < posting->GetSize(); ++posting_ind_) {
+      batch->emplace_back(item.first, posting->ValueAt(posting_ind_));
+    }
+    posting_page_id_ = posting->GetNextPageId();
+    posting_ind_ = 0;
+    this->buffer_pool_manager_->UnpinPage(postingPage->GetPageId(), false);
+  } while (posting_page_id_ != INVALID_PAGE_ID);
+}
+
+/*
+ * @return true if key lies beyond the stop key, if there is one
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::IsPastStop(const KeyType &key) const {
+  return has_stop_key_ && this->comparator_(key, stop_key_) >= (is_stop_inclusive_ ? 1 : 0);
+}
+
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
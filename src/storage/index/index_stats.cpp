@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_stats.cpp
+//
+// Identification: src/storage/index/index_stats.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/index_stats.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace bustub {
+
+/*
+ * Compare two keys column by column, NULL sorts first like in the index
+ * @return : -1, 0 or 1 if lhs is less than, equal to or greater than rhs
+ */
+static int CompareKeys(const Tuple &lhs, const Tuple &rhs, const Schema *key_schema) {
+  for (uint32_t i = 0; i < key_schema->GetColumnCount(); ++i) {
+    auto lhsValue = lhs.GetValue(key_schema, i);
+    auto rhsValue = rhs.GetValue(key_schema, i);
+    if (lhsValue.IsNull() || rhsValue.IsNull()) {
+      if (lhsValue.IsNull() != rhsValue.IsNull()) {
+        return lhsValue.IsNull() ? -1 : 1;
+      }
+      continue;
+    }
+
+    if (lhsValue.CompareLessThan(rhsValue) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (lhsValue.CompareGreaterThan(rhsValue) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * Buckets within the range count in full, buckets it only overlaps count half.
+ * A point lookup assumes the keys of its bucket to be equally frequent.
+ */
+double IndexStats::EstimateSelectivity(const Tuple *low_key, const Tuple *high_key, const Schema *key_schema) const {
+  uint64_t total = 0;
+  for (auto count : histogram_counts_) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  auto sz = histogram_bounds_.size();
+  if (low_key != nullptr && high_key != nullptr && CompareKeys(*low_key, *high_key, key_schema) == 0) {
+    for (size_t i = 0; i < sz; ++i) {
+      if (CompareKeys(histogram_bounds_[i], *low_key, key_schema) >= 0) {
+        return static_cast<double>(histogram_counts_[i]) / std::max<uint64_t>(histogram_num_keys_[i], 1) / total;
+      }
+    }
+    return 0;
+  }
+
+  double matched = 0;
+  for (size_t i = 0; i < sz; ++i) {
+    const auto &upper = histogram_bounds_[i];
+    if (low_key != nullptr && CompareKeys(upper, *low_key, key_schema) < 0) {
+      continue;
+    }
+    if (high_key != nullptr && i > 0 && CompareKeys(histogram_bounds_[i - 1], *high_key, key_schema) >= 0) {
+      break;
+    }
+
+    auto isAboveLow = low_key == nullptr || (i > 0 && CompareKeys(histogram_bounds_[i - 1], *low_key, key_schema) >= 0);
+    auto isBelowHigh = high_key == nullptr || CompareKeys(upper, *high_key, key_schema) <= 0;
+    matched += isAboveLow && isBelowHigh ? histogram_counts_[i] : histogram_counts_[i] / 2.0;
+  }
+
+  return matched / total;
+}
+
+std::string IndexStats::ToString() const {
+  std::stringstream os;
+
+  os << "IndexStats[Height = " << height_ << ", Pages = (";
+  for (size_t i = 0; i < num_pages_.size(); ++i) {
+    os << (i == 0 ? "" : ", ") << num_pages_[i];
+  }
+  os << "), Fill = (";
+  for (size_t i = 0; i < fill_factors_.size(); ++i) {
+    os << (i == 0 ? "" : ", ") << fill_factors_[i];
+  }
+  os << "), Posting pages = " << num_posting_pages_ << ", Keys = " << num_keys_ << ", Values = " << num_values_
+     << ", Sample rate = " << sample_rate_ << ", Buckets = " << histogram_counts_.size() << "]";
+
+  return os.str();
+}
+
+}  // namespace bustub
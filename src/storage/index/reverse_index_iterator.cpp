@@ -0,0 +1,263 @@
+/**
+ * reverse_index_iterator.cpp
+ */
+#include <utility>
+
+#include "storage/index/reverse_index_iterator.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+REVERSE_INDEXITERATOR_TYPE::ReverseIndexIterator(Page *page, BufferPoolManager *buffer_pool_manager,
+                                                 const KeyComparator &comparator,
+                                                 std::function<Page *(const KeyType &)> find_leaf, int start_ind,
+                                                 bool unique_keys, const KeyType *bound)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      find_leaf_(std::move(find_leaf)),
+      unique_keys_(unique_keys) {
+  if (page == nullptr) {
+    return;
+  }
+
+  if (start_ind < 0) {
+    this->MoveToPrevPage(page, bound);
+    return;
+  }
+
+  this->LoadItem(page, start_ind);
+  this->ReleasePage(page);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+REVERSE_INDEXITERATOR_TYPE::~ReverseIndexIterator() = default;
+
+INDEX_TEMPLATE_ARGUMENTS
+bool REVERSE_INDEXITERATOR_TYPE::isEnd() const { return cur_page_id_ == INVALID_PAGE_ID; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &REVERSE_INDEXITERATOR_TYPE::operator*() const {
+  if (isEnd()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "Index Reach End");
+  }
+
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+REVERSE_INDEXITERATOR_TYPE &REVERSE_INDEXITERATOR_TYPE::operator++() {
+  if (isEnd()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "Index Reach End");
+  }
+
+  auto page = this->buffer_pool_manager_->FetchPage(this->cur_page_id_);
+  if (page == nullptr) {
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  page->RLatch();
+  // frames are reused and versions only grow, an unchanged frame and version mean the leaf is untouched
+  auto isChanged = page != cur_page_ || page->GetVersion() != cur_version_;
+  if (isChanged) {
+    // the rest of a posting list is skipped then, its positions may have shifted
+    this->ReleasePage(page);
+    page = this->find_leaf_(item_.first);
+    if (page == nullptr) {
+      cur_page_id_ = INVALID_PAGE_ID;
+      return *this;
+    }
+  }
+
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  auto ind = leaf->KeyIndex(item_.first, this->comparator_);
+  auto isPresent = !isChanged && ind < leaf->GetSize() && this->comparator_(leaf->KeyAt(ind), item_.first) == 0;
+  if (isPresent && !unique_keys_ && BPlusTreePostingPage::IsReference(leaf->ValueAt(ind))) {
+    auto reference = leaf->ValueAt(ind);
+    auto postingPage = this->FetchPostingPage(page, reference);
+    auto posting = reinterpret_cast<BPlusTreePostingPage *>(postingPage->GetData());
+    auto nextPageId = posting->GetNextPageId();
+    auto isLast = posting_ind_ + 1 >= posting->GetSize() && nextPageId == INVALID_PAGE_ID;
+    if (posting_ind_ + 1 < posting->GetSize()) {
+      item_.second = posting->ValueAt(++posting_ind_);
+    } else if (nextPageId != INVALID_PAGE_ID) {
+      posting_page_id_ = nextPageId;
+      posting_ind_ = 0;
+    }
+    this->buffer_pool_manager_->UnpinPage(postingPage->GetPageId(), false);
+
+    if (!isLast) {
+      if (posting_ind_ == 0) {
+        postingPage = this->FetchPostingPage(page, reference);
+        item_.second = reinterpret_cast<BPlusTreePostingPage *>(postingPage->GetData())->ValueAt(0);
+        this->buffer_pool_manager_->UnpinPage(postingPage->GetPageId(), false);
+      }
+      this->ReleasePage(page);
+      return *this;
+    }
+  } else if (isPresent && !unique_keys_ && posting_ind_ + 1 < leaf->ValueCountAt(ind)) {
+    // the next value of an inline posting list
+    item_.second = leaf->ValueAt(ind, ++posting_ind_);
+    this->ReleasePage(page);
+    return *this;
+  }
+
+  posting_page_id_ = INVALID_PAGE_ID;
+  posting_ind_ = 0;
+  if (ind > 0) {
+    this->LoadItem(page, ind - 1);
+    this->ReleasePage(page);
+    return *this;
+  }
+
+  auto key = item_.first;
+  this->MoveToPrevPage(page, &key);
+
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool REVERSE_INDEXITERATOR_TYPE::operator==(const ReverseIndexIterator &itr) const {
+  if (isEnd() && itr.isEnd()) {
+    return true;
+  }
+
+  if (isEnd() || itr.isEnd()) {
+    return false;
+  }
+
+  return this->comparator_(item_.first, itr.item_.first) == 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool REVERSE_INDEXITERATOR_TYPE::operator!=(const ReverseIndexIterator &itr) const { return !(*this == itr); }
+
+INDEX_TEMPLATE_ARGUMENTS
+void REVERSE_INDEXITERATOR_TYPE::ReleasePage(Page *page) const {
+  auto page_id = page->GetPageId();
+  page->RUnlatch();
+  this->buffer_pool_manager_->UnpinPage(page_id, false);
+}
+
+/*
+ * Move to the greatest key below bound (nullptr stands for no bound) left of
+ * the read latched page, which is released. The linked page is pinned while the
+ * left link is read, but only latched after the page is released, so it may
+ * have split in between: its right part is then found by moving right until
+ * the page either links to the page left behind or reaches bound. A page
+ * without keys below bound, e.g. one that lost its entries to a merge, is left
+ * to the left again. Left links are only updated once the writer released its
+ * latches, they may point at any leaf further left or at a merged one.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void REVERSE_INDEXITERATOR_TYPE::MoveToPrevPage(Page *page, const KeyType *bound) {
+  while (true) {
+    auto fromPageId = page->GetPageId();
+    auto prevPageId = reinterpret_cast<LeafPage *>(page->GetData())->GetPrevPageId();
+    if (prevPageId == INVALID_PAGE_ID) {
+      this->ReleasePage(page);
+      break;
+    }
+
+    auto prevPage = this->buffer_pool_manager_->FetchPage(prevPageId);
+    this->ReleasePage(page);
+    if (prevPage == nullptr) {
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    page = this->LatchLeaf(prevPage);
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    while (leaf->GetNextPageId() != fromPageId && leaf->GetNextPageId() != INVALID_PAGE_ID &&
+           (bound == nullptr || this->comparator_(leaf->GetHighKey(), *bound) == -1)) {
+      // merges latch the left sibling last, so the page is released before the next one is latched
+      auto nextPage = this->buffer_pool_manager_->FetchPage(leaf->GetNextPageId());
+      this->ReleasePage(page);
+      if (nextPage == nullptr) {
+        throw ExceptionType::OUT_OF_MEMORY;
+      }
+
+      page = this->LatchLeaf(nextPage);
+      leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    }
+
+    auto ind = bound == nullptr ? leaf->GetSize() : leaf->KeyIndex(*bound, this->comparator_);
+    if (ind > 0) {
+      this->LoadItem(page, ind - 1);
+      this->ReleasePage(page);
+      return;
+    }
+  }
+
+  cur_page_id_ = INVALID_PAGE_ID;
+}
+
+/*
+ * Read latch the pinned page. Left links may still point at a leaf that was
+ * merged away, and a right link read before the latch was released as well.
+ * A merged leaf links to the leaf its entries moved to: the links are
+ * followed until they reach a leaf, which is returned read latched.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *REVERSE_INDEXITERATOR_TYPE::LatchLeaf(Page *page) const {
+  page->RLatch();
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  while (leaf->IsInvalidPage()) {
+    auto prevPage = this->buffer_pool_manager_->FetchPage(leaf->GetPrevPageId());
+    this->ReleasePage(page);
+    if (prevPage == nullptr) {
+      throw ExceptionType::OUT_OF_MEMORY;
+    }
+
+    page = prevPage;
+    page->RLatch();
+    leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  }
+
+  return page;
+}
+
+/*
+ * Make the pair at index of the read latched leaf the current one, starting
+ * at the head of its posting list if it has one
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void REVERSE_INDEXITERATOR_TYPE::LoadItem(Page *page, int index) {
+  cur_page_id_ = page->GetPageId();
+  cur_page_ = page;
+  cur_version_ = page->GetVersion();
+  item_ = reinterpret_cast<LeafPage *>(page->GetData())->GetItem(index);
+  posting_page_id_ = INVALID_PAGE_ID;
+  posting_ind_ = 0;
+  if (!unique_keys_ && BPlusTreePostingPage::IsReference(item_.second)) {
+    auto postingPage = this->FetchPostingPage(page, item_.second);
+    item_.second = reinterpret_cast<BPlusTreePostingPage *>(postingPage->GetData())->ValueAt(0);
+    this->buffer_pool_manager_->UnpinPage(postingPage->GetPageId(), false);
+  }
+}
+
+/*
+ * Fetch the current page of the posting list a leaf entry refers to, the
+ * read latched leaf is released if that fails
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *REVERSE_INDEXITERATOR_TYPE::FetchPostingPage(Page *leaf_page, const ValueType &reference) const {
+  auto pageId = posting_page_id_ == INVALID_PAGE_ID ? reference.GetPageId() : posting_page_id_;
+  auto page = this->buffer_pool_manager_->FetchPage(pageId);
+  if (page == nullptr) {
+    this->ReleasePage(leaf_page);
+    throw ExceptionType::OUT_OF_MEMORY;
+  }
+
+  return page;
+}
+
+template class ReverseIndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
+
+template class ReverseIndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
+
+template class ReverseIndexIterator<GenericKey<16>, RID, GenericComparator<16>>;
+
+template class ReverseIndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
+
+template class ReverseIndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
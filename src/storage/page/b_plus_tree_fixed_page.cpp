@@ -0,0 +1,453 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_fixed_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_fixed_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "common/rid.h"
+#include "storage/page/b_plus_tree_fixed_page.h"
+
+namespace bustub {
+
+/*****************************************************************************
+ * HELPER METHODS AND UTILITIES
+ *****************************************************************************/
+/*
+ * Reset the B-link fields and empty the page, called by the Init method of
+ * leaf and internal pages
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::InitSlots() {
+  static_assert(sizeof(ValueType) >= sizeof(uint32_t), "a value has to hold the handle of a value list");
+  next_page_id_ = INVALID_PAGE_ID;
+  low_key_version_ = 0;
+  prev_page_id_ = INVALID_PAGE_ID;
+  has_low_key_ = 0;
+  num_lists_ = 0;
+  heap_offset_ = SLOTS;
+  garbage_size_ = 0;
+  memset(lists_, 0, sizeof(lists_));
+  memset(&low_key_, 0, sizeof(KeyType));
+  memset(&high_key_, 0, sizeof(KeyType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_FIXED_PAGE_TYPE::KeyAt(int index) const { return keys_[std::clamp(index, 0, SLOTS - 1)]; }
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_FIXED_PAGE_TYPE::ValueAt(int index) const { return ValueAt(index, 0); }
+
+/*
+ * Helper methods to get the values of an entry, the value itself or the run
+ * of values its handle points to
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_FIXED_PAGE_TYPE::ValueAt(int index, int value_index) const {
+  index = std::clamp(index, 0, SLOTS - 1);
+  if (!IsList(index)) {
+    return Values()[index];
+  }
+
+  int offset;
+  int count;
+  GetList(index, &offset, &count);
+  return Values()[std::clamp(offset + std::clamp(value_index, 0, count - 1), 0, SLOTS - 1)];
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::ValueCountAt(int index) const {
+  index = std::clamp(index, 0, SLOTS - 1);
+  if (!IsList(index)) {
+    return 1;
+  }
+
+  int offset;
+  int count;
+  GetList(index, &offset, &count);
+  return count;
+}
+
+/*
+ * Helper methods to get the links and the fences, the high key is only valid
+ * if there is a right link
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_FIXED_PAGE_TYPE::GetNextPageId() const { return next_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_FIXED_PAGE_TYPE::GetPrevPageId() const { return prev_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::SetPrevPageId(page_id_t prev_page_id) { prev_page_id_ = prev_page_id; }
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_FIXED_PAGE_TYPE::GetHighKey() const { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_FIXED_PAGE_TYPE::HasLowKey() const { return has_low_key_ != 0; }
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_FIXED_PAGE_TYPE::GetLowKey() const { return low_key_; }
+
+/*
+ * @return true if key belongs to a page on the right, i.e. key >= high key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_FIXED_PAGE_TYPE::ShouldMoveRight(const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID && comparator(key, high_key_) != -1;
+}
+
+/*
+ * Helper methods to get/bump the low key version
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t B_PLUS_TREE_FIXED_PAGE_TYPE::GetLowKeyVersion() const { return low_key_version_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::IncreaseLowKeyVersion() { ++low_key_version_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::GetPrefixSize() const { return 0; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::GetUsedSpace() const {
+  return (this->GetSize() + SLOTS - heap_offset_ - garbage_size_) * ENTRY_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::GetFreeSpace() const { return CAPACITY - GetUsedSpace(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::EntrySize(const KeyType &key) const { return ENTRY_SIZE; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::MaxEntrySize() const { return (EntryUnits(2) - EntryUnits(1)) * ENTRY_SIZE; }
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_FIXED_PAGE_TYPE::ShortestSeparator(const KeyType &left, const KeyType &right) { return right; }
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Keys are normalized and fit into a machine word, so they are searched as
+ * big-endian words, see NormalizedKeySearch
+ * @param is_equal: set to whether KeyAt(i) == key, if not nullptr
+ * @return: the first index i >= begin so that KeyAt(i) >= key, or the size
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::LowerBound(const KeyType &key, int begin, bool *is_equal) const {
+  using Word = std::conditional_t<sizeof(KeyType) == sizeof(uint64_t), uint64_t, uint32_t>;
+  static_assert(sizeof(KeyType) == sizeof(Word), "fixed pages hold keys of one machine word");
+
+  auto sz = ClampedSize();
+  begin = std::min(begin, sz);
+  auto ind = begin + NormalizedKeySearch<Word>::LowerBound(keys_ + begin, sz - begin, key);
+  if (is_equal != nullptr) {
+    *is_equal = ind < sz && memcmp(&keys_[ind], &key, sizeof(KeyType)) == 0;
+  }
+  return ind;
+}
+
+/*****************************************************************************
+ * MODIFICATION
+ *****************************************************************************/
+/*
+ * Insert the entry at index, the page must have room for it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) {
+  auto sz = this->GetSize();
+  if (sz == heap_offset_) {
+    Compact();
+  }
+
+  memmove(keys_ + index + 1, keys_ + index, (sz - index) * sizeof(KeyType));
+  memmove(Values() + index + 1, Values() + index, (sz - index) * sizeof(ValueType));
+  keys_[index] = key;
+  Values()[index] = value;
+  if (num_lists_ > 0) {
+    InsertListBit(index);
+  }
+  this->SetSize(sz + 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::RemoveAt(int index) {
+  auto sz = this->GetSize();
+  FreeList(index);
+  memmove(keys_ + index, keys_ + index + 1, (sz - index - 1) * sizeof(KeyType));
+  memmove(Values() + index, Values() + index + 1, (sz - index - 1) * sizeof(ValueType));
+  if (num_lists_ > 0) {
+    RemoveListBit(index);
+  }
+  this->SetSize(sz - 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { keys_[index] = key; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::SetValueAt(int index, const ValueType &value) { Values()[index] = value; }
+
+/*
+ * @return: true if the entry at index can hold count values, leaving
+ * reserve_space bytes of free space
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_FIXED_PAGE_TYPE::CanSetValuesAt(int index, int count, int reserve_space) const {
+  auto growth = (EntryUnits(count) - EntryUnits(ValueCountAt(index))) * ENTRY_SIZE;
+  return count <= MAX_ENTRY_VALUES && GetFreeSpace() - growth >= reserve_space;
+}
+
+/*
+ * Replace the values of the entry at index, the page must have room for them
+ * (see CanSetValuesAt). The values must not be the ones of this page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::SetValuesAt(int index, const ValueType *values, int count) {
+  FreeList(index);
+  if (count == 1) {
+    Values()[index] = values[0];
+    return;
+  }
+
+  if (heap_offset_ - this->GetSize() < count) {
+    Compact();
+  }
+  heap_offset_ -= count;
+  memcpy(Values() + heap_offset_, values, count * sizeof(ValueType));
+  SetList(index, heap_offset_, count);
+}
+
+/*****************************************************************************
+ * REORGANIZATION
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<ItemType> B_PLUS_TREE_FIXED_PAGE_TYPE::GetItems() const {
+  std::vector<ItemType> items;
+  auto sz = this->GetSize();
+  items.reserve(sz);
+  for (int i = 0; i < sz; ++i) {
+    if (!IsList(i)) {
+      items.emplace_back(keys_[i], Values()[i]);
+      continue;
+    }
+
+    int offset;
+    int count;
+    GetList(i, &offset, &count);
+    items.emplace_back(keys_[i], Values()[offset]);
+    items.back().more_values.assign(Values() + offset + 1, Values() + offset + count);
+  }
+  return items;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::Assign(const ItemType *items, int size) {
+  num_lists_ = 0;
+  heap_offset_ = SLOTS;
+  garbage_size_ = 0;
+  memset(lists_, 0, sizeof(lists_));
+  for (int i = 0; i < size; ++i) {
+    keys_[i] = items[i].first;
+    int count = items[i].more_values.size() + 1;
+    if (count == 1) {
+      Values()[i] = items[i].second;
+      continue;
+    }
+
+    heap_offset_ -= count;
+    Values()[heap_offset_] = items[i].second;
+    memcpy(Values() + heap_offset_ + 1, items[i].more_values.data(), (count - 1) * sizeof(ValueType));
+    SetList(i, heap_offset_, count);
+  }
+  this->SetSize(size);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::SetFences(const KeyType *low_key, page_id_t next_page_id, const KeyType *high_key) {
+  // the fences may be the ones of this page
+  KeyType lowKey;
+  KeyType highKey;
+  memset(&lowKey, 0, sizeof(KeyType));
+  memset(&highKey, 0, sizeof(KeyType));
+  if (low_key != nullptr) {
+    lowKey = *low_key;
+  }
+  if (next_page_id != INVALID_PAGE_ID) {
+    highKey = *high_key;
+  }
+
+  has_low_key_ = low_key != nullptr ? 1 : 0;
+  low_key_ = lowKey;
+  next_page_id_ = next_page_id;
+  high_key_ = highKey;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+const KeyType *B_PLUS_TREE_FIXED_PAGE_TYPE::LowFence() const { return has_low_key_ != 0 ? &low_key_ : nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const KeyType *B_PLUS_TREE_FIXED_PAGE_TYPE::HighFence() const {
+  return next_page_id_ != INVALID_PAGE_ID ? &high_key_ : nullptr;
+}
+
+/*
+ * @return: the index that splits the entries into two halves of about the
+ * same space, both with at least one entry. Without value lists these are
+ * the halves by count.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::HalfSpaceIndex() const {
+  auto sz = this->GetSize();
+  if (num_lists_ == 0) {
+    return std::max(sz / 2, 1);
+  }
+
+  auto half = this->GetUsedSpace() / ENTRY_SIZE / 2;
+  int used = 0;
+  int index = 0;
+  while (index < sz - 1 && used < half) {
+    used += EntryUnits(ValueCountAt(index));
+    ++index;
+  }
+  return std::max(index, 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_FIXED_PAGE_TYPE::Fits(const ItemType *items, int size, const KeyType *low_key,
+                                       const KeyType *high_key, int reserve_entries) const {
+  auto used = reserve_entries * MaxEntrySize() / ENTRY_SIZE;
+  for (int i = 0; i < size; ++i) {
+    used += EntryUnits(items[i].more_values.size() + 1);
+  }
+  return used <= SLOTS;
+}
+
+/*****************************************************************************
+ * PRIVATE HELPERS
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::ClampedSize() const { return std::clamp(this->GetSize(), 0, SLOTS); }
+
+INDEX_TEMPLATE_ARGUMENTS
+const ValueType *B_PLUS_TREE_FIXED_PAGE_TYPE::Values() const {
+  return reinterpret_cast<const ValueType *>(keys_ + SLOTS);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType *B_PLUS_TREE_FIXED_PAGE_TYPE::Values() { return reinterpret_cast<ValueType *>(keys_ + SLOTS); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_FIXED_PAGE_TYPE::IsList(int index) const { return ((lists_[index / 64] >> (index % 64)) & 1) != 0; }
+
+/*
+ * Helper methods to read/write the handle of a value list, which takes the
+ * first four bytes of the value of the entry. Handles read by optimistic
+ * readers may be garbage, so they are clamped to the page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::GetList(int index, int *offset, int *count) const {
+  uint32_t handle;
+  memcpy(&handle, Values() + index, sizeof(uint32_t));
+  *offset = std::clamp(static_cast<int>(handle & 0xFFFF), 0, SLOTS - 1);
+  *count = std::clamp(static_cast<int>(handle >> 16), 1, MAX_ENTRY_VALUES);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::SetList(int index, int offset, int count) {
+  auto handle = static_cast<uint32_t>(count) << 16 | static_cast<uint32_t>(offset);
+  memcpy(reinterpret_cast<char *>(Values() + index), &handle, sizeof(uint32_t));
+  lists_[index / 64] |= uint64_t{1} << (index % 64);
+  ++num_lists_;
+}
+
+// turn the entry at index back into a plain one, its list becomes garbage
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::FreeList(int index) {
+  if (!IsList(index)) {
+    return;
+  }
+
+  int offset;
+  int count;
+  GetList(index, &offset, &count);
+  garbage_size_ += count;
+  lists_[index / 64] &= ~(uint64_t{1} << (index % 64));
+  --num_lists_;
+}
+
+/*
+ * Shift the bits of the list bitmap from index on by one, making room for the
+ * bit of a new entry at index or dropping the bit of the entry at index
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::InsertListBit(int index) {
+  auto word = index / 64;
+  auto mask = (uint64_t{1} << (index % 64)) - 1;
+  for (int i = LIST_WORDS - 1; i > word; --i) {
+    lists_[i] = lists_[i] << 1 | lists_[i - 1] >> 63;
+  }
+  lists_[word] = (lists_[word] & mask) | ((lists_[word] & ~mask) << 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::RemoveListBit(int index) {
+  auto word = index / 64;
+  auto mask = (uint64_t{1} << (index % 64)) - 1;
+  lists_[word] = (lists_[word] & mask) | ((lists_[word] >> 1) & ~mask);
+  for (int i = word; i < LIST_WORDS - 1; ++i) {
+    lists_[i] |= lists_[i + 1] << 63;
+    lists_[i + 1] >>= 1;
+  }
+}
+
+/*
+ * Move the value lists to the end of the page, dropping the garbage
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_FIXED_PAGE_TYPE::Compact() {
+  ValueType buffer[SLOTS];
+  auto offset = SLOTS;
+  auto sz = this->GetSize();
+  for (int i = 0; i < sz; ++i) {
+    if (!IsList(i)) {
+      continue;
+    }
+
+    int listOffset;
+    int count;
+    GetList(i, &listOffset, &count);
+    offset -= count;
+    memcpy(buffer + offset, Values() + listOffset, count * sizeof(ValueType));
+    auto handle = static_cast<uint32_t>(count) << 16 | static_cast<uint32_t>(offset);
+    memcpy(reinterpret_cast<char *>(Values() + i), &handle, sizeof(uint32_t));
+  }
+
+  memcpy(Values() + offset, buffer + offset, (SLOTS - offset) * sizeof(ValueType));
+  heap_offset_ = offset;
+  garbage_size_ = 0;
+}
+
+// a plain entry takes one entry of space, a list takes one more for every value
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_FIXED_PAGE_TYPE::EntryUnits(int count) { return count == 1 ? 1 : count + 1; }
+
+template class BPlusTreeFixedPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class BPlusTreeFixedPage<GenericKey<8>, RID, GenericComparator<8>>;
+
+template class BPlusTreeFixedPage<GenericKey<4>, page_id_t, GenericComparator<4>>;
+template class BPlusTreeFixedPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+}  // namespace bustub
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -33,24 +34,17 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id
   this->SetSize(0);
   this->SetLSN(INVALID_LSN);
   this->SetMaxSize(max_size);
-  for (int i = 0; i < max_size; ++i) {
-    this->array[i] = MappingType();
-  }
+  this->InitSlots();
 }
+
 /*
- * Helper method to get/set the key associated with input "index"(a.k.a
- * array offset)
+ * @return: true if the key at index can be replaced with key
  */
 INDEX_TEMPLATE_ARGUMENTS
-KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-
-  return array[index].first;
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanSetKeyAt(int index, const KeyType &key) const {
+  return this->GetFreeSpace() >= this->EntrySize(key) - this->EntrySize(this->KeyAt(index));
 }
 
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { array[index].first = key; }
-
 /*
  * Helper method to find and return array index(or offset), so that its value
  * equals to input "value"
@@ -59,7 +53,7 @@ INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
   auto sz = this->GetSize();
   for (decltype(sz) i = 0; i < sz; ++i) {
-    if (array[i].second == value) {
+    if (this->ValueAt(i) == value) {
       return i;
     }
   }
@@ -68,11 +62,36 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
 }
 
 /*
- * Helper method to get the value associated with input "index"(a.k.a array
- * offset)
+ * Size checks, by count and by space. A page needs two children unless it is
+ * the root, which is replaced by its only child.
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return array[index].second; }
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsOverflow() const {
+  return this->GetSize() > this->GetMaxSize() || this->GetFreeSpace() < this->MaxEntrySize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsUnderflow() const {
+  auto sz = this->GetSize();
+  return sz < 2 || (sz - 1 < this->GetMinSize() && this->GetUsedSpace() < this->CAPACITY / 2);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsInsertSafe() const {
+  return this->GetSize() + 1 <= this->GetMaxSize() && this->GetFreeSpace() >= 2 * this->MaxEntrySize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsDeleteSafe() const {
+  auto sz = this->GetSize();
+  return sz > 2 &&
+         (sz - 1 >= this->GetMinSize() + 1 || this->GetUsedSpace() - this->MaxEntrySize() >= this->CAPACITY / 2);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomFor(const KeyType &key) const {
+  return this->GetSize() <= this->GetMaxSize() && this->GetFreeSpace() >= this->EntrySize(key);
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -84,17 +103,14 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return arra
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const {
-  if (comparator(key, this->KeyAt(1)) == -1) {
-    return this->ValueAt(0);
-  }
-
-  auto ind = keyIndex(key, comparator);
-  if (ind < 0) {
-    auto pos = -(ind + 1);
-    return this->ValueAt(pos - 1);
+  bool isEqual;
+  auto ind = this->LowerBound(key, 1, &isEqual);
+  if (isEqual) {
+    return this->ValueAt(ind);
   }
 
-  return array[ind].second;
+  // the index is clamped for readers that see a page under modification
+  return this->ValueAt(ind - 1);
 }
 
 /*****************************************************************************
@@ -109,13 +125,12 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyCo
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                                                      const ValueType &new_value) {
-  array[0] = {KeyType(), old_value};
-  array[1] = {new_key, new_value};
-  this->SetSize(2);
+  ItemType items[] = {{new_key, old_value}, {new_key, new_value}};
+  this->Assign(items, 2);
 }
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
- * old_value
+ * old_value, the page must have room for it
  * @return:  new size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
@@ -127,48 +142,49 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
     return sz;
   }
 
-  for (int i = sz; i > valueInd + 1; --i) {
-    array[i] = array[i - 1];
-  }
-
-  array[valueInd + 1] = {new_key, new_value};
-  this->SetSize(++sz);
-
-  return sz;
+  this->InsertAt(valueInd + 1, new_key, new_value);
+  return sz + 1;
+}
+/*
+ * Append new_key & new_value pair at the end, the key of the first pair is
+ * ignored as usual. The caller has to adopt the child by setting its parent
+ * page id.
+ * NOTE: This method is only called by bulk loading, which appends children in
+ * key order
+ * @return:  new size after insertion
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &new_key, const ValueType &new_value) {
+  auto sz = this->GetSize();
+  this->InsertAt(sz, new_key, new_value);
+  return sz + 1;
 }
 
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Remove half of key & value pairs from this page to the empty "recipient"
+ * page, which is linked in as the right sibling. The first key of the
+ * recipient is the one to push up, it becomes the low key of the recipient
+ * and the high key of this page. A page that is full by count is split in the
+ * middle, one that is full by space is split by space.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,
                                                 BufferPoolManager *buffer_pool_manager) {
-  // last half
-  auto sz = this->GetSize();
-  auto half = sz / 2;
-  recipient->CopyNFrom(&array[half], sz - half, buffer_pool_manager);
-  // memset(&array[half], 0, sizeof(MappingType) * (sz - half));
-  this->SetSize(half);
-}
-
-/* Copy entries into me, starting from {items} and copy {size} entries.
- * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
- * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
-  auto sz = this->GetSize();
-  for (int i = 0; i < size; ++i) {
-    array[i + sz] = items[i];
-  }
-
-  this->SetSize(sz + size);
-
-  for (int i = 0; i < size; ++i) {
-    this->updateParentPageId(items[i], buffer_pool_manager);
+  auto items = this->GetItems();
+  int sz = items.size();
+  auto half = sz > this->GetMaxSize() ? sz / 2 : this->HalfSpaceIndex();
+  auto middleKey = items[half].first;
+
+  recipient->SetFences(&middleKey, this->GetNextPageId(), this->HighFence());
+  recipient->Assign(items.data() + half, sz - half);
+  this->SetFences(this->LowFence(), recipient->GetPageId(), &middleKey);
+  this->Assign(items.data(), half);
+
+  for (int i = half; i < sz; ++i) {
+    recipient->updateParentPageId(items[i].second, buffer_pool_manager);
   }
 }
 
@@ -181,15 +197,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
  * NOTE: store key&value pair continuously after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
-  auto sz = this->GetSize();
-
-  for (int i = index; i + 1 < sz; ++i) {
-    array[i] = array[i + 1];
-  }
-
-  this->SetSize(--sz);
-}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) { this->RemoveAt(index); }
 
 /*
  * Remove the only key & value pair in internal page and return the value
@@ -197,30 +205,55 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
-  auto sz = this->GetSize();
-  auto pageId = array[0].second;
-  // memset(array, 0, sz * sizeof(MappingType));
-  this->SetSize(--sz);
+  auto pageId = this->ValueAt(0);
+  this->RemoveAt(0);
   return pageId;
 }
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
+/*
+ * @return: true if the entries of both pages and the middle key fit into the
+ * "recipient" page, which is the left sibling of this page. Merging widens the
+ * fences of the recipient, so the entries may take more space than they do now.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanMoveAllTo(const BPlusTreeInternalPage *recipient,
+                                                  const KeyType &middle_key) const {
+  if (this->GetSize() + recipient->GetSize() > this->GetMaxSize()) {
+    return false;
+  }
+
+  auto items = recipient->GetItems();
+  auto mine = this->GetItems();
+  mine[0].first = middle_key;
+  items.insert(items.end(), mine.begin(), mine.end());
+  return this->Fits(items.data(), items.size(), recipient->LowFence(), this->HighFence(), 0);
+}
+
 /*
  * Remove all of key & value pairs from this page to "recipient" page.
  * The middle_key is the separation key you should get from the parent. You need
  * to make sure the middle key is added to the recipient to maintain the invariant.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
- * pages that are moved to the recipient
+ * pages that are moved to the recipient. The recipient takes over the right link
+ * and the high key of this page.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                                                BufferPoolManager *buffer_pool_manager) {
-  this->SetKeyAt(0, middle_key);
-  auto sz = this->GetSize();
-  recipient->CopyNFrom(array, sz, buffer_pool_manager);
-  // memset(array, 0, sizeof(MappingType) * sz);
+  auto items = recipient->GetItems();
+  auto mine = this->GetItems();
+  mine[0].first = middle_key;
+  items.insert(items.end(), mine.begin(), mine.end());
+
+  recipient->SetFences(recipient->LowFence(), this->GetNextPageId(), this->HighFence());
+  recipient->Assign(items.data(), items.size());
   this->SetSize(0);
+
+  for (const auto &item : mine) {
+    recipient->updateParentPageId(item.second, buffer_pool_manager);
+  }
 }
 
 /*****************************************************************************
@@ -233,105 +266,86 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient,
  * to make sure the middle key is added to the recipient to maintain the invariant.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
  * pages that are moved to the recipient
+ * @return: false if this page would be left with a single child or the pair
+ * does not fit into the recipient
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                                                       BufferPoolManager *buffer_pool_manager) {
-  this->SetKeyAt(0, middle_key);
-  recipient->CopyLastFrom(array[0], buffer_pool_manager);
-
-  auto sz = this->GetSize();
-  for (int i = 0; i + 1 < sz; ++i) {
-    array[i] = array[i + 1];
+  if (this->GetSize() < 3) {
+    return false;
   }
 
-  this->SetKeyAt(0, KeyType());
-  this->SetSize(--sz);
-}
+  auto mine = this->GetItems();
+  auto newMiddleKey = mine[1].first;
+  auto items = recipient->GetItems();
+  items.emplace_back(middle_key, mine[0].second);
+  if (!recipient->Fits(items.data(), items.size(), recipient->LowFence(), &newMiddleKey, 0)) {
+    return false;
+  }
 
-/* Append an entry at the end.
- * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
- * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
-  array[this->GetSize()] = pair;
-  this->IncreaseSize(1);
+  recipient->SetFences(recipient->LowFence(), recipient->GetNextPageId(), &newMiddleKey);
+  recipient->Assign(items.data(), items.size());
+  this->SetFences(&newMiddleKey, this->GetNextPageId(), this->HighFence());
+  this->Assign(mine.data() + 1, mine.size() - 1);
 
-  this->updateParentPageId(pair, buffer_pool_manager);
+  recipient->updateParentPageId(mine[0].second, buffer_pool_manager);
+  return true;
 }
 
 /*
  * Remove the last key & value pair from this page to head of "recipient" page.
- * You need to handle the original dummy key properly, e.g. updating recipient’s array to position the middle_key at the
- * right place.
+ * The middle_key takes the place of the dummy key of the recipient, and the
+ * key of the moved pair becomes the new middle key.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those pages that are
  * moved to the recipient
+ * @return: false if this page would be left with a single child or the pair
+ * does not fit into the recipient
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                                                        BufferPoolManager *buffer_pool_manager) {
-  recipient->SetKeyAt(0, middle_key);
-
-  auto sz = this->GetSize();
-  this->SetKeyAt(--sz, KeyType());
-
-  recipient->CopyFirstFrom(array[sz], buffer_pool_manager);
-  // memset(&array[sz], 0, sizeof(MappingType));
-  this->SetSize(sz);
-}
+  if (this->GetSize() < 3) {
+    return false;
+  }
 
-/* Append an entry at the beginning.
- * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
- * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
-  auto sz = this->GetSize();
-  for (int i = sz; i > 0; --i) {
-    array[i] = array[i - 1];
+  auto mine = this->GetItems();
+  auto newMiddleKey = mine.back().first;
+  auto items = recipient->GetItems();
+  items[0].first = middle_key;
+  items.insert(items.begin(), mine.back());
+  if (!recipient->Fits(items.data(), items.size(), &newMiddleKey, recipient->HighFence(), 0)) {
+    return false;
   }
 
-  array[0] = pair;
-  this->IncreaseSize(1);
+  recipient->SetFences(&newMiddleKey, recipient->GetNextPageId(), recipient->HighFence());
+  recipient->Assign(items.data(), items.size());
+  this->SetFences(this->LowFence(), this->GetNextPageId(), &newMiddleKey);
+  this->Assign(mine.data(), mine.size() - 1);
 
-  this->updateParentPageId(pair, buffer_pool_manager);
+  recipient->updateParentPageId(mine.back().second, buffer_pool_manager);
+  return true;
 }
 
 /*
- * Do binary search to find and return array index(or offset), so that its value
- * equals to input "value"
+ * Make "sibling" the right sibling of this page, separated by "separator".
+ * Both pages only narrow their fences, so their entries keep fitting.
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_INTERNAL_PAGE_TYPE::keyIndex(const KeyType &key, const KeyComparator &comparator) const {
-  // binary search
-  int l = 1;
-  int r = this->GetSize();
-  while (l < r) {
-    int mid = l + (r - l) / 2;
-    auto &_key = array[mid].first;
-    int result = comparator(key, _key);
-    if (result == 0) {
-      // equal
-      return mid;
-    }
-
-    if (result == -1) {
-      // less
-      r = mid;
-    } else {
-      l = mid + 1;
-    }
-  }
-
-  // not found, but should be in index l
-  return -l - 1;
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::LinkRightSibling(BPlusTreeInternalPage *sibling, const KeyType &separator) {
+  auto items = this->GetItems();
+  this->SetFences(this->LowFence(), sibling->GetPageId(), &separator);
+  this->Assign(items.data(), items.size());
+
+  items = sibling->GetItems();
+  sibling->SetFences(&separator, sibling->GetNextPageId(), sibling->HighFence());
+  sibling->Assign(items.data(), items.size());
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::updateParentPageId(const MappingType &pair,
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::updateParentPageId(const ValueType &child,
                                                         BufferPoolManager *buffer_pool_manager) const {
-  auto pageId = pair.second;
+  auto pageId = child;
   auto page = buffer_pool_manager->FetchPage(pageId);
   auto treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
   treePage->SetParentPageId(this->GetPageId());
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <sstream>
 
 #include "common/exception.h"
@@ -35,23 +36,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, in
   this->SetSize(0);
   this->SetLSN(INVALID_LSN);
   this->SetMaxSize(max_size);
-  this->SetNextPageId(INVALID_PAGE_ID);
-  for (int i = 0; i < max_size; ++i) {
-    this->array[i] = MappingType();
-  }
+  this->InitSlots();
 }
 
 /**
- * Helper methods to set/get next page id
- */
-INDEX_TEMPLATE_ARGUMENTS
-page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const { return next_page_id_; }
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
-
-/**
- * Helper method to find the first index i so that array[i].first >= key
+ * Helper method to find the first index i so that KeyAt(i) >= key
  * NOTE: This method is only used when generating index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
@@ -64,32 +53,61 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator
   return ind;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::LookupIndex(const KeyType &key, const KeyComparator &comparator) const {
+  auto ind = keyIndex(key, comparator);
+  return ind < 0 ? -1 : ind;
+}
+
 /*
- * Helper method to find and return the key associated with input "index"(a.k.a
- * array offset)
+ * Helper method to find and return the key & value pair associated with input
+ * "index"(a.k.a array offset), with the first value of the key
  */
 INDEX_TEMPLATE_ARGUMENTS
-KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const {
+  return {this->KeyAt(index), this->ValueAt(index)};
+}
 
-  return array[index].first;
+/*
+ * Append all values of the entry at index to "values"
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::GetValues(int index, std::vector<ValueType> *values) const {
+  auto count = this->ValueCountAt(index);
+  for (int i = 0; i < count; ++i) {
+    values->emplace_back(this->ValueAt(index, i));
+  }
 }
 
 /*
- * Helper method to find and return the key & value pair associated with input
- * "index"(a.k.a array offset)
+ * Size checks, by count and by space
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  // replace with your own code
-  return array[index];
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsOverflow() const {
+  return this->GetSize() >= this->GetMaxSize() || this->GetFreeSpace() < this->MaxEntrySize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsUnderflow() const {
+  return this->GetSize() < this->GetMinSize() && this->GetUsedSpace() < this->CAPACITY / 2;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsInsertSafe() const {
+  return this->GetSize() + 1 < this->GetMaxSize() && this->GetFreeSpace() >= 2 * this->MaxEntrySize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsDeleteSafe() const {
+  return this->GetSize() - 1 >= this->GetMinSize() || this->GetUsedSpace() - this->MaxEntrySize() >= this->CAPACITY / 2;
 }
 
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 /*
- * Insert key & value pair into leaf page ordered by key
+ * Insert key & value pair into leaf page ordered by key, the page must not be
+ * full
  * @return  page size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
@@ -101,44 +119,31 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &valu
     return sz;
   }
 
-  ind = -(ind + 1);
-  for (int i = sz; i > ind; --i) {
-    array[i] = array[i - 1];
-  }
-
-  array[ind] = {key, value};
-
-  this->SetSize(++sz);
-  return sz;
+  this->InsertAt(-(ind + 1), key, value);
+  return sz + 1;
 }
 
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Remove half of key & value pairs from this page to the empty "recipient"
+ * page, which is linked in as the right sibling. A page that is full by count
+ * is split in the middle, one that is full by space is split by space. The
+ * left link of the page after the recipient is left to the caller.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
-  // last half
-  auto sz = this->GetSize();
-  auto half = sz / 2;
-  recipient->CopyNFrom(&array[half], sz - half);
-  // memset(&array[half], 0, sizeof(MappingType) * (sz - half));
-  this->SetSize(half);
-}
-
-/*
- * Copy starting from items, and copy {size} number of elements into me.
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
-  auto sz = this->GetSize();
-  for (int i = 0; i < size; ++i) {
-    array[sz + i] = items[i];
-  }
-
-  this->SetSize(sz + size);
+  auto items = this->GetItems();
+  int sz = items.size();
+  auto half = sz >= this->GetMaxSize() ? sz / 2 : this->HalfSpaceIndex();
+  auto separator = this->ShortestSeparator(items[half - 1].first, items[half].first);
+
+  recipient->SetFences(&separator, this->GetNextPageId(), this->HighFence());
+  recipient->SetPrevPageId(this->GetPageId());
+  recipient->Assign(items.data() + half, sz - half);
+  this->SetFences(this->LowFence(), recipient->GetPageId(), &separator);
+  this->Assign(items.data(), half);
 }
 
 /*****************************************************************************
@@ -156,17 +161,63 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
     return false;
   }
 
-  *value = array[ind].second;
+  *value = this->ValueAt(ind);
+  return true;
+}
+
+/*
+ * Replace the values of an existing key by value
+ * @return: false if the key does not exist
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::Update(const KeyType &key, const ValueType &value, const KeyComparator &comparator) {
+  auto ind = keyIndex(key, comparator);
+  if (ind < 0) {
+    return false;
+  }
+
+  this->SetValuesAt(ind, &value, 1);
   return true;
 }
 
+/*
+ * Replace the values of the entry at index, e.g. to grow or shrink its inline
+ * posting list
+ * @param   can_overflow   the caller splits the page if it overflows, otherwise
+ *                         the page has to keep room for the largest entry
+ * @return: false if there are too many values or they do not fit, nothing
+ * happened
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::SetValues(int index, const std::vector<ValueType> &values, bool can_overflow) {
+  static_assert(LEAF_PAGE_MAX_INLINE_VALUES <= BPlusTreeNodeLayout<KeyType, ValueType, KeyComparator>::MAX_ENTRY_VALUES,
+                "an inline posting list has to fit into a single entry");
+  int count = values.size();
+  if (count > LEAF_PAGE_MAX_INLINE_VALUES ||
+      !this->CanSetValuesAt(index, count, can_overflow ? 0 : this->MaxEntrySize())) {
+    return false;
+  }
+
+  this->SetValuesAt(index, values.data(), count);
+  return true;
+}
+
+/*
+ * @return: true if the inline posting list of the entry at index can take
+ * one more value, leaving room for the largest entry
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::HasRoomForValue(int index) const {
+  auto count = this->ValueCountAt(index) + 1;
+  return count <= LEAF_PAGE_MAX_INLINE_VALUES && this->CanSetValuesAt(index, count, this->MaxEntrySize());
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
 /*
  * First look through leaf page to see whether delete key exist or not. If
  * exist, perform deletion, otherwise return immediately.
- * NOTE: store key&value pair continuously after deletion
  * @return   page size after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
@@ -177,28 +228,43 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
     return sz;
   }
 
-  // memset(&array[ind], 0, sizeof(MappingType));
-  for (int i = ind; i < sz - 1; ++i) {
-    array[i] = array[i + 1];
-  }
-
-  this->SetSize(--sz);
-  return sz;
+  this->RemoveAt(ind);
+  return sz - 1;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page. Don't forget
- * to update the next_page id in the sibling page
+ * @return: true if the entries of both pages fit into the "recipient" page,
+ * which is the left sibling of this page. Merging widens the fences of the
+ * recipient, so the entries may take more space than they do now.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::CanMoveAllTo(const BPlusTreeLeafPage *recipient) const {
+  if (this->GetSize() + recipient->GetSize() >= this->GetMaxSize()) {
+    return false;
+  }
+
+  auto items = recipient->GetItems();
+  auto mine = this->GetItems();
+  items.insert(items.end(), mine.begin(), mine.end());
+  return this->Fits(items.data(), items.size(), recipient->LowFence(), this->HighFence(), 1);
+}
+
+/*
+ * Remove all of key & value pairs from this page to "recipient" page, which
+ * takes over the right link and the high key of this page. The caller points
+ * the left link of the next page at the recipient.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
-  recipient->CopyNFrom(&array[0], this->GetSize());
-  recipient->SetNextPageId(this->GetPageId());
+  auto items = recipient->GetItems();
+  auto mine = this->GetItems();
+  items.insert(items.end(), mine.begin(), mine.end());
 
-  // memset(array, 0, this->GetSize() * sizeof(MappingType));
+  recipient->SetFences(recipient->LowFence(), this->GetNextPageId(), this->HighFence());
+  recipient->Assign(items.data(), items.size());
   this->SetSize(0);
 }
 
@@ -206,81 +272,81 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to "recipient" page.
+ * Remove the first key & value pair from this page to "recipient" page, its
+ * left sibling. The separator between both pages becomes "separator".
+ * @return: false if the pair does not fit into the recipient
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
-  recipient->CopyLastFrom(array[0]);
-  auto sz = this->GetSize() - 1;
-  for (int i = 0; i < sz; ++i) {
-    array[i] = array[i + 1];
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient, const KeyType &separator) {
+  auto mine = this->GetItems();
+  auto items = recipient->GetItems();
+  items.push_back(mine[0]);
+  if (!recipient->Fits(items.data(), items.size(), recipient->LowFence(), &separator, 1)) {
+    return false;
   }
 
-  this->SetSize(sz);
-}
+  recipient->SetFences(recipient->LowFence(), recipient->GetNextPageId(), &separator);
+  recipient->Assign(items.data(), items.size());
 
-/*
- * Copy the item into the end of my item list. (Append item to my array)
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
-  auto sz = this->GetSize();
-  array[sz] = item;
-  this->SetSize(sz + 1);
+  this->SetFences(&separator, this->GetNextPageId(), this->HighFence());
+  this->Assign(mine.data() + 1, mine.size() - 1);
+  return true;
 }
 
 /*
- * Remove the last key & value pair from this page to "recipient" page.
+ * Remove the last key & value pair from this page to "recipient" page, its
+ * right sibling. The separator between both pages becomes "separator".
+ * @return: false if the pair does not fit into the recipient
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
-  auto sz = this->GetSize();
-  recipient->CopyFirstFrom(array[--sz]);
-  // memset(&array[sz], 0, sizeof(MappingType));
-  this->SetSize(sz);
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient, const KeyType &separator) {
+  auto mine = this->GetItems();
+  auto items = recipient->GetItems();
+  items.insert(items.begin(), mine.back());
+  if (!recipient->Fits(items.data(), items.size(), &separator, recipient->HighFence(), 1)) {
+    return false;
+  }
+
+  recipient->SetFences(&separator, recipient->GetNextPageId(), recipient->HighFence());
+  recipient->Assign(items.data(), items.size());
+
+  this->SetFences(this->LowFence(), this->GetNextPageId(), &separator);
+  this->Assign(mine.data(), mine.size() - 1);
+  return true;
 }
 
 /*
- * Insert item at the front of my items. Move items accordingly.
+ * Make "sibling" the right sibling of this page, separated by "separator".
+ * Both pages only narrow their fences, so their entries keep fitting.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {
-  auto sz = this->GetSize();
-  for (int i = sz; i > 0; --i) {
-    array[i] = array[i - 1];
-  }
-
-  array[0] = item;
-  this->SetSize(sz + 1);
+void B_PLUS_TREE_LEAF_PAGE_TYPE::LinkRightSibling(BPlusTreeLeafPage *sibling, const KeyType &separator) {
+  auto items = this->GetItems();
+  this->SetFences(this->LowFence(), sibling->GetPageId(), &separator);
+  this->Assign(items.data(), items.size());
+
+  items = sibling->GetItems();
+  sibling->SetFences(&separator, sibling->GetNextPageId(), sibling->HighFence());
+  sibling->SetPrevPageId(this->GetPageId());
+  sibling->Assign(items.data(), items.size());
 }
 
 /*
- * Binary Search to find the index of the given key
+ * Search the slots for the index of the given key
+ * @return: the index of the key, or -(index it should be inserted at) - 1 if it
+ * does not exist
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::keyIndex(const KeyType &key, const KeyComparator &comparator) const {
-  // binary search
-  int l = 0;
-  int r = this->GetSize();
-  while (l < r) {
-    int mid = l + (r - l) / 2;
-    auto &_key = array[mid].first;
-    int result = comparator(key, _key);
-    if (result == 0) {
-      // equal
-      return mid;
-    }
-
-    if (result == -1) {
-      // less
-      r = mid;
-    } else {
-      l = mid + 1;
-    }
+  bool isEqual;
+  auto ind = this->LowerBound(key, 0, &isEqual);
+  if (isEqual) {
+    // equal
+    return ind;
   }
 
-  // not found, but should be in index l
-  return -l - 1;
+  // not found, but should be in index ind
+  return -ind - 1;
 }
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_posting_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_posting_page.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+void BPlusTreePostingPage::Init(page_id_t next_page_id) {
+  lsn_ = INVALID_LSN;
+  size_ = 0;
+  next_page_id_ = next_page_id;
+  reserved_ = 0;
+}
+
+bool BPlusTreePostingPage::IsAfter(const RID &value) const {
+  return size_ == 0 || values_[size_ - 1].Get() < value.Get();
+}
+
+bool BPlusTreePostingPage::Contains(const RID &value) const {
+  auto ind = ValueIndex(value);
+  return ind < size_ && values_[ind] == value;
+}
+
+/*
+ * Insert value in order, the page must not be full
+ * @return: false if value is already in the page
+ */
+bool BPlusTreePostingPage::Insert(const RID &value) {
+  auto ind = ValueIndex(value);
+  if (ind < size_ && values_[ind] == value) {
+    return false;
+  }
+
+  std::copy_backward(values_ + ind, values_ + size_, values_ + size_ + 1);
+  values_[ind] = value;
+  ++size_;
+  return true;
+}
+
+/*
+ * @return: false if value is not in the page
+ */
+bool BPlusTreePostingPage::Remove(const RID &value) {
+  auto ind = ValueIndex(value);
+  if (ind == size_ || !(values_[ind] == value)) {
+    return false;
+  }
+
+  std::copy(values_ + ind + 1, values_ + size_, values_ + ind);
+  --size_;
+  return true;
+}
+
+/*
+ * Move the upper half of the RIDs to the (empty) recipient, which is linked in
+ * after this page by the caller
+ */
+void BPlusTreePostingPage::MoveHalfTo(BPlusTreePostingPage *recipient) {
+  auto half = size_ / 2;
+  std::copy(values_ + half, values_ + size_, recipient->values_);
+  recipient->size_ = size_ - half;
+  size_ = half;
+}
+
+/*
+ * Append all RIDs to the recipient, whose RIDs all come before the ones of
+ * this page
+ */
+void BPlusTreePostingPage::MoveAllTo(BPlusTreePostingPage *recipient) {
+  std::copy(values_, values_ + size_, recipient->values_ + recipient->size_);
+  recipient->size_ += size_;
+  size_ = 0;
+}
+
+/*
+ * @return: the first index i so that values_[i] >= value
+ */
+int BPlusTreePostingPage::ValueIndex(const RID &value) const {
+  return static_cast<int>(std::lower_bound(values_, values_ + size_, value,
+                                           [](const RID &lhs, const RID &rhs) { return lhs.Get() < rhs.Get(); }) -
+                          values_);
+}
+
+}  // namespace bustub
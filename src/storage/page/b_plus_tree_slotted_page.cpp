@@ -0,0 +1,571 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_slotted_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_slotted_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/rid.h"
+#include "storage/page/b_plus_tree_slotted_page.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr int HEAD_SIZE = sizeof(uint32_t);
+
+uint64_t MakeSlot(uint32_t head, int offset, int num_values, int size) {
+  return static_cast<uint64_t>(head) << 32 | static_cast<uint64_t>(offset) << 16 |
+         static_cast<uint64_t>(num_values - 1) << 8 | static_cast<uint64_t>(size);
+}
+
+uint32_t SlotHead(uint64_t slot) { return static_cast<uint32_t>(slot >> 32); }
+int SlotOffset(uint64_t slot) { return static_cast<int>((slot >> 16) & 0xFFFF); }
+int SlotNumValues(uint64_t slot) { return static_cast<int>((slot >> 8) & 0xFF) + 1; }
+int SlotSize(uint64_t slot) { return static_cast<int>(slot & 0xFF); }
+
+// the first bytes of a key suffix as a big-endian integer, so that heads compare like the bytes
+uint32_t HeadOf(const char *suffix, int size) {
+  uint32_t head = 0;
+  memcpy(&head, suffix, std::min(size, HEAD_SIZE));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  head = __builtin_bswap32(head);
+#endif
+  return head;
+}
+
+void StoreHead(uint32_t head, char *dst, int size) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  head = __builtin_bswap32(head);
+#endif
+  memcpy(dst, &head, std::min(size, HEAD_SIZE));
+}
+
+}  // namespace
+
+/*****************************************************************************
+ * HELPER METHODS AND UTILITIES
+ *****************************************************************************/
+/*
+ * Reset the B-link fields and empty the page, called by the Init method of
+ * leaf and internal pages
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::InitSlots() {
+  next_page_id_ = INVALID_PAGE_ID;
+  low_key_version_ = 0;
+  heap_offset_ = PAGE_SIZE;
+  garbage_size_ = 0;
+  prefix_size_ = 0;
+  has_low_key_ = 0;
+  prev_page_id_ = INVALID_PAGE_ID;
+  reserved_ = 0;
+  memset(&low_key_, 0, sizeof(KeyType));
+  memset(&high_key_, 0, sizeof(KeyType));
+}
+
+/*
+ * Helper method to rebuild the key associated with input "index"(a.k.a array
+ * offset) from the prefix and the suffix of its entry
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_SLOTTED_PAGE_TYPE::KeyAt(int index) const {
+  KeyType key;
+  auto data = reinterpret_cast<char *>(&key);
+  memset(data, 0, sizeof(KeyType));
+
+  int prefixSize = std::min<int>(prefix_size_, sizeof(KeyType));
+  memcpy(data, &low_key_, prefixSize);
+
+  auto slot = slots_[std::clamp(index, 0, SLOTS - 1)];
+  auto size = std::min<int>(SlotSize(slot), sizeof(KeyType) - prefixSize);
+  StoreHead(SlotHead(slot), data + prefixSize, size);
+  if (size > HEAD_SIZE) {
+    memcpy(data + prefixSize + HEAD_SIZE, SuffixAt(slot), size - HEAD_SIZE);
+  }
+
+  return key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_SLOTTED_PAGE_TYPE::ValueAt(int index) const { return ValueAt(index, 0); }
+
+/*
+ * Helper methods to get the values of an entry, which are stored in order at
+ * the start of the entry
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_SLOTTED_PAGE_TYPE::ValueAt(int index, int value_index) const {
+  auto slot = slots_[std::clamp(index, 0, SLOTS - 1)];
+  ValueType value;
+  memcpy(&value, EntryAt(slot) + std::clamp(value_index, 0, SlotNumValues(slot) - 1) * sizeof(ValueType),
+         sizeof(ValueType));
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::ValueCountAt(int index) const {
+  return SlotNumValues(slots_[std::clamp(index, 0, SLOTS - 1)]);
+}
+
+/*
+ * Helper methods to get the links and the fences, the high key is only valid
+ * if there is a right link
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetNextPageId() const { return next_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetPrevPageId() const { return prev_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::SetPrevPageId(page_id_t prev_page_id) { prev_page_id_ = prev_page_id; }
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetHighKey() const { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_SLOTTED_PAGE_TYPE::HasLowKey() const { return has_low_key_ != 0; }
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetLowKey() const { return low_key_; }
+
+/*
+ * @return true if key belongs to a page on the right, i.e. key >= high key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_SLOTTED_PAGE_TYPE::ShouldMoveRight(const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID && comparator(key, high_key_) != -1;
+}
+
+/*
+ * Helper methods to get/bump the low key version
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetLowKeyVersion() const { return low_key_version_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::IncreaseLowKeyVersion() { ++low_key_version_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetPrefixSize() const { return prefix_size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetUsedSpace() const { return CAPACITY - this->GetFreeSpace(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetFreeSpace() const { return heap_offset_ - SlotsEnd() + garbage_size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::EntrySize(const KeyType &key) const {
+  const char *suffix;
+  return sizeof(uint64_t) + EntryHeapSize(SuffixOf(key, prefix_size_, &suffix), 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::MaxEntrySize() const { return MaxEntrySize(prefix_size_); }
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_SLOTTED_PAGE_TYPE::ShortestSeparator(const KeyType &left, const KeyType &right) {
+  auto leftData = reinterpret_cast<const char *>(&left);
+  auto rightData = reinterpret_cast<const char *>(&right);
+  size_t size = 0;
+  while (size < sizeof(KeyType) && leftData[size] == rightData[size]) {
+    ++size;
+  }
+
+  KeyType separator;
+  memset(&separator, 0, sizeof(KeyType));
+  memcpy(&separator, rightData, std::min(size + 1, sizeof(KeyType)));
+  return separator;
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Keys outside of the prefix sort before or after every entry, otherwise the
+ * heads narrow the search down to the entries with an equal head, which are
+ * told apart by the rest of their suffix
+ * @param is_equal: set to whether KeyAt(i) == key, if not nullptr
+ * @return: the first index i >= begin so that KeyAt(i) >= key, or the size
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::LowerBound(const KeyType &key, int begin, bool *is_equal) const {
+  bool isEqual;
+  if (is_equal == nullptr) {
+    is_equal = &isEqual;
+  }
+
+  *is_equal = false;
+  auto sz = ClampedSize();
+  begin = std::min(begin, sz);
+  int prefixSize = std::min<int>(prefix_size_, sizeof(KeyType));
+  if (prefixSize > 0) {
+    auto cmp = memcmp(&key, &low_key_, prefixSize);
+    if (cmp != 0) {
+      return cmp < 0 ? begin : sz;
+    }
+  }
+
+  const char *suffix;
+  auto size = SuffixOf(key, prefixSize, &suffix);
+  auto head = HeadOf(suffix, size);
+  auto l = begin + SlotHeadLowerBound(slots_ + begin, sz - begin, head);
+  if (size <= HEAD_SIZE) {
+    // an entry with the same head is either equal to the key or longer
+    *is_equal = l < sz && SlotHead(slots_[l]) == head && SlotSize(slots_[l]) == size;
+    return l;
+  }
+
+  // only the entries with the same head are left
+  auto r = head == UINT32_MAX ? sz : l + SlotHeadLowerBound(slots_ + l, sz - l, head + 1);
+  while (l < r) {
+    auto mid = l + (r - l) / 2;
+    if (CompareAt(slots_[mid], head, suffix, size) < 0) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+  *is_equal = l < sz && CompareAt(slots_[l], head, suffix, size) == 0;
+  return l;
+}
+
+/*
+ * Compare the entry of slot with the key suffix of the given head and size
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::CompareAt(uint64_t slot, uint32_t head, const char *suffix, int size) const {
+  auto slotHead = SlotHead(slot);
+  if (slotHead != head) {
+    return slotHead < head ? -1 : 1;
+  }
+
+  auto slotRest = std::max(std::min<int>(SlotSize(slot), sizeof(KeyType)) - HEAD_SIZE, 0);
+  auto rest = std::max(size - HEAD_SIZE, 0);
+  auto cmp = memcmp(SuffixAt(slot), suffix + HEAD_SIZE, std::min(slotRest, rest));
+  if (cmp != 0) {
+    return cmp;
+  }
+
+  // no trailing zero bytes, the longer suffix is the greater one
+  return slotRest < rest ? -1 : (slotRest > rest ? 1 : 0);
+}
+
+/*****************************************************************************
+ * MODIFICATION
+ *****************************************************************************/
+/*
+ * Insert the entry at index, the page must have room for it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) {
+  // the new slot must not run into the entries
+  if (heap_offset_ - SlotsEnd() < static_cast<int>(sizeof(uint64_t))) {
+    Compact(-1);
+  }
+
+  auto sz = this->GetSize();
+  memmove(slots_ + index + 1, slots_ + index, (sz - index) * sizeof(uint64_t));
+  this->SetSize(sz + 1);
+  WriteEntry(index, key, value, nullptr, 0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::RemoveAt(int index) {
+  auto sz = this->GetSize();
+  auto slot = slots_[index];
+  auto heapSize = EntryHeapSize(SlotSize(slot), SlotNumValues(slot));
+  if (SlotOffset(slot) == heap_offset_) {
+    heap_offset_ += heapSize;
+  } else {
+    garbage_size_ += heapSize;
+  }
+
+  memmove(slots_ + index, slots_ + index + 1, (sz - index - 1) * sizeof(uint64_t));
+  this->SetSize(sz - 1);
+}
+
+/*
+ * Replace the key at index, the page must have room for the new entry
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  auto slot = slots_[index];
+  std::vector<ValueType> values(SlotNumValues(slot));
+  memcpy(values.data(), EntryAt(slot), values.size() * sizeof(ValueType));
+  garbage_size_ += EntryHeapSize(SlotSize(slot), SlotNumValues(slot));
+  WriteEntry(index, key, values[0], values.data() + 1, values.size() - 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  memcpy(Data() + SlotOffset(slots_[index]), &value, sizeof(ValueType));
+}
+
+/*
+ * @return: true if the entry at index can hold count values, leaving
+ * reserve_space bytes of free space
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_SLOTTED_PAGE_TYPE::CanSetValuesAt(int index, int count, int reserve_space) const {
+  auto growth = (count - SlotNumValues(slots_[index])) * static_cast<int>(sizeof(ValueType));
+  return count <= MAX_ENTRY_VALUES && GetFreeSpace() - growth >= reserve_space;
+}
+
+/*
+ * Replace the values of the entry at index, the page must have room for them
+ * (see CanSetValuesAt). The values must not be the ones of this page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::SetValuesAt(int index, const ValueType *values, int count) {
+  auto key = KeyAt(index);
+  auto slot = slots_[index];
+  garbage_size_ += EntryHeapSize(SlotSize(slot), SlotNumValues(slot));
+  WriteEntry(index, key, values[0], values + 1, count - 1);
+}
+
+/*
+ * Allocate the entry for the slot at index, which is already part of the page.
+ * The entry holds value followed by num_more more values.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::WriteEntry(int index, const KeyType &key, const ValueType &value,
+                                               const ValueType *more_values, int num_more) {
+  const char *suffix = nullptr;
+  auto size = IsKeyless(index) ? 0 : SuffixOf(key, prefix_size_, &suffix);
+  auto heapSize = EntryHeapSize(size, num_more + 1);
+  // the slot of index is already counted
+  if (heap_offset_ - SlotsEnd() < heapSize) {
+    Compact(index);
+  }
+
+  heap_offset_ -= heapSize;
+  auto entry = Data() + heap_offset_;
+  memcpy(entry, &value, sizeof(ValueType));
+  if (num_more > 0) {
+    memcpy(entry + sizeof(ValueType), more_values, num_more * sizeof(ValueType));
+  }
+  if (size > HEAD_SIZE) {
+    memcpy(entry + (num_more + 1) * sizeof(ValueType), suffix + HEAD_SIZE, size - HEAD_SIZE);
+  }
+  slots_[index] = MakeSlot(size == 0 ? 0 : HeadOf(suffix, size), heap_offset_, num_more + 1, size);
+}
+
+/*
+ * Move all live entries to the end of the page, so that the free space is
+ * contiguous again. The slot at skip_index, if any, has no live entry.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::Compact(int skip_index) {
+  char buffer[PAGE_SIZE];
+  int offset = PAGE_SIZE;
+  auto sz = this->GetSize();
+  for (int i = 0; i < sz; ++i) {
+    if (i == skip_index) {
+      continue;
+    }
+
+    auto slot = slots_[i];
+    auto heapSize = EntryHeapSize(SlotSize(slot), SlotNumValues(slot));
+    offset -= heapSize;
+    memcpy(buffer + offset, Data() + SlotOffset(slot), heapSize);
+    slots_[i] = MakeSlot(SlotHead(slot), offset, SlotNumValues(slot), SlotSize(slot));
+  }
+
+  memcpy(Data() + offset, buffer + offset, PAGE_SIZE - offset);
+  heap_offset_ = offset;
+  garbage_size_ = 0;
+}
+
+/*****************************************************************************
+ * REORGANIZATION
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<ItemType> B_PLUS_TREE_SLOTTED_PAGE_TYPE::GetItems() const {
+  std::vector<ItemType> items;
+  auto sz = this->GetSize();
+  items.reserve(sz);
+  for (int i = 0; i < sz; ++i) {
+    items.emplace_back(KeyAt(i), ValueAt(i));
+    auto numValues = SlotNumValues(slots_[i]);
+    if (numValues > 1) {
+      auto values = reinterpret_cast<const ValueType *>(EntryAt(slots_[i]));
+      items.back().more_values.assign(values + 1, values + numValues);
+    }
+  }
+  return items;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::Assign(const ItemType *items, int size) {
+  heap_offset_ = PAGE_SIZE;
+  garbage_size_ = 0;
+  this->SetSize(size);
+  for (int i = 0; i < size; ++i) {
+    WriteEntry(i, items[i].first, items[i].second, items[i].more_values.data(), items[i].more_values.size());
+  }
+}
+
+/*
+ * Set the fences, the prefix follows from them. The entries are encoded with
+ * the old prefix until they are assigned again.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_SLOTTED_PAGE_TYPE::SetFences(const KeyType *low_key, page_id_t next_page_id,
+                                              const KeyType *high_key) {
+  // the fences may be the ones of this page
+  KeyType lowKey;
+  KeyType highKey;
+  memset(&lowKey, 0, sizeof(KeyType));
+  memset(&highKey, 0, sizeof(KeyType));
+  if (low_key != nullptr) {
+    lowKey = *low_key;
+  }
+  if (next_page_id != INVALID_PAGE_ID) {
+    highKey = *high_key;
+  }
+
+  has_low_key_ = low_key != nullptr ? 1 : 0;
+  low_key_ = lowKey;
+  next_page_id_ = next_page_id;
+  high_key_ = highKey;
+  prefix_size_ = PrefixSize(LowFence(), HighFence());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+const KeyType *B_PLUS_TREE_SLOTTED_PAGE_TYPE::LowFence() const { return has_low_key_ != 0 ? &low_key_ : nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const KeyType *B_PLUS_TREE_SLOTTED_PAGE_TYPE::HighFence() const {
+  return next_page_id_ != INVALID_PAGE_ID ? &high_key_ : nullptr;
+}
+
+/*
+ * @return: the index that splits the entries into two halves of about the
+ * same space, both with at least one entry
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::HalfSpaceIndex() const {
+  auto sz = this->GetSize();
+  auto half = this->GetUsedSpace() / 2;
+  int used = 0;
+  int index = 0;
+  while (index < sz - 1 && used < half) {
+    used += sizeof(uint64_t) + EntryHeapSize(SlotSize(slots_[index]), SlotNumValues(slots_[index]));
+    ++index;
+  }
+  return std::max(index, 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_SLOTTED_PAGE_TYPE::Fits(const ItemType *items, int size, const KeyType *low_key,
+                                         const KeyType *high_key, int reserve_entries) const {
+  auto prefixSize = PrefixSize(low_key, high_key);
+  auto used = reserve_entries * MaxEntrySize(prefixSize);
+  const char *suffix;
+  for (int i = 0; i < size; ++i) {
+    auto suffixSize = IsKeyless(i) ? 0 : SuffixOf(items[i].first, prefixSize, &suffix);
+    used += sizeof(uint64_t) + EntryHeapSize(suffixSize, items[i].more_values.size() + 1);
+  }
+  return used <= CAPACITY;
+}
+
+/*****************************************************************************
+ * PRIVATE HELPERS
+ *****************************************************************************/
+// the first key of an internal page is never used, its entry does not store it
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_SLOTTED_PAGE_TYPE::IsKeyless(int index) const { return index == 0 && !this->IsLeafPage(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+const char *B_PLUS_TREE_SLOTTED_PAGE_TYPE::Data() const { return reinterpret_cast<const char *>(this); }
+
+INDEX_TEMPLATE_ARGUMENTS
+char *B_PLUS_TREE_SLOTTED_PAGE_TYPE::Data() { return reinterpret_cast<char *>(this); }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::SlotsEnd() const {
+  return SLOTTED_PAGE_HEADER_SIZE + this->GetSize() * sizeof(uint64_t);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::ClampedSize() const { return std::clamp(this->GetSize(), 0, SLOTS); }
+
+INDEX_TEMPLATE_ARGUMENTS
+const char *B_PLUS_TREE_SLOTTED_PAGE_TYPE::EntryAt(uint64_t slot) const {
+  auto heapSize = EntryHeapSize(std::min<int>(SlotSize(slot), sizeof(KeyType)), SlotNumValues(slot));
+  return Data() + std::min(SlotOffset(slot), PAGE_SIZE - heapSize);
+}
+
+// the key suffix without its head follows the values of the entry
+INDEX_TEMPLATE_ARGUMENTS
+const char *B_PLUS_TREE_SLOTTED_PAGE_TYPE::SuffixAt(uint64_t slot) const {
+  return EntryAt(slot) + SlotNumValues(slot) * sizeof(ValueType);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::PrefixSize(const KeyType *low_key, const KeyType *high_key) {
+  if (low_key == nullptr || high_key == nullptr) {
+    return 0;
+  }
+
+  auto lowData = reinterpret_cast<const char *>(low_key);
+  auto highData = reinterpret_cast<const char *>(high_key);
+  int size = 0;
+  while (size < static_cast<int>(sizeof(KeyType)) && lowData[size] == highData[size]) {
+    ++size;
+  }
+  return size;
+}
+
+/*
+ * @return: the size of the key without its first prefix_size bytes and
+ * without its trailing zero bytes
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::SuffixOf(const KeyType &key, int prefix_size, const char **suffix) {
+  auto data = reinterpret_cast<const char *>(&key);
+  int end = sizeof(KeyType);
+  uint64_t word;
+  while (end - static_cast<int>(sizeof(word)) >= prefix_size &&
+         (memcpy(&word, data + end - sizeof(word), sizeof(word)), word == 0)) {
+    end -= sizeof(word);
+  }
+  while (end > prefix_size && data[end - 1] == 0) {
+    --end;
+  }
+
+  *suffix = data + prefix_size;
+  return end - prefix_size;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::EntryHeapSize(int suffix_size, int num_values) {
+  return num_values * sizeof(ValueType) + std::max(suffix_size - HEAD_SIZE, 0);
+}
+
+// the largest entry with a single value, entries only get more values if there is room for them
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_SLOTTED_PAGE_TYPE::MaxEntrySize(int prefix_size) {
+  return sizeof(uint64_t) + EntryHeapSize(sizeof(KeyType) - prefix_size, 1);
+}
+
+template class BPlusTreeSlottedPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class BPlusTreeSlottedPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class BPlusTreeSlottedPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+template class BPlusTreeSlottedPage<GenericKey<16>, page_id_t, GenericComparator<16>>;
+template class BPlusTreeSlottedPage<GenericKey<32>, page_id_t, GenericComparator<32>>;
+template class BPlusTreeSlottedPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_directory_page.cpp
+//
+// Identification: src/storage/page/extendible_hash_table_directory_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/extendible_hash_table_directory_page.h"
+
+#include <cassert>
+
+namespace bustub {
+
+void ExtendibleHashTableDirectoryPage::Init(page_id_t page_id, page_id_t bucket_page_id, uint32_t max_depth) {
+  assert(max_depth <= EXTENDIBLE_DIRECTORY_MAX_DEPTH);
+  lsn_ = INVALID_LSN;
+  page_id_ = page_id;
+  max_depth_ = max_depth;
+  global_depth_ = 0;
+  local_depths_[0] = 0;
+  bucket_page_ids_[0] = bucket_page_id;
+}
+
+page_id_t ExtendibleHashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+lsn_t ExtendibleHashTableDirectoryPage::GetLSN() const { return lsn_; }
+
+void ExtendibleHashTableDirectoryPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+uint32_t ExtendibleHashTableDirectoryPage::HashToBucketIndex(uint32_t hash) const { return hash & (Size() - 1); }
+
+page_id_t ExtendibleHashTableDirectoryPage::GetBucketPageId(uint32_t bucket_ind) const {
+  assert(bucket_ind < Size());
+  return bucket_page_ids_[bucket_ind];
+}
+
+void ExtendibleHashTableDirectoryPage::SetBucketPageId(uint32_t bucket_ind, page_id_t bucket_page_id) {
+  assert(bucket_ind < Size());
+  bucket_page_ids_[bucket_ind] = bucket_page_id;
+}
+
+uint32_t ExtendibleHashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_ind) const {
+  auto local_depth = GetLocalDepth(bucket_ind);
+  assert(local_depth > 0);
+  return bucket_ind ^ (1U << (local_depth - 1));
+}
+
+uint32_t ExtendibleHashTableDirectoryPage::GetGlobalDepth() const { return global_depth_; }
+
+uint32_t ExtendibleHashTableDirectoryPage::GetMaxDepth() const { return max_depth_; }
+
+void ExtendibleHashTableDirectoryPage::IncrGlobalDepth() {
+  assert(global_depth_ < max_depth_);
+  auto size = Size();
+  for (uint32_t i = 0; i < size; ++i) {
+    local_depths_[size + i] = local_depths_[i];
+    bucket_page_ids_[size + i] = bucket_page_ids_[i];
+  }
+  ++global_depth_;
+}
+
+void ExtendibleHashTableDirectoryPage::DecrGlobalDepth() {
+  assert(CanShrink());
+  --global_depth_;
+}
+
+bool ExtendibleHashTableDirectoryPage::CanShrink() const {
+  if (global_depth_ == 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < Size(); ++i) {
+    if (local_depths_[i] == global_depth_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t ExtendibleHashTableDirectoryPage::Size() const { return 1U << global_depth_; }
+
+uint32_t ExtendibleHashTableDirectoryPage::GetLocalDepth(uint32_t bucket_ind) const {
+  assert(bucket_ind < Size());
+  return local_depths_[bucket_ind];
+}
+
+void ExtendibleHashTableDirectoryPage::SetLocalDepth(uint32_t bucket_ind, uint32_t local_depth) {
+  assert(bucket_ind < Size() && local_depth <= global_depth_);
+  local_depths_[bucket_ind] = static_cast<uint8_t>(local_depth);
+}
+
+}  // namespace bustub
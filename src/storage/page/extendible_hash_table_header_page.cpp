@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_header_page.cpp
+//
+// Identification: src/storage/page/extendible_hash_table_header_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/extendible_hash_table_header_page.h"
+
+#include <cassert>
+
+namespace bustub {
+
+void ExtendibleHashTableHeaderPage::Init(page_id_t page_id, uint32_t max_depth) {
+  assert(max_depth <= EXTENDIBLE_HEADER_MAX_DEPTH);
+  lsn_ = INVALID_LSN;
+  page_id_ = page_id;
+  max_depth_ = max_depth;
+  for (auto &directory_page_id : directory_page_ids_) {
+    directory_page_id = INVALID_PAGE_ID;
+  }
+}
+
+page_id_t ExtendibleHashTableHeaderPage::GetPageId() const { return page_id_; }
+
+lsn_t ExtendibleHashTableHeaderPage::GetLSN() const { return lsn_; }
+
+void ExtendibleHashTableHeaderPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+/*
+ * The directories take the most significant bits, the buckets of a directory
+ * the least significant ones, so the two never overlap
+ */
+uint32_t ExtendibleHashTableHeaderPage::HashToDirectoryIndex(uint32_t hash) const {
+  return max_depth_ == 0 ? 0 : hash >> (32 - max_depth_);
+}
+
+page_id_t ExtendibleHashTableHeaderPage::GetDirectoryPageId(uint32_t directory_ind) const {
+  assert(directory_ind < MaxSize());
+  return directory_page_ids_[directory_ind];
+}
+
+void ExtendibleHashTableHeaderPage::SetDirectoryPageId(uint32_t directory_ind, page_id_t directory_page_id) {
+  assert(directory_ind < MaxSize());
+  directory_page_ids_[directory_ind] = directory_page_id;
+}
+
+uint32_t ExtendibleHashTableHeaderPage::MaxSize() const { return 1U << max_depth_; }
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_tagged_block_page.cpp
+//
+// Identification: src/storage/page/hash_table_tagged_block_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_tagged_block_page.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+/*
+ * Control bytes follow the protocol of the flags of HashTableBlockPage: an insert claims a slot with a compare and
+ * swap, writes the pair and then publishes it by storing its tag, and a published pair is never written over.
+ */
+static_assert(sizeof(std::atomic<uint8_t>) == 1, "control bytes are loaded as a plain byte array");
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+KeyType HASH_TABLE_TAGGED_BLOCK_TYPE::KeyAt(slot_offset_t bucket_ind) const {
+  return array_[bucket_ind].first;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+ValueType HASH_TABLE_TAGGED_BLOCK_TYPE::ValueAt(slot_offset_t bucket_ind) const {
+  return array_[bucket_ind].second;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TAGGED_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value,
+                                          uint8_t tag) {
+  auto ctrl = EMPTY;
+  if (!ctrl_[bucket_ind].compare_exchange_strong(ctrl, CLAIMED)) {
+    return false;
+  }
+
+  array_[bucket_ind] = MappingType(key, value);
+  ctrl_[bucket_ind].store(tag);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TAGGED_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {
+  ctrl_[bucket_ind].store(DELETED);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TAGGED_BLOCK_TYPE::IsOccupied(slot_offset_t bucket_ind) const {
+  return ctrl_[bucket_ind].load() != EMPTY;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TAGGED_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const {
+  return (ctrl_[bucket_ind].load() & 0x80) != 0;
+}
+
+/*
+ * The group is loaded without ordering, so callers check a matching slot again with IsOccupied or IsReadable before
+ * they read its pair
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_TAGGED_BLOCK_TYPE::MatchTagOrEmpty(slot_offset_t bucket_ind, uint8_t tag) const {
+  auto group = reinterpret_cast<const uint8_t *>(ctrl_ + bucket_ind);
+#if defined(__AVX2__)
+  auto ctrl = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(group));
+  auto is_match = _mm256_or_si256(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8(static_cast<char>(tag))),
+                                  _mm256_cmpeq_epi8(ctrl, _mm256_setzero_si256()));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(is_match));
+#elif defined(__SSE2__)
+  auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+  auto is_match = _mm_or_si128(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(tag))),
+                               _mm_cmpeq_epi8(ctrl, _mm_setzero_si128()));
+  return static_cast<uint32_t>(_mm_movemask_epi8(is_match));
+#else
+  uint32_t matches = 0;
+  for (slot_offset_t i = 0; i < GROUP_SIZE; ++i) {
+    if (group[i] == tag || group[i] == EMPTY) {
+      matches |= 1U << i;
+    }
+  }
+  return matches;
+#endif
+}
+
+// DO NOT REMOVE ANYTHING BELOW THIS LINE
+template class HashTableTaggedBlockPage<int, int, IntComparator>;
+template class HashTableTaggedBlockPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableTaggedBlockPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableTaggedBlockPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableTaggedBlockPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableTaggedBlockPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
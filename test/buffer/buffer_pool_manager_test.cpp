@@ -11,9 +11,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager.h"
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -141,4 +146,81 @@ TEST(BufferPoolManagerTest, DISABLED_SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FindResidentPageTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: new pages are found without pinning them, pages that were never read in are not.
+  page_id_t page_id_temp;
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    pages.push_back(bpm->NewPage(&page_id_temp));
+    snprintf(pages.back()->GetData(), PAGE_SIZE, "page %zu", i);
+  }
+  uint64_t version = 0;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(pages[i], bpm->FindResidentPage(static_cast<page_id_t>(i), &version));
+    EXPECT_TRUE(pages[i]->ValidateVersion(version));
+  }
+  EXPECT_EQ(nullptr, bpm->FindResidentPage(static_cast<page_id_t>(buffer_pool_size), &version));
+  EXPECT_EQ(nullptr, bpm->FindResidentPage(INVALID_PAGE_ID, &version));
+  EXPECT_EQ(1, pages[0]->GetPinCount());
+
+  // Scenario: an evicted page is not found anymore, and its frame gets a new version for the next page.
+  EXPECT_EQ(pages[0], bpm->FindResidentPage(0, &version));
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_FALSE(pages[0]->ValidateVersion(version));
+  EXPECT_EQ(nullptr, bpm->FindResidentPage(0, &version));
+  EXPECT_EQ(pages[0], bpm->FindResidentPage(page_id_temp, &version));
+
+  // Scenario: a deleted page is not found either.
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  EXPECT_TRUE(bpm->DeletePage(page_id_temp));
+  EXPECT_EQ(nullptr, bpm->FindResidentPage(page_id_temp, &version));
+
+  // Scenario: evictions do not wait for readers, and a reader that validates its version read the page it looked for.
+  for (size_t i = 1; i < buffer_pool_size; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(static_cast<page_id_t>(i), true));
+  }
+  std::atomic<bool> is_stopped{false};
+  std::thread reader([bpm, &is_stopped] {
+    char data[16];
+    while (!is_stopped) {
+      uint64_t version = 0;
+      auto page = bpm->FindResidentPage(1, &version);
+      if (page != nullptr) {
+        memcpy(data, page->GetData(), sizeof(data));
+        if (page->ValidateVersion(version)) {
+          EXPECT_EQ(0, strncmp(data, "page 1", sizeof(data)));
+        }
+      }
+    }
+  });
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 250; ++i) {
+    auto page = bpm->FetchPage(1);
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(bpm->UnpinPage(1, false));
+    for (size_t j = 0; j < buffer_pool_size; ++j) {
+      EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+    }
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+  is_stopped = true;
+  reader.join();
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -19,7 +19,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +59,78 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, VictimOrderTest) {
+  ClockReplacer clock_replacer(4);
+
+  // Scenario: an empty replacer has no victim, and pinning or unpinning unknown frames has no effect.
+  int value = -1;
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+  EXPECT_EQ(-1, value);
+  clock_replacer.Pin(0);
+  clock_replacer.Unpin(4);
+  EXPECT_EQ(0, clock_replacer.Size());
+
+  // Scenario: the first sweep clears every reference bit, the second one evicts in clock order.
+  clock_replacer.Unpin(2);
+  clock_replacer.Unpin(0);
+  clock_replacer.Unpin(3);
+  EXPECT_EQ(3, clock_replacer.Size());
+  EXPECT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: the hand stops past the victim, frames in front of it with a cleared reference bit go first.
+  clock_replacer.Unpin(0);
+  EXPECT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  clock_replacer.Unpin(1);
+  EXPECT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // Scenario: frames 0 and 1 were unpinned with their reference bit set, so they need another sweep.
+  EXPECT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: a pinned frame is no victim until it is unpinned again.
+  clock_replacer.Pin(1);
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+  clock_replacer.Unpin(1);
+  EXPECT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, ConcurrentTest) {
+  const int num_threads = 4;
+  const int frames_per_thread = 100;
+  ClockReplacer clock_replacer(num_threads * frames_per_thread);
+
+  // Scenario: threads unpin and pin disjoint frames, the frames they leave unpinned are each victimized once.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&clock_replacer, t] {
+      for (int i = t * frames_per_thread; i < (t + 1) * frames_per_thread; i++) {
+        clock_replacer.Unpin(i);
+        if (i % 2 == 0) {
+          clock_replacer.Pin(i);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * frames_per_thread / 2, clock_replacer.Size());
+
+  std::vector<bool> is_victim(num_threads * frames_per_thread, false);
+  int value;
+  while (clock_replacer.Victim(&value)) {
+    EXPECT_EQ(1, value % 2);
+    EXPECT_FALSE(is_victim[value]);
+    is_victim[value] = true;
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
@@ -10,19 +10,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstdio>
+#include <random>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_set>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
+#include "concurrency/transaction.h"
 #include "gtest/gtest.h"
 #include "type/value_factory.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(CatalogTest, DISABLED_CreateTableTest) {
+TEST(CatalogTest, CreateTableTest) {
   auto disk_manager = new DiskManager("catalog_test.db");
   auto bpm = new BufferPoolManager(32, disk_manager);
   auto catalog = new Catalog(bpm, nullptr, nullptr);
@@ -48,4 +53,324 @@ TEST(CatalogTest, DISABLED_CreateTableTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(CatalogTest, CoveringIndexTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  // the header page, which keeps the root of the index
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  auto catalog = new Catalog(bpm, nullptr, nullptr);
+  auto txn = new Transaction(0);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::INTEGER);
+  columns.emplace_back("C", TypeId::VARCHAR, 16);
+  Schema schema(columns);
+  auto table_metadata = catalog->CreateTable(txn, "potato", schema);
+  EXPECT_EQ(catalog->GetTable("potato"), table_metadata);
+
+  auto make_tuple = [&](int64_t a) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(a),
+                              ValueFactory::GetIntegerValue(static_cast<int32_t>(a * 2)),
+                              ValueFactory::GetVarcharValue("v" + std::to_string(a))};
+    return Tuple(values, &schema);
+  };
+  RID rid;
+  for (int64_t a = 0; a < 50; a++) {
+    ASSERT_TRUE(table_metadata->table_->InsertTuple(make_tuple(a), &rid, txn));
+  }
+
+  // unique index on A that includes C, populated from the table
+  std::vector<Column> key_columns{columns[0]};
+  Schema key_schema(key_columns);
+  auto index_info = catalog->CreateIndex<GenericKey<32>, RID, GenericComparator<32>>(txn, "potato_a", "potato", schema,
+                                                                                     key_schema, {0}, 32, {2}, true);
+  EXPECT_EQ(catalog->GetIndex("potato_a", "potato"), index_info);
+  EXPECT_EQ(catalog->GetTableIndexes("potato").size(), 1);
+  auto index = index_info->index_.get();
+  auto entry_schema = index->GetEntrySchema();
+  ASSERT_EQ(entry_schema->GetColumnCount(), 2);
+
+  for (int64_t a = 0; a < 60; a++) {
+    auto key = make_tuple(a).KeyFromTuple(schema, key_schema, index->GetKeyAttrs());
+    std::vector<Tuple> entries;
+    std::vector<RID> rids;
+    index->ScanEntries(key, &entries, &rids, txn);
+    if (a >= 50) {
+      EXPECT_TRUE(rids.empty());
+      continue;
+    }
+    ASSERT_EQ(rids.size(), 1);
+    ASSERT_EQ(entries.size(), 1);
+    // the included column comes from the index, not from the table
+    EXPECT_EQ(entries[0].GetValue(entry_schema, 0).GetAs<int64_t>(), a);
+    EXPECT_EQ(entries[0].GetValue(entry_schema, 1).ToString(), "v" + std::to_string(a));
+
+    std::vector<RID> scanned;
+    index->ScanKey(key, &scanned, txn);
+    EXPECT_EQ(scanned, rids);
+    Tuple tuple;
+    ASSERT_TRUE(table_metadata->table_->GetTuple(rids[0], &tuple, txn));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int64_t>(), a);
+  }
+
+  // the key stays unique although entries with other included values differ
+  auto tuple = make_tuple(7);
+  index->InsertEntry(tuple.KeyFromTuple(schema, *entry_schema, index->GetEntryAttrs()), RID(1000, 0), txn);
+  auto other = Tuple({ValueFactory::GetBigIntValue(7), ValueFactory::GetIntegerValue(0),
+                      ValueFactory::GetVarcharValue("other")},
+                     &schema);
+  index->InsertEntry(other.KeyFromTuple(schema, *entry_schema, index->GetEntryAttrs()), RID(1000, 1), txn);
+  std::vector<RID> rids;
+  index->ScanKey(tuple.KeyFromTuple(schema, key_schema, index->GetKeyAttrs()), &rids, txn);
+  EXPECT_EQ(rids.size(), 1);
+
+  // deleting takes the whole entry
+  index->DeleteEntry(tuple.KeyFromTuple(schema, *entry_schema, index->GetEntryAttrs()), rids[0], txn);
+  rids.clear();
+  index->ScanKey(tuple.KeyFromTuple(schema, key_schema, index->GetKeyAttrs()), &rids, txn);
+  EXPECT_TRUE(rids.empty());
+
+  // included columns have to fit into the key
+  auto long_tuple = Tuple({ValueFactory::GetBigIntValue(100), ValueFactory::GetIntegerValue(0),
+                           ValueFactory::GetVarcharValue(std::string(30, 'x'))},
+                          &schema);
+  EXPECT_THROW(index->InsertEntry(long_tuple.KeyFromTuple(schema, *entry_schema, index->GetEntryAttrs()), RID(1000, 2),
+                                  txn),
+               Exception);
+
+  bpm->UnpinPage(header_page_id, true);
+  delete txn;
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+  remove("catalog_test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, DuplicateKeyIndexTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  // the header page, which keeps the root of the index
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  auto catalog = new Catalog(bpm, nullptr, nullptr);
+  auto txn = new Transaction(0);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::INTEGER);
+  Schema schema(columns);
+  auto table_metadata = catalog->CreateTable(txn, "potato", schema);
+
+  // B repeats every 10 tuples
+  auto make_tuple = [&](int64_t a) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(a),
+                              ValueFactory::GetIntegerValue(static_cast<int32_t>(a % 10))};
+    return Tuple(values, &schema);
+  };
+  RID rid;
+  for (int64_t a = 0; a < 50; a++) {
+    ASSERT_TRUE(table_metadata->table_->InsertTuple(make_tuple(a), &rid, txn));
+  }
+
+  // indexes are not unique by default and keep every tuple of a key
+  std::vector<Column> key_columns{columns[1]};
+  Schema key_schema(key_columns);
+  auto index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(txn, "potato_b", "potato", schema,
+                                                                                   key_schema, {1}, 8);
+  EXPECT_FALSE(index_info->index_->GetMetadata()->IsUnique());
+  auto unique_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      txn, "potato_b_unique", "potato", schema, key_schema, {1}, 8, {}, true);
+  EXPECT_TRUE(unique_info->index_->GetMetadata()->IsUnique());
+  auto index = index_info->index_.get();
+
+  for (int64_t b = 0; b < 10; b++) {
+    auto key = make_tuple(b).KeyFromTuple(schema, key_schema, index->GetKeyAttrs());
+    std::vector<RID> rids;
+    index->ScanKey(key, &rids, txn);
+    ASSERT_EQ(rids.size(), 5);
+    for (const auto &tuple_rid : rids) {
+      Tuple tuple;
+      ASSERT_TRUE(table_metadata->table_->GetTuple(tuple_rid, &tuple, txn));
+      EXPECT_EQ(tuple.GetValue(&schema, 1).GetAs<int32_t>(), b);
+    }
+
+    std::vector<RID> unique_rids;
+    unique_info->index_->ScanKey(key, &unique_rids, txn);
+    EXPECT_EQ(unique_rids.size(), 1);
+  }
+
+  // a new tuple with a repeated key joins the others
+  auto tuple = make_tuple(53);
+  ASSERT_TRUE(table_metadata->table_->InsertTuple(tuple, &rid, txn));
+  catalog->InsertIndexEntries(txn, "potato", tuple, rid);
+  std::vector<RID> rids;
+  index->ScanKey(tuple.KeyFromTuple(schema, key_schema, index->GetKeyAttrs()), &rids, txn);
+  EXPECT_EQ(rids.size(), 6);
+  rids.clear();
+  unique_info->index_->ScanKey(tuple.KeyFromTuple(schema, key_schema, index->GetKeyAttrs()), &rids, txn);
+  EXPECT_EQ(rids.size(), 1);
+
+  bpm->UnpinPage(header_page_id, true);
+  delete txn;
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+  remove("catalog_test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, IndexBulkLoadTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(64, disk_manager);
+  // the header page, which keeps the root of the index
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  auto txn = new Transaction(0);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  Schema schema(columns);
+
+  // every key comes twice, the second time much later
+  std::vector<int64_t> keys;
+  for (int64_t a = 0; a < 1000; a++) {
+    keys.push_back(a);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  auto make_next = [&]() {
+    return [&, pos = size_t(0)](Tuple *entry, RID *rid) mutable {
+      if (pos == 2 * keys.size()) {
+        return false;
+      }
+      auto a = keys[pos % keys.size()];
+      *entry = Tuple({ValueFactory::GetBigIntValue(a)}, &schema);
+      *rid = RID(static_cast<page_id_t>(a), static_cast<uint32_t>(pos++ / keys.size()));
+      return true;
+    };
+  };
+
+  // small runs, so that the entries are sorted on disk
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> unique_index(
+      new IndexMetadata("potato_unique", "potato", &schema, {0}, true), bpm);
+  EXPECT_TRUE(unique_index.BulkLoad(make_next(), txn, 64));
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+      new IndexMetadata("potato_a", "potato", &schema, {0}, false), bpm);
+  EXPECT_TRUE(index.BulkLoad(make_next(), txn, 64));
+  EXPECT_FALSE(index.BulkLoad(make_next(), txn, 64));
+
+  for (int64_t a = 0; a < 1000; a++) {
+    Tuple key({ValueFactory::GetBigIntValue(a)}, &schema);
+    // the unique index keeps the entry that came first
+    std::vector<RID> rids;
+    unique_index.ScanKey(key, &rids, txn);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0], RID(static_cast<page_id_t>(a), 0));
+
+    rids.clear();
+    index.ScanKey(key, &rids, txn);
+    std::sort(rids.begin(), rids.end(), [](const RID &l, const RID &r) { return l.GetSlotNum() < r.GetSlotNum(); });
+    ASSERT_EQ(rids.size(), 2);
+    EXPECT_EQ(rids[0], RID(static_cast<page_id_t>(a), 0));
+    EXPECT_EQ(rids[1], RID(static_cast<page_id_t>(a), 1));
+  }
+
+  bpm->UnpinPage(header_page_id, true);
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+  remove("catalog_test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, OnlineIndexBuildTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(256, disk_manager);
+  // the header page, which keeps the root of the index
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  auto catalog = new Catalog(bpm, nullptr, nullptr);
+  auto txn = new Transaction(0);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::INTEGER);
+  Schema schema(columns);
+  auto table_metadata = catalog->CreateTable(txn, "potato", schema);
+  auto table = table_metadata->table_.get();
+
+  auto make_tuple = [&](int64_t a) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(a), ValueFactory::GetIntegerValue(static_cast<int32_t>(a))};
+    return Tuple(values, &schema);
+  };
+  RID rid;
+  for (int64_t a = 0; a < 3000; a++) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(a), &rid, txn));
+  }
+
+  // writers insert new tuples and delete every third of them while the index is built
+  const int num_writers = 4;
+  const int64_t keys_per_writer = 1000;
+  std::vector<std::vector<std::pair<RID, bool>>> written(num_writers);
+  std::vector<std::thread> writers;
+  for (int w = 0; w < num_writers; w++) {
+    writers.emplace_back([&, w] {
+      Transaction writer_txn(w + 1);
+      for (int64_t i = 0; i < keys_per_writer; i++) {
+        auto tuple = make_tuple(10000 * (w + 1) + i);
+        RID tuple_rid;
+        ASSERT_TRUE(table->InsertTuple(tuple, &tuple_rid, &writer_txn));
+        catalog->InsertIndexEntries(&writer_txn, "potato", tuple, tuple_rid);
+        auto is_deleted = i % 3 == 0;
+        if (is_deleted) {
+          ASSERT_TRUE(table->MarkDelete(tuple_rid, &writer_txn));
+          catalog->DeleteIndexEntries(&writer_txn, "potato", tuple, tuple_rid);
+        }
+        written[w].emplace_back(tuple_rid, is_deleted);
+      }
+    });
+  }
+
+  std::vector<Column> key_columns{columns[0]};
+  Schema key_schema(key_columns);
+  auto index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(txn, "potato_a", "potato", schema,
+                                                                                   key_schema, {0}, 8);
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  EXPECT_EQ(catalog->GetIndex("potato_a", "potato"), index_info);
+  EXPECT_EQ(catalog->GetTableIndexes("potato").size(), 1);
+  auto index = index_info->index_.get();
+
+  // the index holds exactly the live tuples of the table
+  for (int64_t a = 0; a < 3000; a++) {
+    std::vector<RID> rids;
+    index->ScanKey(make_tuple(a).KeyFromTuple(schema, key_schema, index->GetKeyAttrs()), &rids, txn);
+    EXPECT_EQ(rids.size(), 1);
+  }
+  for (int w = 0; w < num_writers; w++) {
+    for (int64_t i = 0; i < keys_per_writer; i++) {
+      std::vector<RID> rids;
+      auto key = make_tuple(10000 * (w + 1) + i).KeyFromTuple(schema, key_schema, index->GetKeyAttrs());
+      index->ScanKey(key, &rids, txn);
+      if (written[w][i].second) {
+        EXPECT_TRUE(rids.empty());
+      } else {
+        ASSERT_EQ(rids.size(), 1);
+        EXPECT_EQ(rids[0], written[w][i].first);
+      }
+    }
+  }
+
+  bpm->UnpinPage(header_page_id, true);
+  delete txn;
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+  remove("catalog_test.db");
+}
+
 }  // namespace bustub
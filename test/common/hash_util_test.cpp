@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_util_test.cpp
+//
+// Identification: test/common/hash_util_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "container/hash/hash_function.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, HashIntTest) {
+  // neither the low bits nor the high bits collide for small keys
+  std::unordered_set<uint64_t> lower;
+  std::unordered_set<uint64_t> upper;
+  for (uint64_t i = 0; i < 100000; i++) {
+    auto hash = HashUtil::HashInt(i);
+    EXPECT_EQ(hash, HashUtil::HashInt(i));
+    lower.insert(hash & 0xffffffff);
+    upper.insert(hash >> 32);
+  }
+  EXPECT_EQ(100000, lower.size());
+  EXPECT_EQ(100000, upper.size());
+
+  // every value of a 7-bit tag shows up
+  std::unordered_set<uint64_t> tags;
+  for (uint64_t i = 0; i < 1000; i++) {
+    tags.insert(HashUtil::HashInt(i) >> 57);
+  }
+  EXPECT_EQ(128, tags.size());
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, HashBytesTest) {
+  // every length takes another path through the tail, each byte counts
+  std::string bytes(100, 'a');
+  std::unordered_set<hash_t> hashes;
+  for (size_t length = 0; length <= bytes.size(); length++) {
+    auto hash = HashUtil::HashBytes(bytes.data(), length);
+    EXPECT_EQ(hash, HashUtil::HashBytes(std::string(bytes, 0, length).data(), length));
+    hashes.insert(hash);
+    for (size_t i = 0; i < length; i++) {
+      auto changed = bytes;
+      changed[i] = 'b';
+      hashes.insert(HashUtil::HashBytes(changed.data(), length));
+    }
+  }
+  EXPECT_EQ(101 + 100 * 101 / 2, hashes.size());
+
+  EXPECT_NE(HashUtil::CombineHashes(1, 2), HashUtil::CombineHashes(2, 1));
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, HashFunctionTest) {
+  std::vector<int> ints(1000);
+  std::vector<GenericKey<64>> keys(1000);
+  for (int i = 0; i < 1000; i++) {
+    ints[i] = i;
+    keys[i].SetFromInteger(i);
+  }
+
+  // a batch hashes like the keys one by one
+  std::vector<uint64_t> hashes(1000);
+  HashFunction<int> int_hash_fn;
+  int_hash_fn.GetHashes(ints.data(), ints.size(), hashes.data());
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(int_hash_fn.GetHash(i), hashes[i]);
+  }
+  HashFunction<GenericKey<64>> key_hash_fn;
+  key_hash_fn.GetHashes(keys.data(), keys.size(), hashes.data());
+  std::unordered_set<uint64_t> distinct;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(key_hash_fn.GetHash(keys[i]), hashes[i]);
+    distinct.insert(hashes[i]);
+  }
+  EXPECT_EQ(1000, distinct.size());
+}
+
+}  // namespace bustub
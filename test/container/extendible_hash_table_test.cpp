@@ -0,0 +1,309 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_test.cpp
+//
+// Identification: test/container/extendible_hash_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "container/hash/extendible_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // insert a few values
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to insert " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // insert one more value for each key, duplicate pairs are not allowed
+  for (int i = 0; i < 5; i++) {
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+    if (i == 0) {
+      EXPECT_FALSE(ht.Insert(nullptr, i, 2 * i));
+    } else {
+      EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i));
+    }
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i == 0 ? 1 : 2, res.size()) << "Failed to insert " << i << std::endl;
+  }
+
+  // remove the values again
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i == 0) {
+      EXPECT_TRUE(res.empty());
+    } else {
+      ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+      EXPECT_EQ(2 * i, res[0]);
+    }
+  }
+
+  // missing keys
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 20, &res));
+  EXPECT_FALSE(ht.Remove(nullptr, 20, 20));
+  EXPECT_TRUE(ht.VerifyIntegrity());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, SplitMergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // a single directory, so that all keys share one global depth
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 0);
+  EXPECT_EQ(0, ht.GetGlobalDepth(0));
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_GT(ht.GetGlobalDepth(0), 4);
+  EXPECT_TRUE(ht.VerifyIntegrity());
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // emptied buckets merge, and the directory shrinks back
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth(0));
+  EXPECT_TRUE(ht.VerifyIntegrity());
+  for (int i = 0; i < num_keys; i += 7) {
+    std::vector<int> res;
+    EXPECT_FALSE(ht.GetValue(nullptr, i, &res));
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_TRUE(ht.VerifyIntegrity());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, MaxDepthTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // a single bucket that cannot split, it grows overflow pages instead
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 0, 0);
+  const int bucket_size = (PAGE_SIZE - 2 * sizeof(uint32_t)) / sizeof(std::pair<int, int>);
+  const int num_keys = 3 * bucket_size + 10;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, num_keys - 1, num_keys - 1));
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // removals from the first pages are filled from the last one, and emptied overflow pages go away
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, i, &res));
+  }
+  for (int i = 1; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 1, &res));
+  EXPECT_TRUE(ht.Insert(nullptr, 1, 1));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, PinnedBucketTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // page 0 is the header, the first bucket (page 1) is allocated before the directory, its split image is page 3
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 0, 1);
+  const int bucket_size = (PAGE_SIZE - 2 * sizeof(uint32_t)) / sizeof(std::pair<int, int>);
+  for (int i = 0; i <= bucket_size; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_EQ(1, ht.GetGlobalDepth(0));
+
+  // the bucket that empties first is still pinned when the merge deletes it, so the delete is retried later
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  for (int i = 0; i <= bucket_size; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth(0));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+  EXPECT_TRUE(bpm->IsPageResident(1));
+  EXPECT_TRUE(bpm->IsPageResident(3));
+  EXPECT_FALSE(ht.Remove(nullptr, 0, 0));
+  EXPECT_NE(bpm->IsPageResident(1), bpm->IsPageResident(3));
+  EXPECT_TRUE(ht.VerifyIntegrity());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, DuplicateKeyTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // the values of one key share every hash bit, so they fill one bucket at the maximum depth and its overflow pages
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 0, 4);
+  const int num_values = 5000;
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, 7, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i + 100, i));
+  }
+  EXPECT_EQ(4, ht.GetGlobalDepth(7));
+  EXPECT_TRUE(ht.VerifyIntegrity());
+  std::vector<int> res;
+  EXPECT_TRUE(ht.GetValue(nullptr, 7, &res));
+  ASSERT_EQ(num_values, res.size());
+  std::sort(res.begin(), res.end());
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_EQ(i, res[i]);
+  }
+
+  for (int i = 0; i < num_values; i += 3) {
+    EXPECT_TRUE(ht.Remove(nullptr, 7, i));
+  }
+  res.clear();
+  ht.GetValue(nullptr, 7, &res);
+  EXPECT_EQ(num_values - (num_values + 2) / 3, res.size());
+  for (auto value : res) {
+    EXPECT_NE(0, value % 3);
+  }
+  EXPECT_TRUE(ht.VerifyIntegrity());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // few directories, so that the threads split and merge the same ones
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), 1);
+  const int num_threads = 4;
+  const int keys_per_thread = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_threads * keys_per_thread; i += num_threads) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        // only this thread writes the key
+        EXPECT_FALSE(ht.Insert(nullptr, i, i));
+        std::vector<int> res;
+        EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+        EXPECT_EQ(1, res.size());
+        if (i % 2 == 0) {
+          EXPECT_TRUE(ht.Remove(nullptr, i, i));
+        }
+      }
+    });
+  }
+  // every thread inserts the same pairs, only one of them wins each
+  std::atomic<int> num_inserted{0};
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, &num_inserted] {
+      for (int i = 0; i < keys_per_thread; i++) {
+        if (ht.Insert(nullptr, -1 - i, i)) {
+          num_inserted++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(keys_per_thread, num_inserted.load());
+  EXPECT_TRUE(ht.VerifyIntegrity());
+  for (int i = -keys_per_thread; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i >= 0 && i % 2 == 0) {
+      EXPECT_TRUE(res.empty());
+    } else {
+      ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+      EXPECT_EQ(i < 0 ? -1 - i : i, res[0]);
+    }
+  }
+
+  // concurrent removes merge the buckets back
+  threads.clear();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = -keys_per_thread + t; i < num_threads * keys_per_thread; i += num_threads) {
+        if (i < 0 || i % 2 != 0) {
+          EXPECT_TRUE(ht.Remove(nullptr, i, i < 0 ? -1 - i : i));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(ht.VerifyIntegrity());
+  EXPECT_EQ(0, ht.GetGlobalDepth(0));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
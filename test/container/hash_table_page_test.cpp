@@ -19,11 +19,12 @@
 #include "storage/disk/disk_manager.h"
 #include "storage/page/hash_table_block_page.h"
 #include "storage/page/hash_table_header_page.h"
+#include "storage/page/hash_table_tagged_block_page.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_HeaderPageSampleTest) {
+TEST(HashTablePageTest, HeaderPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(5, disk_manager);
 
@@ -61,7 +62,7 @@ TEST(HashTablePageTest, DISABLED_HeaderPageSampleTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_BlockPageSampleTest) {
+TEST(HashTablePageTest, BlockPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(5, disk_manager);
 
@@ -111,4 +112,62 @@ TEST(HashTablePageTest, DISABLED_BlockPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, TaggedBlockPageSampleTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+
+  // get a block page from the BufferPoolManager
+  page_id_t block_page_id = INVALID_PAGE_ID;
+
+  using TaggedBlockPage = HashTableTaggedBlockPage<int, int, IntComparator>;
+  auto block_page = reinterpret_cast<TaggedBlockPage *>(bpm->NewPage(&block_page_id, nullptr)->GetData());
+
+  // insert a few (key, value) pairs, every third one with another tag
+  auto tag = TaggedBlockPage::TagOf(0xab00000000000000ULL);
+  auto other_tag = TaggedBlockPage::TagOf(0x1200000000000000ULL);
+  EXPECT_NE(tag, other_tag);
+  for (unsigned i = 0; i < 10; i++) {
+    EXPECT_TRUE(block_page->Insert(i, i, i, i % 3 == 0 ? other_tag : tag));
+    EXPECT_FALSE(block_page->Insert(i, i, i, tag));
+  }
+
+  // check for the inserted pairs
+  for (unsigned i = 0; i < 10; i++) {
+    EXPECT_EQ(i, block_page->KeyAt(i));
+    EXPECT_EQ(i, block_page->ValueAt(i));
+  }
+
+  // remove a few pairs
+  for (unsigned i = 0; i < 10; i++) {
+    if (i % 2 == 1) {
+      block_page->Remove(i);
+    }
+  }
+
+  // check for the control bytes
+  for (unsigned i = 0; i < 15; i++) {
+    if (i < 10) {
+      EXPECT_TRUE(block_page->IsOccupied(i));
+      EXPECT_EQ(i % 2 == 0, block_page->IsReadable(i));
+    } else {
+      EXPECT_FALSE(block_page->IsOccupied(i));
+    }
+  }
+
+  // a group matches the pairs with the tag and the free slots
+  auto matches = block_page->MatchTagOrEmpty(0, tag);
+  for (unsigned i = 0; i < TaggedBlockPage::GROUP_SIZE; i++) {
+    auto is_match = (i < 10 && i % 2 == 0 && i % 3 != 0) || i >= 10;
+    EXPECT_EQ(is_match, ((matches >> i) & 1) == 1) << "Wrong match " << i << std::endl;
+  }
+
+  // unpin the header page now that we are done
+  bpm->UnpinPage(block_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "common/logger.h"
@@ -21,7 +23,7 @@
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(50, disk_manager);
 
@@ -104,4 +106,215 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, ResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+  auto initial_size = ht.GetSize();
+  const int num_keys = 5000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i, i + 1));
+  }
+  EXPECT_GT(ht.GetSize(), initial_size);
+
+  // remove every other pair, the tombstones are gone after the next resizes
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i + 1));
+  }
+  for (int i = num_keys; i < 2 * num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  for (int i = 0; i < 2 * num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, IncrementalResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+  ht.SetIncrementalResize(true);
+  auto initial_size = ht.GetSize();
+  const int num_keys = 5000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    // the pairs are found while the old layout is split
+    EXPECT_FALSE(ht.Insert(nullptr, i / 2, i / 2));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i / 3, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i / 3 << std::endl;
+    EXPECT_EQ(i / 3, res[0]);
+    if (i % 5 == 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, i / 5, i / 5));
+      EXPECT_TRUE(ht.Insert(nullptr, i / 5, i / 5));
+    }
+  }
+  EXPECT_GT(ht.GetSize(), initial_size);
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, IncrementalResizeCapTest) {
+  // both layouts stay in the buffer pool
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(2 * HASH_TABLE_MAX_BLOCKS + 10, disk_manager);
+
+  // the table grows into HASH_TABLE_MAX_BLOCKS blocks and keeps filling up there
+  const size_t block_size = 4 * PAGE_SIZE / (4 * sizeof(std::pair<int, int>) + 1);
+  const size_t max_size = HASH_TABLE_MAX_BLOCKS * block_size;
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), max_size / 2, HashFunction<int>());
+  ht.SetIncrementalResize(true);
+  EXPECT_LT(ht.GetSize(), max_size);
+  const int num_keys = max_size * 8 / 10;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    if (i % 50 == 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, i / 50, i / 50));
+      EXPECT_TRUE(ht.Insert(nullptr, i / 50, i / 50));
+    }
+  }
+  EXPECT_EQ(max_size, ht.GetSize());
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, TaggedBlockPageTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  using TaggedBlockPage = HashTableTaggedBlockPage<int, int, IntComparator>;
+  LinearProbeHashTable<int, int, IntComparator, TaggedBlockPage> ht("blah", bpm, IntComparator(), 10,
+                                                                    HashFunction<int>());
+  ht.SetIncrementalResize(true);
+  auto initial_size = ht.GetSize();
+  const int num_keys = 5000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i, i + 1));
+    EXPECT_FALSE(ht.Insert(nullptr, i / 2, i / 2));
+  }
+  EXPECT_GT(ht.GetSize(), initial_size);
+
+  // probes skip the tombstones and the pairs of other tags
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i + 1));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i + 1));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, num_keys, &res));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+template <typename BlockPage>
+static void ConcurrentWorkload(bool incremental_resize) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // the table starts small, so inserts resize it while the others go on
+  LinearProbeHashTable<int, int, IntComparator, BlockPage> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+  ht.SetIncrementalResize(incremental_resize);
+  const int num_threads = 4;
+  const int keys_per_thread = 5000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_threads * keys_per_thread; i += num_threads) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        // only this thread writes the key
+        EXPECT_FALSE(ht.Insert(nullptr, i, i));
+        std::vector<int> res;
+        EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+        EXPECT_EQ(1, res.size());
+        if (i % 2 == 0) {
+          EXPECT_TRUE(ht.Remove(nullptr, i, i));
+        }
+      }
+    });
+  }
+  // every thread inserts the same pairs, only one of them wins each
+  std::atomic<int> num_inserted{0};
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, &num_inserted] {
+      for (int i = 0; i < keys_per_thread; i++) {
+        if (ht.Insert(nullptr, -1 - i, i)) {
+          num_inserted++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(keys_per_thread, num_inserted.load());
+  for (int i = -keys_per_thread; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i >= 0 && i % 2 == 0) {
+      EXPECT_TRUE(res.empty());
+    } else {
+      ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+      EXPECT_EQ(i < 0 ? -1 - i : i, res[0]);
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentTest) {
+  for (auto incremental_resize : {false, true}) {
+    ConcurrentWorkload<HashTableBlockPage<int, int, IntComparator>>(incremental_resize);
+    ConcurrentWorkload<HashTableTaggedBlockPage<int, int, IntComparator>>(incremental_resize);
+  }
+}
+
 }  // namespace bustub
@@ -2,9 +2,11 @@
  * b_plus_tree_test.cpp
  */
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
+#include <random>
 #include <thread>                   // NOLINT
 #include "b_plus_tree_test_util.h"  // NOLINT
 
@@ -330,4 +332,726 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, OptimisticMixTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // small nodes so that both the optimistic path and the pessimistic restart get exercised
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys are preloaded and half of them get deleted, odd keys get inserted
+  const int64_t scale_factor = 1000;
+  std::vector<int64_t> preload_keys;
+  std::vector<int64_t> insert_keys;
+  std::vector<int64_t> remove_keys;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    if (key % 2 == 0) {
+      preload_keys.push_back(key);
+      if (key % 4 == 0) {
+        remove_keys.push_back(key);
+      }
+    } else {
+      insert_keys.push_back(key);
+    }
+  }
+  InsertHelper(&tree, preload_keys);
+
+  // readers look up keys that are never removed while writers run
+  auto read_helper = [&tree](uint64_t thread_itr) {
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    for (int64_t key = 2 + 4 * static_cast<int64_t>(thread_itr); key <= scale_factor; key += 4) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    }
+  };
+  std::thread reader(read_helper, 0);
+  std::thread inserter([&tree, &insert_keys] { LaunchParallelTest(2, InsertHelperSplit, &tree, insert_keys, 2); });
+  std::thread remover([&tree, &remove_keys] { LaunchParallelTest(2, DeleteHelperSplit, &tree, remove_keys, 2); });
+  reader.join();
+  inserter.join();
+  remover.join();
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(tree.GetValue(index_key, &rids), key % 4 != 0);
+  }
+
+  int64_t size = 0;
+  int64_t prev_key = 0;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    auto location = (*iterator).second;
+    EXPECT_GT(location.GetSlotNum(), prev_key);
+    prev_key = location.GetSlotNum();
+    size = size + 1;
+  }
+  EXPECT_EQ(size, scale_factor - static_cast<int64_t>(remove_keys.size()));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, InsertRemoveMixTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(128, disk_manager);
+  // small nodes, so that splits and merges of neighbouring leaves under different parents interleave
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // every thread randomly inserts and removes its own keys and remembers which ones it left in the tree
+  const int64_t scale_factor = 3000;
+  const uint64_t num_threads = 4;
+  std::vector<std::vector<bool>> is_inserted(num_threads, std::vector<bool>(scale_factor + 1, false));
+  auto mix_helper = [&tree, &is_inserted](uint64_t thread_itr) {
+    std::mt19937 generator(thread_itr);
+    std::uniform_int_distribution<int64_t> key_distribution(0, scale_factor / num_threads - 1);
+    GenericKey<8> index_key;
+    RID rid;
+    Transaction transaction(0);
+    for (int op = 0; op < 30000; op++) {
+      auto key = key_distribution(generator) * num_threads + thread_itr;
+      index_key.SetFromInteger(key);
+      if (generator() % 2 == 0) {
+        rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+        tree.Insert(index_key, rid, &transaction);
+        is_inserted[thread_itr][key] = true;
+      } else {
+        tree.Remove(index_key, &transaction);
+        is_inserted[thread_itr][key] = false;
+      }
+    }
+  };
+  LaunchParallelTest(num_threads, mix_helper);
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  int64_t num_inserted = 0;
+  for (int64_t key = 0; key <= scale_factor; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    auto isInserted = is_inserted[key % num_threads][key];
+    EXPECT_EQ(tree.GetValue(index_key, &rids), isInserted);
+    num_inserted += isInserted ? 1 : 0;
+  }
+
+  int64_t size = 0;
+  int64_t prev_key = -1;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    EXPECT_GT((*iterator).first.ToString(), prev_key);
+    prev_key = (*iterator).first.ToString();
+    size = size + 1;
+  }
+  EXPECT_EQ(size, num_inserted);
+
+  size = 0;
+  prev_key = scale_factor + 1;
+  for (auto iterator = tree.rbegin(); iterator != tree.rend(); ++iterator) {
+    EXPECT_LT((*iterator).first.ToString(), prev_key);
+    prev_key = (*iterator).first.ToString();
+    size = size + 1;
+  }
+  EXPECT_EQ(size, num_inserted);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, ReverseScanTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // small leaves, so that the left siblings of the scan keep splitting
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys are preloaded and half of them get deleted, odd keys get inserted while the scans run
+  const int64_t scale_factor = 2000;
+  std::vector<int64_t> preload_keys;
+  std::vector<int64_t> insert_keys;
+  std::vector<int64_t> remove_keys;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    (key % 2 == 0 ? preload_keys : insert_keys).push_back(key);
+    if (key % 4 == 2) {
+      remove_keys.push_back(key);
+    }
+  }
+  InsertHelper(&tree, preload_keys);
+
+  // every scan sees the preloaded keys that are never removed, in descending order. Scans go on until the writers
+  // are done.
+  std::atomic<bool> is_done{false};
+  auto scan_helper = [&tree, &preload_keys, &remove_keys, &is_done] {
+    for (int scan = 0; scan < 5 || !is_done; scan++) {
+      int64_t num_kept = 0;
+      int64_t prev_key = scale_factor + 1;
+      for (auto iterator = tree.rbegin(); iterator != tree.rend(); ++iterator) {
+        auto key = (*iterator).first.ToString();
+        EXPECT_LT(key, prev_key);
+        prev_key = key;
+        num_kept += key % 4 == 0 ? 1 : 0;
+      }
+      EXPECT_EQ(num_kept, static_cast<int64_t>(preload_keys.size() - remove_keys.size()));
+    }
+  };
+  std::thread scanner(scan_helper);
+  std::thread inserter([&tree, &insert_keys] { LaunchParallelTest(2, InsertHelperSplit, &tree, insert_keys, 2); });
+  // the removed keys are put back a few times, so that leaves keep merging and splitting under the scans
+  std::thread remover([&tree, &remove_keys] {
+    for (int round = 0; round < 4; round++) {
+      LaunchParallelTest(2, DeleteHelperSplit, &tree, remove_keys, 2);
+      LaunchParallelTest(2, InsertHelperSplit, &tree, remove_keys, 2);
+    }
+    LaunchParallelTest(2, DeleteHelperSplit, &tree, remove_keys, 2);
+  });
+  inserter.join();
+  remover.join();
+  is_done = true;
+  scanner.join();
+
+  int64_t size = 0;
+  int64_t prev_key = scale_factor + 1;
+  for (auto iterator = tree.rbegin(); iterator != tree.rend(); ++iterator) {
+    auto key = (*iterator).first.ToString();
+    EXPECT_EQ(key, prev_key - (prev_key % 4 == 3 ? 2 : 1));
+    prev_key = key;
+    size = size + 1;
+  }
+  EXPECT_EQ(size, scale_factor - static_cast<int64_t>(remove_keys.size()));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, PartitionRangeTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  GenericKey<8> low_key;
+  GenericKey<8> high_key;
+  low_key.SetFromInteger(100);
+  high_key.SetFromInteger(4000);
+  // a single leaf cannot be split
+  std::vector<int64_t> keys = {100, 200, 300};
+  InsertHelper(&tree, keys);
+  auto iterators = tree.PartitionRange(low_key, high_key, 4);
+  ASSERT_EQ(iterators.size(), 1);
+
+  keys.clear();
+  for (int64_t key = 1; key <= 5000; key++) {
+    keys.push_back(key);
+  }
+  InsertHelper(&tree, keys);
+
+  for (int num_partitions : {1, 2, 8, 1000}) {
+    iterators = tree.PartitionRange(low_key, high_key, num_partitions);
+    ASSERT_GE(iterators.size(), 1);
+    ASSERT_LE(iterators.size(), num_partitions);
+    if (num_partitions > 1) {
+      EXPECT_GT(iterators.size(), 1);
+    }
+
+    // every partition is scanned by its own thread
+    std::vector<std::vector<int64_t>> scanned(iterators.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < iterators.size(); i++) {
+      threads.emplace_back([&iterators, &scanned, i] {
+        for (auto &iterator = iterators[i]; !iterator.isEnd(); ++iterator) {
+          scanned[i].push_back((*iterator).first.ToString());
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    int64_t expected = 100;
+    for (const auto &partition : scanned) {
+      for (auto key : partition) {
+        EXPECT_EQ(key, expected++);
+      }
+    }
+    EXPECT_EQ(expected, 4001);
+  }
+
+  // a writer removes the odd keys and puts them back while the partitions are scanned, every even key shows up
+  // exactly once
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 1; key <= 5000; key += 2) {
+    odd_keys.push_back(key);
+  }
+  for (int round = 0; round < 5; round++) {
+    std::atomic<bool> is_done{false};
+    std::thread writer([&tree, &odd_keys, &is_done] {
+      while (!is_done) {
+        DeleteHelper(&tree, odd_keys);
+        InsertHelper(&tree, odd_keys);
+      }
+    });
+
+    iterators = tree.PartitionRange(low_key, high_key, 8);
+    std::vector<std::vector<int64_t>> scanned(iterators.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < iterators.size(); i++) {
+      threads.emplace_back([&iterators, &scanned, i] {
+        for (auto &iterator = iterators[i]; !iterator.isEnd(); ++iterator) {
+          scanned[i].push_back((*iterator).first.ToString());
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    is_done = true;
+    writer.join();
+
+    int64_t prev_key = 99;
+    int64_t num_even = 0;
+    for (const auto &partition : scanned) {
+      for (auto key : partition) {
+        EXPECT_GT(key, prev_key);
+        EXPECT_LE(key, 4000);
+        prev_key = key;
+        num_even += key % 2 == 0 ? 1 : 0;
+      }
+    }
+    EXPECT_EQ(num_even, 1951);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, RootChangeTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // key 0 stays while the writer grows the tree to a few levels and shrinks it back to a root leaf
+  std::vector<int64_t> keys = {0};
+  InsertHelper(&tree, keys);
+  keys.clear();
+  for (int64_t key = 1; key <= 300; key++) {
+    keys.push_back(key);
+  }
+
+  for (auto optimistic_reads : {true, false}) {
+    tree.SetOptimisticReads(optimistic_reads);
+    std::atomic<bool> is_done{false};
+    std::thread writer([&tree, &keys, &is_done] {
+      for (int round = 0; round < 10; round++) {
+        InsertHelper(&tree, keys);
+        DeleteHelper(&tree, keys);
+      }
+      is_done = true;
+    });
+
+    LaunchParallelTest(4, [&tree, &is_done](uint64_t thread_itr) {
+      GenericKey<8> index_key;
+      index_key.SetFromInteger(0);
+      while (!is_done) {
+        std::vector<RID> rids;
+        EXPECT_TRUE(tree.GetValue(index_key, &rids));
+        ASSERT_EQ(rids.size(), 1);
+        EXPECT_EQ(rids[0].GetSlotNum(), 0);
+
+        auto iterator = tree.begin();
+        ASSERT_FALSE(iterator.isEnd());
+        EXPECT_EQ((*iterator).first.ToString(), 0);
+      }
+    });
+    writer.join();
+  }
+
+  auto iterator = tree.begin();
+  ASSERT_FALSE(iterator.isEnd());
+  EXPECT_EQ((*iterator).first.ToString(), 0);
+  ++iterator;
+  EXPECT_TRUE(iterator.isEnd());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, RelaxedDeleteTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 4000; key++) {
+    keys.push_back(key);
+  }
+  LaunchParallelTest(4, InsertHelperSplit, &tree, keys, 4);
+
+  // keys that are not multiples of 10 go away while the background thread merges
+  std::vector<int64_t> remove_keys;
+  for (auto key : keys) {
+    if (key % 10 != 0) {
+      remove_keys.push_back(key);
+    }
+  }
+  tree.SetRelaxedDeletes(true);
+  tree.StartBackgroundMerge();
+  LaunchParallelTest(4, DeleteHelperSplit, &tree, remove_keys, 4);
+  tree.StopBackgroundMerge();
+  tree.MergeUnderflowPages();
+
+  int64_t expected = 10;
+  for (auto iterator = tree.begin(); !iterator.isEnd(); ++iterator) {
+    EXPECT_EQ((*iterator).first.ToString(), expected);
+    expected += 10;
+  }
+  EXPECT_EQ(expected, 4010);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, MultiGetTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys stay while the writers insert and remove the odd ones
+  std::vector<int64_t> stable_keys;
+  for (int64_t key = 2; key <= 2000; key += 2) {
+    stable_keys.push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  std::vector<GenericKey<8>> batch(stable_keys.size());
+  for (size_t i = 0; i < stable_keys.size(); i++) {
+    batch[i].SetFromInteger(stable_keys[stable_keys.size() - 1 - i]);
+  }
+
+  std::atomic<bool> is_done{false};
+  std::atomic<int> num_batches{0};
+  std::thread reader([&] {
+    std::vector<std::vector<RID>> results;
+    while (!is_done) {
+      tree.MultiGet(batch, &results);
+      ASSERT_EQ(results.size(), batch.size());
+      for (size_t i = 0; i < batch.size(); i++) {
+        ASSERT_EQ(results[i].size(), 1);
+        EXPECT_EQ(results[i][0].GetSlotNum(), stable_keys[stable_keys.size() - 1 - i]);
+      }
+      num_batches++;
+    }
+  });
+
+  // the writers split and merge leaves under the batches of the reader until it has done a few
+  LaunchParallelTest(2, [&tree, &num_batches](uint64_t thread_itr) {
+    std::vector<int64_t> keys;
+    for (int64_t key = 2 * static_cast<int64_t>(thread_itr) + 1; key < 2000; key += 4) {
+      keys.push_back(key);
+    }
+    for (int round = 0; round < 5 || num_batches < 3; round++) {
+      InsertHelper(&tree, keys);
+      DeleteHelper(&tree, keys);
+    }
+  });
+  is_done = true;
+  reader.join();
+
+  std::vector<std::vector<RID>> results;
+  tree.MultiGet(batch, &results);
+  for (size_t i = 0; i < batch.size(); i++) {
+    ASSERT_EQ(results[i].size(), 1);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, InsertIfAbsentTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // small leaves, so that many ranges span two leaves
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // every writer tries to put its own key into each range [16 * g, 16 * g + 15], only one may succeed per range
+  const int64_t num_ranges = 500;
+  std::vector<std::atomic<int>> num_inserted(num_ranges);
+  LaunchParallelTest(4, [&tree, &num_inserted, num_ranges](uint64_t thread_itr) {
+    Transaction transaction(static_cast<txn_id_t>(thread_itr));
+    GenericKey<8> index_key;
+    GenericKey<8> low_key;
+    GenericKey<8> high_key;
+    for (int64_t g = 0; g < num_ranges; g++) {
+      int64_t key = 16 * g + 3 * static_cast<int64_t>(thread_itr) + 1;
+      index_key.SetFromInteger(key);
+      low_key.SetFromInteger(16 * g);
+      high_key.SetFromInteger(16 * g + 15);
+      if (tree.InsertIfAbsent(index_key, RID(static_cast<page_id_t>(g), static_cast<uint32_t>(key)), low_key,
+                              high_key, &transaction)) {
+        num_inserted[g]++;
+      }
+    }
+  });
+
+  for (int64_t g = 0; g < num_ranges; g++) {
+    EXPECT_EQ(num_inserted[g], 1);
+  }
+  int64_t expected = 0;
+  for (auto iterator = tree.begin(); !iterator.isEnd(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetPageId(), expected);
+    EXPECT_EQ((*iterator).first.ToString() / 16, expected);
+    expected++;
+  }
+  EXPECT_EQ(expected, num_ranges);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, ChangeBufferTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // a small pool, so writers mostly go to the change buffer
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(40, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 8, 8, false);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // keys above 10000 keep a single value while the writers run
+  std::vector<int64_t> stable_keys;
+  for (int64_t key = 10001; key <= 10200; key++) {
+    stable_keys.push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  // the writers start the background merge thread with their first buffered change
+  tree.SetChangeBuffering(true);
+  tree.SetBackgroundMergeOnDemand(true);
+  std::atomic<bool> is_done{false};
+  std::thread reader([&tree, &stable_keys, &is_done] {
+    GenericKey<8> index_key;
+    while (!is_done) {
+      for (auto key : stable_keys) {
+        std::vector<RID> rids;
+        index_key.SetFromInteger(key);
+        EXPECT_TRUE(tree.GetValue(index_key, &rids));
+        ASSERT_EQ(rids.size(), 1);
+      }
+    }
+  });
+
+  // every writer gives its keys two values and takes the first one away again
+  LaunchParallelTest(4, [&tree](uint64_t thread_itr) {
+    Transaction transaction(static_cast<txn_id_t>(thread_itr));
+    GenericKey<8> index_key;
+    for (int64_t key = static_cast<int64_t>(thread_itr) + 1; key <= 2000; key += 4) {
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, RID(static_cast<page_id_t>(key), 0), &transaction));
+      EXPECT_TRUE(tree.Insert(index_key, RID(static_cast<page_id_t>(key), 1), &transaction));
+    }
+    for (int64_t key = static_cast<int64_t>(thread_itr) + 1; key <= 2000; key += 4) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, RID(static_cast<page_id_t>(key), 0), &transaction);
+    }
+  });
+  is_done = true;
+  reader.join();
+  tree.StopBackgroundMerge();
+  tree.MergeChangeBuffer();
+  EXPECT_FALSE(tree.HasPendingChanges());
+
+  int64_t expected = 1;
+  for (auto iterator = tree.begin(); !iterator.isEnd(); ++iterator) {
+    EXPECT_EQ((*iterator).first.ToString(), expected);
+    EXPECT_EQ((*iterator).second.GetSlotNum(), expected > 10000 ? expected : 1);
+    expected = expected == 2000 ? 10001 : expected + 1;
+  }
+  EXPECT_EQ(expected, 10201);
+
+  tree.SetChangeBuffering(false);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, ChangeBufferStressTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // buffered inserts and removes split and merge the leaves of the change buffers, with and without the merge thread
+  for (bool is_background_merge : {false, true}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(64, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 8, 8, false);
+    // create and fetch header_page
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    (void)header_page;
+
+    // keys above 10000 keep a single value while the writers run
+    std::vector<int64_t> stable_keys;
+    for (int64_t key = 10001; key <= 10100; key++) {
+      stable_keys.push_back(key);
+    }
+    InsertHelper(&tree, stable_keys);
+
+    tree.SetChangeBuffering(true);
+    if (is_background_merge) {
+      tree.StartBackgroundMerge();
+    }
+    std::atomic<bool> is_done{false};
+    auto read_helper = [&tree, &stable_keys, &is_done] {
+      GenericKey<8> index_key;
+      while (!is_done) {
+        for (auto key : stable_keys) {
+          std::vector<RID> rids;
+          index_key.SetFromInteger(key);
+          EXPECT_TRUE(tree.GetValue(index_key, &rids));
+          ASSERT_EQ(rids.size(), 1);
+        }
+      }
+    };
+    std::thread reader1(read_helper);
+    std::thread reader2(read_helper);
+
+    // every writer adds a value to each of its keys and takes it away again, a few times over
+    LaunchParallelTest(3, [&tree](uint64_t thread_itr) {
+      Transaction transaction(static_cast<txn_id_t>(thread_itr));
+      GenericKey<8> index_key;
+      for (int32_t cycle = 0; cycle < 3; cycle++) {
+        for (int64_t key = static_cast<int64_t>(thread_itr) + 1; key <= 1500; key += 3) {
+          index_key.SetFromInteger(key);
+          tree.Insert(index_key, RID(static_cast<page_id_t>(key), cycle), &transaction);
+        }
+        for (int64_t key = static_cast<int64_t>(thread_itr) + 1; key <= 1500; key += 3) {
+          index_key.SetFromInteger(key);
+          tree.Remove(index_key, RID(static_cast<page_id_t>(key), cycle), &transaction);
+        }
+      }
+    });
+    is_done = true;
+    reader1.join();
+    reader2.join();
+    tree.StopBackgroundMerge();
+    tree.MergeChangeBuffer();
+    EXPECT_FALSE(tree.HasPendingChanges());
+
+    int64_t expected = 10001;
+    for (auto iterator = tree.begin(); !iterator.isEnd(); ++iterator) {
+      EXPECT_EQ((*iterator).first.ToString(), expected++);
+    }
+    EXPECT_EQ(expected, 10101);
+
+    tree.SetChangeBuffering(false);
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+  delete key_schema;
+}
+
 }  // namespace bustub
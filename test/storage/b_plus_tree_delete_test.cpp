@@ -3,12 +3,18 @@
  */
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <thread>  // NOLINT
 
 #include "b_plus_tree_test_util.h"  // NOLINT
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -170,4 +176,477 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BLinkHighKeyTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree with small nodes, so that splits, merges and redistributions all happen
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  for (int64_t key = 1; key <= 200; key++) {
+    rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  for (int64_t key = 1; key <= 200; key++) {
+    if (key % 3 != 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+  }
+
+  // every key of a leaf is below its high key, every key of the right sibling is at least the high key
+  using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  auto leaf_page_id = tree.FindLeafPage(index_key, true)->GetPageId();
+  int64_t num_keys = 0;
+  while (leaf_page_id != INVALID_PAGE_ID) {
+    auto leaf = reinterpret_cast<LeafPage *>(bpm->FetchPage(leaf_page_id)->GetData());
+    num_keys += leaf->GetSize();
+    auto next_page_id = leaf->GetNextPageId();
+    if (next_page_id != INVALID_PAGE_ID) {
+      EXPECT_EQ(comparator(leaf->KeyAt(leaf->GetSize() - 1), leaf->GetHighKey()), -1);
+      auto next_leaf = reinterpret_cast<LeafPage *>(bpm->FetchPage(next_page_id)->GetData());
+      EXPECT_NE(comparator(next_leaf->KeyAt(0), leaf->GetHighKey()), -1);
+      bpm->UnpinPage(next_page_id, false);
+    }
+    bpm->UnpinPage(leaf_page_id, false);
+    leaf_page_id = next_page_id;
+  }
+  EXPECT_EQ(num_keys, 66);
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 200; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(tree.GetValue(index_key, &rids), key % 3 == 0);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+TEST(BPlusTreeTests, DuplicateKeyDeleteTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree with duplicate keys
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 4, 4, false);
+  GenericKey<8> index_key;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // keys 3 and 5 need chains of several posting pages
+  std::vector<std::pair<int64_t, RID>> entries;
+  std::map<int64_t, std::set<int64_t>> expected;
+  for (int64_t key = 1; key <= 30; key++) {
+    int64_t num_values = key == 3 || key == 5 ? 1200 : key % 3 + 1;
+    for (int64_t slot = 0; slot < num_values; slot++) {
+      entries.emplace_back(key, RID(static_cast<page_id_t>(key), slot));
+      expected[key].insert(slot);
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, entries.back().second, transaction);
+    }
+  }
+
+  auto check = [&]() {
+    std::vector<RID> rids;
+    for (int64_t key = 1; key <= 30; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      auto it = expected.find(key);
+      EXPECT_EQ(tree.GetValue(index_key, &rids), it != expected.end());
+      std::vector<int64_t> slots;
+      for (const auto &rid : rids) {
+        slots.push_back(rid.GetSlotNum());
+      }
+      std::vector<int64_t> expected_slots;
+      if (it != expected.end()) {
+        expected_slots.assign(it->second.begin(), it->second.end());
+      }
+      EXPECT_EQ(slots, expected_slots);
+    }
+  };
+
+  // deleting the whole key frees its posting list
+  index_key.SetFromInteger(5);
+  tree.Remove(index_key, transaction);
+  expected.erase(5);
+  entries.erase(std::remove_if(entries.begin(), entries.end(), [](const auto &entry) { return entry.first == 5; }),
+                entries.end());
+  check();
+
+  // pairs that do not exist are ignored
+  index_key.SetFromInteger(1);
+  tree.Remove(index_key, RID(1, 100), transaction);
+  tree.Remove(index_key, RID(2, 0), transaction);
+  check();
+
+  // delete pair by pair, a key goes away with its last value
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+  for (size_t i = 0; i < entries.size(); i++) {
+    const auto &[key, rid] = entries[i];
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, rid, transaction);
+    expected[key].erase(rid.GetSlotNum());
+    if (expected[key].empty()) {
+      expected.erase(key);
+    }
+    if (i % 500 == 0) {
+      check();
+    }
+  }
+  check();
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+TEST(BPlusTreeTests, StringKeyTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a varchar(64)");
+  GenericComparator<64> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree with pages as large as they get
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm, comparator);
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // long keys with a long common prefix
+  auto make_key = [&](int64_t key) {
+    char str[64];
+    snprintf(str, sizeof(str), "https://www.example.com/users/%06ld/profile", key);
+    GenericKey<64> index_key;
+    index_key.SetFromKey(Tuple({ValueFactory::GetVarcharValue(str)}, key_schema), key_schema);
+    return index_key;
+  };
+  auto key_size = [](const GenericKey<64> &index_key) {
+    int size = sizeof(index_key.data_);
+    while (size > 0 && index_key.data_[size - 1] == 0) {
+      --size;
+    }
+    return size;
+  };
+
+  const int64_t scale = 5000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= scale; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  for (auto key : keys) {
+    tree.Insert(make_key(key), RID(static_cast<int32_t>(key), 0), transaction);
+  }
+
+  // leaves hold more keys than fixed size slots would, their separators in the parent are truncated
+  using LeafPage = BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+  using InternalPage = BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+  auto full_size = key_size(make_key(1));
+  auto leaf_page_id = tree.FindLeafPage(make_key(1), true)->GetPageId();
+  auto leaf = reinterpret_cast<LeafPage *>(bpm->FetchPage(leaf_page_id)->GetData());
+  auto parent_page_id = leaf->GetParentPageId();
+  bpm->UnpinPage(leaf_page_id, false);
+  auto parent = reinterpret_cast<InternalPage *>(bpm->FetchPage(parent_page_id)->GetData());
+  for (int i = 1; i < parent->GetSize(); i++) {
+    EXPECT_LT(key_size(parent->KeyAt(i)), full_size);
+  }
+  bpm->UnpinPage(parent_page_id, false);
+
+  int64_t num_keys = 0;
+  int64_t num_leaves = 0;
+  int64_t expected = 1;
+  while (leaf_page_id != INVALID_PAGE_ID) {
+    leaf = reinterpret_cast<LeafPage *>(bpm->FetchPage(leaf_page_id)->GetData());
+    for (int i = 0; i < leaf->GetSize(); i++) {
+      EXPECT_EQ(comparator(leaf->KeyAt(i), make_key(expected++)), 0);
+    }
+    if (leaf->HasLowKey() && leaf->GetNextPageId() != INVALID_PAGE_ID) {
+      EXPECT_GT(leaf->GetPrefixSize(), 0);
+    }
+    num_keys += leaf->GetSize();
+    ++num_leaves;
+    auto next_page_id = leaf->GetNextPageId();
+    bpm->UnpinPage(leaf_page_id, false);
+    leaf_page_id = next_page_id;
+  }
+  EXPECT_EQ(num_keys, scale);
+  EXPECT_GT(num_keys / num_leaves, static_cast<int64_t>(PAGE_SIZE / (sizeof(GenericKey<64>) + sizeof(RID))));
+
+  // delete two thirds of the keys
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    if (key % 3 != 0) {
+      tree.Remove(make_key(key), transaction);
+    }
+  }
+  for (int64_t key = 1; key <= scale; key++) {
+    rids.clear();
+    EXPECT_EQ(tree.GetValue(make_key(key), &rids), key % 3 == 0);
+  }
+  expected = 3;
+  for (auto iterator = tree.begin(); !iterator.isEnd(); ++iterator) {
+    EXPECT_EQ(comparator((*iterator).first, make_key(expected)), 0);
+    expected += 3;
+  }
+  EXPECT_EQ(expected, scale / 3 * 3 + 3);
+
+  for (auto key : keys) {
+    tree.Remove(make_key(key), transaction);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, ReverseScanTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ trees, the second one is bulk loaded
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> bulk_tree("bar_pk", bpm, comparator, 8, 8);
+  GenericKey<8> index_key;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys only, so that bounds fall between keys as well
+  std::vector<int64_t> keys;
+  for (int64_t key = 2; key <= 4000; key += 2) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(static_cast<page_id_t>(key), 0), transaction));
+  }
+  int64_t next_key = 2;
+  EXPECT_TRUE(bulk_tree.BulkLoad(
+      [&next_key](GenericKey<8> *key, RID *value) {
+        if (next_key > 4000) {
+          return false;
+        }
+        key->SetFromInteger(next_key);
+        *value = RID(static_cast<page_id_t>(next_key), 0);
+        next_key += 2;
+        return true;
+      },
+      0.7, transaction));
+
+  using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+  using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  // every leaf links back to the one before it
+  auto check_links = [bpm](Tree *t) {
+    page_id_t prev_page_id = INVALID_PAGE_ID;
+    auto cur_page_id = t->FindLeafPage(GenericKey<8>(), true)->GetPageId();
+    while (cur_page_id != INVALID_PAGE_ID) {
+      auto leaf = reinterpret_cast<LeafPage *>(bpm->FetchPage(cur_page_id)->GetData());
+      EXPECT_EQ(leaf->GetPrevPageId(), prev_page_id);
+      prev_page_id = cur_page_id;
+      cur_page_id = leaf->GetNextPageId();
+      bpm->UnpinPage(prev_page_id, false);
+    }
+  };
+  // the reverse scan from bound yields every remaining key <= bound in descending order
+  auto check_scan = [](Tree *t, const std::set<int64_t> &remaining, int64_t bound) {
+    GenericKey<8> bound_key;
+    bound_key.SetFromInteger(bound);
+    auto expected = std::make_reverse_iterator(remaining.upper_bound(bound));
+    for (auto iterator = t->RBegin(bound_key); iterator != t->rend(); ++iterator) {
+      ASSERT_NE(expected, remaining.rend());
+      EXPECT_EQ((*iterator).first.ToString(), *expected);
+      EXPECT_EQ((*iterator).second.GetPageId(), *expected++);
+    }
+    EXPECT_EQ(expected, remaining.rend());
+  };
+
+  std::set<int64_t> remaining(keys.begin(), keys.end());
+  for (auto *t : {&tree, &bulk_tree}) {
+    check_links(t);
+    int64_t expected = 4000;
+    for (auto iterator = t->rbegin(); iterator != t->rend(); ++iterator) {
+      EXPECT_EQ((*iterator).first.ToString(), expected);
+      expected -= 2;
+    }
+    EXPECT_EQ(expected, 0);
+    for (auto bound : {0, 2, 3, 1001, 2000, 3999, 4000, 5000}) {
+      check_scan(t, remaining, bound);
+    }
+  }
+
+  // top 10 below a bound only needs the first few steps
+  index_key.SetFromInteger(3001);
+  auto iterator = tree.RBegin(index_key);
+  for (int64_t key = 3000; key > 2980; key -= 2, ++iterator) {
+    EXPECT_EQ((*iterator).first.ToString(), key);
+  }
+
+  // merges and redistributions keep the left links
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+  for (size_t i = 0; i < keys.size() * 3 / 4; i++) {
+    index_key.SetFromInteger(keys[i]);
+    tree.Remove(index_key, transaction);
+    bulk_tree.Remove(index_key, transaction);
+    remaining.erase(keys[i]);
+  }
+  for (auto *t : {&tree, &bulk_tree}) {
+    check_links(t);
+    for (auto bound : {0, 2, 1001, 2000, 4000, 5000}) {
+      check_scan(t, remaining, bound);
+    }
+  }
+
+  // an iterator whose leaf is merged away and freed between two steps finds its key again from the root
+  auto scan_key = *std::next(remaining.begin(), remaining.size() / 2);
+  index_key.SetFromInteger(scan_key);
+  auto merged_iterator = tree.RBegin(index_key);
+  EXPECT_EQ((*merged_iterator).first.ToString(), scan_key);
+  for (auto it = remaining.lower_bound(scan_key - 100); it != remaining.upper_bound(scan_key + 100);) {
+    index_key.SetFromInteger(*it);
+    tree.Remove(index_key, transaction);
+    it = remaining.erase(it);
+  }
+  auto expected = std::make_reverse_iterator(remaining.lower_bound(scan_key));
+  for (++merged_iterator; merged_iterator != tree.rend(); ++merged_iterator) {
+    ASSERT_NE(expected, remaining.rend());
+    EXPECT_EQ((*merged_iterator).first.ToString(), *expected++);
+  }
+  EXPECT_EQ(expected, remaining.rend());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, RelaxedDeleteTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  GenericKey<8> index_key;
+  std::vector<GenericKey<8>> bounds;
+  IndexStats stats;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 2000; key++) {
+    keys.push_back(key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(static_cast<page_id_t>(key), 0), transaction);
+  }
+  tree.CollectStats(&stats, &bounds);
+  auto num_leaves = stats.num_pages_.back();
+
+  // deletes leave the structure alone until the underfull leaves are merged
+  tree.SetRelaxedDeletes(true);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  std::set<int64_t> remaining(keys.begin(), keys.end());
+  for (size_t i = 0; i < keys.size() * 7 / 8; i++) {
+    index_key.SetFromInteger(keys[i]);
+    tree.Remove(index_key, transaction);
+    remaining.erase(keys[i]);
+  }
+  tree.CollectStats(&stats, &bounds);
+  EXPECT_EQ(stats.num_pages_.back(), num_leaves);
+  EXPECT_EQ(stats.num_keys_, remaining.size());
+
+  EXPECT_GT(tree.MergeUnderflowPages(), 0);
+  EXPECT_EQ(tree.MergeUnderflowPages(), 0);
+  tree.CollectStats(&stats, &bounds);
+  EXPECT_LT(stats.num_pages_.back(), num_leaves / 2);
+  EXPECT_EQ(stats.num_keys_, remaining.size());
+  auto expected = remaining.begin();
+  for (auto iterator = tree.begin(); !iterator.isEnd(); ++iterator) {
+    ASSERT_NE(expected, remaining.end());
+    EXPECT_EQ((*iterator).first.ToString(), *expected++);
+  }
+  EXPECT_EQ(expected, remaining.end());
+  for (auto key : remaining) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+  }
+
+  // the background thread collapses the tree once every key is gone
+  tree.StartBackgroundMerge();
+  for (auto key : remaining) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  for (int i = 0; i < 500 && !tree.IsEmpty(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  tree.StopBackgroundMerge();
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
@@ -3,12 +3,18 @@
  */
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <random>
+#include <thread>  // NOLINT
 
 #include "b_plus_tree_test_util.h"  // NOLINT
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/external_sort.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -139,4 +145,913 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree with small nodes and a low fill factor, so that the tree gets deep
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // every key is returned twice, duplicates are skipped
+  int64_t next_key = 2;
+  auto next = [&next_key](GenericKey<8> *key, RID *value) {
+    if (next_key / 2 > 1000) {
+      return false;
+    }
+    int64_t k = next_key++ / 2;
+    key->SetFromInteger(k);
+    value->Set(static_cast<int32_t>(k >> 32), k & 0xFFFFFFFF);
+    return true;
+  };
+  EXPECT_TRUE(tree.BulkLoad(next, 0.5, transaction));
+  EXPECT_FALSE(tree.IsEmpty());
+
+  // a tree can only be bulk loaded once
+  next_key = 2;
+  EXPECT_FALSE(tree.BulkLoad(next, 1.0, transaction));
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 1000; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  int64_t current_key = 1;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, 1001);
+
+  // the loaded tree keeps working with regular inserts and deletes
+  for (int64_t key = 1; key <= 1000; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  for (int64_t key = 1001; key <= 1100; key++) {
+    rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+  for (int64_t key = 1; key <= 1100; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(tree.GetValue(index_key, &rids), key > 1000 || key % 2 == 0);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BulkLoadAbortTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // a small buffer pool, the bulk load pins two pages per level of a deep tree
+  const size_t buffer_pool_size = 10;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  int64_t next_key = 1;
+  int64_t last_key = 100000;
+  auto next = [&next_key, &last_key](GenericKey<8> *key, RID *value) {
+    if (next_key > last_key) {
+      return false;
+    }
+    key->SetFromInteger(next_key);
+    value->Set(0, next_key++);
+    return true;
+  };
+  // a frame is left for every page but the header page once a bulk load gave up
+  auto expect_all_unpinned = [bpm]() {
+    std::vector<page_id_t> page_ids(buffer_pool_size - 1);
+    for (auto &new_page_id : page_ids) {
+      EXPECT_NE(nullptr, bpm->NewPage(&new_page_id));
+    }
+    for (auto new_page_id : page_ids) {
+      bpm->UnpinPage(new_page_id, false);
+      bpm->DeletePage(new_page_id);
+    }
+  };
+
+  // the buffer pool runs out of frames
+  EXPECT_THROW(tree.BulkLoad(next, 1.0, transaction), ExceptionType);
+  EXPECT_TRUE(tree.IsEmpty());
+  expect_all_unpinned();
+
+  // the input stream fails
+  next_key = 1;
+  last_key = 50;
+  auto failing = [&next](GenericKey<8> *key, RID *value) {
+    if (!next(key, value)) {
+      throw Exception(ExceptionType::INVALID, "input failed");
+    }
+    return true;
+  };
+  EXPECT_THROW(tree.BulkLoad(failing, 1.0, transaction), Exception);
+  EXPECT_TRUE(tree.IsEmpty());
+  expect_all_unpinned();
+
+  // the root latch was released, the tree can still be loaded and written
+  next_key = 1;
+  EXPECT_TRUE(tree.BulkLoad(next, 1.0, transaction));
+  index_key.SetFromInteger(51);
+  rid.Set(0, 51);
+  EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 51; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BulkLoadUnsortedTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 5, 5);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 2000; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+  // unsorted input is rejected and leaves the tree empty
+  size_t pos = 0;
+  auto unsorted = [&keys, &pos](GenericKey<8> *key, RID *value) {
+    if (pos == keys.size()) {
+      return false;
+    }
+    key->SetFromInteger(keys[pos]);
+    value->Set(0, keys[pos++]);
+    return true;
+  };
+  EXPECT_THROW(tree.BulkLoad(unsorted, 1.0, transaction), Exception);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  // small runs, so that the sorter spills and merges runs from disk
+  ExternalSort<GenericKey<8>, RID, GenericComparator<8>> sorter(comparator, "test.run", 64, 3);
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+    sorter.Add(index_key, rid);
+  }
+  sorter.Finish();
+  EXPECT_GT(sorter.GetNumRuns(), 1);
+  EXPECT_TRUE(tree.BulkLoad([&sorter](GenericKey<8> *key, RID *value) { return sorter.Next(key, value); }, 0.8,
+                            transaction));
+
+  int64_t current_key = 1;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, 2001);
+
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    tree.Remove(index_key, transaction);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  // the sort is stable across runs, values of a repeated key come out in the order they were added
+  ExternalSort<GenericKey<8>, RID, GenericComparator<8>> stable_sorter(comparator, "test.run", 16, 3);
+  for (int32_t i = 0; i < 1000; i++) {
+    index_key.SetFromInteger(keys[i] % 10);
+    stable_sorter.Add(index_key, RID(i, 0));
+  }
+  stable_sorter.Finish();
+  EXPECT_GT(stable_sorter.GetNumRuns(), 1);
+  int64_t prev_key = -1;
+  page_id_t prev_page_id = -1;
+  for (int i = 0; stable_sorter.Next(&index_key, &rid); i++) {
+    if (index_key.ToString() == prev_key) {
+      EXPECT_GT(rid.GetPageId(), prev_page_id);
+    }
+    prev_key = index_key.ToString();
+    prev_page_id = rid.GetPageId();
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+TEST(BPlusTreeTests, DuplicateKeyTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ trees with duplicate keys
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 4, 4, false);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> bulk_tree("bar_idx", bpm, comparator, 4, 4, false);
+  GenericKey<8> index_key;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // key 7 needs a chain of several posting pages, the other keys have one to four values
+  std::vector<std::pair<int64_t, RID>> entries;
+  for (int64_t key = 1; key <= 40; key++) {
+    int64_t num_values = key == 7 ? 1500 : key % 4 + 1;
+    for (int64_t slot = 0; slot < num_values; slot++) {
+      entries.emplace_back(key, RID(static_cast<page_id_t>(key), slot));
+    }
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+  for (const auto &[key, rid] : entries) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+  for (const auto &[key, rid] : entries) {
+    index_key.SetFromInteger(key);
+    EXPECT_FALSE(tree.Insert(index_key, rid, transaction));
+  }
+
+  // values of the same key come back from one lookup in RID order
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 40; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids.size(), key == 7 ? 1500 : key % 4 + 1);
+    for (size_t slot = 0; slot < rids.size(); slot++) {
+      EXPECT_EQ(rids[slot], RID(static_cast<page_id_t>(key), slot));
+    }
+  }
+
+  // bulk loading collects equal keys into posting lists as well, in whatever order their values come
+  std::stable_sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  size_t pos = 0;
+  auto next = [&entries, &pos](GenericKey<8> *key, RID *value) {
+    if (pos == entries.size()) {
+      return false;
+    }
+    key->SetFromInteger(entries[pos].first);
+    *value = entries[pos++].second;
+    return true;
+  };
+  EXPECT_TRUE(bulk_tree.BulkLoad(next, 1.0, transaction));
+
+  // the iterator yields every key & value pair
+  for (auto *t : {&tree, &bulk_tree}) {
+    std::vector<std::pair<int64_t, RID>> scanned;
+    for (auto iterator = t->begin(); iterator != t->end(); ++iterator) {
+      scanned.emplace_back((*iterator).first.ToString(), (*iterator).second);
+    }
+    ASSERT_EQ(scanned.size(), entries.size());
+    for (size_t i = 1; i < scanned.size(); i++) {
+      EXPECT_TRUE(scanned[i - 1].first < scanned[i].first ||
+                  (scanned[i - 1].first == scanned[i].first &&
+                   scanned[i - 1].second.GetSlotNum() < scanned[i].second.GetSlotNum()));
+      EXPECT_EQ(scanned[i].second.GetPageId(), scanned[i].first);
+    }
+
+    // descending scans yield the keys in reverse, but the values of a key still in ascending order
+    std::stable_sort(scanned.begin(), scanned.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    size_t pos = 0;
+    for (auto iterator = t->rbegin(); iterator != t->rend(); ++iterator) {
+      ASSERT_LT(pos, scanned.size());
+      EXPECT_EQ((*iterator).first.ToString(), scanned[pos].first);
+      EXPECT_EQ((*iterator).second, scanned[pos++].second);
+    }
+    EXPECT_EQ(pos, scanned.size());
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Short posting lists stay inline in the leaf entries, integer keys of 8 bytes use the fixed-width layout and keys
+ * of 64 bytes the slotted one
+ */
+template <size_t KeySize>
+static void CheckInlinePostingLists() {
+  using KeyType = GenericKey<KeySize>;
+  using ValueType = RID;
+  using KeyComparator = GenericComparator<KeySize>;
+  using Tree = BPlusTree<KeyType, ValueType, KeyComparator>;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<KeySize> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  Tree tree("foo_idx", bpm, comparator, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE, false);
+  Tree bulk_tree("bar_idx", bpm, comparator, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE, false);
+  GenericKey<KeySize> index_key;
+  Transaction *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // up to LEAF_PAGE_MAX_INLINE_VALUES values per key, over enough keys for lists to move through splits
+  std::vector<std::pair<int64_t, RID>> entries;
+  for (int64_t key = 0; key < 300; key++) {
+    for (int64_t slot = 0; slot <= key % LEAF_PAGE_MAX_INLINE_VALUES; slot++) {
+      entries.emplace_back(key, RID(static_cast<page_id_t>(key), slot));
+    }
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+  for (const auto &[key, rid] : entries) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+  for (const auto &[key, rid] : entries) {
+    index_key.SetFromInteger(key);
+    EXPECT_FALSE(tree.Insert(index_key, rid, transaction));
+  }
+
+  IndexStats stats;
+  std::vector<GenericKey<KeySize>> bounds;
+  tree.CollectStats(&stats, &bounds);
+  EXPECT_GT(stats.height_, 1);
+  EXPECT_EQ(stats.num_values_, entries.size());
+  EXPECT_EQ(stats.num_posting_pages_, 0);
+
+  auto check_values = [&](Tree *t, int64_t key, size_t num_values) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(t->GetValue(index_key, &rids), num_values > 0);
+    ASSERT_EQ(rids.size(), num_values);
+    for (size_t slot = 0; slot < rids.size(); slot++) {
+      EXPECT_EQ(rids[slot], RID(static_cast<page_id_t>(key), slot));
+    }
+  };
+  for (int64_t key = 0; key < 300; key++) {
+    check_values(&tree, key, key % LEAF_PAGE_MAX_INLINE_VALUES + 1);
+  }
+
+  // one more value spills the list to a posting page
+  const int64_t spilled_key = LEAF_PAGE_MAX_INLINE_VALUES - 1;
+  index_key.SetFromInteger(spilled_key);
+  EXPECT_TRUE(tree.Insert(index_key, RID(spilled_key, LEAF_PAGE_MAX_INLINE_VALUES), transaction));
+  entries.emplace_back(spilled_key, RID(spilled_key, LEAF_PAGE_MAX_INLINE_VALUES));
+  tree.CollectStats(&stats, &bounds);
+  EXPECT_EQ(stats.num_posting_pages_, 1);
+  check_values(&tree, spilled_key, LEAF_PAGE_MAX_INLINE_VALUES + 1);
+
+  // the scans yield every value, inline or not, in RID order
+  std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+    return a.first < b.first || (a.first == b.first && a.second.Get() < b.second.Get());
+  });
+  size_t pos = 0;
+  auto next = [&entries, &pos](GenericKey<KeySize> *key, RID *value) {
+    if (pos == entries.size()) {
+      return false;
+    }
+    key->SetFromInteger(entries[pos].first);
+    *value = entries[pos++].second;
+    return true;
+  };
+  EXPECT_TRUE(bulk_tree.BulkLoad(next, 1.0, transaction));
+  bulk_tree.CollectStats(&stats, &bounds);
+  EXPECT_EQ(stats.num_values_, entries.size());
+  EXPECT_EQ(stats.num_posting_pages_, 1);
+  for (auto *t : {&tree, &bulk_tree}) {
+    pos = 0;
+    for (auto iterator = t->begin(); iterator != t->end(); ++iterator) {
+      ASSERT_LT(pos, entries.size());
+      EXPECT_EQ((*iterator).first.ToString(), entries[pos].first);
+      EXPECT_EQ((*iterator).second, entries[pos++].second);
+    }
+    EXPECT_EQ(pos, entries.size());
+
+    std::vector<std::pair<GenericKey<KeySize>, RID>> batch;
+    pos = 0;
+    for (auto iterator = t->begin(); iterator.NextBatch(&batch);) {
+      for (const auto &[key, rid] : batch) {
+        ASSERT_LT(pos, entries.size());
+        EXPECT_EQ(rid, entries[pos++].second);
+      }
+    }
+    EXPECT_EQ(pos, entries.size());
+
+    pos = entries.size();
+    for (auto iterator = t->rbegin(); iterator != t->rend(); ++iterator) {
+      ASSERT_GT(pos, 0);
+      EXPECT_EQ((*iterator).first.ToString(), entries[--pos].first);
+    }
+    EXPECT_EQ(pos, 0);
+  }
+
+  // a list that shrinks to half of the inline limit moves back into the leaf
+  for (int64_t slot = LEAF_PAGE_MAX_INLINE_VALUES; slot >= LEAF_PAGE_MAX_INLINE_VALUES / 2; slot--) {
+    index_key.SetFromInteger(spilled_key);
+    tree.Remove(index_key, RID(spilled_key, slot), transaction);
+  }
+  tree.CollectStats(&stats, &bounds);
+  EXPECT_EQ(stats.num_posting_pages_, 0);
+  check_values(&tree, spilled_key, LEAF_PAGE_MAX_INLINE_VALUES / 2);
+
+  // values leave inline lists from the back, whole keys go at once
+  for (int64_t key = 0; key < 300; key++) {
+    index_key.SetFromInteger(key);
+    if (key % 3 == 0) {
+      tree.Remove(index_key, transaction);
+      check_values(&tree, key, 0);
+    } else if (key != spilled_key) {
+      tree.Remove(index_key, RID(key, key % LEAF_PAGE_MAX_INLINE_VALUES), transaction);
+      tree.Remove(index_key, RID(key, LEAF_PAGE_MAX_INLINE_VALUES), transaction);
+      check_values(&tree, key, key % LEAF_PAGE_MAX_INLINE_VALUES);
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, InlinePostingListTest) {
+  CheckInlinePostingLists<8>();
+  CheckInlinePostingLists<64>();
+}
+
+TEST(BPlusTreeTests, BatchScanTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ trees with unique and with duplicate keys
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 8, 8);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> dup_tree("bar_idx", bpm, comparator, 8, 8, false);
+  GenericKey<8> index_key;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  for (int64_t key = 1; key <= 1000; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(static_cast<page_id_t>(key), 0), transaction));
+    for (int64_t slot = 0; slot < key % 3 + 1; slot++) {
+      EXPECT_TRUE(dup_tree.Insert(index_key, RID(static_cast<page_id_t>(key), slot), transaction));
+    }
+  }
+
+  // batches hold at most a leaf each and end at the end key
+  GenericKey<8> end_key;
+  end_key.SetFromInteger(900);
+  index_key.SetFromInteger(101);
+  auto iterator = tree.Begin(index_key);
+  std::vector<std::pair<GenericKey<8>, RID>> batch;
+  int64_t expected = 101;
+  int num_batches = 0;
+  while (iterator.NextBatch(&batch, &end_key)) {
+    EXPECT_LE(batch.size(), 8);
+    for (const auto &[key, rid] : batch) {
+      EXPECT_EQ(key.ToString(), expected);
+      EXPECT_EQ(rid.GetPageId(), expected++);
+    }
+    num_batches++;
+  }
+  EXPECT_EQ(expected, 901);
+  EXPECT_GE(num_batches, 800 / 8);
+  EXPECT_TRUE(iterator.isEnd());
+  EXPECT_FALSE(iterator.NextBatch(&batch, &end_key));
+  EXPECT_TRUE(batch.empty());
+
+  // the predicate filters within the leaves, posting lists come back whole
+  auto is_even = [](const GenericKey<8> &key) { return key.ToString() % 2 == 0; };
+  auto dup_iterator = dup_tree.begin();
+  expected = 2;
+  int64_t slot = 0;
+  while (dup_iterator.NextBatch(&batch, nullptr, is_even)) {
+    for (const auto &[key, rid] : batch) {
+      EXPECT_EQ(key.ToString(), expected);
+      EXPECT_EQ(rid, RID(static_cast<page_id_t>(expected), slot));
+      if (++slot == expected % 3 + 1) {
+        expected += 2;
+        slot = 0;
+      }
+    }
+  }
+  EXPECT_EQ(expected, 1002);
+
+  // batches pick up where the iterator stands
+  index_key.SetFromInteger(500);
+  auto start_iterator = dup_tree.Begin(index_key);
+  ++start_iterator;
+  EXPECT_TRUE(start_iterator.NextBatch(&batch, &index_key));
+  ASSERT_EQ(batch.size(), 2);
+  EXPECT_EQ(batch[0].second, RID(500, 1));
+  EXPECT_EQ(batch[1].second, RID(500, 2));
+  EXPECT_FALSE(start_iterator.NextBatch(&batch, &index_key));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, MultiGetTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ trees with unique and with duplicate keys
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 8, 8);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> dup_tree("bar_idx", bpm, comparator, 8, 8, false);
+  GenericKey<8> index_key;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys only
+  for (int64_t key = 2; key <= 2000; key += 2) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(static_cast<page_id_t>(key), 0), transaction));
+    for (int64_t slot = 0; slot < key % 3 + 1; slot++) {
+      EXPECT_TRUE(dup_tree.Insert(index_key, RID(static_cast<page_id_t>(key), slot), transaction));
+    }
+  }
+
+  // unsorted probes with misses and repeated keys
+  std::vector<int64_t> probes;
+  for (int64_t key = 0; key <= 2001; key += 3) {
+    probes.push_back(key);
+  }
+  probes.push_back(4);
+  probes.push_back(4);
+  std::shuffle(probes.begin(), probes.end(), std::mt19937(0));
+  std::vector<GenericKey<8>> keys(probes.size());
+  for (size_t i = 0; i < probes.size(); i++) {
+    keys[i].SetFromInteger(probes[i]);
+  }
+
+  std::vector<std::vector<RID>> results;
+  tree.MultiGet(keys, &results, transaction);
+  ASSERT_EQ(results.size(), probes.size());
+  for (size_t i = 0; i < probes.size(); i++) {
+    auto is_present = probes[i] % 2 == 0 && probes[i] > 0 && probes[i] <= 2000;
+    ASSERT_EQ(results[i].size(), is_present ? 1 : 0);
+    if (is_present) {
+      EXPECT_EQ(results[i][0], RID(static_cast<page_id_t>(probes[i]), 0));
+    }
+  }
+
+  dup_tree.MultiGet(keys, &results, transaction);
+  for (size_t i = 0; i < probes.size(); i++) {
+    std::vector<RID> rids;
+    dup_tree.GetValue(keys[i], &rids, transaction);
+    EXPECT_EQ(results[i], rids);
+  }
+
+  // the index hands batches of keys to MultiGet
+  IndexMetadata *metadata = new IndexMetadata("baz_idx", "foo", key_schema, {0});
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(metadata, bpm);
+  std::vector<Tuple> tuples;
+  for (int64_t key = 1; key <= 100; key++) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetBigIntValue(key)}, key_schema);
+    index.InsertEntry(tuples.back(), RID(static_cast<page_id_t>(key), 0), transaction);
+  }
+  tuples.emplace_back(std::vector<Value>{ValueFactory::GetBigIntValue(1000)}, key_schema);
+  std::reverse(tuples.begin(), tuples.end());
+  index.ScanKeys(tuples, &results, transaction);
+  ASSERT_EQ(results.size(), 101);
+  EXPECT_TRUE(results[0].empty());
+  for (int64_t i = 1; i <= 100; i++) {
+    ASSERT_EQ(results[i].size(), 1);
+    EXPECT_EQ(results[i][0].GetPageId(), 101 - i);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, CollectStatsTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  IndexMetadata *metadata = new IndexMetadata("foo_idx", "foo", key_schema, {0});
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(metadata, bpm);
+  IndexStats stats;
+  index.CollectStats(&stats, 1.0, 32, transaction);
+  EXPECT_EQ(stats.height_, 0);
+  EXPECT_EQ(stats.EstimateSelectivity(nullptr, nullptr, key_schema), 0);
+
+  auto make_key = [&](int64_t key) { return Tuple({ValueFactory::GetBigIntValue(key)}, key_schema); };
+  const int64_t num_keys = 10000;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    index.InsertEntry(make_key(key), RID(static_cast<page_id_t>(key), 0), transaction);
+  }
+
+  index.CollectStats(&stats, 1.0, 32, transaction);
+  ASSERT_GE(stats.height_, 2);
+  ASSERT_EQ(stats.num_pages_.size(), stats.height_);
+  EXPECT_EQ(stats.num_pages_[0], 1);
+  for (auto fill : stats.fill_factors_) {
+    EXPECT_GT(fill, 0);
+    EXPECT_LE(fill, 1);
+  }
+  EXPECT_EQ(stats.num_keys_, num_keys);
+  EXPECT_EQ(stats.num_values_, num_keys);
+  EXPECT_EQ(stats.num_posting_pages_, 0);
+  EXPECT_EQ(stats.sample_rate_, 1);
+
+  // equi-depth: every bucket holds about the same number of keys
+  ASSERT_EQ(stats.histogram_bounds_.size(), 32);
+  ASSERT_EQ(stats.histogram_counts_.size(), 32);
+  uint64_t total = 0;
+  for (size_t i = 0; i < stats.histogram_counts_.size(); i++) {
+    EXPECT_NEAR(stats.histogram_counts_[i], num_keys / 32.0, 1);
+    EXPECT_EQ(stats.histogram_num_keys_[i], stats.histogram_counts_[i]);
+    total += stats.histogram_counts_[i];
+  }
+  EXPECT_EQ(total, num_keys);
+  EXPECT_EQ(stats.histogram_bounds_.back().GetValue(key_schema, 0).GetAs<int64_t>(), num_keys);
+
+  auto low = make_key(1000);
+  auto high = make_key(2999);
+  EXPECT_NEAR(stats.EstimateSelectivity(&low, &high, key_schema), 0.2, 0.02);
+  EXPECT_NEAR(stats.EstimateSelectivity(nullptr, &high, key_schema), 0.3, 0.02);
+  EXPECT_NEAR(stats.EstimateSelectivity(&low, nullptr, key_schema), 0.9, 0.02);
+  EXPECT_NEAR(stats.EstimateSelectivity(&low, &low, key_schema), 1.0 / num_keys, 1e-6);
+  auto beyond = make_key(num_keys + 1);
+  EXPECT_EQ(stats.EstimateSelectivity(&beyond, nullptr, key_schema), 0);
+
+  // a sample of the leaves is scaled up to the whole tree
+  index.CollectStats(&stats, 0.5, 32, transaction);
+  EXPECT_GT(stats.sample_rate_, 0);
+  EXPECT_LE(stats.sample_rate_, 1);
+  EXPECT_NEAR(stats.num_values_, num_keys, num_keys * 0.5);
+  EXPECT_NEAR(stats.EstimateSelectivity(&low, &high, key_schema), 0.2, 0.15);
+
+  // duplicate keys count every value of their posting list
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> dup_tree("bar_idx", bpm, comparator, 8, 8, false);
+  GenericKey<8> index_key;
+  for (int64_t key = 0; key < 10; key++) {
+    index_key.SetFromInteger(key);
+    for (int64_t slot = 0; slot < (key + 1) * 100; slot++) {
+      EXPECT_TRUE(dup_tree.Insert(index_key, RID(static_cast<page_id_t>(key), slot), transaction));
+    }
+  }
+  std::vector<GenericKey<8>> bounds;
+  dup_tree.CollectStats(&stats, &bounds, 1.0, 4);
+  EXPECT_EQ(stats.num_pages_.size(), stats.height_);
+  EXPECT_EQ(stats.num_keys_, 10);
+  EXPECT_EQ(stats.num_values_, 5500);
+  EXPECT_GT(stats.num_posting_pages_, 0);
+  ASSERT_EQ(bounds.size(), stats.histogram_counts_.size());
+  ASSERT_LE(bounds.size(), 4);
+  total = 0;
+  for (auto count : stats.histogram_counts_) {
+    total += count;
+  }
+  EXPECT_EQ(total, 5500);
+  EXPECT_EQ(bounds.back().ToString(), 9);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, ChangeBufferTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // a small pool, so most leaves are not resident
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 4, 4, false);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> unique_tree("foo_pk", bpm, comparator, 4, 4);
+  GenericKey<8> index_key;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  EXPECT_THROW(unique_tree.SetChangeBuffering(true), Exception);
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 400; key++) {
+    keys.push_back(key);
+  }
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(static_cast<page_id_t>(key), 0), transaction));
+  }
+
+  // every key gets a second value and even keys lose their first one, mostly in the change buffer
+  tree.SetChangeBuffering(true);
+  EXPECT_FALSE(tree.HasPendingChanges());
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(static_cast<page_id_t>(key), 1), transaction));
+    if (key % 2 == 0) {
+      tree.Remove(index_key, RID(static_cast<page_id_t>(key), 0), transaction);
+    }
+  }
+  EXPECT_TRUE(tree.HasPendingChanges());
+  EXPECT_FALSE(tree.IsEmpty());
+
+  auto expected = [](int64_t key) {
+    std::vector<RID> rids{RID(static_cast<page_id_t>(key), 1)};
+    if (key % 2 == 1) {
+      rids.insert(rids.begin(), RID(static_cast<page_id_t>(key), 0));
+    }
+    return rids;
+  };
+
+  // lookups see the buffered changes
+  std::sort(keys.begin(), keys.end());
+  std::vector<GenericKey<8>> batch;
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    batch.push_back(index_key);
+  }
+  std::vector<std::vector<RID>> results;
+  tree.MultiGet(batch, &results, transaction);
+  ASSERT_EQ(results.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::sort(results[i].begin(), results[i].end(),
+              [](const RID &a, const RID &b) { return a.GetSlotNum() < b.GetSlotNum(); });
+    EXPECT_EQ(results[i], expected(keys[i]));
+  }
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids, transaction));
+    std::sort(rids.begin(), rids.end(), [](const RID &a, const RID &b) { return a.GetSlotNum() < b.GetSlotNum(); });
+    EXPECT_EQ(rids, expected(key));
+  }
+
+  // removing a key drops its pending changes as well
+  for (int64_t key = 1; key <= 10; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+    rids.clear();
+    EXPECT_FALSE(tree.GetValue(index_key, &rids, transaction));
+    EXPECT_TRUE(rids.empty());
+  }
+
+  // a range scan merges the changes of its range first
+  GenericKey<8> stop_key;
+  index_key.SetFromInteger(100);
+  stop_key.SetFromInteger(199);
+  std::vector<std::pair<int64_t, RID>> scanned;
+  for (auto iterator = tree.Begin(index_key, stop_key, true); !iterator.isEnd(); ++iterator) {
+    scanned.emplace_back((*iterator).first.ToString(), (*iterator).second);
+  }
+  std::vector<std::pair<int64_t, RID>> expected_scan;
+  for (int64_t key = 100; key <= 199; key++) {
+    for (const auto &rid : expected(key)) {
+      expected_scan.emplace_back(key, rid);
+    }
+  }
+  EXPECT_EQ(scanned, expected_scan);
+
+  // the remaining changes are merged by the background thread
+  tree.StartBackgroundMerge();
+  while (tree.HasPendingChanges()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  tree.StopBackgroundMerge();
+  scanned.clear();
+  for (auto iterator = tree.begin(); !iterator.isEnd(); ++iterator) {
+    scanned.emplace_back((*iterator).first.ToString(), (*iterator).second);
+  }
+  expected_scan.clear();
+  for (int64_t key = 11; key <= 400; key++) {
+    for (const auto &rid : expected(key)) {
+      expected_scan.emplace_back(key, rid);
+    }
+  }
+  EXPECT_EQ(scanned, expected_scan);
+
+  // deletes of every remaining value empty the tree once merged
+  std::shuffle(expected_scan.begin(), expected_scan.end(), std::mt19937(1));
+  for (const auto &[key, rid] : expected_scan) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, rid, transaction);
+  }
+  EXPECT_GT(tree.MergeChangeBuffer(), 0);
+  EXPECT_FALSE(tree.HasPendingChanges());
+  EXPECT_TRUE(tree.IsEmpty());
+  tree.SetChangeBuffering(false);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
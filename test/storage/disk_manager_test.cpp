@@ -11,10 +11,12 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstring>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_trace.h"
 
 namespace bustub {
 
@@ -30,6 +32,7 @@ class DiskManagerTest : public ::testing::Test {
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.trace");
   };
 };
 
@@ -72,6 +75,51 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, TraceTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  char log[16] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  dm.WritePage(0, data);  // not traced
+  dm.EnableTrace("test.trace");
+  auto page_id = dm.AllocatePage();
+  dm.WritePage(page_id, data);
+  dm.ReadPage(page_id, buf);
+  dm.WriteLog(log, sizeof(log));
+  dm.DeallocatePage(page_id);
+  dm.DisableTrace();
+  dm.ReadPage(0, buf);  // not traced
+
+  DiskTraceReader reader("test.trace");
+  DiskTraceRecord record{};
+  std::vector<DiskTraceOp> expected_ops = {DiskTraceOp::ALLOCATE_PAGE, DiskTraceOp::WRITE_PAGE, DiskTraceOp::READ_PAGE,
+                                           DiskTraceOp::WRITE_LOG, DiskTraceOp::DEALLOCATE_PAGE};
+  uint64_t last_timestamp = 0;
+  for (auto op : expected_ops) {
+    ASSERT_TRUE(reader.Next(&record));
+    EXPECT_EQ(op, record.op_);
+    EXPECT_GE(record.timestamp_us_, last_timestamp);
+    last_timestamp = record.timestamp_us_;
+    if (op == DiskTraceOp::WRITE_LOG) {
+      EXPECT_EQ(INVALID_PAGE_ID, record.page_id_);
+      EXPECT_EQ(sizeof(log), record.size_);
+    } else {
+      EXPECT_EQ(page_id, record.page_id_);
+    }
+    if (op == DiskTraceOp::READ_PAGE || op == DiskTraceOp::WRITE_PAGE) {
+      EXPECT_EQ(PAGE_SIZE, record.size_);
+    }
+  }
+  EXPECT_FALSE(reader.Next(&record));
+  EXPECT_EQ(2, dm.GetNumReads());
+
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
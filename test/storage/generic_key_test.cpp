@@ -0,0 +1,128 @@
+/**
+ * generic_key_test.cpp
+ */
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/b_plus_tree_key_search.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// the normalized encoding must order keys exactly like comparing their values column by column
+TEST(GenericKeyTest, NormalizedOrderTest) {
+  Schema key_schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 8), Column("c", TypeId::DECIMAL),
+                     Column("d", TypeId::SMALLINT)});
+  GenericComparator<32> comparator(&key_schema);
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int32_t> int_dist(-3, 3);
+  std::vector<std::string> strings = {"", std::string(1, '\0'), std::string("a\0b", 3), "a", "ab", "b"};
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < 200; i++) {
+    rows.push_back({ValueFactory::GetIntegerValue(int_dist(rng) * 100000),
+                    ValueFactory::GetVarcharValue(strings[rng() % strings.size()]),
+                    ValueFactory::GetDecimalValue(int_dist(rng) * 1.5),
+                    ValueFactory::GetSmallIntValue(static_cast<int16_t>(int_dist(rng) * 1000))});
+  }
+
+  auto value_compare = [](const std::vector<Value> &lhs, const std::vector<Value> &rhs) {
+    for (size_t i = 0; i < lhs.size(); i++) {
+      if (lhs[i].CompareLessThan(rhs[i]) == CmpBool::CmpTrue) {
+        return -1;
+      }
+      if (lhs[i].CompareGreaterThan(rhs[i]) == CmpBool::CmpTrue) {
+        return 1;
+      }
+    }
+    return 0;
+  };
+
+  std::vector<GenericKey<32>> keys(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    keys[i].SetFromKey(Tuple(rows[i], &key_schema), &key_schema);
+    for (uint32_t col = 0; col < key_schema.GetColumnCount(); col++) {
+      EXPECT_EQ(keys[i].ToValue(&key_schema, col).CompareEquals(rows[i][col]), CmpBool::CmpTrue);
+    }
+  }
+  for (size_t i = 0; i < rows.size(); i++) {
+    for (size_t j = 0; j < rows.size(); j++) {
+      EXPECT_EQ(comparator(keys[i], keys[j]), value_compare(rows[i], rows[j]));
+    }
+  }
+}
+
+TEST(GenericKeyTest, IntegerKeyTest) {
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+
+  std::vector<int64_t> values = {BUSTUB_INT64_MIN, -(1LL << 40), -256, -1, 0, 1, 255, 256, 1LL << 40, BUSTUB_INT64_MAX};
+  GenericKey<8> lhs;
+  GenericKey<8> rhs;
+  for (size_t i = 0; i < values.size(); i++) {
+    lhs.SetFromInteger(values[i]);
+    EXPECT_EQ(lhs.ToString(), values[i]);
+    for (size_t j = 0; j < values.size(); j++) {
+      rhs.SetFromInteger(values[j]);
+      EXPECT_EQ(comparator(lhs, rhs), i < j ? -1 : (i > j ? 1 : 0));
+    }
+  }
+}
+
+// the SIMD search over the slots of a slotted page must agree with a binary search for every node size
+TEST(GenericKeyTest, SlotHeadSearchTest) {
+  std::mt19937 rng(0);
+  for (int size = 0; size <= 300; size++) {
+    // few distinct heads, so that runs of equal heads cross the SIMD lanes, and heads with the top bit set
+    std::vector<uint64_t> slots(size);
+    for (int i = 0; i < size; i++) {
+      auto head = static_cast<uint32_t>(rng() % (size + 1)) * 0x01010101U;
+      slots[i] = static_cast<uint64_t>(head) << 32 | (rng() & 0xFFFFFFFFU);
+    }
+    std::sort(slots.begin(), slots.end());
+    for (int probe = 0; probe < 20; probe++) {
+      auto head = static_cast<uint32_t>(rng() % (size + 2)) * 0x01010101U;
+      auto expected = std::lower_bound(slots.begin(), slots.end(), static_cast<uint64_t>(head) << 32) - slots.begin();
+      EXPECT_EQ(SlotHeadLowerBound(slots.data(), size, head), expected);
+    }
+  }
+}
+
+
+// the SIMD search of word sized keys in fixed-width pages must agree with a binary search for every node size
+TEST(GenericKeyTest, NormalizedKeySearchTest) {
+  Schema key_schema4({Column("a", TypeId::INTEGER)});
+  Schema key_schema8({Column("a", TypeId::BIGINT)});
+  GenericComparator<4> comparator4(&key_schema4);
+  GenericComparator<8> comparator8(&key_schema8);
+
+  std::mt19937 rng(0);
+  for (int size = 0; size <= 300; size++) {
+    std::vector<GenericKey<4>> keys4(size);
+    std::vector<GenericKey<8>> keys8(size);
+    for (int i = 0; i < size; i++) {
+      auto v = 3 * (i - size / 2);
+      keys4[i].SetFromKey(Tuple({ValueFactory::GetIntegerValue(v)}, &key_schema4), &key_schema4);
+      keys8[i].SetFromInteger(v);
+    }
+    for (int probe = 0; probe < 20; probe++) {
+      int32_t v = static_cast<int32_t>(rng() % (3 * size + 7)) - 3 * (size / 2) - 3;
+      GenericKey<4> key4;
+      GenericKey<8> key8;
+      key4.SetFromKey(Tuple({ValueFactory::GetIntegerValue(v)}, &key_schema4), &key_schema4);
+      key8.SetFromInteger(v);
+      EXPECT_EQ(NormalizedKeySearch<uint32_t>::LowerBound(keys4.data(), size, key4),
+                BinaryLowerBound(keys4.data(), 0, size, key4, comparator4));
+      EXPECT_EQ(NormalizedKeySearch<uint64_t>::LowerBound(keys8.data(), size, key8),
+                BinaryLowerBound(keys8.data(), 0, size, key8, comparator8));
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// btree_bench.cpp
+//
+// Identification: tools/btree_bench/btree_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Mixed read/write concurrency benchmark for BPlusTree. Runs lookups, inserts and deletes on uniformly random
+ * keys from a growing number of threads and reports throughput for the optimistic protocols (latch crabbing that
+ * only write latches leaves, version-validated lookups) and the pessimistic latch crabbing protocol.
+ *
+ * Usage: bustub-btree-bench [--threads <max threads>] [--read-ratio <percent>] [--keys <key space>]
+ *                           [--ops <ops per thread>] [--pool-size <frames>] [--mode optimistic|pessimistic|both]
+ *
+ * Thread counts are swept in powers of two up to --threads. Writes are split evenly between inserts and deletes,
+ * and the tree is preloaded with every other key of the key space so both kinds of writes find work to do.
+ */
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+using BenchTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+struct BenchOptions {
+  uint64_t max_threads_{4};
+  int read_ratio_{80};
+  int64_t num_keys_{100000};
+  uint64_t ops_per_thread_{100000};
+  size_t pool_size_{BUFFER_POOL_SIZE};
+  bool run_optimistic_{true};
+  bool run_pessimistic_{true};
+};
+
+static void PrintUsage() {
+  std::cerr << "usage: bustub-btree-bench [--threads <max threads>] [--read-ratio <percent>] [--keys <key space>] "
+               "[--ops <ops per thread>] [--pool-size <frames>] [--mode optimistic|pessimistic|both]"
+            << std::endl;
+}
+
+static bool ParseOptions(int argc, char **argv, BenchOptions *options) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string flag(argv[i]);
+    std::string value(argv[i + 1]);
+    if (flag == "--threads") {
+      options->max_threads_ = std::stoul(value);
+    } else if (flag == "--read-ratio") {
+      options->read_ratio_ = std::stoi(value);
+    } else if (flag == "--keys") {
+      options->num_keys_ = std::stol(value);
+    } else if (flag == "--ops") {
+      options->ops_per_thread_ = std::stoul(value);
+    } else if (flag == "--pool-size") {
+      options->pool_size_ = std::stoul(value);
+    } else if (flag == "--mode") {
+      options->run_optimistic_ = value == "optimistic" || value == "both";
+      options->run_pessimistic_ = value == "pessimistic" || value == "both";
+      if (!options->run_optimistic_ && !options->run_pessimistic_) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  return argc % 2 == 1 && options->max_threads_ > 0 && options->read_ratio_ >= 0 && options->read_ratio_ <= 100 &&
+         options->num_keys_ > 0 && options->pool_size_ > 0;
+}
+
+static void Worker(BenchTree *tree, const BenchOptions &options, uint64_t thread_itr) {
+  std::mt19937_64 rng(thread_itr + 1);
+  std::uniform_int_distribution<int64_t> key_dist(1, options.num_keys_);
+  std::uniform_int_distribution<int> op_dist(0, 99);
+  Transaction transaction(static_cast<txn_id_t>(thread_itr));
+  GenericKey<8> index_key;
+  std::vector<RID> result;
+
+  for (uint64_t i = 0; i < options.ops_per_thread_; ++i) {
+    auto key = key_dist(rng);
+    auto op = op_dist(rng);
+    index_key.SetFromInteger(key);
+    if (op < options.read_ratio_) {
+      result.clear();
+      tree->GetValue(index_key, &result, &transaction);
+    } else if ((op - options.read_ratio_) % 2 == 0) {
+      tree->Insert(index_key, RID(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key)), &transaction);
+    } else {
+      tree->Remove(index_key, &transaction);
+    }
+  }
+}
+
+/** @return throughput in operations per second */
+static double RunOnce(const BenchOptions &options, bool optimistic, uint64_t num_threads) {
+  const std::string db_file = "btree_bench.db";
+  DiskManager disk_manager(db_file);
+  BufferPoolManager bpm(options.pool_size_, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(&header_page_id);
+
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+  BenchTree tree("btree_bench", &bpm, comparator);
+  tree.SetOptimisticLatching(optimistic);
+  tree.SetOptimisticReads(optimistic);
+
+  Transaction transaction(0);
+  GenericKey<8> index_key;
+  for (int64_t key = 2; key <= options.num_keys_; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key)), &transaction);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (uint64_t thread_itr = 0; thread_itr < num_threads; ++thread_itr) {
+    threads.emplace_back(Worker, &tree, std::cref(options), thread_itr);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bpm.UnpinPage(header_page_id, true);
+  disk_manager.ShutDown();
+  remove(db_file.c_str());
+  remove("btree_bench.log");
+  return static_cast<double>(options.ops_per_thread_ * num_threads) / elapsed;
+}
+
+static int Run(const BenchOptions &options) {
+  std::cout << "keys " << options.num_keys_ << ", read ratio " << options.read_ratio_ << "%, ops per thread "
+            << options.ops_per_thread_ << ", pool size " << options.pool_size_ << std::endl;
+  std::cout << "threads\tmode\t\tops/s" << std::endl;
+  for (uint64_t num_threads = 1; num_threads <= options.max_threads_; num_threads *= 2) {
+    if (options.run_optimistic_) {
+      std::cout << num_threads << "\toptimistic\t" << static_cast<uint64_t>(RunOnce(options, true, num_threads))
+                << std::endl;
+    }
+    if (options.run_pessimistic_) {
+      std::cout << num_threads << "\tpessimistic\t" << static_cast<uint64_t>(RunOnce(options, false, num_threads))
+                << std::endl;
+    }
+  }
+  return 0;
+}
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  bustub::BenchOptions options;
+  if (!bustub::ParseOptions(argc, argv, &options)) {
+    bustub::PrintUsage();
+    return 1;
+  }
+  return bustub::Run(options);
+}
@@ -0,0 +1,170 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_search_bench.cpp
+//
+// Identification: tools/key_search_bench/key_search_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Micro benchmark for the search within a single B+ tree leaf. Compares the binary search over interleaved
+ * key/value pairs of fixed size, which is how leaf pages used to be laid out, with the leaf page of the current
+ * layout, which is picked from the key type (see BPlusTreeNodeLayout):
+ * - integer keys of one machine word, which use the fixed-width layout and its SIMD key search
+ * - string keys of several key sizes, which use the slotted layout. Keys share a common prefix, like most string
+ *   keys of an index do, so the slotted page also reports how many more keys it holds thanks to head compression.
+ *
+ * Usage: bustub-key-search-bench [--searches <searches per key size>]
+ */
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/rid.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+static void PrintUsage() {
+  std::cerr << "usage: bustub-key-search-bench [--searches <searches per key size>]" << std::endl;
+}
+
+/** The search of the interleaved layout, see the old BPlusTreeLeafPage::keyIndex. */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+static int InterleavedLowerBound(const std::vector<MappingType> &items, const KeyType &key,
+                                 const KeyComparator &comparator) {
+  int l = 0;
+  int r = static_cast<int>(items.size());
+  while (l < r) {
+    int mid = l + (r - l) / 2;
+    if (comparator(items[mid].first, key) == -1) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+  return l;
+}
+
+/**
+ * Fill a leaf between two siblings with the even keys above its low key and search it, so that a slotted leaf
+ * shares the prefix of its keys through its fences
+ */
+template <size_t KeySize, typename MakeKey>
+static void RunLeaf(const char *kind, const GenericComparator<KeySize> &comparator, MakeKey &&make_key,
+                    uint64_t num_searches) {
+  using KeyType = GenericKey<KeySize>;
+  using ValueType = RID;
+  using KeyComparator = GenericComparator<KeySize>;
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
+  std::vector<char> buffers(3 * PAGE_SIZE);
+  auto left = reinterpret_cast<LeafPage *>(&buffers[0]);
+  auto leaf = reinterpret_cast<LeafPage *>(&buffers[PAGE_SIZE]);
+  auto right = reinterpret_cast<LeafPage *>(&buffers[2 * PAGE_SIZE]);
+  left->Init(0);
+  leaf->Init(1);
+  right->Init(2);
+  left->LinkRightSibling(leaf, make_key(0));
+  leaf->LinkRightSibling(right, make_key(10000));
+
+  std::vector<MappingType> items;
+  for (int i = 0; !leaf->IsOverflow(); i++) {
+    auto key = make_key(2 * i + 2);
+    leaf->Insert(key, RID(i), comparator);
+    items.emplace_back(key, RID(i));
+  }
+  const int num_keys = leaf->GetSize();
+  const int fixed_keys = (PAGE_SIZE - 32 - sizeof(KeyType)) / (sizeof(KeyType) + sizeof(ValueType));
+
+  // half of the searches hit
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int32_t> dist(1, 2 * num_keys + 2);
+  std::vector<KeyType> targets;
+  for (int i = 0; i < 4096; i++) {
+    targets.push_back(make_key(dist(rng)));
+  }
+
+  auto run = [&](auto &&search) {
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_searches; i++) {
+      checksum += search(targets[i % targets.size()]);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return std::make_pair(elapsed / static_cast<double>(num_searches), checksum);
+  };
+
+  auto [interleaved_ns, interleaved_sum] =
+      run([&](const KeyType &key) { return InterleavedLowerBound<KeyType, ValueType>(items, key, comparator); });
+  auto [leaf_ns, leaf_sum] = run([&](const KeyType &key) { return leaf->KeyIndex(key, comparator); });
+  if (interleaved_sum != leaf_sum) {
+    std::cerr << "search results differ for GenericKey<" << KeySize << ">" << std::endl;
+  }
+
+  std::cout << kind << "\t" << KeySize << "\t\t" << fixed_keys << "\t\t" << num_keys << "\t\t"
+            << leaf->GetPrefixSize() << "\t" << interleaved_ns << "\t\t" << leaf_ns << std::endl;
+}
+
+template <size_t KeySize>
+static void RunIntegerKeys(uint64_t num_searches) {
+  Schema key_schema({Column("a", KeySize < sizeof(int64_t) ? TypeId::INTEGER : TypeId::BIGINT)});
+  GenericComparator<KeySize> comparator(&key_schema);
+  auto make_key = [&key_schema](int32_t v) {
+    GenericKey<KeySize> key;
+    auto value = KeySize < sizeof(int64_t) ? ValueFactory::GetIntegerValue(v) : ValueFactory::GetBigIntValue(v);
+    key.SetFromKey(Tuple({value}, &key_schema), &key_schema);
+    return key;
+  };
+  RunLeaf<KeySize>("integer", comparator, make_key, num_searches);
+}
+
+template <size_t KeySize>
+static void RunStringKeys(uint64_t num_searches) {
+  Schema key_schema({Column("a", TypeId::VARCHAR, KeySize)});
+  GenericComparator<KeySize> comparator(&key_schema);
+  auto make_key = [&key_schema](int32_t v) {
+    char str[32];
+    snprintf(str, sizeof(str), "user:%08d", v);
+    GenericKey<KeySize> key;
+    key.SetFromKey(Tuple({ValueFactory::GetVarcharValue(str)}, &key_schema), &key_schema);
+    return key;
+  };
+  RunLeaf<KeySize>("string", comparator, make_key, num_searches);
+}
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  uint64_t num_searches = 10000000;
+  if (argc == 3 && std::string(argv[1]) == "--searches") {
+    num_searches = std::stoul(argv[2]);
+  } else if (argc != 1) {
+    bustub::PrintUsage();
+    return 1;
+  }
+
+#ifdef __AVX2__
+  std::cout << "simd: avx2" << std::endl;
+#else
+  std::cout << "simd: none" << std::endl;
+#endif
+  std::cout << "keys\tkey size\tfixed keys\tleaf keys\tprefix\tinterleaved ns\tleaf ns" << std::endl;
+  bustub::RunIntegerKeys<4>(num_searches);
+  bustub::RunIntegerKeys<8>(num_searches);
+  bustub::RunStringKeys<16>(num_searches);
+  bustub::RunStringKeys<32>(num_searches);
+  bustub::RunStringKeys<64>(num_searches);
+  return 0;
+}
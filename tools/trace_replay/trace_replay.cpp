@@ -0,0 +1,248 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// trace_replay.cpp
+//
+// Identification: tools/trace_replay/trace_replay.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Replays an I/O trace recorded by DiskManager::EnableTrace against a BufferPoolManager, so that pool sizes,
+ * replacement policies and prefetching can be evaluated offline on production access patterns.
+ *
+ * Usage: bustub-trace-replay --trace <file> [--pool-size <frames>] [--replacer lru|clock] [--prefetch <pages>]
+ *                            [--db <file>]
+ *
+ * The replay runs against a scratch database, by default a new file in the temporary directory. A file given with
+ * --db must not exist yet, since the replay resizes it and deletes it at the end, together with its log file.
+ *
+ * Page reads of the trace become FetchPage/UnpinPage calls, allocations become NewPage calls and deallocations become
+ * DeletePage calls. Page writes were flushes or evictions of the traced buffer pool, the replayed pool writes back on
+ * its own, so they are counted but not replayed, like log records. The hit ratio only counts the traced reads, pages
+ * prefetched after them are read in unless resident but neither count as hits nor refresh resident pages.
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_trace.h"
+
+namespace bustub {
+
+struct ReplayOptions {
+  std::string trace_file_;
+  std::string db_file_;
+  size_t pool_size_{BUFFER_POOL_SIZE};
+  BufferPoolManager::ReplacerType replacer_type_{BufferPoolManager::ReplacerType::LRU};
+  page_id_t prefetch_{0};
+};
+
+struct ReplayStats {
+  uint64_t page_reads_{0};
+  uint64_t page_writes_{0};
+  uint64_t allocations_{0};
+  uint64_t deallocations_{0};
+  uint64_t log_ops_{0};
+  uint64_t fetches_{0};
+  uint64_t hits_{0};
+  uint64_t prefetches_{0};
+  uint64_t traced_read_latency_ns_{0};
+};
+
+static void PrintUsage() {
+  std::cerr << "usage: bustub-trace-replay --trace <file> [--pool-size <frames>] [--replacer lru|clock] "
+               "[--prefetch <pages>] [--db <file>]"
+            << std::endl;
+}
+
+static bool ParseOptions(int argc, char **argv, ReplayOptions *options) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string flag(argv[i]);
+    std::string value(argv[i + 1]);
+    if (flag == "--trace") {
+      options->trace_file_ = value;
+    } else if (flag == "--pool-size") {
+      options->pool_size_ = std::stoul(value);
+    } else if (flag == "--replacer") {
+      if (value == "lru") {
+        options->replacer_type_ = BufferPoolManager::ReplacerType::LRU;
+      } else if (value == "clock") {
+        options->replacer_type_ = BufferPoolManager::ReplacerType::CLOCK;
+      } else {
+        return false;
+      }
+    } else if (flag == "--prefetch") {
+      options->prefetch_ = std::stoi(value);
+    } else if (flag == "--db") {
+      options->db_file_ = value;
+    } else {
+      return false;
+    }
+  }
+  return argc % 2 == 1 && !options->trace_file_.empty() && options->pool_size_ > 0;
+}
+
+/** Fetches and immediately unpins a page, which is how a traced access looks to the buffer pool. */
+static void Touch(BufferPoolManager *bpm, page_id_t page_id) {
+  if (bpm->FetchPage(page_id) == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "buffer pool has no evictable frame");
+  }
+  bpm->UnpinPage(page_id, false);
+}
+
+/** A traced read: a hit if the page is resident before it is fetched. */
+static void Read(BufferPoolManager *bpm, page_id_t page_id, ReplayStats *stats) {
+  ++stats->fetches_;
+  if (bpm->IsPageResident(page_id)) {
+    ++stats->hits_;
+  }
+  Touch(bpm, page_id);
+}
+
+/** A prefetch reads a page in if it is not resident, without refreshing resident pages in the replacer. */
+static void Prefetch(BufferPoolManager *bpm, page_id_t page_id, ReplayStats *stats) {
+  if (!bpm->IsPageResident(page_id)) {
+    ++stats->prefetches_;
+    Touch(bpm, page_id);
+  }
+}
+
+/** The log file DiskManager opens next to a database file. */
+static std::string LogFileOf(const std::string &db_file) { return db_file.substr(0, db_file.rfind('.')) + ".log"; }
+
+/** Picks a database file in the temporary directory that no other file or replay uses. */
+static std::string ScratchDbFile() {
+  auto directory = std::filesystem::temp_directory_path();
+  for (int i = 0;; ++i) {
+    auto db_file =
+        (directory / ("bustub-trace-replay-" + std::to_string(getpid()) + "-" + std::to_string(i) + ".db")).string();
+    if (!std::filesystem::exists(db_file) && !std::filesystem::exists(LogFileOf(db_file))) {
+      return db_file;
+    }
+  }
+}
+
+static int Replay(const ReplayOptions &options) {
+  auto db_file = options.db_file_.empty() ? ScratchDbFile() : options.db_file_;
+  if (db_file.rfind('.') == std::string::npos) {
+    std::cerr << "database file needs an extension: " << db_file << std::endl;
+    return 1;
+  }
+  if (std::filesystem::exists(db_file) || std::filesystem::exists(LogFileOf(db_file))) {
+    std::cerr << "database file or its log exists already, it would be overwritten: " << db_file << std::endl;
+    return 1;
+  }
+
+  // first pass: the replay database must cover every page the trace touches
+  page_id_t max_page_id = INVALID_PAGE_ID;
+  DiskTraceRecord record{};
+  {
+    DiskTraceReader reader(options.trace_file_);
+    while (reader.Next(&record)) {
+      max_page_id = std::max(max_page_id, record.page_id_);
+    }
+  }
+
+  DiskManager disk_manager(db_file);
+  std::filesystem::resize_file(db_file, static_cast<uintmax_t>(max_page_id + 1) * PAGE_SIZE);
+  // pages allocated during the replay get fresh ids above every traced id
+  for (page_id_t i = 0; i <= max_page_id; ++i) {
+    disk_manager.AllocatePage();
+  }
+
+  BufferPoolManager bpm(options.pool_size_, &disk_manager, nullptr, options.replacer_type_);
+  std::unordered_map<page_id_t, page_id_t> allocated;
+  auto map_page_id = [&allocated](page_id_t page_id) {
+    auto iter = allocated.find(page_id);
+    return iter == allocated.end() ? page_id : iter->second;
+  };
+
+  ReplayStats stats;
+  DiskTraceReader reader(options.trace_file_);
+  auto start = std::chrono::steady_clock::now();
+  while (reader.Next(&record)) {
+    switch (record.op_) {
+      case DiskTraceOp::READ_PAGE:
+        ++stats.page_reads_;
+        stats.traced_read_latency_ns_ += record.latency_ns_;
+        Read(&bpm, map_page_id(record.page_id_), &stats);
+        for (page_id_t i = 1; i <= options.prefetch_ && record.page_id_ + i <= max_page_id; ++i) {
+          Prefetch(&bpm, map_page_id(record.page_id_ + i), &stats);
+        }
+        break;
+      case DiskTraceOp::WRITE_PAGE:
+        ++stats.page_writes_;
+        break;
+      case DiskTraceOp::ALLOCATE_PAGE: {
+        ++stats.allocations_;
+        page_id_t page_id = INVALID_PAGE_ID;
+        if (bpm.NewPage(&page_id) == nullptr) {
+          throw Exception(ExceptionType::OUT_OF_MEMORY, "buffer pool has no evictable frame");
+        }
+        bpm.UnpinPage(page_id, true);
+        allocated[record.page_id_] = page_id;
+        break;
+      }
+      case DiskTraceOp::DEALLOCATE_PAGE:
+        ++stats.deallocations_;
+        bpm.DeletePage(map_page_id(record.page_id_));
+        break;
+      case DiskTraceOp::READ_LOG:
+      case DiskTraceOp::WRITE_LOG:
+        ++stats.log_ops_;
+        break;
+    }
+  }
+  bpm.FlushAllPages();
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+  auto disk_reads = static_cast<uint64_t>(disk_manager.GetNumReads());
+  std::cout << "trace: " << options.trace_file_ << std::endl;
+  std::cout << "  page reads: " << stats.page_reads_ << ", page writes: " << stats.page_writes_
+            << ", allocations: " << stats.allocations_ << ", deallocations: " << stats.deallocations_
+            << ", log ops: " << stats.log_ops_ << std::endl;
+  if (stats.page_reads_ > 0) {
+    std::cout << "  traced avg read latency: " << stats.traced_read_latency_ns_ / stats.page_reads_ / 1000.0 << " us"
+              << std::endl;
+  }
+  std::cout << "config: pool size " << options.pool_size_ << ", replacer "
+            << (options.replacer_type_ == BufferPoolManager::ReplacerType::LRU ? "lru" : "clock") << ", prefetch "
+            << options.prefetch_ << std::endl;
+  std::cout << "  buffer fetches: " << stats.fetches_ << ", hits: " << stats.hits_
+            << ", prefetches: " << stats.prefetches_ << ", disk reads: " << disk_reads
+            << ", disk writes: " << disk_manager.GetNumWrites() << std::endl;
+  if (stats.fetches_ > 0) {
+    std::cout << "  hit ratio: " << static_cast<double>(stats.hits_) / static_cast<double>(stats.fetches_)
+              << std::endl;
+  }
+  std::cout << "  replay time: " << elapsed.count() / 1000.0 << " ms" << std::endl;
+
+  disk_manager.ShutDown();
+  remove(db_file.c_str());
+  remove(LogFileOf(db_file).c_str());
+  return 0;
+}
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  bustub::ReplayOptions options;
+  if (!bustub::ParseOptions(argc, argv, &options)) {
+    bustub::PrintUsage();
+    return 1;
+  }
+  return bustub::Replay(options);
+}
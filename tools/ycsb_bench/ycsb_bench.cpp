@@ -0,0 +1,471 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ycsb_bench.cpp
+//
+// Identification: tools/ycsb_bench/ycsb_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * YCSB-style concurrency benchmark for BPlusTree, LinearProbeHashTable (with plain or tagged blocks) and
+ * ExtendibleHashTable. Loads --records records, then runs the core workloads on them and reports throughput and the
+ * 50th, 99th and 99.9th percentile of the operation latency:
+ *
+ *   A  50% reads, 50% updates                  zipfian
+ *   B  95% reads, 5% updates                   zipfian
+ *   C  100% reads                              zipfian
+ *   D  95% reads, 5% inserts                   latest
+ *   E  95% scans, 5% inserts                   zipfian, scans of 1 to --scan-length records
+ *   F  50% reads, 50% read-modify-writes       zipfian
+ *
+ * Usage: bustub-ycsb-bench [--index btree|hash|tagged|extendible,...] [--workloads <letters>]
+ *                          [--distribution <distribution>] [--records <records>] [--ops <ops per thread>]
+ *                          [--threads <max threads>] [--pool-sizes <frames>,...] [--scan-length <max records>]
+ *
+ * --distribution is uniform, zipfian or latest and overrides the request distribution of every workload. Thread
+ * counts are swept in powers of two up to --threads, once for each buffer pool size. Records are inserted in hashed
+ * order like in YCSB, so inserts do not all go to the end of the tree. The hash tables have no scans and skip E.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "container/hash/extendible_hash_table.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+using BenchKey = GenericKey<8>;
+using BenchComparator = GenericComparator<8>;
+
+enum class IndexKind { BTREE, HASH, TAGGED_HASH, EXTENDIBLE };
+
+static const char *const INDEX_NAMES[] = {"btree", "hash", "tagged", "extendible"};
+
+enum class Distribution { DEFAULT, UNIFORM, ZIPFIAN, LATEST };
+
+struct Workload {
+  char name_;
+  // percentages of the operations, the rest are read-modify-writes
+  int read_;
+  int update_;
+  int insert_;
+  int scan_;
+  Distribution distribution_;
+};
+
+static const Workload WORKLOADS[] = {
+    {'a', 50, 50, 0, 0, Distribution::ZIPFIAN}, {'b', 95, 5, 0, 0, Distribution::ZIPFIAN},
+    {'c', 100, 0, 0, 0, Distribution::ZIPFIAN}, {'d', 95, 0, 5, 0, Distribution::LATEST},
+    {'e', 0, 0, 5, 95, Distribution::ZIPFIAN},  {'f', 50, 0, 0, 0, Distribution::ZIPFIAN},
+};
+
+struct BenchOptions {
+  std::vector<IndexKind> indexes_{IndexKind::BTREE, IndexKind::HASH, IndexKind::TAGGED_HASH, IndexKind::EXTENDIBLE};
+  std::string workloads_{"abcdef"};
+  Distribution distribution_{Distribution::DEFAULT};
+  uint64_t num_records_{100000};
+  uint64_t ops_per_thread_{100000};
+  uint64_t max_threads_{4};
+  std::vector<size_t> pool_sizes_{BUFFER_POOL_SIZE};
+  int max_scan_length_{100};
+};
+
+/** The operations of the workloads on one of the indexes */
+class BenchIndex {
+ public:
+  virtual ~BenchIndex() = default;
+  virtual bool Read(const BenchKey &key, Transaction *transaction) = 0;
+  virtual bool Insert(const BenchKey &key, const RID &value, Transaction *transaction) = 0;
+  virtual void Update(const BenchKey &key, const RID &value, Transaction *transaction) = 0;
+  // @return false if the index has no scans
+  virtual bool Scan(const BenchKey &key, int length, Transaction *transaction) = 0;
+};
+
+class BenchTree : public BenchIndex {
+ public:
+  BenchTree(BufferPoolManager *bpm, const BenchComparator &comparator) : tree_("ycsb_bench", bpm, comparator) {}
+
+  bool Read(const BenchKey &key, Transaction *transaction) override {
+    std::vector<RID> result;
+    return tree_.GetValue(key, &result, transaction);
+  }
+
+  bool Insert(const BenchKey &key, const RID &value, Transaction *transaction) override {
+    return tree_.Insert(key, value, transaction);
+  }
+
+  void Update(const BenchKey &key, const RID &value, Transaction *transaction) override {
+    tree_.Remove(key, transaction);
+    tree_.Insert(key, value, transaction);
+  }
+
+  bool Scan(const BenchKey &key, int length, Transaction *transaction) override {
+    auto itr = tree_.Begin(key);
+    for (int i = 0; i < length && !itr.isEnd(); ++i) {
+      ++itr;
+    }
+    return true;
+  }
+
+ private:
+  BPlusTree<BenchKey, RID, BenchComparator> tree_;
+};
+
+template <typename BlockPage>
+class BenchHashTable : public BenchIndex {
+ public:
+  BenchHashTable(BufferPoolManager *bpm, const BenchComparator &comparator, size_t num_buckets)
+      : hash_table_("ycsb_bench", bpm, comparator, num_buckets, HashFunction<BenchKey>()) {}
+
+  bool Read(const BenchKey &key, Transaction *transaction) override {
+    std::vector<RID> result;
+    return hash_table_.GetValue(transaction, key, &result);
+  }
+
+  bool Insert(const BenchKey &key, const RID &value, Transaction *transaction) override {
+    return hash_table_.Insert(transaction, key, value);
+  }
+
+  void Update(const BenchKey &key, const RID &value, Transaction *transaction) override {
+    hash_table_.Remove(transaction, key, value);
+    hash_table_.Insert(transaction, key, value);
+  }
+
+  bool Scan(const BenchKey &key, int length, Transaction *transaction) override { return false; }
+
+ private:
+  LinearProbeHashTable<BenchKey, RID, BenchComparator, BlockPage> hash_table_;
+};
+
+class BenchExtendibleHashTable : public BenchIndex {
+ public:
+  BenchExtendibleHashTable(BufferPoolManager *bpm, const BenchComparator &comparator)
+      : hash_table_("ycsb_bench", bpm, comparator, HashFunction<BenchKey>()) {}
+
+  bool Read(const BenchKey &key, Transaction *transaction) override {
+    std::vector<RID> result;
+    return hash_table_.GetValue(transaction, key, &result);
+  }
+
+  bool Insert(const BenchKey &key, const RID &value, Transaction *transaction) override {
+    return hash_table_.Insert(transaction, key, value);
+  }
+
+  void Update(const BenchKey &key, const RID &value, Transaction *transaction) override {
+    hash_table_.Remove(transaction, key, value);
+    hash_table_.Insert(transaction, key, value);
+  }
+
+  bool Scan(const BenchKey &key, int length, Transaction *transaction) override { return false; }
+
+ private:
+  ExtendibleHashTable<BenchKey, RID, BenchComparator> hash_table_;
+};
+
+/** 64-bit FNV-1a of a record number, which YCSB uses to scramble keys */
+static uint64_t FnvHash(uint64_t n) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < 8; ++i) {
+    hash ^= n & 0xff;
+    hash *= 0x100000001b3ULL;
+    n >>= 8;
+  }
+  return hash;
+}
+
+/** The key of a record number, keys are inserted in hashed order */
+static int64_t KeyOf(uint64_t record) { return static_cast<int64_t>(FnvHash(record) >> 1); }
+
+static RID ValueOf(uint64_t record) {
+  return RID(static_cast<int32_t>(record >> 32), static_cast<uint32_t>(record));
+}
+
+/**
+ * Zipfian ranks in [0, num_items) with the YCSB constant 0.99, after Gray et al., "Quickly Generating Billion-Record
+ * Synthetic Databases". Rank 0 is the most popular.
+ */
+class ZipfianGenerator {
+ public:
+  explicit ZipfianGenerator(uint64_t num_items) : num_items_(num_items) {
+    for (uint64_t i = 1; i <= num_items; ++i) {
+      zetan_ += 1.0 / std::pow(static_cast<double>(i), THETA);
+    }
+    auto zeta2 = 1.0 + 1.0 / std::pow(2.0, THETA);
+    alpha_ = 1.0 / (1.0 - THETA);
+    eta_ = (1.0 - std::pow(2.0 / static_cast<double>(num_items), 1.0 - THETA)) / (1.0 - zeta2 / zetan_);
+  }
+
+  uint64_t Next(std::mt19937_64 *rng) const {
+    auto u = std::uniform_real_distribution<double>(0.0, 1.0)(*rng);
+    auto uz = u * zetan_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, THETA)) {
+      return 1;
+    }
+    auto rank = static_cast<uint64_t>(static_cast<double>(num_items_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(rank, num_items_ - 1);
+  }
+
+ private:
+  static constexpr double THETA = 0.99;
+  uint64_t num_items_;
+  double zetan_{0};
+  double alpha_;
+  double eta_;
+};
+
+/** State shared by the threads of a run */
+struct RunState {
+  BenchIndex *index_;
+  const Workload *workload_;
+  Distribution distribution_;
+  const ZipfianGenerator *zipfian_;
+  // record number of the next insert, records below it are (being) inserted
+  std::atomic<uint64_t> next_record_;
+};
+
+/** Pick the record an operation other than an insert works on */
+static uint64_t ChooseRecord(const RunState &state, uint64_t num_records, std::mt19937_64 *rng) {
+  auto max_record = state.next_record_.load();
+  switch (state.distribution_) {
+    case Distribution::UNIFORM:
+      return std::uniform_int_distribution<uint64_t>(0, max_record - 1)(*rng);
+    case Distribution::LATEST:
+      // the most recent inserts are the most popular
+      return max_record - 1 - std::min(state.zipfian_->Next(rng), max_record - 1);
+    default:
+      // scrambled, so the popular records are spread over the key space
+      return FnvHash(state.zipfian_->Next(rng)) % num_records;
+  }
+}
+
+static void Worker(RunState *state, const BenchOptions &options, uint64_t thread_itr,
+                   std::vector<uint64_t> *latencies) {
+  std::mt19937_64 rng(thread_itr + 1);
+  std::uniform_int_distribution<int> op_dist(0, 99);
+  std::uniform_int_distribution<int> scan_dist(1, options.max_scan_length_);
+  Transaction transaction(static_cast<txn_id_t>(thread_itr));
+  const auto &workload = *state->workload_;
+  BenchKey index_key;
+  latencies->reserve(options.ops_per_thread_);
+
+  for (uint64_t i = 0; i < options.ops_per_thread_; ++i) {
+    auto op = op_dist(rng);
+    auto start = std::chrono::steady_clock::now();
+    if (op < workload.insert_) {
+      auto record = state->next_record_.fetch_add(1);
+      index_key.SetFromInteger(KeyOf(record));
+      state->index_->Insert(index_key, ValueOf(record), &transaction);
+    } else {
+      auto record = ChooseRecord(*state, options.num_records_, &rng);
+      index_key.SetFromInteger(KeyOf(record));
+      op -= workload.insert_;
+      if (op < workload.read_) {
+        state->index_->Read(index_key, &transaction);
+      } else if (op < workload.read_ + workload.update_) {
+        state->index_->Update(index_key, ValueOf(record), &transaction);
+      } else if (op < workload.read_ + workload.update_ + workload.scan_) {
+        state->index_->Scan(index_key, scan_dist(rng), &transaction);
+      } else {
+        state->index_->Read(index_key, &transaction);
+        state->index_->Update(index_key, ValueOf(record), &transaction);
+      }
+    }
+    latencies->push_back(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+  }
+}
+
+/** @return the latency at percentile p of the sorted latencies, in microseconds */
+static double Percentile(const std::vector<uint64_t> &latencies, double p) {
+  auto ind = std::min(static_cast<size_t>(static_cast<double>(latencies.size()) * p), latencies.size() - 1);
+  return static_cast<double>(latencies[ind]) / 1000.0;
+}
+
+static void RunOnce(const BenchOptions &options, IndexKind index_kind, const Workload &workload, size_t pool_size,
+                    uint64_t num_threads) {
+  const std::string db_file = "ycsb_bench.db";
+  DiskManager disk_manager(db_file);
+  BufferPoolManager bpm(pool_size, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(&header_page_id);
+
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  BenchComparator comparator(&key_schema);
+  std::unique_ptr<BenchIndex> index;
+  switch (index_kind) {
+    case IndexKind::BTREE:
+      index = std::make_unique<BenchTree>(&bpm, comparator);
+      break;
+    case IndexKind::HASH:
+      index = std::make_unique<BenchHashTable<HashTableBlockPage<BenchKey, RID, BenchComparator>>>(
+          &bpm, comparator, 2 * options.num_records_);
+      break;
+    case IndexKind::TAGGED_HASH:
+      index = std::make_unique<BenchHashTable<HashTableTaggedBlockPage<BenchKey, RID, BenchComparator>>>(
+          &bpm, comparator, 2 * options.num_records_);
+      break;
+    case IndexKind::EXTENDIBLE:
+      index = std::make_unique<BenchExtendibleHashTable>(&bpm, comparator);
+      break;
+  }
+
+  // load phase
+  Transaction transaction(0);
+  BenchKey index_key;
+  for (uint64_t record = 0; record < options.num_records_; ++record) {
+    index_key.SetFromInteger(KeyOf(record));
+    index->Insert(index_key, ValueOf(record), &transaction);
+  }
+
+  ZipfianGenerator zipfian(options.num_records_);
+  RunState state{index.get(), &workload, options.distribution_, &zipfian, {options.num_records_}};
+  if (state.distribution_ == Distribution::DEFAULT) {
+    state.distribution_ = workload.distribution_;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::vector<uint64_t>> thread_latencies(num_threads);
+  std::vector<std::thread> threads;
+  for (uint64_t thread_itr = 0; thread_itr < num_threads; ++thread_itr) {
+    threads.emplace_back(Worker, &state, std::cref(options), thread_itr, &thread_latencies[thread_itr]);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<uint64_t> latencies;
+  for (const auto &thread_latency : thread_latencies) {
+    latencies.insert(latencies.end(), thread_latency.begin(), thread_latency.end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << INDEX_NAMES[static_cast<int>(index_kind)] << "\t" << workload.name_ << "\t\t" << pool_size << "\t"
+            << num_threads << "\t" << static_cast<uint64_t>(static_cast<double>(latencies.size()) / elapsed) << "\t"
+            << Percentile(latencies, 0.5) << "\t" << Percentile(latencies, 0.99) << "\t" << Percentile(latencies, 0.999)
+            << std::endl;
+
+  index.reset();
+  bpm.UnpinPage(header_page_id, true);
+  disk_manager.ShutDown();
+  remove(db_file.c_str());
+  remove("ycsb_bench.log");
+}
+
+static void PrintUsage() {
+  std::cerr << "usage: bustub-ycsb-bench [--index btree|hash|tagged|extendible,...] [--workloads <letters>] "
+               "[--distribution uniform|zipfian|latest] [--records <records>] [--ops <ops per thread>] "
+               "[--threads <max threads>] [--pool-sizes <frames>,...] [--scan-length <max records>]"
+            << std::endl;
+}
+
+static bool ParseOptions(int argc, char **argv, BenchOptions *options) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string flag(argv[i]);
+    std::string value(argv[i + 1]);
+    if (flag == "--index") {
+      options->indexes_.clear();
+      std::stringstream names(value);
+      std::string name;
+      while (std::getline(names, name, ',')) {
+        auto index_name = std::find(std::begin(INDEX_NAMES), std::end(INDEX_NAMES), name);
+        if (index_name == std::end(INDEX_NAMES)) {
+          return false;
+        }
+        options->indexes_.push_back(static_cast<IndexKind>(index_name - std::begin(INDEX_NAMES)));
+      }
+    } else if (flag == "--workloads") {
+      options->workloads_ = value;
+      for (auto name : value) {
+        if (std::none_of(std::begin(WORKLOADS), std::end(WORKLOADS),
+                         [name](const Workload &workload) { return workload.name_ == name; })) {
+          return false;
+        }
+      }
+    } else if (flag == "--distribution") {
+      if (value == "uniform") {
+        options->distribution_ = Distribution::UNIFORM;
+      } else if (value == "zipfian") {
+        options->distribution_ = Distribution::ZIPFIAN;
+      } else if (value == "latest") {
+        options->distribution_ = Distribution::LATEST;
+      } else {
+        return false;
+      }
+    } else if (flag == "--records") {
+      options->num_records_ = std::stoul(value);
+    } else if (flag == "--ops") {
+      options->ops_per_thread_ = std::stoul(value);
+    } else if (flag == "--threads") {
+      options->max_threads_ = std::stoul(value);
+    } else if (flag == "--pool-sizes") {
+      options->pool_sizes_.clear();
+      std::stringstream sizes(value);
+      std::string size;
+      while (std::getline(sizes, size, ',')) {
+        options->pool_sizes_.push_back(std::stoul(size));
+      }
+    } else if (flag == "--scan-length") {
+      options->max_scan_length_ = std::stoi(value);
+    } else {
+      return false;
+    }
+  }
+  return argc % 2 == 1 && options->num_records_ > 1 && options->ops_per_thread_ > 0 && options->max_threads_ > 0 &&
+         !options->indexes_.empty() && !options->pool_sizes_.empty() &&
+         std::all_of(options->pool_sizes_.begin(), options->pool_sizes_.end(), [](size_t size) { return size > 0; }) &&
+         options->max_scan_length_ > 0;
+}
+
+static int Run(const BenchOptions &options) {
+  std::cout << "records " << options.num_records_ << ", ops per thread " << options.ops_per_thread_
+            << ", max scan length " << options.max_scan_length_ << std::endl;
+  std::cout << "index\tworkload\tpool\tthreads\tops/s\tp50(us)\tp99(us)\tp999(us)" << std::endl;
+  for (auto name : options.workloads_) {
+    const auto &workload = *std::find_if(std::begin(WORKLOADS), std::end(WORKLOADS),
+                                         [name](const Workload &workload) { return workload.name_ == name; });
+    for (auto pool_size : options.pool_sizes_) {
+      for (uint64_t num_threads = 1; num_threads <= options.max_threads_; num_threads *= 2) {
+        for (auto index_kind : options.indexes_) {
+          if (index_kind == IndexKind::BTREE || workload.scan_ == 0) {
+            RunOnce(options, index_kind, workload, pool_size, num_threads);
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  bustub::BenchOptions options;
+  if (!bustub::ParseOptions(argc, argv, &options)) {
+    bustub::PrintUsage();
+    return 1;
+  }
+  return bustub::Run(options);
+}